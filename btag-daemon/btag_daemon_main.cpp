@@ -26,8 +26,10 @@
 #include <stdexcept>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <csignal>
 #endif
 #include <algorithm>
+#include <map>
 #include <lg_io.h>
 #include <lg_time.h>
 #include <lgen_process.h>
@@ -89,11 +91,13 @@ void serviceMaintenance ( const string& binaryName, const string& command, const
 }
 #else
 bool sigtermReceived = false;
+volatile sig_atomic_t childSignal = 0;
 void sigchldHandler ( int sigNum )	// This is a signal handler to prevent the child processes becoming zombies
 {
 	pid_t pid;
 	int status;
 	while ( ( pid = waitpid ( -1, &status, WNOHANG ) ) > 0 );
+	childSignal = 1;				// A search may have finished so check the queue straight away
 }
 void sigtermHandler ( int sigNum )
 {
@@ -206,6 +210,9 @@ bool singleServer = false;
 GenElapsedTime et;
 SetString startedJobs;
 SetString activeJobs;
+typedef std::map <string, GenElapsedTime> MapStringToGenElapsedTime;
+typedef MapStringToGenElapsedTime::iterator MapStringToGenElapsedTimeIterator;
+MapStringToGenElapsedTime startingJobs;		// Started searches that may not have set their status to searching yet
 string serverStr;
 bool firstLoop = true;
 
@@ -214,6 +221,9 @@ void daemonLoop ()
 	try {
 		static string host = Hostname::instance ().getHostname ();
 		readParameters ();
+#ifndef VIS_C
+		childSignal = 0;
+#endif
 		DaemonJobQueue djq = MySQLPPSDDBase::instance ().getDaemonJobQueue ();
 		djq.setActions ( host, maxJobsPerUser );
 		VectorDaemonJobItem cleanUpItems = djq.getCleanUpJobItems ();
@@ -225,25 +235,34 @@ void daemonLoop ()
 		}
 		SetString doneJobs;
 		activeJobs = djq.getActiveJobKeys ();
+		for ( MapStringToGenElapsedTimeIterator i = startingJobs.begin () ; i != startingJobs.end () ; ) {	// Allow a loop time for a search to start
+			if ( activeJobs.count ( i->first ) || i->second.getElapsedTime () * 1000 > loopTime ) startingJobs.erase ( i++ );
+			else i++;
+		}
 		set_difference ( startedJobs.begin (), startedJobs.end (), activeJobs.begin (), activeJobs.end (), inserter ( doneJobs, doneJobs.begin () ) );
 		for ( SetStringConstIterator sKey = doneJobs.begin () ; sKey != doneJobs.end () ; sKey++ ) {
+			if ( startingJobs.count ( *sKey ) ) continue;
 			DaemonJobItem* dji = MySQLPPSDDBase::instance ().getDaemonJobItemByKey ( *sKey );
 			sendEmail ( dji, serverStr + "/msform.cgi?form=search_compare&search_key=" + *sKey );
 			delete dji;
 			startedJobs.erase ( *sKey );
 		}
-		if ( djq.getNumRunning () < maxSearches ) {		// Only a single search can be started each time round the loop
-			string searchKey = djq.getNextSearchJobKey ();
-			if ( !searchKey.empty () ) {
-				if ( !singleServer ) genSleep ( djq.getNumRunning () * loopTime );
-				if ( MySQLPPSDDBase::instance ().setJobStart ( searchKey ) ) {
-					if ( !btagSubmit ( searchKey, Hostname::instance ().getHostname () ) ) {
+		int numFree = maxSearches - djq.getNumRunning () - static_cast <int> ( startingJobs.size () );
+		StringVector searchKeys = djq.getNextSearchJobKeys ();		// In fair share order
+		if ( numFree > 0 && !searchKeys.empty () ) {				// Start as many searches as there are free slots
+			if ( !singleServer ) genSleep ( djq.getNumRunning () * loopTime / maxSearches );	// Give less busy servers the first chance of the searches
+			for ( StringVectorSizeType i = 0 ; i < searchKeys.size () && numFree > 0 ; i++ ) {
+				const string& searchKey = searchKeys [i];
+				if ( MySQLPPSDDBase::instance ().setJobStart ( searchKey ) ) {	// Fails if another server has started the search
+					if ( !btagSubmit ( searchKey, host ) ) {
 						logOutput ( "Unable to start search." );
 						MySQLPPSDDBase::instance ().setJobSubmitted ( searchKey );	// Resubmit the job if it wouldn't start
 					}
 					else {
 						logOutput ( "Started search " + searchKey );
 						startedJobs.insert ( searchKey );
+						startingJobs [searchKey] = GenElapsedTime ();
+						numFree--;
 					}
 				}
 			}
@@ -263,8 +282,10 @@ void daemonLoop ()
 		millisecs = millisecs - (sec * 1000);
 		req.tv_sec = sec;
 		req.tv_nsec = millisecs * 1000000L;
-		while ( nanosleep ( &req, &req ) == -1 ) {
-			if ( sigtermReceived ) break;
+		if ( !childSignal && !hupSignal ) {			// Don't sleep if a signal arrived during this pass
+			while ( nanosleep ( &req, &req ) == -1 ) {	// Interrupted by a signal
+				if ( sigtermReceived || hupSignal || childSignal ) break;
+			}
 		}
 #endif
 	}
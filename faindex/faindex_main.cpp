@@ -90,6 +90,7 @@ static void faindexWebBrowser ( int argc, char** argv )
 			}
 			else {
 				FAIndexNormalParameters params ( &paramList );
+				importCompressedDatabase ( params.getDatabase () );
 				if ( params.getDNAToProtein () )
 					createdDatabaseName = dna_database_to_protein_database ( params.getDatabase (), params.getDeleteDNADatabase () );
 				else if ( params.getRandomDatabase () )
@@ -120,6 +121,7 @@ static void faindexWebBrowser ( int argc, char** argv )
 }
 static void faindexCommandLine ( const string& database )
 {
+	importCompressedDatabase ( database );
 	create_database_files ( database, InfoParams::instance ().getBoolValue ( "faindex_parallel", false ) );
 	cout << endl;
 	cout << "Indexed New Database: " << database << endl << endl;
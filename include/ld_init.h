@@ -99,6 +99,7 @@ public:
 	std::string getResultsFile () const { return resultsFile; }
 	std::string getNodeName () const { return nodeName; }
 	int getPID () const { return nodePID; }
+	int getPriority () const { return priority; }
 	bool getJobSignalAbort () const;
 	bool isSubmitted () const;
 	bool isRunningOrStarted () const;
@@ -124,7 +125,7 @@ class DaemonJobQueue {
 	VectorDaemonJobItem jobItems;
 	VectorDaemonJobItem cleanUpJobItems;
 	SetString activeJobKeys;
-	std::string nextSearchJobKey;
+	StringVector nextSearchJobKeys;
 	int numRunning;
 public:
 	DaemonJobQueue ();
@@ -132,7 +133,7 @@ public:
 	void setActions ( const std::string& host, int maxJobsPerUser );
 	VectorDaemonJobItem getCleanUpJobItems () const { return cleanUpJobItems; }
 	SetString getActiveJobKeys () const { return activeJobKeys; }
-	std::string getNextSearchJobKey () const { return nextSearchJobKey; }
+	StringVector getNextSearchJobKeys () const { return nextSearchJobKeys; }
 	int getNumRunning () const { return numRunning; }
 };
 
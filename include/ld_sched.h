@@ -0,0 +1,47 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libdbase                                                      *
+*                                                                             *
+*  Filename   : ld_sched.h                                                    *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Chooses the order queued Batch-Tag searches are started in.   *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __ld_sched_h
+#define __ld_sched_h
+
+#include <string>
+#include <lgen_define.h>
+
+class DaemonJobRecord {
+	std::string searchJobKey;
+	std::string projectID;
+	std::string user;			// The user's project directory
+	int priority;
+public:
+	DaemonJobRecord ( const std::string& searchJobKey, const std::string& projectID, const std::string& user, int priority ) :
+		searchJobKey ( searchJobKey ), projectID ( projectID ), user ( user ), priority ( priority ) {}
+	std::string getSearchJobKey () const { return searchJobKey; }
+	std::string getProjectID () const { return projectID; }
+	std::string getUser () const { return user; }
+	int getPriority () const { return priority; }
+};
+typedef std::vector <DaemonJobRecord> VectorDaemonJobRecord;
+typedef VectorDaemonJobRecord::size_type VectorDaemonJobRecordSizeType;
+
+StringVector getFairShareJobKeys ( const VectorDaemonJobRecord& queued, MapStringToInt userJobs, MapPairStringStringToInt hostUserJobs, const std::string& host, int maxJobsPerUser );
+
+#endif /* ! __ld_sched_h */
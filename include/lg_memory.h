@@ -23,7 +23,28 @@
 #ifndef __lg_memory_h
 #define __lg_memory_h
 
+#include <cstddef>
+#include <vector>
+
 void gen_bzero ( char* block, int size );
 void gen_bcopy ( char* source, char* dest, int size );
 
+/*
+Bump allocator for large numbers of small objects that are all freed together. The memory
+is only returned when the arena is destroyed. Allocations are aligned for any fundamental
+type.
+*/
+class GenArena {
+	std::vector <char*> blocks;
+	char* next;
+	size_t left;
+	size_t blockSize;
+	GenArena ( const GenArena& );
+	GenArena& operator= ( const GenArena& );
+public:
+	GenArena ( size_t blockSize = 1048576 );
+	~GenArena ();
+	void* allocate ( size_t size );
+};
+
 #endif /* ! __lg_memory_h */
@@ -39,6 +39,21 @@
 #include <lgen_error.h>
 #include <lgen_file.h>
 
+/*
+Access pattern hints passed to madvise when the file is mapped. On 64 bit Linux systems the whole
+file is mapped at once if mmap_whole_file is set in computer.txt. Otherwise the file is mapped in
+windows of block_size * num_blocks bytes. The other computer.txt options are:
+
+	mmap_populate	- prefault files opened with MMAP_ADVICE_WILLNEED (MAP_POPULATE).
+	mmap_hugepage	- request transparent huge pages for the mapping (MADV_HUGEPAGE).
+*/
+enum MMapAdvice {
+	MMAP_ADVICE_NORMAL,
+	MMAP_ADVICE_SEQUENTIAL,		// Scanned from start to end
+	MMAP_ADVICE_RANDOM,			// Binary searches and other random lookups
+	MMAP_ADVICE_WILLNEED		// Small, frequently accessed index files
+};
+
 template <class T> class MMapFile {
 	T* startPointer;
 	T* endPointer;
@@ -48,7 +63,11 @@ template <class T> class MMapFile {
 	GENINT64 byteMapSize;
 	GENINT64 fileSize;
 	GENINT64 mapLimit;
+	MMapAdvice advice;
+	bool populate;
+	bool hugepage;
 	//void printSystemInfo ();
+	void setAdvice ();
 	void createView ( GENINT64 startOffset, GENINT64 endOffset = 0 );
 	void newView ( GENINT64 startOffset, GENINT64 endOffset = 0 );
 #ifdef VIS_C
@@ -58,7 +77,7 @@ template <class T> class MMapFile {
 	int fd;
 #endif
 public:
-	MMapFile ( const std::string& name, GENINT64 startOffset = 0, GENINT64 mapLimit = 0 );
+	MMapFile ( const std::string& name, GENINT64 startOffset = 0, GENINT64 mapLimit = 0, MMapAdvice advice = MMAP_ADVICE_NORMAL );
 	~MMapFile ();
 	T& subscript ( GENINT64 index )
 	{
@@ -85,7 +104,8 @@ public:
 	GENINT64 getFileSize () const { return fileSize; }
 };
 template <class T>
-MMapFile<T>::MMapFile ( const std::string& name, GENINT64 startOffset, GENINT64 mapLimit )
+MMapFile<T>::MMapFile ( const std::string& name, GENINT64 startOffset, GENINT64 mapLimit, MMapAdvice advice ) :
+	advice ( advice )
 {
 #ifdef VIS_C
 	hFile = CreateFile ( name.c_str (), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, 0 );
@@ -100,10 +120,17 @@ MMapFile<T>::MMapFile ( const std::string& name, GENINT64 startOffset, GENINT64
 	nvs.getValue ( "block_size", granularity );
 	int numBlocks;
 	nvs.getValue ( "num_blocks", numBlocks );
+	populate = nvs.getBoolValue ( "mmap_populate", false );
+	hugepage = nvs.getBoolValue ( "mmap_hugepage", false );
 
 	if ( mapLimit == 0 ) {
 		mapLimit = granularity * numBlocks;
 	}
+#ifndef VIS_C
+	if ( sizeof (void*) == 8 && nvs.getBoolValue ( "mmap_whole_file", false ) ) {	// The address space is large enough to map the whole file so there are no remaps
+		mapLimit = genMax ( mapLimit, fileSize );
+	}
+#endif
 	this->mapLimit = mapLimit;
 	createView ( startOffset );
 }
@@ -141,11 +168,16 @@ void MMapFile<T>::createView ( GENINT64 startOffset, GENINT64 endOffset )
 	startPointer = (T*)MapViewOfFile ( hmmf, FILE_MAP_READ, high32, low32, byteMapSize );
 	if ( startPointer == NULL ) ErrorHandler::genError ()->error ( "MapViewOfFile failed in MMapFile" );
 #else
+	int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+	if ( populate && advice == MMAP_ADVICE_WILLNEED ) flags |= MAP_POPULATE;
+#endif
 	ErrorHandler::genError ()->resetErrorNumber ();
-	startPointer = (T*) mmap ( 0, byteMapSize, PROT_READ, MAP_SHARED, fd, byteMapStart );	// addr, len, prot, flags, fd, off
+	startPointer = (T*) mmap ( 0, byteMapSize, PROT_READ, flags, fd, byteMapStart );	// addr, len, prot, flags, fd, off
 	if ( ErrorHandler::genError ()->getErrorNumber () != 0 ) {
 		ErrorHandler::genError ()->error ( "Memory page mapping (mmap) failure.\n" );
 	}
+	setAdvice ();
 #endif
 	mapStart = byteMapStart / sizeof (T);
 	GENINT64 mapSize = byteMapSize /  sizeof (T);
@@ -153,6 +185,20 @@ void MMapFile<T>::createView ( GENINT64 startOffset, GENINT64 endOffset )
 	endPointer = startPointer + ( mapSize - 1 );
 }
 template <class T>
+void MMapFile<T>::setAdvice ()
+{
+#ifndef VIS_C
+	int adv = MADV_NORMAL;
+	if ( advice == MMAP_ADVICE_SEQUENTIAL )		adv = MADV_SEQUENTIAL;
+	else if ( advice == MMAP_ADVICE_RANDOM )	adv = MADV_RANDOM;
+	else if ( advice == MMAP_ADVICE_WILLNEED )	adv = MADV_WILLNEED;
+	if ( adv != MADV_NORMAL ) madvise ( (void*) startPointer, byteMapSize, adv );	// The hints are only advisory so failures are ignored
+#ifdef MADV_HUGEPAGE
+	if ( hugepage ) madvise ( (void*) startPointer, byteMapSize, MADV_HUGEPAGE );
+#endif
+#endif
+}
+template <class T>
 void MMapFile<T>::newView ( GENINT64 startIndex, GENINT64 endIndex )
 {
 #ifdef VIS_C
@@ -23,7 +23,10 @@
 #ifndef __lgen_reg_exp_h
 #define __lgen_reg_exp_h
 
+#include <map>
 #include <string>
+#include <vector>
+#include <lgen_define.h>
 
 class RegularExpression {
 protected:
@@ -81,6 +84,7 @@ public:
 	const char* getLoc1 () const { return loc1; }
 	int getNErr () const { return nerr; }
 	void resetMulti () { sameString = false; }
+	friend class RegularExpressionDFA;
 };
 
 
@@ -93,4 +97,49 @@ public:
 	const char* errorLocation ( const char* string, bool reset );
 };
 
+/*
+Lazily built DFA used to screen strings before running the backtracking matcher. It is built
+from the compiled expression and accepts every string that the expression (or the expression
+allowing maxErrors substitutions) can match, so isPresent returning false means there is no
+match. It may also accept some strings that don't match, eg as unbounded ranges are limited
+to 20000 characters by RegularExpression, so the expression has to be run to find the match.
+Expressions using back references or word boundaries are not screened.
+*/
+class RegularExpressionDFA {
+	struct Position {
+		unsigned int charSet [8];
+		bool optional;
+		bool repeat;
+		bool substitute;
+	};
+	std::vector <Position> positions;
+	int maxErrors;
+	bool usable;
+	bool anchored;
+	bool endAnchor;
+	std::string prefix;
+	int charClass [256];
+	std::vector <unsigned char> classChars;		// A character from each class
+	GENUINT64 startMask;
+	GENUINT64 acceptMask;
+	std::vector <GENUINT64> masks;
+	std::vector <char> stateTypes;			// Indexed like transitions
+	std::vector <int> transitions;			// Offset of the next state's row
+	std::map <GENUINT64, int> stateIndex;
+	static const int MAX_STATES;
+	static const char MATCH_STATE;
+	static const char DEAD_STATE;
+	void parse ( const RegularExpression& regExp );
+	int getBit ( int position, int errors ) const { return errors * ( positions.size () + 1 ) + position; }
+	void initCharClasses ();
+	GENUINT64 closure ( GENUINT64 mask ) const;
+	GENUINT64 nextMask ( GENUINT64 mask, unsigned char c ) const;
+	int addState ( GENUINT64 mask );
+	int getNextState ( int row, int cc );
+public:
+	RegularExpressionDFA ( const RegularExpression& regExp, int maxErrors = 0, bool ignoreStartAnchor = false );
+	bool isPresent ( const char* str );
+	bool isUsable () const { return usable; }
+};
+
 #endif /* ! __lgen_reg_exp_h */
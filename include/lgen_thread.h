@@ -0,0 +1,105 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libgen                                                        *
+*                                                                             *
+*  Filename   : lgen_thread.h                                                 *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Minimal portable thread and mutex wrappers.                   *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lgen_thread_h
+#define __lgen_thread_h
+
+#ifdef VIS_C
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __GNUC__							// Includes the mingw build which ignores __declspec(thread)
+#define GEN_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define GEN_THREAD_LOCAL __declspec(thread)
+#endif
+
+class GenMutex {
+#ifdef VIS_C
+	CRITICAL_SECTION cs;
+#else
+	pthread_mutex_t mutex;
+#endif
+	GenMutex ( const GenMutex& );
+	GenMutex& operator= ( const GenMutex& );
+public:
+	GenMutex ();
+	~GenMutex ();
+	void lock ();
+	void unlock ();
+};
+
+class GenMutexLock {
+	GenMutex& mutex;
+	GenMutexLock ( const GenMutexLock& );
+	GenMutexLock& operator= ( const GenMutexLock& );
+public:
+	GenMutexLock ( GenMutex& mutex ) : mutex ( mutex ) { mutex.lock (); }
+	~GenMutexLock () { mutex.unlock (); }
+};
+
+class GenThread {
+#ifdef VIS_C
+	HANDLE handle;
+	static DWORD WINAPI threadFunction ( LPVOID arg );
+#else
+	pthread_t handle;
+	static void* threadFunction ( void* arg );
+#endif
+	bool started;
+	GenThread ( const GenThread& );
+	GenThread& operator= ( const GenThread& );
+protected:
+	virtual void run () = 0;
+public:
+	GenThread ();
+	virtual ~GenThread ();
+	void start ();
+	void join ();
+};
+
+int genGetNumProcessors ();
+
+void genAddThreadLocalInstance ( void* p, void ( *deleter ) ( void* ) );
+void genDeleteThreadLocalInstances ();
+
+template <class T>
+void genDeleteThreadLocalInstance ( void* pp )
+{
+	T*& p = *static_cast <T**> (pp);
+	delete p;
+	p = 0;
+}
+
+template <class T>
+T& genThreadLocalInstance ( T*& p )	// p should be a GEN_THREAD_LOCAL pointer. The instance is deleted when a GenThread finishes.
+{
+	if ( p == 0 ) {
+		p = new T;
+		genAddThreadLocalInstance ( &p, genDeleteThreadLocalInstance <T> );
+	}
+	return *p;
+}
+
+#endif /* ! __lgen_thread_h */
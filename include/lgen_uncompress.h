@@ -23,12 +23,64 @@
 #ifndef __lgen_uncompress_h
 #define __lgen_uncompress_h
 
+#include <fstream>
+#include <istream>
+#include <streambuf>
 #include <string>
+#include <vector>
+#include <lgen_define.h>
 
+struct z_stream_s;
+
+/*
+Decompresses a gzip file or the first entry of a zip file as it is read so that the contents
+never need to be written to disk. Uncompressed files are passed through unchanged. Seeking
+is supported for tellg and seekg but a backwards seek restarts the decompression so the
+stream is intended for sequential reading.
+*/
+class GenZIStreambuf : public std::streambuf {
+	enum Format { PLAIN, GZIP, ZIP_STORED, ZIP_DEFLATED };
+	std::string fullPath;
+	std::ifstream ist;
+	Format format;
+	z_stream_s* zs;
+	std::vector <char> inBuffer;
+	std::vector <char> outBuffer;
+	std::streamoff dataStart;		// Start of the compressed data in the file
+	GENINT64 storedSize;			// Size of a stored zip entry
+	GENINT64 storedRemaining;
+	GENINT64 pos;					// Uncompressed offset of the start of outBuffer
+	bool streamEnd;
+	void openFormat ();
+	void rewind ();
+	std::streamsize readInput ( char* buffer, std::streamsize n );
+	std::streamsize inflateBuffer ();
+	void zerror ( const std::string& err ) const;
+protected:
+	int_type underflow ();
+	pos_type seekoff ( off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in );
+	pos_type seekpos ( pos_type sp, std::ios_base::openmode which = std::ios_base::in );
+public:
+	GenZIStreambuf ( const std::string& fullPath );
+	~GenZIStreambuf ();
+	bool isCompressed () const { return format != PLAIN; }
+	void close () { ist.close (); }
+};
+
+class GenZIFStream : public std::istream {
+	GenZIStreambuf buf;
+public:
+	GenZIFStream ( const std::string& fullPath );
+	bool isCompressed () const { return buf.isCompressed (); }
+	void close () { buf.close (); }
+};
+
+GENINT64 genUncompressedFileSize ( const std::string& filename );
 std::string genUnzip ( const std::string& filename, bool deleteFile, bool createSubdirectory );
 void gen7zaUncompress ( const std::string& filename );
 bool gen7zaCreate ( const std::string& filename );
 bool gen7zaCreate ( const std::string& archiveName, const std::string& filename, const std::string& type );
-std::string genPreprocessFile ( const std::string& filename );
+std::string genPreprocessFile ( const std::string& filename, bool keepCompressed = false );
+void genUncompressFile ( const std::string& filename, const std::string& newFilename );
 
 #endif /* ! __lgen_uncompress_h */
@@ -66,6 +66,7 @@ public:
 	FastaServer* getFS () const { return fs; }
 	static void setOutputCharacter ( char ch ) { outputCharacter = ch; }
 	static void setMPI () { mpi = true; }
+	static bool getMPI () { return mpi; }
 	static void setNumDatabaseEntries ( int n ) { numDatabaseEntries = n; }
 	static void setNumSearches ( int n ) { numSearches = n; }
 	static void resetElapsedTime ( int startFraction )
@@ -34,5 +34,6 @@ public:
 };
 
 AccessionNumberMap* getAccessionNumberMap ( const std::string& database );
+bool createAccessionNumberOffsetFile ( const std::string& database );
 
 #endif /* ! __lu_acc_num_h */
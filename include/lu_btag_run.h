@@ -24,9 +24,11 @@
 #define __lu_btag_run_h
 
 class ParameterList;
+class FileSplit;
 
 void initialiseProspectorBTag ( const std::string& searchKey = "" );
 int getMSMSMaxSpectra ( ParameterList* paramList );
+void printMSMSSearchPasses ( const FileSplit& fs, int numSearches );
 void runBatchTag ( ParameterList* paramList, int numSearches, int searchNumber, const std::string& searchJobID, int startSerial );
 void joinResultsFiles ( const ParameterList* paramList, int numSearches );
 std::string getBatchTagOutputPath ( const ParameterList* params );
@@ -28,6 +28,7 @@
 #include <algorithm>
 #include <sstream>
 #include <lgen_define.h>
+#include <lu_pk_index.h>
 
 class SpecID;
 class Tolerance;
@@ -187,9 +188,9 @@ class UpdatingJavascriptMessage;
 
 class DataReader {
 	bool intensityFlag;
-	GenIFStream* ifstr;			// the input file stream
+	std::istream* ifstr;		// the input file stream
 	std::istringstream isstr;	// the input string stream
-	GenIFStream* initFStream ( const std::string& s, bool fileFlag );
+	std::istream* initFStream ( const std::string& s, bool fileFlag );
 	std::istream& initStream ( bool fileFlag );
 	virtual void readParentData ( int charge, int isotopeOffset );
 	virtual void skipParentData ();
@@ -200,9 +201,11 @@ protected:
 	int num;
 	std::streampos spos;
 	std::streampos endPos;
+	std::streampos indexPos;	// Position of the first spectrum to read found from the peak list index
 	IntVector chargeRange;
 	MapStringToInt spotNumber;
 	MapStringToStreampos mapSpecID;
+	std::string filename;		// empty if the data isn't from a file
 	void readLine ( char* ptr );
 	DataPoint* dataPoint;
 	MSMSDataPoint msmsDataPoint;
@@ -214,6 +217,11 @@ protected:
 	void readMSMSData ( MSMSDataPointVector& msmsDataPointList, int charge, int isotopeOffset );
 	bool readMSMSData ( MSMSDataPointVector& msmsDataPointList, int charge, int isotopeOffset, double mOverZ );
 	void readMSMSQuanData ( XYData& xyData, double startMass, double endMass );
+	virtual void getPeakListIndexEntries ( PeakListIndexEntryVector& entries ) {}
+	PeakListIndex* getPeakListIndex ( int format );
+	void setIndexPos ( PeakListIndex* pli, int entry );
+	void initIndexPosFromIndex ( int format, int index );
+	void initIndexPosFromScanNumber ( int format, const std::string& scanNumber );
 public:
 	DataReader ( const std::string& s, bool fileFlag, bool intensityFlag );
 	~DataReader ();
@@ -253,7 +261,17 @@ class MGFDataReader : public DataReader {
 	bool getMSMSTitleParams ( const std::string& line, std::string& spot, int& run, std::string& msmsInfo );
 	IntVector getScansFromScanLine ();
 	void initMaps ( int fraction, int chrg, const std::string& version, UpdatingJavascriptMessage* ujm );
+	void initMaps ( PeakListIndex* pli, int fraction, bool readRT, UpdatingJavascriptMessage* ujm );
+	void addToMaps ( const std::string& line, int fraction, bool readRT, UpdatingJavascriptMessage* ujm );
+	static bool isScanNumber ( std::string msmsInfo, const std::string& scanNumber );
+	bool getTitleLine ( std::streampos sp, std::string& line );
+	void readSpectrum ( MSMSDataPointVector& msmsDataPointList, std::streampos sp, int chrg );
+	bool getDataFromTitle ( PeakListIndex* pli, MSMSDataPointVector& msmsDataPointList, const std::string& title, int chrg );
+	bool getDataFromMOverZ ( PeakListIndex* pli, MSMSDataPointVector& msmsDataPointList, double mOverZ, int chrg );
+	bool getDataFromScanNumber ( PeakListIndex* pli, MSMSDataPointVector& msmsDataPointList, const std::string& scanNumber, int chrg );
 	void getRTInSeconds ( std::string& rt );
+	void getPeakListIndexEntries ( PeakListIndexEntryVector& entries );
+	static void setPrecursorInfo ( PeakListIndexEntryVector& entries, PeakListIndexEntryVector::size_type start, double mOverZ, double rt, int charge );
 public:
 	MGFDataReader ( const std::string& s, bool fileFlag );
 	void getData ( MSMSDataPointVector& msmsDataPointList, const SpecID& specID, int chrg, const std::string& version, UpdatingJavascriptMessage* ujm );
@@ -275,6 +293,7 @@ class MS2DataReader : public DataReader {
 	void parseHeaderLines ( bool bullseye, std::string& spot, int& spectrumNumber, std::string& msmsInfo, DoubleVector& mVector, IntVector& zVector );
 	bool readMSMSData ();
 	bool skipMSMSData ();
+	void getPeakListIndexEntries ( PeakListIndexEntryVector& entries );
 public:
 	MS2DataReader ( const std::string& s, bool fileFlag );
 	void getData ( MSDataPointVector& msDataPointList, int fraction, const SpecID& specID ) {}
@@ -289,6 +308,7 @@ class APLDataReader : public DataReader {
 	void parseHeaderLines ( std::string& spot, int& spectrumNumber, std::string& msmsInfo, DoubleVector& mVector, IntVector& zVector );
 	bool readMSMSData ();
 	bool skipMSMSData ();
+	void getPeakListIndexEntries ( PeakListIndexEntryVector& entries );
 public:
 	APLDataReader ( const std::string& s, bool fileFlag );
 	void getData ( MSDataPointVector& msDataPointList, int fraction, const SpecID& specID ) {}
@@ -0,0 +1,96 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_dig_cache.h                                                *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Cache of database digests shared between the serial searches  *
+*               of a Batch-Tag job.                                           *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_dig_cache_h
+#define __lu_dig_cache_h
+
+#include <map>
+#include <string>
+#include <fstream>
+#include <lgen_define.h>
+#include <lgen_thread.h>
+
+template <class T> class MMapFile;
+class FrameIterator;
+
+class DigestCacheKey {
+	int database;
+	int entry;
+	int frameTranslation;
+	int frame;
+public:
+	DigestCacheKey ( int database, const FrameIterator& fi );
+	bool operator< ( const DigestCacheKey& rhs ) const
+	{
+		if ( database != rhs.database )					return database < rhs.database;
+		if ( entry != rhs.entry )						return entry < rhs.entry;
+		if ( frameTranslation != rhs.frameTranslation )	return frameTranslation < rhs.frameTranslation;
+		return frame < rhs.frame;
+	}
+};
+
+/*
+The cache holds the cleavage indicies and the unlimited fragment masses of each reading
+frame digested by the first serial search. Each record is laid out as
+
+	int numFragments, int frameLength, double mass [numFragments], int cleavageIndex [numFragments]
+
+Records are packed into large memory blocks until the memory limit is reached. Further
+records are written to a spill file which is memory mapped when the cache is frozen.
+Records are only added before the cache is frozen and only read afterwards so reads
+need no locking.
+*/
+class DigestCache {
+	struct Record {
+		const char* data;
+		GENINT64 spillOffset;
+		Record ( const char* data, GENINT64 spillOffset ) :
+			data ( data ),
+			spillOffset ( spillOffset ) {}
+	};
+	typedef std::map <DigestCacheKey, Record> RecordMap;
+	typedef RecordMap::iterator RecordMapIterator;
+	typedef RecordMap::const_iterator RecordMapConstIterator;
+	RecordMap records;
+	CharPtrVector blocks;
+	int blockUsed;
+	GENINT64 memoryUsed;
+	GENINT64 maxMemory;
+	std::string spillFile;
+	std::ofstream* spill;
+	GENINT64 spillSize;
+	MMapFile <char>* spillMap;
+	bool building;
+	GenMutex mutex;
+	static const int BLOCK_SIZE;
+	char* allocate ( int size );
+public:
+	DigestCache ( const std::string& spillFile, GENINT64 maxMemory );
+	~DigestCache ();
+	bool getBuilding () const { return building; }
+	void add ( int database, const FrameIterator& fi, int frameLength, const IntVector& cleavageIndex, const DoubleVector& mass );
+	bool get ( int database, const FrameIterator& fi, int frameLength, int& numFragments, const int*& cleavageIndex, const double*& mass ) const;
+	void freeze ();
+};
+
+#endif /* ! __lu_dig_cache_h */
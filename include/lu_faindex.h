@@ -26,6 +26,7 @@
 class FastaServer;
 
 void create_new_database_from_indicies_list ( FastaServer* fs, const std::string& database, const std::string& subDatabaseID, const IntVector& indicies );
+void importCompressedDatabase ( const std::string& database );
 void create_database_files ( const std::string& file_name, bool parallel );
 void add_single_database_entry ( const std::string& filename, const std::string& protein, const std::string& name, const std::string& species, const std::string& accession_number );
 std::string dna_database_to_protein_database ( const std::string& database, bool delete_dna_database );
@@ -49,6 +49,7 @@ namespace FileTypes {
 	const std::string DOC = "doc";
 	const std::string DOCX = "docx";
 	const std::string GZ = "gz";
+	const std::string ZIP = "zip";
 	const std::string Z = "z";
 	const std::string BZ2 = "bz2";
 	const std::string Z7 = "7z";
@@ -93,5 +94,6 @@ bool isSPTXTFile ( const std::string& fullPath );
 bool isPDFFile ( const std::string& fullPath );
 bool isBSCFile ( const std::string& fullPath );
 bool isCompressedUpload ( const std::string& fullPath );
+std::string getUncompressedFilename ( const std::string& fullPath );
 
 #endif /* ! __lu_file_type_h */
@@ -0,0 +1,79 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_frag_index.h                                               *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Inverted index from fragment ion mass to the spectra          *
+*               containing a matching peak.                                   *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_frag_index_h
+#define __lu_frag_index_h
+
+#include <string>
+#include <vector>
+#include <lgen_define.h>
+#include <lu_mass.h>
+
+class MSMSSearch;
+
+class FragmentIonMatches {		// Per search thread counts of the ions shared by a peptide and the spectra in its precursor window
+	friend class FragmentIonIndex;
+	int first;
+	int last;
+	int minMatches;
+	IntVector sharedIons;
+public:
+	FragmentIonMatches () :
+		first ( 0 ),
+		last ( 0 ),
+		minMatches ( 0 ) {}
+	bool isCandidate ( int i ) const
+	{
+		if ( i < first || i >= last ) return true;
+		return sharedIons [i-first] >= minMatches;
+	}
+};
+
+/*
+Each backbone ion tag of each spectrum is posted to every bin its tolerance window overlaps.
+The postings in a bin are in spectrum order so the spectra in a precursor window form a
+contiguous range. A peptide's N and C terminal ion ladders are calculated once and each ion
+is looked up in a single bin to count the ions it shares with all the spectra in the window.
+Spectra sharing fewer than minMatches ions are not passed to the full scoring functions.
+The binning can only overestimate the number of shared ions.
+*/
+class FragmentIonIndex {
+	MassType minMass;
+	MassType binWidth;
+	int numBins;
+	int minMatches;
+	IntVector nBinStart;
+	IntVector nPostings;
+	IntVector cBinStart;
+	IntVector cPostings;
+	DoubleVector parentMassMinusPosTolerance;
+	void initBins ( const std::vector <MassTypeVector>& tag, const std::vector <MassTypeVector>& tol, IntVector& binStart, IntVector& postings );
+	int getBin ( MassType m ) const { return ( m - minMass ) / binWidth; }
+	void countIon ( MassType m, const IntVector& binStart, const IntVector& postings, FragmentIonMatches& fim ) const;
+public:
+	FragmentIonIndex ( const std::vector <MassTypeVector>& nTag, const std::vector <MassTypeVector>& nTol, const std::vector <MassTypeVector>& cTag, const std::vector <MassTypeVector>& cTol, const DoubleVector& parentMassMinusPosTolerance, int minMatches );
+	void getMatches ( const std::string& peptide, int first, double molWt, FragmentIonMatches& fim ) const;
+	static FragmentIonIndex* create ( const std::vector <MSMSSearch*>& msMSSearch );
+};
+
+#endif /* ! __lu_frag_index_h */
@@ -0,0 +1,57 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_frag_simd.h                                                *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Vectorized comparison of a theoretical fragment ion mass      *
+*               against a block of peaks.                                     *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_frag_simd_h
+#define __lu_frag_simd_h
+
+#include <string>
+#include <lu_mass.h>
+
+const int FRAG_SIMD_BLOCK_SIZE = 32;	// Maximum number of peaks compared in one call
+const int FRAG_SIMD_PADDING = 8;		// Arrays must be readable this far past the last peak
+
+/*
+The functions compare the ion against n peaks ( n <= FRAG_SIMD_BLOCK_SIZE ) and return a
+mask with bit i set if the test is true for peak i. The comparisons are done with integer
+arithmetic so the results are identical whichever implementation is selected at run time.
+
+fragMatchMask		- genAbsDiff ( ion, tag [i] ) < tol [i]
+fragGreaterMask		- ion > max [i]
+*/
+unsigned int fragMatchMask ( MassType ion, const MassType* tag, const MassType* tol, int n );
+unsigned int fragGreaterMask ( MassType ion, const MassType* max, int n );
+const char* getFragSIMDName ();
+bool setFragSIMD ( const std::string& name );	// "scalar", "SSE2" or "AVX2". Returns false if not available.
+
+inline unsigned int fragMaskLowBits ( int n )
+{
+	return ( n >= 32 ) ? 0xffffffff : ( 1U << n ) - 1;
+}
+inline int fragMaskCount ( unsigned int mask )
+{
+	int n = 0;
+	for ( ; mask ; mask &= mask - 1 ) n++;
+	return n;
+}
+
+#endif /* ! __lu_frag_simd_h */
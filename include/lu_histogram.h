@@ -72,12 +72,27 @@ public:
 	double getTailPercent () const { return tailPercent; }
 };
 
+/*
+The scores are counted in fixed width bins rather than stored so the memory use doesn't depend
+on the number of peptides scored. The bins are initially one score unit (1/SCORE_TYPE_MULTIPLIER)
+wide so the expectation values are the same as if the scores were stored. If the score range
+needs more than MAX_BINS bins the bin width is doubled until it fits.
+*/
 class SurvivalHistogram : public Histogram {
 	mutable XYData xySurv;
 	mutable int numSpectra;
 	mutable double b;
 	mutable double a;
+	UIntVector counts;
+	int binStart;					// Score units at the start of the first bin
+	int binShift;					// The bins are 2^binShift score units wide
+	static const int MAX_BINS;
 	void compute ( int numSavedPeptides ) const;
+	void makeSurvivalHistogram ( GENINT64 n ) const;
+	void getMoments ( GENINT64 n, double& mean, double& sdev, double& var ) const;
+	double getBinValue ( UIntVectorSizeType i ) const;
+	void addScore ( int score, unsigned int count );
+	void resizeBins ( int score, int minShift );
 	static std::string expectationMethod;
 	static int minUsedPeptides;
 	static double tailPercent;
@@ -88,24 +103,13 @@ public:
 	virtual ~SurvivalHistogram ();
 	void printHTML ( std::ostream& os, double score, int numSavedPeptides ) const;
 	void printXML ( std::ostream& os, int numSavedPeptides ) const;
-	bool addValue ( const double x )
-	{
-		if ( sizeLimit == 0 ) {		// Just add up the number of spectra
-			size++;
-			return true;
-		}
-		if ( size < sizeLimit ) {
-			val.push_back ( x );
-			size++;
-			return true;
-		}
-		return false;
-	}
+	bool addValue ( const double x );
 	static void setExpectationMethod ( const std::string& method )
 	{
 		expectationMethod = method;
 	}
 	int getSize () const { return size; }
+	bool merge ( const SurvivalHistogram& rhs );
 	void init ( int numSavedPeptides ) const;
 	double getEValue ( double score ) const;
 	bool getEValueFlag () const { return a != 0.0; }
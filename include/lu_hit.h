@@ -80,6 +80,7 @@ public:
 	}
 	std::string getAccessionNumber () const;
 	bool isDecoy () const;
+	void setFastaServer ( FastaServer* f ) { fs = f; }
 	static void addFS ( const FastaServer* fs, int num );
 	static void reset ();
 };
@@ -27,6 +27,7 @@
 #include <lu_db_srch.h>
 
 class MSHomologyParameters;
+class SequenceTagMatcher;
 
 class HomologyHit : public ProteinHit {
 	std::string sequence;
@@ -40,11 +41,11 @@ class HomologyHit : public ProteinHit {
 	mutable bool scoreSet;
 	static int numPreviousAA;
 	static int numNextAA;
-	std::string getPreviousAA ( const char* protein ) const;
-	std::string getNextAA () const;
+	static std::string getPreviousAA ( const char* protein, const char* loc1 );
+	static std::string getNextAA ( const char* loc2 );
 public:
 	double proteinScore;
-	HomologyHit ( FastaServer* fs, int index, int dnaReadingFrame, int openReadingFrame, const char* protein, const std::string& measuredSequence, int sequenceSet, int numSubstitutions );
+	HomologyHit ( FastaServer* fs, int index, int dnaReadingFrame, int openReadingFrame, const char* protein, const SequenceTagMatcher& matcher, int hitNumber );
 	void printHTMLHeader ( std::ostream& os ) const;
 	void printDelimitedHeader ( std::ostream& os ) const;
 	void printHTML ( std::ostream& os, bool newProtein ) const;
@@ -133,25 +134,36 @@ public:
 
 	void calculateScores ( int minMatches, const std::string& scoreMatrix );
 	void addHit ( const HomologyHit& hit ) { peptideHits.push_back ( hit ); }
+	void merge ( const HomologyHits& rhs )
+		{ peptideHits.insert ( peptideHits.end (), rhs.peptideHits.begin (), rhs.peptideHits.end () ); }
 
 	bool differentProteins ( int num1, int num2 ) const
 		{ return peptideHits [num1].getIndex () != peptideHits [num2].getIndex (); }
 	int peptideHitsSize () const { return peptideHits.size (); }
 };
 
+class FrameIterator;
+
 class HomologySearch : public DatabaseSearch {
+	friend class HomologySearchThread;
 	HomologyHits* homologyHits;
+	SequenceTagMatcher* matcher;
 	const MSHomologyParameters& homologyParams;
 	int maxPeptideHits;
+	int numThreads;
 	void sequenceSearch ();
 	void doSearch ( FastaServer* fsPtr, int i );
-	void add_hit ( FastaServer* fs, int index, int dnaReadingFrame, int openReadingFrame, char* protein );
+	void doThreadedSearch ( FastaServer* fsPtr, int num );
+	void frameSearch ( FastaServer* fs, const FrameIterator& fi, char* reading_frame, SequenceTagMatcher& tagMatcher, HomologyHits& hits ) const;
+	void add_hit ( FastaServer* fs, const FrameIterator& fi, char* protein, const SequenceTagMatcher& tagMatcher, HomologyHits& hits ) const;
+	void checkNumPeptideHits ( const HomologyHits& hits ) const;
 	void printParamsBodyHTML ( std::ostream& os ) const;
 	void printHTMLHitsTable ( std::ostream& os ) const;
 	void printDelimitedHits ( std::ostream& os ) const;
 	void printXMLHits ( std::ostream& os ) const;
 public:
 	HomologySearch ( const MSHomologyParameters& params );
+	~HomologySearch ();
 };
 
 #endif /* ! __lu_hom_srch_h */
@@ -38,7 +38,7 @@ typedef ElementVector::size_type ElementVectorSizeType;
 struct IsotopicDistributionComponent {
 	double probability;
 	double massOffset;
-	std::string formula;
+	int isotopeAtomsIndex;	// Start of the isotope atom counts for fine structure components, -1 otherwise
 };
 
 typedef std::vector <IsotopicDistributionComponent> IsotopicDistributionComponentVector;
@@ -47,6 +47,8 @@ typedef IsotopicDistributionComponentVector::size_type IsotopicDistributionCompo
 class IsotopicDistribution {
 	ElementalFormula elementalFormula;
 	std::vector <IsotopicDistributionComponent> isotopicDistributionComponent;
+	IntVector componentIsotopeAtoms;
+	int numIsotopeAtoms;
 	double monoisotopicMass;
 	double idealMonoisotopicMass;
 	double idealMonoisotopicMZ;
@@ -55,6 +57,7 @@ class IsotopicDistribution {
 	bool noDistribution;
 	bool monoisotopicPeakTooSmall;
 	double probabilityLimit;
+	bool fineStructure;
 	double totalAbundance;
 
 	std::vector <Element> elements;
@@ -71,10 +74,11 @@ class IsotopicDistribution {
 
 	void calcIsotopeDistributionComponent ( int elementNumber, int isotopeNumber, double probability );
 	void addIsotropicDistributionComponent ( double probability );
+	bool calcAggregatedDistribution ();
 public:
-	IsotopicDistribution ( ElementalFormula& ef, int charge, double probabilityLimit );
-	IsotopicDistribution ( const std::string& eFormula, int charge, double probabilityLimit );
-	IsotopicDistribution ( double mOverZ, int charge, const std::string& averagineFormulaStr, double probabilityLimit );
+	IsotopicDistribution ( ElementalFormula& ef, int charge, double probabilityLimit, bool fineStructure = false );
+	IsotopicDistribution ( const std::string& eFormula, int charge, double probabilityLimit, bool fineStructure = false );
+	IsotopicDistribution ( double mOverZ, int charge, const std::string& averagineFormulaStr, double probabilityLimit, bool fineStructure = false );
 	~IsotopicDistribution ();
 	void createIsotopicDistribution ( ElementalFormula& f );
 	bool getNoDistribution () const { return noDistribution; }
@@ -84,35 +88,38 @@ public:
 	int getCharge () const { return charge; }
 	double getIdealMonoisotopicMass () const { return idealMonoisotopicMass; }
 	double getIdealMonoisotopicMZ () const { return idealMonoisotopicMZ; }
+	std::string getFormula ( const IsotopicDistributionComponent& idc ) const;
 	friend class IsotopicDistributionConstIterator;
 };
 
 class IsotopicDistributionConstIterator {
+	const IsotopicDistribution* isotopicDistribution;
 	const IsotopicDistributionComponentVector& isotopicDistributionComponent;
 	IsotopicDistributionComponentVectorSizeType cur;
 public:
 	IsotopicDistributionConstIterator ( const IsotopicDistribution* isotopicDistribution ) :
+		isotopicDistribution ( isotopicDistribution ),
 		isotopicDistributionComponent ( isotopicDistribution->isotopicDistributionComponent ),
 		cur ( 0 ) {}
 	const double& probability () const { return isotopicDistributionComponent [cur].probability;}
 	const double& massOffset () const { return isotopicDistributionComponent [cur].massOffset;}
-	const std::string& formula () const { return isotopicDistributionComponent [cur].formula;}
+	std::string formula () const { return isotopicDistribution->getFormula ( isotopicDistributionComponent [cur] );}
 	bool more () const { return cur < isotopicDistributionComponent.size (); }
 	void advance () { cur++; }
 };
 
 class IsotopePeakStats : public IsotopicDistribution {
-	static const double DEFAULT_PROBABILITY_LIMIT;
-	static const std::string DEFAULT_AVERAGINE_FORMULA;
 	DoubleVector averageMass;
 	DoubleVector totalProbability;
 	DoubleVector maximumProbability;
 	IntVector numComponents;
 	void createIsotopePeakStats ();
 public:
-	IsotopePeakStats ( ElementalFormula& ef, int charge, double probabilityLimit = DEFAULT_PROBABILITY_LIMIT );
-	IsotopePeakStats ( const std::string& eFormula, int charge, double probabilityLimit = DEFAULT_PROBABILITY_LIMIT );
-	IsotopePeakStats ( double mOverZ, int charge, const std::string& averagineFormulaStr = DEFAULT_AVERAGINE_FORMULA, double probabilityLimit = DEFAULT_PROBABILITY_LIMIT );
+	static const double DEFAULT_PROBABILITY_LIMIT;
+	static const std::string DEFAULT_AVERAGINE_FORMULA;
+	IsotopePeakStats ( ElementalFormula& ef, int charge, double probabilityLimit = DEFAULT_PROBABILITY_LIMIT, bool fineStructure = false );
+	IsotopePeakStats ( const std::string& eFormula, int charge, double probabilityLimit = DEFAULT_PROBABILITY_LIMIT, bool fineStructure = false );
+	IsotopePeakStats ( double mOverZ, int charge, const std::string& averagineFormulaStr = DEFAULT_AVERAGINE_FORMULA, double probabilityLimit = DEFAULT_PROBABILITY_LIMIT, bool fineStructure = false );
 	int size () const { return averageMass.size (); }
 	double getStartMass () const { return size () ? averageMass.front () : 0.0; }
 	double getEndMass () const { return size () ? averageMass.back () : 0.0; }
@@ -126,6 +133,21 @@ public:
 	friend class IsotopePeakStatsConstIterator;
 };
 
+/*
+Process wide cache of isotope distributions. The distributions are shared so must not be
+modified and each one obtained must be handed back with release. The least recently used
+distributions that are not in use are deleted once the cache holds more than
+isotope_cache_size entries. Averagine distributions are calculated at the centre of a
+0.01 Da mass bin.
+*/
+class IsotopePeakStatsCache {
+	static const IsotopePeakStats* get ( const std::string& eFormula, int averagineBin, int charge, double probabilityLimit );
+public:
+	static const IsotopePeakStats* getIsotopePeakStats ( const std::string& eFormula, int charge, double probabilityLimit = IsotopePeakStats::DEFAULT_PROBABILITY_LIMIT );
+	static const IsotopePeakStats* getAveragineIsotopePeakStats ( double mOverZ, int charge );
+	static void release ( const IsotopePeakStats* ips );
+};
+
 class IsotopePeakStatsConstIterator {
 	const DoubleVector& averageMassList;
 	const DoubleVector& totalProbabilityList;
@@ -150,20 +172,20 @@ public:
 class IsotopeProfile : public XYData {
 protected:
 	static bool detailed;
+	static void getProfilePeaks ( std::vector <IsotopePeakStats*>& ips, const DoubleVector& intensity, DoubleVector& mass, DoubleVector& height );
+	static void getProfileXValues ( double startX, double endX, double step, DoubleVector& x );
+	static DoubleVectorSizeType getFirstProfileIndex ( const DoubleVector& x, double startX );
+	void addProfile ( const DoubleVector& x, const DoubleVector& y );
 public:
 	static void getStartAndEndMass ( std::vector <IsotopePeakStats*>& ips, double& startMass, double& endMass );
 	static double getStep ( double step, double resolution, double mass );
 	static void setDetailed ( bool d ) { detailed = d; }
 };
 class GaussianIsotopeProfile : public IsotopeProfile {
-	void simpleProfile ( double twoSDSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y );
-	void detailedProfile ( double twoSDSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y );
 public:
 	GaussianIsotopeProfile ( std::vector <IsotopePeakStats*>& ips, const DoubleVector& intensity, double resolution );
 };
 class LorentzianIsotopeProfile : public IsotopeProfile {
-	void simpleProfile ( double beta, double betaSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y );
-	void detailedProfile ( double beta, double betaSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y );
 public:
 	LorentzianIsotopeProfile ( std::vector <IsotopePeakStats*>& ips, const DoubleVector& intensity, double resolution );
 };
@@ -0,0 +1,112 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_ms1_store.h                                                *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Binary store of the MS scans from an mzML file for raw data   *
+*               access.                                                       *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_ms1_store_h
+#define __lu_ms1_store_h
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <nr.h>
+#include <lgen_define.h>
+
+template <class T> class MMapFile;
+
+struct MS1ScanStoreHeader {
+	char magic [8];
+	int version;
+	int pad;
+	GENINT64 fileSize;		// Size and modification time of the mzML file
+	GENINT64 modifyTime;
+	GENINT64 numMS1Scans;
+	GENINT64 numMSMSScans;
+	GENINT64 tableOffset;	// Start of the MS1ScanStoreScan records
+};
+
+struct MS1ScanStoreScan {
+	double rt;				// Minutes
+	GENINT64 offset;		// Start of the m/z values, the float intensities follow
+	int scan;
+	int numPeaks;
+};
+
+struct MS1ScanStoreMSMSScan {
+	int scan;
+	int ms1Index;			// Index of the preceding MS scan in RT order
+};
+
+typedef std::vector <MS1ScanStoreScan> MS1ScanStoreScanVector;
+typedef std::vector <MS1ScanStoreMSMSScan> MS1ScanStoreMSMSScanVector;
+
+/*
+The store is written to a single file next to the mzML file (<mzML file>.ms1). It contains:
+
+	MS1ScanStoreHeader
+	For each MS scan the m/z values as doubles followed by the intensities as floats,
+	padded to a multiple of 8 bytes.
+	MS1ScanStoreScan records sorted by retention time.
+	MS1ScanStoreMSMSScan records sorted by scan number.
+
+The store is rebuilt if the size or modification time of the mzML file changes.
+*/
+class MS1ScanStoreWriter {
+	std::string mzMLFile;
+	std::string tempFile;
+	std::ofstream ost;
+	GENINT64 offset;
+	MS1ScanStoreScanVector ms1Scans;
+	MS1ScanStoreMSMSScanVector msmsScans;
+	std::map <int, int> ms1ScanIndex;
+public:
+	MS1ScanStoreWriter ( const std::string& mzMLFile );
+	~MS1ScanStoreWriter ();
+	void addMS1Scan ( int scan, double rt, const DoubleVector& mz, const DoubleVector& intensity );
+	void addMSMSScan ( int scan, int precursorScan );
+	void write ();
+};
+
+class MS1ScanStore {
+	MMapFile <char>* file;
+	const char* data;
+	MS1ScanStoreScanVector ms1Scans;
+	MS1ScanStoreMSMSScanVector msmsScans;
+	static const char* MAGIC;
+	static const int VERSION;
+	static bool checkHeader ( const std::string& mzMLFile );
+	void addScan ( int index, double startMass, double endMass, DoubleVector& x, DoubleVector& y, bool first ) const;
+public:
+	MS1ScanStore ( const std::string& mzMLFile );
+	~MS1ScanStore ();
+	int size () const { return ms1Scans.size (); }
+	double getRT ( int index ) const { return ms1Scans [index].rt; }
+	int getMS1Index ( int scan ) const;
+	void getXYData ( XYData& xyData, int index, int numScans, double startMass = 0.0, double endMass = 0.0 ) const;
+
+	static void initHeader ( MS1ScanStoreHeader& header, const std::string& mzMLFile );
+	static std::string getStoreFilename ( const std::string& mzMLFile ) { return mzMLFile + ".ms1"; }
+	static MS1ScanStore* getStore ( const std::string& mzMLFile );
+	friend class MS1ScanStoreWriter;
+};
+
+#endif /* ! __lu_ms1_store_h */
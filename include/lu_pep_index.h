@@ -0,0 +1,87 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_pep_index.h                                                *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Precomputed, mass sorted index of the enzyme cleavage         *
+*               products of a database.                                       *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_pep_index_h
+#define __lu_pep_index_h
+
+#include <string>
+#include <lgen_define.h>
+#include <lu_mass.h>
+
+template <class T> class MMapFile;
+class FastaServer;
+
+struct PeptideIndexEntry {
+	double mass;			// Peptide mass including the terminal groups and cation
+	GENINT64 seqOffset;		// Offset of the sequence in the .pxs file
+	int index;				// Database entry serial number
+	int start;				// Zero based start position in the protein
+	unsigned short length;
+	char previousAA;		// '-' for protein N-terminus
+	char nextAA;			// '-' for protein C-terminus
+};
+
+struct PeptideIndexHeader {
+	char magic [8];
+	int version;
+	int missedCleavages;
+	double maxMass;
+	double terminalWt;
+	double aaWt [AA_ARRAY_SIZE];
+	GENINT64 numEntries;
+	GENINT64 databaseTime;
+	char enzyme [64];
+};
+
+/*
+The index is held in three files in the seqdb directory:
+
+	.pxh - header recording the enzyme, missed cleavages and amino acid masses used.
+	.pix - PeptideIndexEntry records sorted by mass.
+	.pxs - concatenated peptide sequences.
+
+The masses depend on the amino acid masses (monoisotopic/average, constant modifications)
+so the base name includes a hash of these.
+*/
+class PeptideMassIndex {
+	MMapFile <PeptideIndexEntry>* entries;
+	MMapFile <char>* sequences;
+	GENINT64 numEntries;
+	static const char* MAGIC;
+	static const int VERSION;
+	static void initHeader ( PeptideIndexHeader& header, FastaServer* fs, const std::string& enzyme, int missedCleavages, double maxMass );
+	static bool checkHeader ( const std::string& baseName, const PeptideIndexHeader& header );
+public:
+	PeptideMassIndex ( const std::string& baseName );
+	~PeptideMassIndex ();
+	GENINT64 size () const { return numEntries; }
+	PeptideIndexEntry getEntry ( GENINT64 i ) const;
+	GENINT64 lowerBound ( double mass ) const;
+	std::string getSequence ( const PeptideIndexEntry& entry ) const;
+
+	static std::string getBaseName ( FastaServer* fs, const std::string& enzyme, int missedCleavages );
+	static void create ( FastaServer* fs, const std::string& enzyme, int missedCleavages, double maxMass );
+	static PeptideMassIndex* getIndex ( FastaServer* fs, const std::string& enzyme, int missedCleavages, double maxMass );
+};
+
+#endif /* ! __lu_pep_index_h */
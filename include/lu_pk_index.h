@@ -0,0 +1,93 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_pk_index.h                                                 *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Sidecar offset index for mgf, ms2 and apl peak lists.         *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_pk_index_h
+#define __lu_pk_index_h
+
+#include <string>
+#include <vector>
+#include <lgen_define.h>
+
+class GenIFStream;
+
+struct PeakListIndexEntry {
+	GENINT64 offset;		// Position of the spectrum in the peak list (after BEGIN IONS for mgf files)
+	double mOverZ;			// Precursor m/z (the first precursor for ms2 and apl files)
+	double rt;				// RTINSECONDS for mgf files, -1 if not present
+	int scan;				// First scan number, -1 if not numeric
+	int charge;				// Precursor charge, 0 if not present
+	unsigned int titleHash;	// Hash of the mgf TITLE line, 0 for other formats
+	int pad;
+};
+
+typedef std::vector <PeakListIndexEntry> PeakListIndexEntryVector;
+
+struct PeakListIndexHeader {
+	char magic [8];
+	int version;
+	int format;
+	GENINT64 fileSize;		// Size and modification time of the indexed peak list
+	GENINT64 modifyTime;
+	GENINT64 numEntries;
+};
+
+/*
+The index is written to a single file next to the peak list (<peak list>.pli). It contains:
+
+	PeakListIndexHeader
+	PeakListIndexEntry records in file order.
+	Entry numbers sorted by scan number.
+	Entry numbers sorted by title hash.
+	Entry numbers sorted by precursor m/z.
+
+Lookups are binary searches on the file so only a few records are read for each spectrum.
+The index is rebuilt if the size or modification time of the peak list changes. Matches
+should be verified against the peak list as the scan numbers and hashes can be ambiguous.
+*/
+class PeakListIndex {
+	GenIFStream* ist;
+	GENINT64 numEntries;
+	static const char* MAGIC;
+	static const int VERSION;
+	int getOrder ( int list, GENINT64 i ) const;
+	IntVector equalRange ( int list, double key ) const;
+	static void initHeader ( PeakListIndexHeader& header, const std::string& peakList, int format );
+	static bool checkHeader ( const std::string& peakList, int format );
+public:
+	enum { MGF_FORMAT = 1, MS2_FORMAT = 2, APL_FORMAT = 3 };
+	PeakListIndex ( const std::string& peakList );
+	~PeakListIndex ();
+	GENINT64 size () const { return numEntries; }
+	PeakListIndexEntry getEntry ( GENINT64 i ) const;
+	IntVector getScanEntries ( int scan ) const;
+	IntVector getTitleEntries ( const std::string& title ) const;
+	IntVector getMOverZEntries ( double mOverZ ) const;
+
+	static double getKey ( int list, const PeakListIndexEntry& entry );
+	static std::string getIndexFilename ( const std::string& peakList ) { return peakList + ".pli"; }
+	static unsigned int getTitleHash ( const std::string& title );
+	static int getScanNumber ( const std::string& scan );
+	static void write ( const std::string& peakList, int format, const PeakListIndexEntryVector& entries );
+	static PeakListIndex* getIndex ( const std::string& peakList, int format );
+};
+
+#endif /* ! __lu_pk_index_h */
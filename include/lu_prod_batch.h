@@ -0,0 +1,50 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_prod_batch.h                                               *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Runs a batch of MS-Product searches within the calling        *
+*               program.                                                      *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_prod_batch_h
+#define __lu_prod_batch_h
+
+#include <string>
+#include <lgen_define.h>
+
+/*
+The searches are queued as they are reported and run at the end of the calling program as
+MS-Product sets global state such as the amino acid masses. Each search writes its results
+file in the same way as an mssearch.cgi MS-Product run with results_to_file set. The screen
+output is discarded.
+
+On Linux the batch can be split between several processes (msproduct_num_processes in
+info.txt). Processes are used rather than threads as MS-Product is not thread safe.
+*/
+class MSProductBatch {
+	StringVector queryStrings;
+	MSProductBatch ();
+	void runSearch ( const std::string& queryString ) const;
+	void runSearches ( int first, int increment ) const;
+public:
+	static MSProductBatch& instance ();
+	void add ( const std::string& commandLineNVPairs );
+	void run ();
+};
+
+#endif /* ! __lu_prod_batch_h */
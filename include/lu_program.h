@@ -47,6 +47,7 @@ public:
 	void printTabDelimitedText ( std::ostream& os );
 	void printMGFSpectrum ( std::ostream& os );
 	static void setParams ( const ParameterList* p ) { paramList = p; };
+	static const ParameterList* getParams () { return paramList; };
 };
 
 #endif /* ! __lu_program_h */
@@ -0,0 +1,78 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_seq_pack.h                                                 *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Residue packed copy of the database sequences.                *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __lu_seq_pack_h
+#define __lu_seq_pack_h
+
+#include <string>
+#include <lgen_define.h>
+
+template <class T> class MMapFile;
+class FastaServer;
+
+struct PackedSequenceEntry {
+	GENINT64 offset;		// Word offset of the sequence in the .psq file
+	int length;				// Number of residues
+	int pad;
+};
+
+struct PackedSequenceHeader {
+	char magic [8];
+	int version;
+	int numFrames;			// 6 for DNA databases (the translated reading frames), otherwise 1
+	GENINT64 numEntries;
+	GENINT64 databaseSize;
+	GENINT64 databaseTime;
+	GENINT64 numWords;
+};
+
+/*
+The store is held in two files in the seqdb directory:
+
+	.psi - PackedSequenceHeader followed by a PackedSequenceEntry for each entry and frame.
+	.psq - the sequences packed 12 residues to a 64 bit word (5 bits per residue).
+
+Each sequence starts on a word boundary. Sequences contain no new lines so a residue can be
+decoded without looking at the rest of the entry. For DNA databases the six reading frames
+are translated when the store is created. The store is ignored if the database changes.
+*/
+class PackedSequenceStore {
+	MMapFile <PackedSequenceEntry>* entries;
+	MMapFile <GENUINT64>* words;
+	int numFrames;
+	static const char* MAGIC;
+	static const int VERSION;
+	static const int RESIDUES_PER_WORD;
+	static std::string getBaseName ( const std::string& database );
+	static void initHeader ( PackedSequenceHeader& header, const std::string& database );
+	static bool checkHeader ( const std::string& database, int numEntries );
+	static int getCode ( char aa );
+public:
+	PackedSequenceStore ( const std::string& database );
+	~PackedSequenceStore ();
+	int getSequence ( int serialNumber, int frame, char* protein, int maxLength ) const;
+
+	static void create ( FastaServer* fs );
+	static PackedSequenceStore* getStore ( const std::string& database, int numEntries );
+};
+
+#endif /* ! __lu_seq_pack_h */
@@ -86,6 +86,9 @@ public:
 	virtual bool doMatch ( const std::string& peptide, bool nTermPeptide, bool cTermPeptide, double mol_wt, TagMatchVector& tagMatch, const ScoreType& minScore );
 	virtual void printExpectationHTML ( std::ostream& os, double score, int numSavedSpectra ) {}
 	virtual void printExpectationXML ( std::ostream& os, int numSavedSpectra ) {}
+	virtual void merge ( const MSMSSearch* rhs ) {}
+	virtual void addUnscoredMatch ( const std::string& peptide ) {}
+	virtual bool getFragmentIndexTags ( MassTypeVector& nTag, MassTypeVector& nTol, MassTypeVector& cTag, MassTypeVector& cTol ) const { return false; }
 };
 typedef std::vector<MSMSSearch*>::iterator MSMSSearchIterator;
 typedef std::vector<MSMSSearch*>::const_iterator MSMSSearchConstIterator;
@@ -138,6 +141,19 @@ public:
 
 class LinkInfo;
 
+struct IonMatchTest {		// One branch of the ion type priority order used by the vectorized matching
+	const MassType* tag;
+	const MassType* tol;
+	ScoreType score;
+};
+inline void addIonMatchTest ( IonMatchTest* tests, int& n, const MassType* tag, const MassType* tol, ScoreType score )
+{
+	tests [n].tag = tag;
+	tests [n].tol = tol;
+	tests [n].score = score;
+	n++;
+}
+
 class MSTagSearch : public MSMSSearch {
 	friend class UnmatchedCompositionSearch;
 protected:
@@ -155,6 +171,13 @@ protected:
 	int numPeaks;
 	MassTypeVector fragTolerance;
 
+	int tagStride;
+	MassTypeVector nIonTagSoA;			// Structure of arrays copies of the tags used by the vectorized matching
+	MassTypeVector cIonTagSoA;
+	MassTypeVector fragToleranceSoA;	// 1, 2 and 3 times fragTolerance
+	MassTypeVector maxNFragTagSoA;
+	MassTypeVector maxCFragTagSoA;
+
 	ScoreTypeVector ionMatched;
 
 	ScoreType previousScore;
@@ -172,6 +195,11 @@ protected:
 	static void initXLVariables ( const LinkInfo* linkInfo );
 	static void initFragTagFlags ( const BiemannParameters& bp );
 	void initFragTags ();
+	void initFragTagsSoA ();
+	const MassType* getNTag ( int index ) const { return &nIonTagSoA [index*tagStride]; }
+	const MassType* getCTag ( int index ) const { return &cIonTagSoA [index*tagStride]; }
+	const MassType* getFragTol ( int charge ) const { return &fragToleranceSoA [(charge-1)*tagStride]; }
+	void matchIonTests ( MassType ion, int& start, const MassTypeVector& minTag, const MassTypeVector& maxTagSoA, const IonMatchTest* tests, int numTests );
 	void xLinkMatchCID ( const PeptideSequence& ps, double molWt, double diff );
 	void xLinkMatchCID2 ( const PeptideSequence& ps );
 	void xLinkMatchETD ( const PeptideSequence& ps, double molWt, double diff );
@@ -1359,7 +1387,6 @@ protected:
 	static unsigned int waterLossMask;
 
 	static MassType maxInternalIonMass;
-	static size_t getHistogramLimit ( const MSTagParameters& params );
 	void fMatch ( const std::string& sequence, int& numUnmatchedIons, ScoreType& score );
 	static double xLinkMass;
 	static double xLinkImmoniumMass;
@@ -1384,14 +1411,20 @@ public:
 	bool getSpectrumRetained () const { return spectrumRetained && peaks.getSpectrumRetained (); }
 	void setSpectrumRetained ( bool flag ) { spectrumRetained = flag; }
 	int getHistogramSize () const { return survHist.getSize (); }
+	void merge ( const MSMSSearch* rhs );
 	bool doMatch ( const std::string& peptide, bool nTermPeptide, bool cTermPeptide, double molWt, TagMatchVector& tagMatch, const ScoreType& minScore );
+	void addUnscoredMatch ( const std::string& peptide );
 	void printExpectationHTML ( std::ostream& os, double score, int numSavedSpectra ) { survHist.printHTML ( os, score, numSavedSpectra ); }
 	double getEvalue ( double score ) const { return survHist.getEValue ( score ); }
 	bool getEValueFlag () const { return survHist.getEValueFlag (); }
 	void printExpectationXML ( std::ostream& os, int numSavedSpectra ) { survHist.printXML ( os, numSavedSpectra ); }
 	void fragmentMatch2 ( const PeptideSequence& ps, int& numUnmatchedIons, ScoreType& score, bool reset );
+	bool getFragmentIndexTags ( MassTypeVector& nTag, MassTypeVector& nTol, MassTypeVector& cTag, MassTypeVector& cTol ) const;
 	static void setNTerminusWt ( const MassType nt ) { nTerminusWt = nt; }
 	static void setCTerminusWt ( const MassType ct ) { cTerminusWt = ct; }
+	static MassType getNTerminusWt () { return nTerminusWt; }
+	static MassType getCTerminusWt () { return cTerminusWt; }
+	static size_t getHistogramLimit ( const MSTagParameters& params );
 };
 
 class MSTagSearchAllowErrors : public MSTagSearch {
@@ -29,10 +29,13 @@
 #include <lu_mut_mtrx.h>
 #include <lu_charge.h>
 #include <lu_tag_frag.h>
+#include <lu_frag_index.h>
 
 class RegularExpression;
 class FrameIterator;
 class MSProductLink;
+class TagSearchThread;
+class DigestCache;
 
 class TagHit : public ProteinHit {
 	std::string sequence;
@@ -242,6 +245,7 @@ public:
 	void rankHits ();
 	void pruneHits ();
 	void push_back ( const T& hit );
+	void merge ( const TagHitsContainer& rhs, FastaServer* fs );
 	int size () const { return tHits.size (); }
 	int getNumPeaks () const { return peaks->size (); }
 	int getNumSavedHits () const { return numSavedHits; }
@@ -298,6 +302,7 @@ public:
 	void sortAndRank ();
 	void prune ();
 	void addHit ( const TagHit& hit, int dataSet = 0 );
+	void merge ( const TagHits& rhs, FastaServer* fs );
 
 	ScoreType getScore ( int i, int j ) const { return hits [i]->getScore ( j ); }
 	ScoreType getMinScore ( int index ) const { return hits [index]->getMinScore (); }
@@ -311,7 +316,24 @@ typedef TagHitVector::size_type TagHitVectorSizeType;
 
 typedef std::vector <RegularExpression*> RegularExpressionPtrVector;
 
+class TagSearchContext {		// The state that is modified as a database search proceeds
+public:
+	std::vector <MSMSSearch*>& msMSSearch;
+	TagHits* tagHits;
+	TagMatchVector tagMatch;
+	FragmentIonMatches fragMatches;
+	int databaseNumber;
+	TagSearchContext ( std::vector <MSMSSearch*>& msMSSearch, TagHits* tagHits ) :
+		msMSSearch ( msMSSearch ),
+		tagHits ( tagHits ),
+		databaseNumber ( 0 ) {}
+};
+
 class TagSearch : public DatabaseSearch {
+	friend class TagSearchThread;
+	int numThreads;
+	std::vector <MSMSSearch*> threadMSMSSearch;
+	void doThreadedSearch ( FastaServer* fsPtr, int num );
 protected:
 	MSTagParameters& tagParams;
 	std::vector <MSMSSearch*> msMSSearch;
@@ -319,7 +341,7 @@ protected:
 	int maxTagMatches;
 	bool randomSearch;
 	TagHits* tagHits;
-	TagMatchVector tagMatch;
+	TagSearchContext tagSearchContext;
 	unsigned int compMask;
 	bool compMaskTypeAnd;
 	bool compMaskTypeOr;
@@ -327,8 +349,8 @@ protected:
 	IntVectorVector regExpSites;
 	bool rexpFlag;
 	ModificationTable* modTable;
-	void addTagHit ( int searchNumber, const TagMatchVector& tagMatch, const std::string& sequence, const FrameIterator& fi, int previousAA, int nextAA, int startAA );
-	virtual void tag_search ( const FrameIterator& fi, const char* frame ) = 0;
+	void addTagHit ( TagHits* tagHits, int searchNumber, const TagMatchVector& tagMatch, const std::string& sequence, const FrameIterator& fi, int previousAA, int nextAA, int startAA );
+	virtual void tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc ) = 0;
 	void printParamsBodyHTML ( std::ostream& os ) const;
 	bool checkComposition ( const std::string& fragment );
 	static int getPruneInterval ( int numSearches )
@@ -358,6 +380,7 @@ protected:
 	static int missedCleavages;
 	void initNonSpecific ( const MSTagParameters& params );
 	void doNormalSearch ( FastaServer* fsPtr, int num );
+	virtual bool indexSearch ( FastaServer* fsPtr, int num ) { return false; }
 public:
 	TagSearch ( MSTagParameters& params );
 	virtual ~TagSearch ();
@@ -375,7 +398,7 @@ class NoEnzymeSearch : public TagSearch {
 	DoubleVector startMasses;
 	DoubleVector endMasses;
 protected:
-	void tag_search ( const FrameIterator& fi, const char* frame );
+	void tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc );
 public:
 	NoEnzymeSearch ( MSTagParameters& params );
 	~NoEnzymeSearch ();
@@ -385,7 +408,7 @@ class NoEnzymeIntSearch : public TagSearch {
 	IntVector startMasses;
 	IntVector endMasses;
 protected:
-	void tag_search ( const FrameIterator& fi, const char* frame );
+	void tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc );
 public:
 	NoEnzymeIntSearch ( MSTagParameters& params );
 	~NoEnzymeIntSearch ();
@@ -395,11 +418,16 @@ class YesEnzymeSearch : public TagSearch {
 	double startLimit;
 	double endLimit;
 	double cleavedLimit;
+	bool usePeptideIndex;
+	FragmentIonIndex* fragIndex;
+	static DigestCache* digestCache;
 protected:
-	void tag_search ( const FrameIterator& fi, const char* frame );
+	void tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc );
+	bool indexSearch ( FastaServer* fsPtr, int num );
 public:
 	YesEnzymeSearch ( MSTagParameters& params );
 	~YesEnzymeSearch ();
+	static void setDigestCache ( DigestCache* dc ) { digestCache = dc; }
 };
 
 #endif /* ! __lu_tag_srch_h */
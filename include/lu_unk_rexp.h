@@ -27,12 +27,55 @@
 
 class Tolerance;
 
-void initialise_regular_expression_hit_list ( const StringVector& reg_exp_hits, const IntVector& set, const IntVector& max_allow_errors, const Tolerance* massTolerance, int check_peptide_length );
-bool multi_unknome_hits_present ( char* offset );
-bool unknome_hit_present ( const char* offset );
-bool get_unknome_rexp_results ( char** measured_sequence, int* sequence_set, int* num_substitutions, bool reset );
-char* get_regular_expression_match ();
-const char* get_regular_expression_loc1 ();
-const char* get_regular_expression_loc2 ();
+/*
+Finds the possible sequences allowing each sequence its own maximum number of substitutions.
+Reading frames are first scanned with a bit-parallel (shift-add) matcher covering all the
+sequences, which marks the positions where some sequence matches. Only these positions are
+then checked sequence by sequence to choose the reported hits. The object holds all the
+search state so a separate object should be used for each thread.
+*/
+class SequenceTagMatcher {
+	StringVector hits;
+	std::vector <const char*> hitPtrs;
+	IntVector seqSet;
+	IntVector maxErrs;
+	IntVector node;				// Length of the prefix shared with the previous sequence
+	int maxNumErrs;
+	int minLen;
+	int maxLen;
+	bool checkLen;
+	IntVector sumErrors;
+	IntVector hitNumber;
+	int nhits;
+	int numErrors;
+	bool sameString;
+	const char* loc1;
+	const char* loc2;
+
+	int numWords;
+	int charIndex [256];
+	std::vector <GENUINT64> startBits;	// First position of each sequence
+	std::vector <GENUINT64> charBits;	// Positions matching each character
+	std::vector <GENUINT64> acceptBits;	// Last position of each sequence for each number of errors
+	IntVector lastBitLength;			// Sequence length if this is its last position
+	std::vector <GENUINT64> state;
+	std::vector <char> candidates;
+	const char* candidateStart;
+
+	void initFilter ();
+	void findCandidates ( const char* str, int len );
+	bool hitPresent ( const char* offset, bool sameFrame );
+public:
+	SequenceTagMatcher ( const StringVector& regExpHits, const IntVector& set, const IntVector& maxAllowErrors, const Tolerance* massTolerance, bool checkPeptideLength );
+	bool isPresentMulti ( const char* offset );
+	int getNumHits () const { return nhits; }
+	int getHitNumber ( int i ) const { return hitNumber [i]; }
+	std::string getMeasuredSequence ( int i ) const { return hits [hitNumber [i]]; }
+	int getSequenceSet ( int i ) const { return seqSet [hitNumber [i]]; }
+	int getNumSubstitutions () const { return numErrors; }
+	std::string getMatch () const { return std::string ( loc1, loc2 - loc1 ); }
+	const char* getLoc1 () const { return loc1; }
+	const char* getLoc2 () const { return loc2; }
+};
 
 #endif /* ! __lu_unk_rexp_h */
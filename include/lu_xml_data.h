@@ -130,6 +130,39 @@ public:
 	~PPExpatMZMLCountScans () {}
 };
 
+class MS1ScanStoreWriter;
+
+class PPExpatMZMLMS1Data : public PPExpat {
+	MS1ScanStoreWriter& writer;
+	bool spectrumFlag;
+	bool paramGroupFlag;
+	bool binaryDataArray;
+	bool binaryFlag;
+	bool compression;
+	bool mzArrayFlag;
+	bool intenArrayFlag;
+	int precision;
+	int index;
+	int scan;
+	int msLevel;
+	double rt;
+	int precursorScan;
+
+	std::string paramGroupID;
+	std::map <std::string, MapStringToString> paramGroups;
+	MapStringToString curParam;
+
+	DoubleVector mzList;
+	DoubleVector intensityList;
+	void startElement ( const char* name, const char** attributes );
+	void endElement ( const char* name );
+	void characterDataHandler ( const char* str, int len );
+	static int getScanNumber ( const std::string& id, int defaultScan );
+public:
+	PPExpatMZMLMS1Data ( MS1ScanStoreWriter& writer );
+	~PPExpatMZMLMS1Data ();
+};
+
 class PPExpatMZDataData : public PPExpatSpecData {
 	bool spectrumFlag;
 	bool scanFlag;
@@ -28,6 +28,7 @@
 #include <vector>
 #include <algorithm>
 #include <lgen_define.h>
+#include <lgen_thread.h>
 
 #ifdef NR_MAIN
 #define NR_EXTERN
@@ -35,7 +36,7 @@
 #define NR_EXTERN extern
 #endif
 
-NR_EXTERN int nrerrno;
+NR_EXTERN GEN_THREAD_LOCAL int nrerrno;
 #define ZBRENT_ROOT_NOT_BRACKETED 1
 #define ZBRENT_MAX_ITERATIONS_EXCEEDED 2
 
@@ -37,6 +37,7 @@
 #include <lu_repository.h>
 #include <lu_xml.h>
 #include <ld_init.h>
+#include <ld_sched.h>
 #include <my_global.h>
 #include <mysql.h>
 #include <errmsg.h>
@@ -1326,16 +1327,21 @@ void DaemonJobQueue::addItem ( const MYSQL_ROW& row )
 void DaemonJobQueue::setActions ( const string& host, int maxJobsPerUser )
 {
 	numRunning = 0;
-	nextSearchJobKey = "";
+	nextSearchJobKeys.clear ();
 	SetString projRunning;
+	MapStringToInt userJobs;
 	for ( VectorDaemonJobItem::size_type ii = 0 ; ii < jobItems.size () ; ii++ ) {	// Get a list of projects with running jobs. Only 1 job per project
 																					// can run at the same time
 		const DaemonJobItem& ji = jobItems [ii];
-		if ( ji.isRunningOrStarted () ) projRunning.insert ( ji.getProjectID () );
+		if ( ji.isRunningOrStarted () ) {
+			projRunning.insert ( ji.getProjectID () );
+			userJobs [ji.getProjDir ()]++;
+		}
 	}
 	if ( jobItems.empty () ) return;
 	IntVector runningPIDs = getProcessNumberList ();			// Get a list of all running processes
 	MapPairStringStringToInt mpssi;
+	VectorDaemonJobRecord queued;
 	for ( VectorDaemonJobItem::size_type i = 0 ; i < jobItems.size () ; i++ ) {
 		DaemonJobItem& ji = jobItems [i];
 		string searchJobID = ji.getSearchJobID ();
@@ -1344,24 +1350,7 @@ void DaemonJobQueue::setActions ( const string& host, int maxJobsPerUser )
 		bool localJob = ( nodeName == host );
 		bool notStarted = ( nodeName == "NULL" );
 		int pid = ji.getPID ();
-		bool limitPerUser = false;
-		string projDir = ji.getProjDir ();
-		if ( maxJobsPerUser ) {
-			if ( nodeName != "NULL" ) {
-				PairStringString pss = make_pair ( nodeName, projDir );
-				MapPairStringStringToIntIterator cur = mpssi.find ( pss );
-				if ( cur != mpssi.end () )	cur->second++;
-				else						mpssi [pss] = 1;
-			}
-			else {
-				PairStringString pss = make_pair ( host, projDir );
-				MapPairStringStringToIntIterator cur = mpssi.find ( pss );
-				if ( cur != mpssi.end () && cur->second >= maxJobsPerUser ) {
-					limitPerUser = true;
-				}
-			}
-
-		}
+		if ( !notStarted ) mpssi [make_pair ( nodeName, ji.getProjDir () )]++;	// Number of jobs for each user on each node
 		if ( ji.getJobSignalAbort () ) {
 			if ( localJob ) {			// Only abort searches on the local daemon
 				killProcess ( pid );	// Kill the process. Doesn't matter if it isn't running
@@ -1403,12 +1392,13 @@ void DaemonJobQueue::setActions ( const string& host, int maxJobsPerUser )
 				numRunning++;
 			}
 		}
-		else {																														// Other submitted jobs
-			if ( nextSearchJobKey.empty () && ji.isSubmitted () && !projRunning.count ( ji.getProjectID () ) && !limitPerUser ) {	// Next job in queue
-				nextSearchJobKey = searchJobKey;
+		else {												// Other submitted jobs
+			if ( ji.isSubmitted () && !projRunning.count ( ji.getProjectID () ) ) {
+				queued.push_back ( DaemonJobRecord ( searchJobKey, ji.getProjectID (), ji.getProjDir (), ji.getPriority () ) );
 			}
 		}
 	}
+	nextSearchJobKeys = getFairShareJobKeys ( queued, userJobs, mpssi, host, maxJobsPerUser );
 }
 BatchJobItem::BatchJobItem ( const MYSQL_ROW& row )
 {
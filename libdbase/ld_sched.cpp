@@ -0,0 +1,67 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libdbase                                                      *
+*                                                                             *
+*  Filename   : ld_sched.cpp                                                  *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Chooses the order queued Batch-Tag searches are started in.   *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <ld_sched.h>
+using std::string;
+using std::make_pair;
+
+/*
+queued - the searches that could start, in priority then submission order. They can't be in a
+project that already has a search running.
+userJobs - the number of searches running for each user across all servers.
+hostUserJobs - the number of searches running for each node and user.
+
+Returns the keys of the searches to start, in the order they should be started. Searches of equal
+priority are taken from the user with the fewest searches running, so one user's queue can't
+block everyone else's. Only one search per project is started and no user gets more than
+maxJobsPerUser searches on this host (0 means no limit).
+*/
+StringVector getFairShareJobKeys ( const VectorDaemonJobRecord& queued, MapStringToInt userJobs, MapPairStringStringToInt hostUserJobs, const string& host, int maxJobsPerUser )
+{
+	StringVector keys;
+	BoolDeque used ( queued.size (), false );
+	SetString projStarted;
+	for ( ; ; ) {
+		int best = -1;
+		int bestUserJobs = 0;
+		for ( VectorDaemonJobRecordSizeType i = 0 ; i < queued.size () ; i++ ) {
+			if ( used [i] ) continue;
+			const DaemonJobRecord& djr = queued [i];
+			if ( best != -1 && djr.getPriority () != queued [best].getPriority () ) break;
+			if ( projStarted.count ( djr.getProjectID () ) ) continue;			// Only 1 job per project
+			string user = djr.getUser ();
+			if ( maxJobsPerUser && hostUserJobs [make_pair ( host, user )] >= maxJobsPerUser ) continue;
+			int uj = userJobs [user];
+			if ( best == -1 || uj < bestUserJobs ) {
+				best = i;
+				bestUserJobs = uj;
+			}
+		}
+		if ( best == -1 ) break;
+		used [best] = true;
+		const DaemonJobRecord& djr = queued [best];
+		keys.push_back ( djr.getSearchJobKey () );
+		projStarted.insert ( djr.getProjectID () );
+		userJobs [djr.getUser ()]++;
+		hostUserJobs [make_pair ( host, djr.getUser () )]++;
+	}
+	return keys;
+}
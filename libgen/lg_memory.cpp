@@ -20,6 +20,7 @@
 *                                                                             *
 ******************************************************************************/
 #include <cstring>
+#include <lg_memory.h>
 #include <lg_stdlib.h>
 
 void gen_bzero ( char* block, int size )
@@ -34,3 +35,32 @@ void gen_bcopy ( char* source, char* dest, int size )
 
 	memcpy ( (void*) dest, (void*) source, (size_t)size );
 }
+
+namespace {
+const size_t ARENA_ALIGNMENT = 16;
+}
+
+GenArena::GenArena ( size_t blockSize ) :
+	next ( 0 ),
+	left ( 0 ),
+	blockSize ( blockSize )
+{
+}
+GenArena::~GenArena ()
+{
+	for ( std::vector <char*>::size_type i = 0 ; i < blocks.size () ; i++ ) delete [] blocks [i];
+}
+void* GenArena::allocate ( size_t size )
+{
+	size = ( size + ARENA_ALIGNMENT - 1 ) & ~( ARENA_ALIGNMENT - 1 );
+	if ( size > left ) {
+		size_t n = size > blockSize ? size : blockSize;	// Oversized objects get a block of their own
+		blocks.push_back ( new char [n] );
+		next = blocks.back ();
+		left = n;
+	}
+	void* p = next;
+	next += size;
+	left -= size;
+	return p;
+}
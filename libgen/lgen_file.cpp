@@ -26,6 +26,7 @@
 #include <lg_string.h>
 #include <lgen_error.h>
 #include <lgen_file.h>
+#include <lgen_uncompress.h>
 #ifdef VIS_C
 #include <windows.h>
 #include <direct.h>
@@ -290,6 +291,16 @@ double genVolumeSize ( const string& fileName )
 // UNIX \n
 bool isTextFile ( const string& fileName, int maxLen )
 {
+	string suffix = genSuffixFromPath ( fileName );
+	if ( !genStrcasecmp ( suffix.c_str (), "gz" ) || !genStrcasecmp ( suffix.c_str (), "zip" ) ) {	// Check the decompressed contents
+		GenZIFStream ist ( fileName );
+		for ( int i = 0 ; i < maxLen ; i++ ) {
+			int c = ist.get ();
+			if ( c == EOF ) break;
+			if ( c == '\r' || c == '\n' ) return true;
+		}
+		return false;
+	}
 	FILE* fp1 = gen_fopen_binary ( fileName, "r", "isTextFile" );
 	bool ret = false;
 	for ( int i = 0 ; i < maxLen ; i++ ) {
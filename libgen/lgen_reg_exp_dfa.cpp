@@ -0,0 +1,287 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libgen                                                        *
+*                                                                             *
+*  Filename   : lgen_reg_exp_dfa.cpp                                          *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : DFA for screening strings before a regular expression search. *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstring>
+#include <lgen_reg_exp.h>
+using std::string;
+using std::vector;
+
+namespace {
+struct RegularExpressionElement {
+	unsigned int charSet [8];
+	int minCount;
+	int maxCount;			// -1 for unbounded
+	bool substitute;
+	int getNumPositions () const { return maxCount < 0 ? minCount + 1 : maxCount; }
+};
+typedef vector <RegularExpressionElement> RegularExpressionElementVector;
+
+inline void addChar ( unsigned int* charSet, int c )
+{
+	charSet [c >> 5] |= 1U << ( c & 31 );
+}
+inline bool isChar ( const unsigned int* charSet, int c )
+{
+	return ( charSet [c >> 5] & ( 1U << ( c & 31 ) ) ) != 0;
+}
+}
+
+const int RegularExpressionDFA::MAX_STATES = 4096;
+const char RegularExpressionDFA::MATCH_STATE = 1;
+const char RegularExpressionDFA::DEAD_STATE = 2;
+
+RegularExpressionDFA::RegularExpressionDFA ( const RegularExpression& regExp, int maxErrors, bool ignoreStartAnchor ) :
+	maxErrors ( maxErrors ),
+	usable ( true ),
+	anchored ( regExp.circf && !ignoreStartAnchor ),
+	endAnchor ( false ),
+	startMask ( 0 ),
+	acceptMask ( 0 )
+{
+	parse ( regExp );
+	if ( !usable ) return;
+	initCharClasses ();
+	startMask = closure ( static_cast <GENUINT64> (1) << getBit ( 0, 0 ) );
+	for ( int e = 0 ; e <= maxErrors ; e++ ) acceptMask |= static_cast <GENUINT64> (1) << getBit ( positions.size (), e );
+	addState ( startMask );
+}
+void RegularExpressionDFA::parse ( const RegularExpression& regExp )
+{
+	const int STAR = RegularExpression::STAR;
+	const int RNGE = RegularExpression::RNGE;
+	RegularExpressionElementVector elements;
+	const char* ep = regExp.expbuf;
+	for ( ; ; ) {
+		int op = *ep++;
+		if ( op == RegularExpression::CCEOF ) break;
+		if ( op == RegularExpression::CBRA || op == RegularExpression::CKET ) {
+			ep++;
+			continue;
+		}
+		if ( op == RegularExpression::CDOL ) {
+			if ( *ep != RegularExpression::CCEOF ) usable = false;
+			endAnchor = true;
+			continue;
+		}
+		RegularExpressionElement el;
+		memset ( el.charSet, 0, sizeof (el.charSet) );
+		el.minCount = 1;
+		el.maxCount = 1;
+		int base = op & ~RNGE;
+		int repeat = op & RNGE;
+		if ( base == RegularExpression::CCHR ) {
+			addChar ( el.charSet, static_cast <unsigned char> (*ep++) );
+		}
+		else if ( base == RegularExpression::CDOT ) {
+			for ( int c = 1 ; c < 256 ; c++ ) addChar ( el.charSet, c );
+		}
+		else if ( base == RegularExpression::CCL || base == RegularExpression::NCCL ) {
+			bool neg = base == RegularExpression::NCCL;
+			for ( int c = 1 ; c < 256 ; c++ ) {		// Same test as RegularExpression::advance
+				bool present = ( c & 0200 ) == 0 && ( ep [c >> 3] & RegularExpression::bittab [c & 07] );
+				if ( present != neg ) addChar ( el.charSet, c );
+			}
+			ep += 16;
+		}
+		else if ( base == RegularExpression::CXCL ) {
+			for ( int c = 1 ; c < 256 ; c++ ) {
+				if ( ep [c >> 3] & RegularExpression::bittab [c & 07] ) addChar ( el.charSet, c );
+			}
+			ep += 32;
+		}
+		else {							// Back references and word boundaries
+			usable = false;
+			return;
+		}
+		if ( repeat == STAR ) {
+			el.minCount = 0;
+			el.maxCount = -1;
+		}
+		else if ( repeat == RNGE ) {
+			el.minCount = *ep++ & 0377;
+			int sizeCode = *ep++ & 0377;
+			el.maxCount = ( sizeCode == 255 ) ? -1 : sizeCode;
+		}
+		el.substitute = repeat == 0 && base != RegularExpression::CDOT && base != RegularExpression::CXCL;
+		elements.push_back ( el );
+	}
+	int maxPositions = 64 / ( maxErrors + 1 ) - 1;	// The NFA states have to fit in 64 bits
+	if ( maxPositions < 1 ) {
+		usable = false;
+		return;
+	}
+	while ( !elements.empty () ) {		// Widen the longest ranges until the expression fits
+		int total = 0;
+		RegularExpressionElementVector::size_type longest = 0;
+		for ( RegularExpressionElementVector::size_type i = 0 ; i < elements.size () ; i++ ) {
+			total += elements [i].getNumPositions ();
+			if ( elements [i].getNumPositions () > elements [longest].getNumPositions () ) longest = i;
+		}
+		if ( total <= maxPositions || elements [longest].getNumPositions () <= 1 ) break;
+		elements [longest].minCount = 0;
+		elements [longest].maxCount = -1;
+		elements [longest].substitute = false;
+	}
+	for ( RegularExpressionElementVector::size_type i = 0 ; i < elements.size () ; i++ ) {
+		const RegularExpressionElement& el = elements [i];
+		Position p;
+		memcpy ( p.charSet, el.charSet, sizeof (p.charSet) );
+		p.optional = false;
+		p.repeat = false;
+		p.substitute = el.substitute && maxErrors > 0;
+		for ( int j = 0 ; j < el.minCount ; j++ ) positions.push_back ( p );
+		p.substitute = false;
+		if ( el.maxCount < 0 ) {
+			if ( el.minCount ) positions.back ().repeat = true;
+			else {
+				p.optional = true;
+				p.repeat = true;
+				positions.push_back ( p );
+			}
+		}
+		else {
+			p.optional = true;
+			for ( int k = el.minCount ; k < el.maxCount ; k++ ) positions.push_back ( p );
+		}
+	}
+	if ( positions.size () > static_cast <vector <Position>::size_type> (maxPositions) ) {	// Only screen using the start of the expression
+		positions.resize ( maxPositions );
+		endAnchor = false;
+	}
+	if ( !anchored && maxErrors == 0 ) {		// Any match starts with this string
+		for ( vector <Position>::size_type i = 0 ; i < positions.size () && !positions [i].optional ; i++ ) {
+			int numChars = 0;
+			int ch = 0;
+			for ( int c = 1 ; c < 256 ; c++ ) {
+				if ( isChar ( positions [i].charSet, c ) ) {
+					numChars++;
+					ch = c;
+				}
+			}
+			if ( numChars != 1 ) break;
+			prefix += static_cast <char> (ch);
+			if ( positions [i].repeat ) break;
+		}
+	}
+}
+void RegularExpressionDFA::initCharClasses ()	// Characters that behave the same share a column of the transition table
+{
+	std::map <string, int> classIndex;
+	charClass [0] = 0;
+	for ( int c = 1 ; c < 256 ; c++ ) {
+		string signature;
+		for ( vector <Position>::size_type i = 0 ; i < positions.size () ; i++ ) {
+			signature += isChar ( positions [i].charSet, c ) ? '1' : '0';
+		}
+		std::map <string, int>::const_iterator cur = classIndex.find ( signature );
+		if ( cur == classIndex.end () ) {
+			int cc = classChars.size ();
+			classIndex [signature] = cc;
+			classChars.push_back ( c );
+			charClass [c] = cc;
+		}
+		else charClass [c] = (*cur).second;
+	}
+}
+GENUINT64 RegularExpressionDFA::closure ( GENUINT64 mask ) const
+{
+	for ( int e = 0 ; e <= maxErrors ; e++ ) {
+		for ( vector <Position>::size_type j = 0 ; j < positions.size () ; j++ ) {
+			if ( positions [j].optional && ( mask & ( static_cast <GENUINT64> (1) << getBit ( j, e ) ) ) ) {
+				mask |= static_cast <GENUINT64> (1) << getBit ( j + 1, e );
+			}
+		}
+	}
+	return mask;
+}
+GENUINT64 RegularExpressionDFA::nextMask ( GENUINT64 mask, unsigned char c ) const
+{
+	GENUINT64 next = 0;
+	for ( int e = 0 ; e <= maxErrors ; e++ ) {
+		for ( vector <Position>::size_type j = 0 ; j < positions.size () ; j++ ) {
+			if ( ( mask & ( static_cast <GENUINT64> (1) << getBit ( j, e ) ) ) == 0 ) continue;
+			const Position& p = positions [j];
+			if ( isChar ( p.charSet, c ) ) {
+				next |= static_cast <GENUINT64> (1) << getBit ( j + 1, e );
+				if ( p.repeat ) next |= static_cast <GENUINT64> (1) << getBit ( j, e );
+			}
+			else if ( p.substitute && e < maxErrors ) {
+				next |= static_cast <GENUINT64> (1) << getBit ( j + 1, e + 1 );
+			}
+		}
+	}
+	next = closure ( next );
+	if ( !anchored ) next |= startMask;		// A match can start at the next character
+	return next;
+}
+int RegularExpressionDFA::addState ( GENUINT64 mask )	// Returns the start of the state's row in the transition table
+{
+	std::map <GENUINT64, int>::const_iterator cur = stateIndex.find ( mask );
+	if ( cur != stateIndex.end () ) return (*cur).second;
+	int row = transitions.size ();
+	masks.push_back ( mask );
+	transitions.resize ( row + classChars.size (), -1 );
+	char type = 0;
+	if ( mask == 0 )										type = DEAD_STATE;
+	else if ( !endAnchor && ( mask & acceptMask ) )	type = MATCH_STATE;
+	stateTypes.resize ( transitions.size (), 0 );
+	stateTypes [row] = type;
+	stateIndex [mask] = row;
+	return row;
+}
+int RegularExpressionDFA::getNextState ( int row, int cc )
+{
+	int next = transitions [row + cc];
+	if ( next >= 0 ) return next;
+	GENUINT64 mask = nextMask ( masks [row / classChars.size ()], classChars [cc] );
+	if ( masks.size () >= MAX_STATES && stateIndex.find ( mask ) == stateIndex.end () ) {	// Start again keeping only the start state
+		masks.clear ();
+		stateTypes.clear ();
+		transitions.clear ();
+		stateIndex.clear ();
+		addState ( startMask );
+		return addState ( mask );
+	}
+	next = addState ( mask );
+	transitions [row + cc] = next;
+	return next;
+}
+bool RegularExpressionDFA::isPresent ( const char* str )
+{
+	if ( !usable ) return true;
+	int row = 0;							// The start state
+	if ( stateTypes [row] == MATCH_STATE ) return true;
+	bool skip = !prefix.empty ();
+	const char* p = str;
+	for ( ; ; ) {
+		if ( row == 0 && skip ) {		// Skip to where a match could start
+			p = strstr ( p, prefix.c_str () );
+			if ( p == 0 ) return false;
+		}
+		unsigned char c = *p++;
+		if ( c == 0 ) break;
+		int cc = charClass [c];
+		int next = transitions [row + cc];
+		row = ( next >= 0 ) ? next : getNextState ( row, cc );
+		if ( stateTypes [row] ) return stateTypes [row] == MATCH_STATE;
+	}
+	return ( masks [row / classChars.size ()] & acceptMask ) != 0;
+}
@@ -0,0 +1,148 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libgen                                                        *
+*                                                                             *
+*  Filename   : lgen_thread.cpp                                               *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Minimal portable thread and mutex wrappers.                   *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <vector>
+#include <lgen_error.h>
+#include <lgen_thread.h>
+#ifndef VIS_C
+#include <unistd.h>
+#endif
+
+namespace {
+typedef std::pair <void*, void (*) ( void* )> ThreadLocalInstance;
+typedef std::vector <ThreadLocalInstance> ThreadLocalInstanceVector;
+GEN_THREAD_LOCAL ThreadLocalInstanceVector* threadLocalInstances = 0;
+}
+
+#ifdef VIS_C
+GenMutex::GenMutex ()
+{
+	InitializeCriticalSection ( &cs );
+}
+GenMutex::~GenMutex ()
+{
+	DeleteCriticalSection ( &cs );
+}
+void GenMutex::lock ()
+{
+	EnterCriticalSection ( &cs );
+}
+void GenMutex::unlock ()
+{
+	LeaveCriticalSection ( &cs );
+}
+#else
+GenMutex::GenMutex ()
+{
+	pthread_mutex_init ( &mutex, 0 );
+}
+GenMutex::~GenMutex ()
+{
+	pthread_mutex_destroy ( &mutex );
+}
+void GenMutex::lock ()
+{
+	pthread_mutex_lock ( &mutex );
+}
+void GenMutex::unlock ()
+{
+	pthread_mutex_unlock ( &mutex );
+}
+#endif
+void genAddThreadLocalInstance ( void* p, void ( *deleter ) ( void* ) )
+{
+	if ( threadLocalInstances == 0 ) threadLocalInstances = new ThreadLocalInstanceVector;
+	threadLocalInstances->push_back ( ThreadLocalInstance ( p, deleter ) );
+}
+void genDeleteThreadLocalInstances ()	// Deletes the instances created by genThreadLocalInstance in the calling thread
+{
+	if ( threadLocalInstances ) {
+		for ( ThreadLocalInstanceVector::size_type i = 0 ; i < threadLocalInstances->size () ; i++ ) {
+			(*threadLocalInstances) [i].second ( (*threadLocalInstances) [i].first );
+		}
+		delete threadLocalInstances;
+		threadLocalInstances = 0;
+	}
+}
+GenThread::GenThread () :
+	started ( false )
+{
+}
+GenThread::~GenThread ()
+{
+	if ( started ) join ();
+}
+#ifdef VIS_C
+DWORD WINAPI GenThread::threadFunction ( LPVOID arg )
+{
+	static_cast <GenThread*> (arg)->run ();
+	genDeleteThreadLocalInstances ();
+	return 0;
+}
+void GenThread::start ()
+{
+	handle = CreateThread ( NULL, 0, threadFunction, this, 0, NULL );
+	if ( handle == NULL ) {
+		ErrorHandler::genError ()->error ( "Unable to create thread.\n" );
+	}
+	started = true;
+}
+void GenThread::join ()
+{
+	if ( started ) {
+		WaitForSingleObject ( handle, INFINITE );
+		CloseHandle ( handle );
+		started = false;
+	}
+}
+int genGetNumProcessors ()
+{
+	SYSTEM_INFO si;
+	GetSystemInfo ( &si );
+	return si.dwNumberOfProcessors;
+}
+#else
+void* GenThread::threadFunction ( void* arg )
+{
+	static_cast <GenThread*> (arg)->run ();
+	genDeleteThreadLocalInstances ();
+	return 0;
+}
+void GenThread::start ()
+{
+	if ( pthread_create ( &handle, 0, threadFunction, this ) != 0 ) {
+		ErrorHandler::genError ()->error ( "Unable to create thread.\n" );
+	}
+	started = true;
+}
+void GenThread::join ()
+{
+	if ( started ) {
+		pthread_join ( handle, 0 );
+		started = false;
+	}
+}
+int genGetNumProcessors ()
+{
+	long n = sysconf ( _SC_NPROCESSORS_ONLN );
+	return n > 0 ? static_cast <int> (n) : 1;
+}
+#endif
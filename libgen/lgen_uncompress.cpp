@@ -19,12 +19,195 @@
 *  All rights reserved.                                                       *
 *                                                                             *
 ******************************************************************************/
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
 #include <lgen_error.h>
+#include <lg_io.h>
 #include <lg_stdlib.h>
 #include <lg_string.h>
 #include <lgen_file.h>
+#include <lgen_uncompress.h>
 #include <lu_getfil.h>
 using std::string;
+using std::ifstream;
+using std::ios_base;
+using std::streamsize;
+using std::streamoff;
+using std::vector;
+using std::runtime_error;
+
+namespace {
+const int ZSTREAM_BUFFER_SIZE = 65536;
+
+unsigned int getLittleEndian16 ( const unsigned char* p )
+{
+	return p [0] | ( p [1] << 8 );
+}
+unsigned int getLittleEndian32 ( const unsigned char* p )
+{
+	return p [0] | ( p [1] << 8 ) | ( p [2] << 16 ) | ( static_cast <unsigned int> (p [3]) << 24 );
+}
+}
+
+GenZIStreambuf::GenZIStreambuf ( const string& fullPath ) :
+	fullPath ( fullPath ),
+	ist ( fullPath.c_str (), ios_base::binary ),
+	format ( PLAIN ),
+	zs ( 0 ),
+	inBuffer ( ZSTREAM_BUFFER_SIZE ),
+	outBuffer ( ZSTREAM_BUFFER_SIZE ),
+	dataStart ( 0 ),
+	storedSize ( 0 ),
+	storedRemaining ( 0 ),
+	pos ( 0 ),
+	streamEnd ( false )
+{
+	if ( !ist ) {
+		ErrorHandler::genError ()->error ( "File open failure.\nFilename: " + genEscapePath ( fullPath ) + ".\n" );
+	}
+	openFormat ();
+	rewind ();
+}
+GenZIStreambuf::~GenZIStreambuf ()
+{
+	if ( zs ) {
+		inflateEnd ( zs );
+		delete zs;
+	}
+}
+void GenZIStreambuf::zerror ( const string& err ) const
+{
+	ErrorHandler::genError ()->error ( "Decompression failure: " + err + ".\nFilename: " + genEscapePath ( fullPath ) + ".\n" );
+}
+void GenZIStreambuf::openFormat ()
+{
+	unsigned char h [30];
+	ist.read ( (char*) h, 30 );
+	streamsize n = ist.gcount ();
+	if ( n >= 2 && h [0] == 0x1f && h [1] == 0x8b ) {
+		format = GZIP;
+	}
+	else if ( n == 30 && h [0] == 'P' && h [1] == 'K' && h [2] == 3 && h [3] == 4 ) {		// Zip local file header
+		unsigned int flags = getLittleEndian16 ( h + 6 );
+		unsigned int method = getLittleEndian16 ( h + 8 );
+		if ( flags & 1 ) zerror ( "encrypted zip files are not supported" );
+		if ( method == 8 ) format = ZIP_DEFLATED;
+		else if ( method == 0 ) {
+			storedSize = getLittleEndian32 ( h + 18 );
+			if ( ( flags & 8 ) || storedSize == 0xffffffff ) zerror ( "the zip entry size is unknown" );
+			format = ZIP_STORED;
+		}
+		else zerror ( "unsupported zip compression method" );
+		dataStart = 30 + getLittleEndian16 ( h + 26 ) + getLittleEndian16 ( h + 28 );	// Skip the file name and extra field
+	}
+	if ( format == GZIP || format == ZIP_DEFLATED ) {
+		zs = new z_stream;
+		memset ( zs, 0, sizeof (z_stream) );
+		if ( inflateInit2 ( zs, format == GZIP ? 15 + 16 : -15 ) != Z_OK ) zerror ( "zlib initialisation failed" );
+	}
+}
+void GenZIStreambuf::rewind ()
+{
+	ist.clear ();
+	ist.seekg ( dataStart );
+	storedRemaining = storedSize;
+	pos = 0;
+	streamEnd = false;
+	if ( zs ) {
+		inflateReset ( zs );
+		zs->avail_in = 0;
+	}
+	setg ( &outBuffer [0], &outBuffer [0], &outBuffer [0] );
+}
+streamsize GenZIStreambuf::readInput ( char* buffer, streamsize n )
+{
+	ist.read ( buffer, n );
+	return ist.gcount ();
+}
+streamsize GenZIStreambuf::inflateBuffer ()
+{
+	char* out = &outBuffer [0];
+	streamsize size = outBuffer.size ();
+	if ( format == PLAIN ) return readInput ( out, size );
+	if ( format == ZIP_STORED ) {
+		streamsize n = readInput ( out, genMin ( static_cast <GENINT64> (size), storedRemaining ) );
+		if ( n == 0 && storedRemaining > 0 ) zerror ( "unexpected end of file" );
+		storedRemaining -= n;
+		return n;
+	}
+	zs->next_out = reinterpret_cast <Bytef*> (out);
+	zs->avail_out = size;
+	while ( zs->avail_out == size && !streamEnd ) {
+		if ( zs->avail_in == 0 ) {
+			streamsize n = readInput ( &inBuffer [0], inBuffer.size () );
+			if ( n == 0 ) zerror ( "unexpected end of file" );
+			zs->next_in = reinterpret_cast <Bytef*> (&inBuffer [0]);
+			zs->avail_in = n;
+		}
+		int ret = inflate ( zs, Z_NO_FLUSH );
+		if ( ret == Z_STREAM_END ) {
+			streamEnd = true;
+			if ( format == GZIP ) {		// gzip files can have several members
+				if ( zs->avail_in == 0 ) {
+					streamsize n = readInput ( &inBuffer [0], inBuffer.size () );
+					zs->next_in = reinterpret_cast <Bytef*> (&inBuffer [0]);
+					zs->avail_in = n;
+				}
+				if ( zs->avail_in != 0 && zs->next_in [0] == 0x1f ) {	// Anything else is trailing garbage
+					inflateReset ( zs );
+					streamEnd = false;
+				}
+			}
+		}
+		else if ( ret != Z_OK ) zerror ( zs->msg ? zs->msg : "corrupt data" );
+	}
+	return size - zs->avail_out;
+}
+GenZIStreambuf::int_type GenZIStreambuf::underflow ()
+{
+	if ( gptr () < egptr () ) return traits_type::to_int_type ( *gptr () );
+	pos += egptr () - eback ();
+	streamsize n = inflateBuffer ();
+	setg ( &outBuffer [0], &outBuffer [0], &outBuffer [0] + n );
+	if ( n == 0 ) return traits_type::eof ();
+	return traits_type::to_int_type ( *gptr () );
+}
+GenZIStreambuf::pos_type GenZIStreambuf::seekoff ( off_type off, ios_base::seekdir dir, ios_base::openmode which )
+{
+	if ( dir == ios_base::cur )			return seekpos ( pos + ( gptr () - eback () ) + off, which );
+	else if ( dir == ios_base::beg )	return seekpos ( off, which );
+	else								return pos_type ( off_type ( -1 ) );	// The uncompressed size isn't known
+}
+GenZIStreambuf::pos_type GenZIStreambuf::seekpos ( pos_type sp, ios_base::openmode which )
+{
+	GENINT64 target = off_type ( sp );
+	if ( target < 0 ) return pos_type ( off_type ( -1 ) );
+	if ( target < pos || target > pos + ( egptr () - eback () ) ) {
+		if ( format == PLAIN ) {
+			ist.clear ();
+			ist.seekg ( target );
+			pos = target;
+			setg ( &outBuffer [0], &outBuffer [0], &outBuffer [0] );
+			return sp;
+		}
+		if ( target < pos ) rewind ();				// Decompress again from the start
+	}
+	while ( target > pos + ( egptr () - eback () ) ) {
+		setg ( eback (), egptr (), egptr () );
+		if ( underflow () == traits_type::eof () ) return pos_type ( off_type ( -1 ) );
+	}
+	setg ( eback (), eback () + ( target - pos ), egptr () );
+	return sp;
+}
+
+GenZIFStream::GenZIFStream ( const string& fullPath ) :
+	std::istream ( 0 ),
+	buf ( fullPath )
+{
+	rdbuf ( &buf );
+	exceptions ( ios_base::badbit );	// Report decompression errors rather than treating them as end of file
+}
 
 namespace {
 string getUnzipError ( int err )
@@ -444,8 +627,110 @@ string genUntar ( const string& filename, bool deleteFile, bool createSubdirecto
 	}
 	return newDir;
 }
+void genUncompressFile ( const string& filename, const string& newFilename )
+{
+	GenZIFStream ist ( filename );
+	GenOFStream ost ( newFilename, ios_base::binary );
+	vector <char> buffer ( ZSTREAM_BUFFER_SIZE );
+	try {
+		while ( ist ) {
+			ist.read ( &buffer [0], buffer.size () );
+			if ( ist.gcount () ) ost.write ( &buffer [0], ist.gcount () );
+		}
+	}
+	catch ( runtime_error e ) {
+		ost.close ();
+		genUnlink ( newFilename );
+		throw;
+	}
+	ost.close ();
+	if ( ost.fail () ) {
+		genUnlink ( newFilename );
+		ErrorHandler::genError ()->error ( "File write failure.\nFilename: " + genEscapePath ( newFilename ) + ".\n" );
+	}
+}
+namespace {
+// Reads the central directory header of the first entry of a zip file into h.
+bool getFirstZipCentralHeader ( ifstream& ist, unsigned char* h, unsigned int& numEntries )
+{
+	ist.seekg ( 0, ios_base::end );
+	streamoff fileSize = ist.tellg ();
+	streamoff tailSize = genMin ( fileSize, static_cast <streamoff> (65535 + 22) );	// The end record is followed by a comment of up to 65535 bytes
+	if ( tailSize < 22 ) return false;
+	vector <unsigned char> tail ( tailSize );
+	ist.seekg ( fileSize - tailSize );
+	ist.read ( (char*) &tail [0], tailSize );
+	if ( !ist ) return false;
+	streamoff i = tailSize - 22;
+	for ( ; i >= 0 ; i-- ) {
+		if ( tail [i] == 'P' && tail [i+1] == 'K' && tail [i+2] == 5 && tail [i+3] == 6 ) break;
+	}
+	if ( i < 0 ) return false;
+	numEntries = getLittleEndian16 ( &tail [i+10] );
+	ist.seekg ( getLittleEndian32 ( &tail [i+16] ) );					// Central directory
+	ist.read ( (char*) h, 46 );
+	return ist && h [0] == 'P' && h [1] == 'K' && h [2] == 1 && h [3] == 2;
+}
+// Returns true if the zip file contains a single file that GenZIFStream can read.
+bool getSingleZipEntryName ( const string& filename, string& name )
+{
+	ifstream ist ( filename.c_str (), ios_base::binary );
+	if ( !ist ) return false;
+	unsigned char h [46];
+	unsigned int numEntries;
+	if ( !getFirstZipCentralHeader ( ist, h, numEntries ) || numEntries != 1 ) return false;
+	unsigned int flags = getLittleEndian16 ( h + 8 );
+	unsigned int method = getLittleEndian16 ( h + 10 );
+	if ( ( flags & 1 ) || ( method != 0 && method != 8 ) ) return false;
+	if ( method == 0 && ( flags & 8 ) ) return false;
+	unsigned int nameLen = getLittleEndian16 ( h + 28 );
+	if ( nameLen == 0 ) return false;
+	name.resize ( nameLen );
+	ist.read ( &name [0], nameLen );
+	if ( !ist || name [nameLen-1] == '/' ) return false;				// A directory
+	name = genFilenameFromPath ( name );
+	return !name.empty () && name != "." && name != "..";
+}
+}
+// Returns the size of the data GenZIFStream reads from the file. For a gzip file this is taken from
+// the size stored at the end of the file which is the size modulo 2^32 of the last member. For a zip
+// file it is the size of the first entry. If the size can't be found the file size is returned.
+GENINT64 genUncompressedFileSize ( const string& filename )
+{
+	GENINT64 fileSize = genFileSize ( filename );
+	ifstream ist ( filename.c_str (), ios_base::binary );
+	unsigned char h [46];
+	ist.read ( (char*) h, 4 );
+	if ( !ist ) return fileSize;
+	if ( h [0] == 0x1f && h [1] == 0x8b && fileSize >= 18 ) {			// Smallest gzip file
+		ist.seekg ( -4, ios_base::end );
+		ist.read ( (char*) h, 4 );
+		if ( !ist ) return fileSize;
+		GENINT64 size = getLittleEndian32 ( h );
+		GENINT64 minSize = fileSize - fileSize / 64 - 1024;			// Compressing can only add a little to incompressible data
+		while ( size < minSize ) size += static_cast <GENINT64> (1) << 32;	// The size has wrapped
+		return size;
+	}
+	if ( h [0] == 'P' && h [1] == 'K' && h [2] == 3 && h [3] == 4 ) {
+		unsigned int numEntries;
+		if ( getFirstZipCentralHeader ( ist, h, numEntries ) ) {
+			unsigned int size = getLittleEndian32 ( h + 24 );
+			if ( size != 0xffffffff ) return size;						// Zip64 sizes are in the extra field
+		}
+	}
+	return fileSize;
+}
 string genGunzip ( const string& filename )
 {
+	string suffix = genSuffixFromPath ( filename );
+	const char* csuffix = suffix.c_str ();
+	if ( !genStrcasecmp ( csuffix, "gz" ) || !genStrcasecmp ( csuffix, "tgz" ) ) {	// zlib can't read the .Z and .bz2 formats
+		string newFilename = filename.substr ( 0, filename.length () - ( suffix.length () + 1 ) );
+		if ( !genStrcasecmp ( csuffix, "tgz" ) ) newFilename += ".tar";
+		genUncompressFile ( filename, newFilename );
+		genUnlink ( filename );
+		return newFilename;
+	}
 	string command;
 #ifdef VIS_C
 	command += SystemCallBinDir::instance ().getSystemCallBinDir ();
@@ -455,21 +740,41 @@ string genGunzip ( const string& filename )
 	command += " ";
 	command += "\"" + filename + "\"";
 	genSystem ( command, "", false );
-	string suffix = genSuffixFromPath ( filename );
-	const char* csuffix = suffix.c_str ();
-	if ( !genStrcasecmp ( csuffix, "gz" ) ) return filename.substr ( 0, filename.length () - 3 );
-	else if ( !genStrcasecmp ( csuffix, "z" ) ) return filename.substr ( 0, filename.length () - 2 );
-	else if ( !genStrcasecmp ( csuffix, "tgz" ) ) return filename.substr ( 0, filename.length () - 4 ) + ".tar";
+	if ( !genStrcasecmp ( csuffix, "z" ) ) return filename.substr ( 0, filename.length () - 2 );
 	else if ( !genStrcasecmp ( csuffix, "taz" ) ) return filename.substr ( 0, filename.length () - 4 ) + ".tar";
 	else return filename.substr ( 0, filename.length () - 4 ); // bz2
 }
-string genPreprocessFile ( const string& filename )
+// If keepCompressed is set single gzip files and zip files with a single entry are left compressed as
+// GenZIFStream can read them directly. A zip file is moved into a subdirectory and named after its entry.
+string genPreprocessFile ( const string& filename, bool keepCompressed )
 {
 	string retFilename;
 	string suffix = genSuffixFromPath ( filename );
 	string originalSuffix = suffix;
 	const char* csuffix = suffix.c_str ();
-	if ( !genStrcasecmp ( csuffix, "zip" ) ) {
+	string zipEntryName;
+	if ( keepCompressed && !genStrcasecmp ( csuffix, "gz" ) && genStrcasecmp ( genSuffixFromPath ( filename.substr ( 0, filename.length () - 3 ) ).c_str (), "tar" ) ) {
+		retFilename = filename;		// The file is not processed
+	}
+	else if ( keepCompressed && !genStrcasecmp ( csuffix, "zip" ) && getSingleZipEntryName ( filename, zipEntryName ) ) {
+		retFilename = filename.substr ( 0, filename.length () - 4 );
+		genCreateDirectory ( retFilename );
+		genRename ( filename, retFilename + SLASH + zipEntryName + "." + originalSuffix );
+	}
+	else if ( !genStrcasecmp ( csuffix, "zip" ) && getSingleZipEntryName ( filename, zipEntryName ) ) {
+		retFilename = filename.substr ( 0, filename.length () - 4 );	// Uncompress the file into a subdirectory and delete the original archive
+		genCreateDirectory ( retFilename );
+		try {
+			genUncompressFile ( filename, retFilename + SLASH + zipEntryName );
+		}
+		catch ( runtime_error e ) {
+			genUnlinkDirectory ( retFilename );
+			genUnlink ( filename );
+			throw;
+		}
+		genUnlink ( filename );
+	}
+	else if ( !genStrcasecmp ( csuffix, "zip" ) ) {
 		retFilename = genUnzip ( filename, true, true );	// Unzip the files into a subdirectory and delete the original archive
 	}
 	else if ( !genStrcasecmp ( csuffix, "7z" ) ) {
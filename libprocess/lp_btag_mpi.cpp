@@ -162,6 +162,7 @@ void BatchTagMPI::run ()
 		if ( rank == 0 ) {
 			ProjectFile pf ( paramList [index] );
 			fs = new FileSplit ( pf.getNumMSMSSpectra (), numSearches, getMSMSMaxSpectra ( paramList [index] ) );
+			if ( startSerial == 1 || index != 0 ) printMSMSSearchPasses ( *fs, numSearches );
 #ifdef MYSQL_DATABASE
 			if ( !searchJobID.empty () ) MySQLPPSDDBase::instance ().setNumSerial ( searchJobID, fs->getNumSerial () );
 #endif
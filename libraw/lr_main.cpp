@@ -33,6 +33,8 @@
 #include <lr_main.h>
 #include <lu_t2d.h>
 #include <lu_file_type.h>
+#include <lu_getfil.h>
+#include <lu_ms1_store.h>
 #ifdef XCALIBUR
 #include <lx_raw.h>
 #endif
@@ -139,6 +141,72 @@ string CentroidInstance::getRawType () const
 	return "";		// return empty string - not a raw type
 }
 
+class MzMLInstance : public CentroidInstance {
+	MS1ScanStore* store;
+	StringVector stringTimes;
+	int getMS1Index ( const SpecID& specID ) const;
+public:
+	MzMLInstance ( const string& fName, const string& centroidFile );
+	~MzMLInstance ();
+	void getXYData ( vector <XYData>& vXYData, PairStringVectorString& sTimes, bool msFullScan, const SpecID& specID, double mOverZ, double startMass = 0.0, double endMass = 0.0 );
+	void getQuantitationXYData ( vector <XYData>& vXYData, PairStringVectorString& sTimes, bool ITRAQ, const SpecID& specID, double mOverZ, const string& version, double startMass = 0.0, double endMass = 0.0 );
+	string getRawType () const;
+};
+MzMLInstance::MzMLInstance ( const string& fName, const string& centroidFile ) :
+	CentroidInstance ( centroidFile ),
+	store ( MS1ScanStore::getStore ( fName ) )
+{
+	for ( int i = 0 ; i < store->size () ; i++ ) {
+		stringTimes.push_back ( gen_ftoa ( store->getRT ( i ), "%.3f" ) );
+	}
+}
+MzMLInstance::~MzMLInstance ()
+{
+	delete store;
+}
+int MzMLInstance::getMS1Index ( const SpecID& specID ) const
+{
+	string msmsInfo = specID.getMSMSInfo ();
+	if ( msmsInfo.empty () ) {
+		throw runtime_error ( "Scan information not present in the centroid file." );
+	}
+	int scan = atoi ( msmsInfo.c_str () );
+	int index = store->getMS1Index ( scan );
+	if ( index == -1 ) {
+		ostringstream err;
+		err << "There is no MS scan for scan number " << scan << " in the mzML file.";
+		throw runtime_error ( err.str () );
+	}
+	return index;
+}
+void MzMLInstance::getXYData ( vector <XYData>& vXYData, PairStringVectorString& sTimes, bool msFullScan, const SpecID& specID, double mOverZ, double startMass, double endMass )
+{
+	if ( msFullScan ) {
+		int index = getMS1Index ( specID );
+		sTimes.first = stringTimes;
+		sTimes.second = stringTimes [index];
+		store->getXYData ( vXYData [0], index, 1, startMass, endMass );
+	}
+	else
+		CentroidInstance::getXYData ( vXYData, sTimes, msFullScan, specID, mOverZ, startMass, endMass );
+}
+void MzMLInstance::getQuantitationXYData ( vector <XYData>& vXYData, PairStringVectorString& sTimes, bool ITRAQ, const SpecID& specID, double mOverZ, const string& version, double startMass, double endMass )
+{
+	if ( ITRAQ ) {		// The MS/MS peaks come from the centroid file
+		CentroidInstance::getQuantitationXYData ( vXYData, sTimes, ITRAQ, specID, mOverZ, version, startMass, endMass );
+		return;
+	}
+	static int numScans = InfoParams::instance ().getIntValue ( "mzml_quan_scans", 1 );
+	int index = getMS1Index ( specID );
+	sTimes.first = stringTimes;
+	sTimes.second = stringTimes [index];
+	store->getXYData ( vXYData [0], index, numScans, startMass, endMass );
+}
+string MzMLInstance::getRawType () const
+{
+	return MZML;
+}
+
 class T2DInstance : public RawInstance {
 	string fName;
 	static string getTOFTOFRawFilename ( const string& path, const SpecID& specID );
@@ -340,6 +408,8 @@ RawFile::RawFile ( const ParameterList* params, int fraction, double rtIntervalS
 	else if ( isFileType ( filePath, RAW ) )		// RAW
 		rawInstance = new ThermoRawInstance ( filePath, rtIntervalStart, rtIntervalEnd );
 #endif
+	else if ( isFileType ( filePath, MZML ) )		// mzML
+		rawInstance = new MzMLInstance ( filePath, getCentroidDataFilename ( params, fraction ) );
 	else											// The raw file is specified in the project file but can't be read.
 		throw runtime_error ( "Raw data display is not currently possible on the chosen instrument type." );
 }
@@ -19,7 +19,16 @@
 *  All rights reserved.                                                       *
 *                                                                             *
 ******************************************************************************/
+#ifndef VIS_C
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#ifdef VIS_C
+#include <process.h>
+#endif
 #include <algorithm>
+#include <fstream>
+#include <lg_string.h>
 #include <lgen_file.h>
 #include <lgen_mmap.h>
 #include <lgen_sort.h>
@@ -30,6 +39,8 @@ using std::string;
 using std::vector;
 using std::lower_bound;
 using std::ios;
+using std::ostream;
+using std::ofstream;
 
 #define MAX_NON_PRINT 31
 
@@ -47,9 +58,14 @@ public:
 };
 
 class GeneralAccessionNumberMap : public AccessionNumberMap {
-	UIntVector aNums;
+	int numEntries;
+	Int64Vector aNums;								// Only used if the .aco file can't be written
 	mutable MMapFile <char>* mm;
+	mutable MMapFile <GENINT64>* offsets;
 	string fullPath;
+	string offsetPath;
+	GENINT64 getOffset ( int i ) const { return offsets ? offsets->subscript ( i ) : aNums [i]; }
+	bool checkOffsetFile () const;
 public:
 	GeneralAccessionNumberMap ( const string& database );
 	~GeneralAccessionNumberMap ();
@@ -61,6 +77,10 @@ public:
 			delete mm;
 			mm = 0;
 		}
+		if ( offsets != 0 ) {
+			delete offsets;
+			offsets = 0;
+		}
 	}
 };
 
@@ -129,78 +149,120 @@ bool NumericAccessionNumberMap::accessionNumberUnique ( const string& accessionN
 {
 	return getIndexNumber ( accessionNumber ) == -1;
 }
-GeneralAccessionNumberMap::GeneralAccessionNumberMap ( const string& database )
+static void scanAccessionNumberFile ( const string& fullPath, int numEntries, Int64Vector& aNums, ostream* ost )
+// Finds the start of each line of the .acc file. If ost is set the offsets are written to it rather than stored.
+{
+	const Int64Vector::size_type BUFFER_SIZE = 0x100000;
+	MMapFile <char> mm ( fullPath, 0, 0, MMAP_ADVICE_SEQUENTIAL );
+	GENINT64 startIndex = 0;
+	const char* fpointerStart = mm.getStartPointer ();
+	const char* fpointerEnd = mm.getEndPointer ();
+	while ( *fpointerEnd != '\n' ) fpointerEnd--;
+	const char* pointer = fpointerStart;
+
+	for ( int i = 0 ; i < numEntries ; i++ ) {
+		aNums.push_back ( mm.getMapOffset ( pointer ) );
+		if ( ost && aNums.size () == BUFFER_SIZE ) {
+			ost->write ( (char*) &aNums [0], aNums.size () * sizeof (GENINT64) );
+			aNums.clear ();
+		}
+		if ( pointer [0] != ' ' ) {
+			while ( *++pointer != ' ' );
+		}
+		char* end;
+		strtol ( pointer+1, &end, 10 );						// Skip integer
+		pointer = end;
+		while ( pointer <= fpointerEnd && *pointer <= MAX_NON_PRINT ) {
+			pointer++;
+		}
+		if ( pointer > fpointerEnd ) {
+			if ( i == numEntries - 1 ) break;
+			startIndex = mm.getMapOffset ( pointer );
+			fpointerStart = mm.getRange ( startIndex, startIndex + 0x7ffff );
+			fpointerEnd = mm.getEndPointer ();
+			while ( *fpointerEnd != '\n' ) fpointerEnd--;
+			pointer = fpointerStart;
+		}
+	}
+	if ( ost && !aNums.empty () ) {
+		ost->write ( (char*) &aNums [0], aNums.size () * sizeof (GENINT64) );
+		aNums.clear ();
+	}
+}
+static int getNumAccessionNumbers ( const string& database )
 {
 	int numEntries;
+	GenIFStream idiFile ( SeqdbDir::instance ().getSeqdbDir () + database + ".idi", ios::binary );
+	idiFile.read ( (char*) &numEntries, sizeof (unsigned int) );
+	return numEntries;
+}
+bool createAccessionNumberOffsetFile ( const string& database )
+{
+	string fullPath = SeqdbDir::instance ().getSeqdbDir () + database + ".acc";
+	if ( !genFileExists ( fullPath ) ) return false;
+	string offsetPath = SeqdbDir::instance ().getSeqdbDir () + database + ".aco";
+	string tempPath = offsetPath + "." + gen_itoa ( getpid () ) + ".tmp";	// Another process may be creating the same file
+	ofstream ost ( tempPath.c_str (), ios::binary );
+	if ( !ost ) return false;
+	Int64Vector aNums;
+	scanAccessionNumberFile ( fullPath, getNumAccessionNumbers ( database ), aNums, &ost );
+	ost.close ();
+	if ( ost.fail () ) {
+		genUnlink ( tempPath );
+		return false;
+	}
+	genRename ( tempPath, offsetPath );
+	return true;
+}
+GeneralAccessionNumberMap::GeneralAccessionNumberMap ( const string& database ) :
+	numEntries ( 0 ),
+	mm ( 0 ),
+	offsets ( 0 )
+{
 	fullPath = SeqdbDir::instance ().getSeqdbDir () + database + ".acc";
+	offsetPath = SeqdbDir::instance ().getSeqdbDir () + database + ".aco";
 	if ( genFileExists ( fullPath ) ) {
-
-		GenIFStream idiFile ( SeqdbDir::instance ().getSeqdbDir () + database + ".idi", ios::binary );
-		idiFile.read ( (char*) &numEntries, sizeof (unsigned int) );
-		idiFile.close ();
-
-		aNums.reserve ( numEntries );
-
-		mm = new MMapFile <char> ( fullPath );
-		unsigned int startIndex = 0;
-		const char* fpointerStart = mm->getStartPointer ();
-		const char* fpointerEnd = mm->getEndPointer ();
-		while ( *fpointerEnd != '\n' ) fpointerEnd--;
-		const char* pointer = fpointerStart;
-
-		for ( int i = 0 ; i < numEntries ; i++ ) {
-			aNums.push_back ( mm->getMapOffset ( pointer ) );
-			if ( pointer [0] != ' ' ) {
-				while ( *++pointer != ' ' );
-			}
-			char* end;
-			strtol ( pointer+1, &end, 10 );						// Skip integer
-			pointer = end;
-			while ( pointer <= fpointerEnd && *pointer <= MAX_NON_PRINT ) {
-				pointer++;
-			}
-			if ( pointer > fpointerEnd ) {
-				if ( i == numEntries - 1 ) break;
-				startIndex += pointer - fpointerStart;
-				fpointerStart = mm->getRange ( startIndex, startIndex + 0x7ffff );
-				fpointerEnd = mm->getEndPointer ();
-				while ( *fpointerEnd != '\n' ) fpointerEnd--;
-				pointer = fpointerStart;
+		numEntries = getNumAccessionNumbers ( database );
+		if ( !checkOffsetFile () ) {		// Databases indexed before the .aco file was introduced
+			if ( !createAccessionNumberOffsetFile ( database ) || !checkOffsetFile () ) {
+				aNums.reserve ( numEntries );
+				scanAccessionNumberFile ( fullPath, numEntries, aNums, 0 );
 			}
 		}
-		reset ();
 	}
 }
+bool GeneralAccessionNumberMap::checkOffsetFile () const
+{
+	if ( !genFileExists ( offsetPath ) ) return false;
+	if ( genFileSize ( offsetPath ) != numEntries * sizeof (GENINT64) ) return false;
+	return genLastModifyTime ( offsetPath ) >= genLastModifyTime ( fullPath );
+}
 GeneralAccessionNumberMap::~GeneralAccessionNumberMap ()
 {
 	reset ();
 }
-class GeneralAccessionNumberSort {
-	mutable MMapFile <char>* mm;
-	char delim;
-public:
-	GeneralAccessionNumberSort ( MMapFile <char>* mm, char delim ) :
-		mm ( mm ),
-		delim ( delim ) {}
-
-	bool operator () ( const unsigned int& a, const char* b ) const
-	{
-		const char* first = mm->getRange ( a, a + 0x200 );
-		return genStrcasecmp ( first, b, delim ) < 0;
-	}
-};
 int GeneralAccessionNumberMap::getIndexNumber ( const string& accessionNumber ) const
 {
-	if ( mm == 0 ) mm = new MMapFile <char> ( fullPath );
-	const char* fpointerStart = mm->getStartPointer ();
+	if ( numEntries == 0 ) return -1;
+	if ( mm == 0 ) mm = new MMapFile <char> ( fullPath, 0, 0, MMAP_ADVICE_RANDOM );
+	if ( offsets == 0 && aNums.empty () ) offsets = new MMapFile <GENINT64> ( offsetPath, 0, numEntries * sizeof (GENINT64), MMAP_ADVICE_RANDOM );
 	static char delim = ' ';
 	string aann = accessionNumber + delim;
-	UIntVectorConstIterator an = lower_bound ( aNums.begin (), aNums.end (), aann.c_str (), GeneralAccessionNumberSort ( mm, delim ) );
-	if ( an == aNums.end () ) return -1;
-
-	int idx = an - aNums.begin ();
+	int first = 0;								// Binary search for the first entry not less than the accession number
+	int count = numEntries;
+	while ( count > 0 ) {
+		int step = count / 2;
+		int mid = first + step;
+		GENINT64 off = getOffset ( mid );
+		if ( genStrcasecmp ( mm->getRange ( off, off + 0x200 ), aann.c_str (), delim ) < 0 ) {
+			first = mid + 1;
+			count -= step + 1;
+		}
+		else count = step;
+	}
+	if ( first == numEntries ) return -1;
 
-	unsigned int off = aNums [idx];
+	GENINT64 off = getOffset ( first );
 	const char* a = mm->getRange ( off, off + 0x200 );
 	int ret;
 	if ( genStrcasecmp ( a, aann.c_str (), delim ) )
@@ -24,6 +24,7 @@
 #include <lg_string.h>
 #include <lgen_error.h>
 #include <lgen_file.h>
+#include <lgen_uncompress.h>
 #include <lu_getfil.h>
 #include <lu_param_list.h>
 #include <lu_prog.h>
@@ -36,6 +37,9 @@
 #endif
 #include <lu_tag_par.h>
 #include <lu_tag_srch.h>
+#include <lu_dig_cache.h>
+#include <lu_charge.h>
+#include <lu_data.h>
 
 using std::string;
 using std::cout;
@@ -104,8 +108,47 @@ string getBatchTagOutputPath ( const ParameterList* params )
 #endif
 	return adjustPPOutputPath ( path ) + outputFilename + ".xml";
 }
+namespace {
+const int PEAK_LIST_BYTES_PER_PEAK = 20;		// Approximate length of a peak line in a peak list file
+const int SPECTRUM_OVERHEAD_BYTES = 4096;		// Spectrum information, search and hit container objects
+/*
+Estimate of the memory needed to search one spectrum. This is made up of the raw peak list, the
+filtered peaks used for the search and the hits saved for the spectrum. Hits are only pruned
+periodically so twice the number saved is allowed for.
+*/
+double getMSMSSpectrumMemory ( const ParameterList* paramList )
+{
+	ProjectFile pf ( paramList );
+	IntVector nSpec = pf.getNumMSMSSpectra ();
+	GENINT64 peakListBytes = 0;
+	int totSpec = 0;
+	for ( StringVectorSizeType i = 0 ; i < pf.getNumFiles () ; i++ ) {
+		string path = pf.getCentroidPath ( i );
+		if ( !path.empty () && genFileExists ( path ) ) {
+			peakListBytes += genUncompressedFileSize ( path );	// The peak lists may be compressed
+			totSpec += nSpec [i];
+		}
+	}
+	double rawPeaks = totSpec ? static_cast <double> ( peakListBytes ) / totSpec / PEAK_LIST_BYTES_PER_PEAK : 0.0;
+	int maxPeaks = paramList->getIntValue ( "msms_max_peaks", 60 );
+	string linkSearchType = paramList->getStringValue ( "link_search_type" );
+	bool link = linkSearchType != "No Link" && linkSearchType != "";
+	int savedHits = link ? paramList->getIntValue ( "max_saved_tag_hits", 1000 ) : paramList->getIntValue ( "msms_max_reported_hits", 50 );
+	double bytes = SPECTRUM_OVERHEAD_BYTES;
+	bytes += rawPeaks * sizeof (DataFilePeak);
+	bytes += maxPeaks * 2 * sizeof (Peak);
+	bytes += savedHits * 2 * sizeof (TagHit);
+	return bytes;
+}
+}
+
 int getMSMSMaxSpectra ( ParameterList* paramList )
 {
+	int memoryBudget = InfoParams::instance ().getIntValue ( "msms_memory_budget", 0 );	// MB
+	if ( memoryBudget > 0 ) {
+		int maxSpectra = static_cast <int> ( memoryBudget * 1048576.0 / getMSMSSpectrumMemory ( paramList ) );
+		return genMax ( maxSpectra, 4 );
+	}
 	int maxSpectra = InfoParams::instance ().getIntValue ( "msms_max_spectra", 500 );
 	string linkSearchType = paramList->getStringValue ( "link_search_type" );
 	if ( linkSearchType != "No Link" && linkSearchType != "" ) {
@@ -117,6 +160,13 @@ int getMSMSMaxSpectra ( ParameterList* paramList )
 	}
 	return maxSpectra;
 }
+void printMSMSSearchPasses ( const FileSplit& fs, int numSearches )
+{
+	int numProcesses = genMax ( 1, genMin ( fs.getTotalSpectra (), numSearches ) );
+	cout << fs.getTotalSpectra () << " spectra will be searched in " << fs.getNumSerial () << ( fs.getNumSerial () == 1 ? " database pass" : " database passes" );
+	if ( numProcesses > 1 ) cout << " on each of " << numProcesses << " processes";
+	cout << "." << endl;
+}
 void runBatchTag ( ParameterList* paramList, int numSearches, int searchNumber, const string& searchJobID, int startSerial )
 {
 	string outputFilename = getBatchTagOutputPath ( paramList ) + string ( "_" ) + gen_itoa ( searchNumber );
@@ -126,6 +176,7 @@ void runBatchTag ( ParameterList* paramList, int numSearches, int searchNumber,
 	MSProgram::setParams ( paramList );
 	ProjectFile pf ( paramList );
 	FileSplit fs ( pf.getNumMSMSSpectra (), numSearches, getMSMSMaxSpectra ( paramList ) );
+	if ( searchNumber == 0 && startSerial == 1 ) printMSMSSearchPasses ( fs, numSearches );
 #ifdef MYSQL_DATABASE
 	if ( searchJobID.empty () ) MySQLPPSDDBase::instance ( false, true );
 #endif
@@ -144,6 +195,12 @@ void runBatchTag ( ParameterList* paramList, int numSearches, int searchNumber,
 	if ( !searchJobID.empty () ) MySQLPPSDDBase::instance ().setNumSerial ( searchJobID, fs.getNumSerial () );
 #endif
 	int startSerialIndex = startSerial - 1;
+	DigestCache* digestCache = 0;
+	if ( fs.getNumSerial () - startSerialIndex > 1 && InfoParams::instance ().getBoolValue ( "digest_cache", false ) ) {
+		GENINT64 maxMemory = InfoParams::instance ().getIntValue ( "digest_cache_memory", 256 );	// MB
+		digestCache = new DigestCache ( outputFilename + ".dig", maxMemory * 1048576 );
+		YesEnzymeSearch::setDigestCache ( digestCache );
+	}
 	MSTagParameters* params = 0;
 	for ( int i = startSerialIndex ; i < fs.getNumSerial () ; i++ ) {
 #ifdef MYSQL_DATABASE
@@ -159,6 +216,11 @@ void runBatchTag ( ParameterList* paramList, int numSearches, int searchNumber,
 			ts->printBodyXML ( os, searchNumber == 0 && i == 0 );	// Only show pre search results for one search
 			delete ts;
 		}
+		if ( digestCache ) digestCache->freeze ();		// Later searches reuse the digests from the first one
+	}
+	if ( digestCache ) {
+		YesEnzymeSearch::setDigestCache ( 0 );
+		delete digestCache;
 	}
 	delete params;
 	if ( searchNumber == genMin ( fs.getTotalSpectra (), numSearches ) - 1 ) {
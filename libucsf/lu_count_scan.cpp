@@ -23,6 +23,7 @@
 #include <lg_string.h>
 #include <lg_io.h>
 #include <lgen_error.h>
+#include <lgen_uncompress.h>
 #include <lu_count_scan.h>
 #include <lu_xml_data.h>
 using std::string;
@@ -54,7 +55,7 @@ MascotCountScans::MascotCountScans ( const string& filename )
 {
 	count = 0;
 	string line;
-	GenIFStream ist ( filename );
+	GenZIFStream ist ( filename );
 	while ( getline ( ist, line ) ) {
 		if ( !line.compare ( 0, 8, "END IONS" ) ) {
 			count++;
@@ -66,7 +67,7 @@ MS2CountScans::MS2CountScans ( const string& filename )
 {
 	count = 0;
 	string line;
-	GenIFStream ist ( filename );
+	GenZIFStream ist ( filename );
 	while ( getline ( ist, line ) ) {
 		if ( !line.compare ( 0, 1, "S" ) ) {
 			count++;
@@ -78,7 +79,7 @@ APLCountScans::APLCountScans ( const string& filename )
 {
 	count = 0;
 	string line;
-	GenIFStream ist ( filename );
+	GenZIFStream ist ( filename );
 	while ( getline ( ist, line ) ) {
 		if ( !line.compare ( 0, 12, "peaklist end" ) ) {
 			count++;
@@ -90,7 +91,7 @@ PPCountMSScans::PPCountMSScans ( const string& filename )
 {
 	count = 0;
 	string line;
-	GenIFStream ist ( filename );
+	GenZIFStream ist ( filename );
 	while ( getline ( ist, line ) ) {
 		if ( !line.compare ( 0, 3, ">M1" ) ) {
 			count++;
@@ -102,7 +103,7 @@ PPCountMSMSScans::PPCountMSMSScans ( const string& filename )
 {
 	count = 0;
 	string line;
-	GenIFStream ist ( filename );
+	GenZIFStream ist ( filename );
 	while ( getline ( ist, line ) ) {
 		if ( !line.compare ( 0, 3, ">M2" ) ) {
 			count++;
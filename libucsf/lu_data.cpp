@@ -27,6 +27,7 @@
 #include <lg_string.h>
 #include <lg_time.h>
 #include <lgen_error.h>
+#include <lgen_uncompress.h>
 #include <lu_delim.h>
 #ifdef BATCHTAG
 #include <lu_xml_data.h>
@@ -126,7 +127,9 @@ DataReader::DataReader ( const string& s, bool fileFlag, bool intensityFlag ) :
 	istr ( initStream ( fileFlag ) ),
 	intensityFlag ( intensityFlag ),
 	num ( 0 ),
-	endPos ( 0 )
+	endPos ( 0 ),
+	indexPos ( 0 ),
+	filename ( fileFlag ? s : "" )
 {
 	if ( fileFlag ) lastFilename = s;
 }
@@ -139,9 +142,12 @@ istream& DataReader::initStream ( bool fileFlag )
 	if ( fileFlag ) return *ifstr;
 	else return isstr;
 }
-GenIFStream* DataReader::initFStream ( const string& s, bool fileFlag )
+istream* DataReader::initFStream ( const string& s, bool fileFlag )
 {
 	if ( fileFlag ) {
+		GenZIFStream* z = new GenZIFStream ( s );
+		if ( z->isCompressed () ) return z;		// gzip and zip files are decompressed as they are read
+		delete z;
 		GenIFStream p ( s, ios::binary );
 		string line;
 		getline ( p, line );
@@ -297,6 +303,49 @@ bool DataReader::isEOF ()
 	int c = istr.peek ();
 	return c == EOF;
 }
+PeakListIndex* DataReader::getPeakListIndex ( int format )
+// Returns 0 if the data isn't from a file or the index can't be written
+{
+	if ( filename.empty () || !InfoParams::instance ().getBoolValue ( "peak_list_index", true ) ) return 0;
+	PeakListIndex* pli = PeakListIndex::getIndex ( filename, format );
+	if ( pli == 0 ) {
+		istr.clear ();
+		istr.seekg ( 0 );
+		PeakListIndexEntryVector entries;
+		getPeakListIndexEntries ( entries );
+		istr.clear ();
+		istr.seekg ( 0 );
+		PeakListIndex::write ( filename, format, entries );
+		pli = PeakListIndex::getIndex ( filename, format );
+	}
+	return pli;
+}
+void DataReader::setIndexPos ( PeakListIndex* pli, int entry )
+{
+	indexPos = pli->getEntry ( entry ).offset;
+	num = entry;				// The number of spectra before the one at indexPos
+}
+void DataReader::initIndexPosFromIndex ( int format, int index )
+{
+	if ( num != 0 ) return;		// Only used when reading from the start of the file
+	PeakListIndex* pli = getPeakListIndex ( format );
+	if ( pli ) {
+		if ( index >= 1 && index <= pli->size () ) setIndexPos ( pli, index - 1 );
+		delete pli;
+	}
+}
+void DataReader::initIndexPosFromScanNumber ( int format, const string& scanNumber )
+{
+	if ( num != 0 ) return;		// Only used when reading from the start of the file
+	int scan = PeakListIndex::getScanNumber ( scanNumber );
+	if ( scan == -1 ) return;
+	PeakListIndex* pli = getPeakListIndex ( format );
+	if ( pli ) {
+		IntVector iv = pli->getScanEntries ( scan );
+		if ( !iv.empty () ) setIndexPos ( pli, iv [0] );	// The spectra are read from the first one with this scan number
+		delete pli;
+	}
+}
 void DataReader::getData ( MSMSDataPointVector& msmsDataPointList, const SpecID& specID, int chrg, const string& version, UpdatingJavascriptMessage* ujm )
 {
 	throw runtime_error ( "Writing peak lists in this format is currently not supported." );
@@ -442,6 +491,7 @@ void MS2DataReader::getDataFromIndex ( MSMSDataPointVector& msmsDataPointList, i
 	SpecID specID ( id );
 	readRT = false;
 	readScan = false;
+	if ( off == 0 ) initIndexPosFromIndex ( PeakListIndex::MS2_FORMAT, index );
 	getData ( msmsDataPointList, fraction, spectrumRange, specID, chrg, "", off );
 }
 void MS2DataReader::getDataFromScanNumber ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, const string& scanNumber, int chrg, int off )
@@ -449,6 +499,7 @@ void MS2DataReader::getDataFromScanNumber ( MSMSDataPointVector& msmsDataPointLi
 	string id = gen_itoa ( fraction ) + "-" + scanNumber + "-1-1";
 	SpecID specID ( id );
 	readRT = false;
+	if ( off == 0 ) initIndexPosFromScanNumber ( PeakListIndex::MS2_FORMAT, scanNumber );
 	getData ( msmsDataPointList, fraction, spectrumRange, specID, chrg, "", off );
 }
 void MS2DataReader::getData ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, const SpecID& specID, int chrg, const string& version, int off )
@@ -456,6 +507,10 @@ void MS2DataReader::getData ( MSMSDataPointVector& msmsDataPointList, int fracti
 	if ( off != 0 ) istr.seekg ( off );
 	bool readPeaks = false;
 	bool bullseye = parseHeader ();
+	if ( indexPos != 0 ) {		// Only the first read starts from the index position
+		istr.seekg ( indexPos );
+		indexPos = 0;
+	}
 	for ( ; ; ) {
 		string spot = gen_itoa ( num + 1 );
 		string msmsInfo;
@@ -505,6 +560,29 @@ void MS2DataReader::getData ( MSMSDataPointVector& msmsDataPointList, int fracti
 		}
 	}
 }
+void MS2DataReader::getPeakListIndexEntries ( PeakListIndexEntryVector& entries )
+{
+	bool bullseye = parseHeader ();
+	for ( ; ; ) {
+		PeakListIndexEntry entry;
+		entry.offset = istr.tellg ();
+		string spot;
+		string msmsInfo;
+		DoubleVector mVector;
+		IntVector zVector;
+		int spectrumNumber;
+		parseHeaderLines ( bullseye, spot, spectrumNumber, msmsInfo, mVector, zVector );
+		entry.mOverZ = mVector.empty () ? 0.0 : mVector [0];
+		entry.rt = -1.0;
+		entry.scan = PeakListIndex::getScanNumber ( msmsInfo );
+		entry.charge = zVector.empty () ? 0 : zVector [0];
+		entry.titleHash = 0;
+		entry.pad = 0;
+		entries.push_back ( entry );
+		if ( skipMSMSData () == false ) break;	// End of file
+	}
+	spotNumber.clear ();
+}
 bool MS2DataReader::readMSMSData ()
 {
 	dataPoint->clear ();
@@ -639,17 +717,23 @@ void APLDataReader::getDataFromIndex ( MSMSDataPointVector& msmsDataPointList, i
 {
 	string id = gen_itoa ( fraction ) + "-" + gen_itoa ( index ) + "-1-1";
 	SpecID specID ( id );
+	if ( off == 0 ) initIndexPosFromIndex ( PeakListIndex::APL_FORMAT, index );
 	getData ( msmsDataPointList, fraction, spectrumRange, specID, chrg, "", off );
 }
 void APLDataReader::getDataFromScanNumber ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, const string& scanNumber, int chrg, int off )
 {
 	string id = gen_itoa ( fraction ) + "-" + scanNumber + "-1-1";
 	SpecID specID ( id );
+	if ( off == 0 ) initIndexPosFromScanNumber ( PeakListIndex::APL_FORMAT, scanNumber );
 	getData ( msmsDataPointList, fraction, spectrumRange, specID, chrg, "", off );
 }
 void APLDataReader::getData ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, const SpecID& specID, int chrg, const string& version, int off )
 {
 	if ( off != 0 ) istr.seekg ( off );
+	if ( indexPos != 0 ) {		// Only the first read starts from the index position
+		istr.seekg ( indexPos );
+		indexPos = 0;
+	}
 	bool readPeaks = false;
 	for ( ; ; ) {
 		string spot = gen_itoa ( num + 1 );
@@ -699,6 +783,28 @@ void APLDataReader::getData ( MSMSDataPointVector& msmsDataPointList, int fracti
 		}
 	}
 }
+void APLDataReader::getPeakListIndexEntries ( PeakListIndexEntryVector& entries )
+{
+	for ( ; ; ) {
+		PeakListIndexEntry entry;
+		entry.offset = istr.tellg ();
+		string spot;
+		string msmsInfo;
+		DoubleVector mVector;
+		IntVector zVector;
+		int spectrumNumber;
+		parseHeaderLines ( spot, spectrumNumber, msmsInfo, mVector, zVector );
+		entry.mOverZ = mVector.empty () ? 0.0 : mVector [0];
+		entry.rt = -1.0;
+		entry.scan = PeakListIndex::getScanNumber ( msmsInfo );
+		entry.charge = zVector.empty () ? 0 : zVector [0];
+		entry.titleHash = 0;
+		entry.pad = 0;
+		entries.push_back ( entry );
+		if ( skipMSMSData () == false ) break;	// End of file
+	}
+	spotNumber.clear ();
+}
 bool APLDataReader::readMSMSData ()
 {
 	dataPoint->clear ();
@@ -797,34 +903,63 @@ MGFDataReader::MGFDataReader ( const string& s, bool fileFlag ) :
 void MGFDataReader::initMaps ( int fraction, int chrg, const string& version, UpdatingJavascriptMessage* ujm )
 // Used by BiblioSpec creation in Search Compare
 {
-	string line;
 	bool readRT = version == "" || !Version::isOlderVersion ( version, "5.13.1" );
+	PeakListIndex* pli = getPeakListIndex ( PeakListIndex::MGF_FORMAT );
+	if ( pli ) {
+		initMaps ( pli, fraction, readRT, ujm );
+		delete pli;
+		return;
+	}
+	string line;
 	while ( getline ( istr, line ) ) {
 		if ( line.length () != 0 && line [0] != '#' ) {
 			if ( !line.compare ( 0, 5, "BEGIN" ) ) spos = istr.tellg ();
-			else {
-				string spot = gen_itoa ( num + 1 );
-				int run = 1;
-				string msmsInfo;
-				if ( MGFInfo::instance ().getTitleParams ( line, spot, run, msmsInfo ) ) {
-					if ( msmsInfo == "s" ) {
-						msmsInfo = MGFInfo::instance ().getMSMSInfoFromScans ( getScansFromScanLine () );
-					}
-					if ( readRT ) getRTInSeconds ( spot );		// The spot field is filled with the RTINSECONDS line if present
-					MapStringToIntIterator cur = spotNumber.find ( spot );
-					if ( cur != spotNumber.end () ) cur->second++;
-					else spotNumber [spot] = 1;
-					cur = spotNumber.find ( spot );
-					int spectrumNumber = cur->second;
-					ostringstream ost;
-					num++;
-					if ( num % 100 == 0 ) ujm->writeMessage ( cout, "Initializing peak list map " + gen_itoa ( num ) + " spectra processed" );
-					ost << fraction << '-' << spot << '-' << run << '-' << spectrumNumber;
-					mapSpecID [ost.str ()] = spos;
-				}
+			else addToMaps ( line, fraction, readRT, ujm );
+		}
+	}
+}
+void MGFDataReader::initMaps ( PeakListIndex* pli, int fraction, bool readRT, UpdatingJavascriptMessage* ujm )
+// Only the header lines of each spectrum are read
+{
+	GENINT64 lastOffset = -1;
+	for ( GENINT64 i = 0 ; i < pli->size () ; i++ ) {
+		GENINT64 offset = pli->getEntry ( i ).offset;
+		if ( offset == lastOffset ) continue;		// More than one title in the spectrum
+		lastOffset = offset;
+		spos = offset;
+		istr.clear ();
+		istr.seekg ( spos );
+		string line;
+		while ( getline ( istr, line ) ) {
+			if ( line.length () != 0 && line [0] != '#' ) {
+				if ( isdigit ( line [0] ) || !line.compare ( 0, 3, "END" ) ) break;
+				addToMaps ( line, fraction, readRT, ujm );
 			}
 		}
 	}
+	istr.clear ();
+}
+void MGFDataReader::addToMaps ( const string& line, int fraction, bool readRT, UpdatingJavascriptMessage* ujm )
+{
+	string spot = gen_itoa ( num + 1 );
+	int run = 1;
+	string msmsInfo;
+	if ( MGFInfo::instance ().getTitleParams ( line, spot, run, msmsInfo ) ) {
+		if ( msmsInfo == "s" ) {
+			msmsInfo = MGFInfo::instance ().getMSMSInfoFromScans ( getScansFromScanLine () );
+		}
+		if ( readRT ) getRTInSeconds ( spot );		// The spot field is filled with the RTINSECONDS line if present
+		MapStringToIntIterator cur = spotNumber.find ( spot );
+		if ( cur != spotNumber.end () ) cur->second++;
+		else spotNumber [spot] = 1;
+		cur = spotNumber.find ( spot );
+		int spectrumNumber = cur->second;
+		ostringstream ost;
+		num++;
+		if ( num % 100 == 0 ) ujm->writeMessage ( cout, "Initializing peak list map " + gen_itoa ( num ) + " spectra processed" );
+		ost << fraction << '-' << spot << '-' << run << '-' << spectrumNumber;
+		mapSpecID [ost.str ()] = spos;
+	}
 }
 void MGFDataReader::getData ( MSMSDataPointVector& msmsDataPointList, const SpecID& specID, int chrg, const string& version, UpdatingJavascriptMessage* ujm )
 // Used by BiblioSpec creation in Search Compare
@@ -883,6 +1018,16 @@ void MGFDataReader::getData ( MSMSDataPointVector& msmsDataPointList, int fracti
 }
 void MGFDataReader::getDataFromTitle ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, const string& title, int chrg, int off )
 {
+	if ( off == 0 && num == 0 ) {
+		PeakListIndex* pli = getPeakListIndex ( PeakListIndex::MGF_FORMAT );
+		if ( pli ) {
+			bool found = getDataFromTitle ( pli, msmsDataPointList, title, chrg );
+			delete pli;
+			if ( found ) return;
+			istr.clear ();
+			istr.seekg ( 0 );
+		}
+	}
 	if ( off != 0 ) istr.seekg ( off );
 	string line;
 	spos = istr.tellg ();
@@ -903,8 +1048,33 @@ void MGFDataReader::getDataFromTitle ( MSMSDataPointVector& msmsDataPointList, i
 		}
 	}
 }
+bool MGFDataReader::getDataFromTitle ( PeakListIndex* pli, MSMSDataPointVector& msmsDataPointList, const string& title, int chrg )
+{
+	IntVector iv = pli->getTitleEntries ( title );
+	for ( IntVectorSizeType i = 0 ; i < iv.size () ; i++ ) {
+		streampos sp = pli->getEntry ( iv [i] ).offset;
+		string line;
+		if ( getTitleLine ( sp, line ) && !line.compare ( 0, 5, "TITLE" ) && !line.substr ( 6 ).compare ( title ) ) {
+			num = iv [i] + 1;
+			readSpectrum ( msmsDataPointList, sp, chrg );
+			return true;
+		}
+	}
+	return false;
+}
 void MGFDataReader::getDataFromIndex ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, int index, int chrg, int off )
 {
+	if ( off == 0 && num == 0 ) {
+		PeakListIndex* pli = getPeakListIndex ( PeakListIndex::MGF_FORMAT );
+		if ( pli ) {
+			if ( index >= 1 && index <= pli->size () ) {
+				num = index;
+				readSpectrum ( msmsDataPointList, pli->getEntry ( index - 1 ).offset, chrg );
+			}
+			delete pli;
+			return;
+		}
+	}
 	if ( off != 0 ) istr.seekg ( off );
 	string line;
 	spos = istr.tellg ();
@@ -927,6 +1097,16 @@ void MGFDataReader::getDataFromIndex ( MSMSDataPointVector& msmsDataPointList, i
 }
 void MGFDataReader::getDataFromMOverZ ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, double mOverZ, int chrg, int off )
 {
+	if ( off == 0 && num == 0 ) {
+		PeakListIndex* pli = getPeakListIndex ( PeakListIndex::MGF_FORMAT );
+		if ( pli ) {
+			bool found = getDataFromMOverZ ( pli, msmsDataPointList, mOverZ, chrg );
+			delete pli;
+			if ( found ) return;
+			istr.clear ();
+			istr.seekg ( 0 );
+		}
+	}
 	if ( off != 0 ) istr.seekg ( off );
 	string line;
 	spos = istr.tellg ();
@@ -944,8 +1124,32 @@ void MGFDataReader::getDataFromMOverZ ( MSMSDataPointVector& msmsDataPointList,
 		}
 	}
 }
+bool MGFDataReader::getDataFromMOverZ ( PeakListIndex* pli, MSMSDataPointVector& msmsDataPointList, double mOverZ, int chrg )
+{
+	IntVector iv = pli->getMOverZEntries ( mOverZ );
+	for ( IntVectorSizeType i = 0 ; i < iv.size () ; i++ ) {
+		istr.clear ();
+		istr.seekg ( pli->getEntry ( iv [i] ).offset );
+		msmsDataPoint.setPointInfo ( 1, "", 1, 1, "" );
+		if ( readMSMSData ( msmsDataPointList, chrg, 0, mOverZ ) ) {
+			num = iv [i] + 1;
+			return true;
+		}
+	}
+	return false;
+}
 void MGFDataReader::getDataFromScanNumber ( MSMSDataPointVector& msmsDataPointList, int fraction, const SpectrumRange& spectrumRange, const string& scanNumber, int chrg, int off )
 {
+	if ( off == 0 && num == 0 ) {
+		PeakListIndex* pli = getPeakListIndex ( PeakListIndex::MGF_FORMAT );
+		if ( pli ) {
+			bool found = getDataFromScanNumber ( pli, msmsDataPointList, scanNumber, chrg );
+			delete pli;
+			if ( found ) return;
+			istr.clear ();
+			istr.seekg ( 0 );
+		}
+	}
 	if ( off != 0 ) istr.seekg ( off );
 	string line;
 	spos = istr.tellg ();
@@ -960,14 +1164,7 @@ void MGFDataReader::getDataFromScanNumber ( MSMSDataPointVector& msmsDataPointLi
 					if ( msmsInfo == "s" ) {
 						msmsInfo = MGFInfo::instance ().getMSMSInfoFromScans ( getScansFromScanLine () );
 					}
-					int c1 = scanNumber.find ( ',' );
-					if ( c1 == string::npos ) {				// If no comma in scanNumber
-						int c2 = msmsInfo.find ( ',' );
-						if ( c2 != string::npos ) {			// If comma in msmsInfo
-							msmsInfo = msmsInfo.substr ( 0, c2 );
-						}
-					}
-					if ( msmsInfo == scanNumber ) {
+					if ( isScanNumber ( msmsInfo, scanNumber ) ) {
 						istr.seekg ( spos );
 						msmsDataPoint.setPointInfo ( 1, "", 1, 1, "" );
 						readMSMSData ( msmsDataPointList, chrg, 0 );
@@ -978,6 +1175,114 @@ void MGFDataReader::getDataFromScanNumber ( MSMSDataPointVector& msmsDataPointLi
 		}
 	}
 }
+bool MGFDataReader::getDataFromScanNumber ( PeakListIndex* pli, MSMSDataPointVector& msmsDataPointList, const string& scanNumber, int chrg )
+{
+	int scan = PeakListIndex::getScanNumber ( scanNumber );
+	if ( scan == -1 ) return false;
+	IntVector iv = pli->getScanEntries ( scan );
+	for ( IntVectorSizeType i = 0 ; i < iv.size () ; i++ ) {
+		streampos sp = pli->getEntry ( iv [i] ).offset;
+		string line;
+		if ( getTitleLine ( sp, line ) ) {
+			string spot;
+			int run = 1;
+			string msmsInfo;
+			MGFInfo::instance ().getTitleParams ( line, spot, run, msmsInfo );
+			if ( msmsInfo == "s" ) {
+				msmsInfo = MGFInfo::instance ().getMSMSInfoFromScans ( getScansFromScanLine () );
+			}
+			if ( isScanNumber ( msmsInfo, scanNumber ) ) {
+				num = iv [i] + 1;
+				readSpectrum ( msmsDataPointList, sp, chrg );
+				return true;
+			}
+		}
+	}
+	return false;
+}
+bool MGFDataReader::isScanNumber ( string msmsInfo, const string& scanNumber )
+{
+	int c1 = scanNumber.find ( ',' );
+	if ( c1 == string::npos ) {				// If no comma in scanNumber
+		int c2 = msmsInfo.find ( ',' );
+		if ( c2 != string::npos ) {			// If comma in msmsInfo
+			msmsInfo = msmsInfo.substr ( 0, c2 );
+		}
+	}
+	return msmsInfo == scanNumber;
+}
+bool MGFDataReader::getTitleLine ( streampos sp, string& line )
+// Reads the first title line of the spectrum starting at sp
+{
+	istr.clear ();
+	istr.seekg ( sp );
+	while ( getline ( istr, line ) ) {
+		if ( line.length () != 0 && line [0] != '#' ) {
+			if ( line [0] == 'T' ) return true;
+			if ( isdigit ( line [0] ) || !line.compare ( 0, 3, "END" ) ) break;
+		}
+	}
+	return false;
+}
+void MGFDataReader::readSpectrum ( MSMSDataPointVector& msmsDataPointList, streampos sp, int chrg )
+{
+	spos = sp;					// So rewind goes back to the start of this spectrum
+	istr.clear ();
+	istr.seekg ( sp );
+	msmsDataPoint.setPointInfo ( 1, "", 1, 1, "" );
+	readMSMSData ( msmsDataPointList, chrg, 0 );
+}
+void MGFDataReader::getPeakListIndexEntries ( PeakListIndexEntryVector& entries )
+// There is an entry for each title line. The precursor information is set at the end of the spectrum.
+{
+	string line;
+	streampos sp = istr.tellg ();
+	PeakListIndexEntryVector::size_type start = 0;
+	double mOverZ = 0.0;
+	double rt = -1.0;
+	int charge = 0;
+	while ( getline ( istr, line ) ) {
+		if ( line.length () == 0 || line [0] == '#' || isdigit ( line [0] ) ) continue;
+		if ( !line.compare ( 0, 5, "BEGIN" ) ) {
+			sp = istr.tellg ();
+			start = entries.size ();
+			mOverZ = 0.0;
+			rt = -1.0;
+			charge = 0;
+		}
+		else if ( !line.compare ( 0, 5, "TITLE" ) ) {
+			PeakListIndexEntry entry;
+			entry.offset = sp;
+			string spot;
+			int run = 1;
+			string msmsInfo;
+			MGFInfo::instance ().getTitleParams ( line, spot, run, msmsInfo );
+			if ( msmsInfo == "s" ) {
+				msmsInfo = MGFInfo::instance ().getMSMSInfoFromScans ( getScansFromScanLine () );
+			}
+			entry.scan = PeakListIndex::getScanNumber ( msmsInfo );
+			entry.titleHash = PeakListIndex::getTitleHash ( line.substr ( 6 ) );
+			entry.pad = 0;
+			entries.push_back ( entry );
+		}
+		else if ( !line.compare ( 0, 8, "PEPMASS=" ) )		mOverZ = atof ( line.substr ( 8 ).c_str () );
+		else if ( !line.compare ( 0, 7, "CHARGE=" ) )		charge = atoi ( line.substr ( 7 ).c_str () );
+		else if ( !line.compare ( 0, 12, "RTINSECONDS=" ) )	rt = atof ( line.substr ( 12 ).c_str () );
+		else if ( !line.compare ( 0, 3, "END" ) ) {
+			setPrecursorInfo ( entries, start, mOverZ, rt, charge );
+			start = entries.size ();
+		}
+	}
+	setPrecursorInfo ( entries, start, mOverZ, rt, charge );	// No END IONS line at the end of the file
+}
+void MGFDataReader::setPrecursorInfo ( PeakListIndexEntryVector& entries, PeakListIndexEntryVector::size_type start, double mOverZ, double rt, int charge )
+{
+	for ( PeakListIndexEntryVector::size_type i = start ; i < entries.size () ; i++ ) {
+		entries [i].mOverZ = mOverZ;
+		entries [i].rt = rt;
+		entries [i].charge = charge;
+	}
+}
 void MGFDataReader::writePeakList ( ostream& os )
 {
 	int c;
@@ -273,6 +273,7 @@ void DataSetInfo::parseData ( const ParameterList* params, const string& scanNum
 void DataSetInfo::initDataReader ( const string& s, bool fileFlag )
 {
 	bool illegal = false;
+	string peakList = getUncompressedFilename ( s );
 	if ( dataFormat == "PP M/Z Intensity Charge" || dataFormat == "PP M/Z Charge" ) {
 		if ( fileFlag ) {
 			if ( !isTextFile ( s, 256 ) ) {
@@ -300,11 +301,11 @@ void DataSetInfo::initDataReader ( const string& s, bool fileFlag )
 		dr = new MS2DataReader ( s, fileFlag );
 	else if ( dataFormat == APL )
 		dr = new APLDataReader ( s, fileFlag );
-	else if ( isFileType ( s, MGF ) )
+	else if ( isFileType ( peakList, MGF ) )
 		dr = new MGFDataReader ( s, fileFlag );
-	else if ( isFileType ( s, MS2 ) )
+	else if ( isFileType ( peakList, MS2 ) )
 		dr = new MS2DataReader ( s, fileFlag );
-	else if ( isFileType ( s, APL ) )
+	else if ( isFileType ( peakList, APL ) )
 		dr = new APLDataReader ( s, fileFlag );
 #ifdef BATCHTAG
 	else if ( isFileType ( s, MZXML ) )
@@ -0,0 +1,158 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_dig_cache.cpp                                              *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Cache of database digests shared between the serial searches  *
+*               of a Batch-Tag job.                                           *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstring>
+#include <lgen_file.h>
+#include <lgen_mmap.h>
+#include <lp_frame.h>
+#include <lu_dig_cache.h>
+using std::string;
+using std::ios_base;
+using std::ofstream;
+using std::make_pair;
+
+namespace {
+const int RECORD_ALIGNMENT = sizeof (double);
+int getRecordSize ( int numFragments )
+{
+	int size = 2 * sizeof (int) + numFragments * ( sizeof (double) + sizeof (int) );
+	return ( ( size + RECORD_ALIGNMENT - 1 ) / RECORD_ALIGNMENT ) * RECORD_ALIGNMENT;
+}
+}
+
+DigestCacheKey::DigestCacheKey ( int database, const FrameIterator& fi ) :
+	database ( database ),
+	entry ( fi.getEntry () ),
+	frameTranslation ( fi.getFrameTranslation () ),
+	frame ( fi.getFrame () )
+{
+}
+
+const int DigestCache::BLOCK_SIZE = 4 * 1048576;
+
+DigestCache::DigestCache ( const string& spillFile, GENINT64 maxMemory ) :
+	blockUsed ( BLOCK_SIZE ),
+	memoryUsed ( 0 ),
+	maxMemory ( maxMemory ),
+	spillFile ( spillFile ),
+	spill ( 0 ),
+	spillSize ( 0 ),
+	spillMap ( 0 ),
+	building ( true )
+{
+}
+DigestCache::~DigestCache ()
+{
+	for ( CharPtrVectorSizeType i = 0 ; i < blocks.size () ; i++ ) {
+		delete [] blocks [i];
+	}
+	delete spill;
+	delete spillMap;
+	if ( genFileExists ( spillFile ) ) genUnlink ( spillFile );
+}
+char* DigestCache::allocate ( int size )
+{
+	if ( size > BLOCK_SIZE ) {						// Very long frames get a block of their own
+		blocks.insert ( blocks.begin (), new char [size] );
+		memoryUsed += size;
+		return blocks.front ();
+	}
+	if ( blockUsed + size > BLOCK_SIZE ) {
+		blocks.push_back ( new char [BLOCK_SIZE] );
+		memoryUsed += BLOCK_SIZE;
+		blockUsed = 0;
+	}
+	char* p = blocks.back () + blockUsed;
+	blockUsed += size;
+	return p;
+}
+void DigestCache::add ( int database, const FrameIterator& fi, int frameLength, const IntVector& cleavageIndex, const DoubleVector& mass )
+{
+	DigestCacheKey key ( database, fi );
+	int numFragments = cleavageIndex.size ();
+	int size = getRecordSize ( numFragments );
+	GenMutexLock lock ( mutex );					// Searches on several threads may be adding records
+	if ( !building || records.find ( key ) != records.end () ) return;
+	char* record;
+	string spillRecord;
+	bool inBlock = size <= BLOCK_SIZE && blockUsed + size <= BLOCK_SIZE;
+	if ( inBlock || memoryUsed + genMax ( size, BLOCK_SIZE ) <= maxMemory ) {
+		record = allocate ( size );
+	}
+	else {
+		if ( spill == 0 ) {
+			spill = new ofstream ( spillFile.c_str (), ios_base::binary );
+			if ( !*spill ) return;					// The cache just holds what has been added so far
+		}
+		spillRecord.resize ( size );
+		record = &spillRecord [0];
+	}
+	int* header = reinterpret_cast <int*> (record);
+	header [0] = numFragments;
+	header [1] = frameLength;
+	if ( numFragments ) {
+		memcpy ( record + 2 * sizeof (int), &mass [0], numFragments * sizeof (double) );
+		memcpy ( record + 2 * sizeof (int) + numFragments * sizeof (double), &cleavageIndex [0], numFragments * sizeof (int) );
+	}
+	if ( spillRecord.empty () ) {
+		records.insert ( make_pair ( key, Record ( record, 0 ) ) );
+	}
+	else {
+		spill->write ( record, size );
+		records.insert ( make_pair ( key, Record ( 0, spillSize ) ) );
+		spillSize += size;
+	}
+}
+bool DigestCache::get ( int database, const FrameIterator& fi, int frameLength, int& numFragments, const int*& cleavageIndex, const double*& mass ) const
+{
+	if ( building ) return false;
+	RecordMapConstIterator cur = records.find ( DigestCacheKey ( database, fi ) );
+	if ( cur == records.end () || cur->second.data == 0 ) return false;
+	const char* record = cur->second.data;
+	const int* header = reinterpret_cast <const int*> (record);
+	if ( header [1] != frameLength ) return false;	// Not the same frame
+	numFragments = header [0];
+	mass = reinterpret_cast <const double*> (record + 2 * sizeof (int));
+	cleavageIndex = reinterpret_cast <const int*> (record + 2 * sizeof (int) + numFragments * sizeof (double));
+	return true;
+}
+/*
+Called once the first serial search is complete. Spilled records can't be read until
+the spill file is mapped.
+*/
+void DigestCache::freeze ()
+{
+	GenMutexLock lock ( mutex );
+	if ( !building ) return;
+	building = false;
+	if ( spill == 0 ) return;
+	spill->close ();
+	bool ok = !spill->fail ();
+	delete spill;
+	spill = 0;
+	if ( !ok || spillSize == 0 ) return;			// Spilled records are recalculated
+	spillMap = new MMapFile <char> ( spillFile, 0, spillSize, MMAP_ADVICE_RANDOM );
+	const char* base = spillMap->getStartPointer ();
+	for ( RecordMapIterator i = records.begin () ; i != records.end () ; i++ ) {
+		if ( i->second.data == 0 ) i->second.data = base + i->second.spillOffset;
+	}
+}
@@ -26,16 +26,21 @@
 #include <lg_new.h>
 #include <lg_stdio.h>
 #include <lgen_file.h>
+#include <lgen_uncompress.h>
 #include <lu_fasta.h>
 #include <lu_acc_num.h>
 #include <lu_mass_seq.h>
 #include <lu_pi.h>
+#include <lu_pep_index.h>
+#include <lu_seq_pack.h>
+#include <lu_const_mod.h>
 #include <lu_getfil.h>
 #include <lu_mass.h>
 #include <lu_html.h>
 #include <lu_check_db.h>
 #include <lg_string.h>
 #include <lu_species.h>
+#include <lgen_thread.h>
 using std::string;
 using std::vector;
 using std::ios_base;
@@ -202,6 +207,7 @@ static void processAlphaNumericAccessionNumbers ( FastaServer* fs, const string&
 static void processNumericAccessionNumbers ( FastaServer* fs, const string& fileName );
 static void processMW ( FastaServer* fs, const string& fileName );
 static void processPI ( FastaServer* fs, const string& fileName );
+static void processPeptideIndex ( FastaServer* fs, const string& fileName );
 static string convertDNADatabaseToProteinDatabase ( const string& database );
 static void deleteDatabaseFiles ( const string& database );
 static void deleteDatabaseIndexFiles ( const string& database );
@@ -226,6 +232,53 @@ void create_new_database_from_indicies_list ( FastaServer* fs, const string& dat
  		ost.write ( (char*) entry, length * sizeof (char) );
 	}
 }
+/*
+Creates a newly downloaded database from a .gz or single entry .zip file in the seqdb directory if
+the uncompressed file doesn't exist. The file is decompressed in process as it is read and any CR
+characters are converted at the same time.
+*/
+void importCompressedDatabase ( const string& database )
+{
+	if ( genFileExists ( SeqdbDir::instance ().getDatabasePath ( database ) ) ) return;
+	string path = SeqdbDir::instance ().getDatabasePathCreateOrAppend ( database );
+	string compressedPath;
+	if ( genFileExists ( path + ".gz" ) )		compressedPath = path + ".gz";
+	else if ( genFileExists ( path + ".zip" ) )	compressedPath = path + ".zip";
+	else return;
+	ErrorHandler::genError ()->message ( "\nCreating the database file from " + genFilenameFromPath ( compressedPath ) + ".\n" );
+	GenZIFStream ist ( compressedPath );
+	GenOFStream ost ( path, ios_base::binary );
+	vector <char> in ( 65536 );
+	vector <char> out;
+	out.reserve ( in.size () );
+	bool previousCR = false;
+	try {
+		while ( ist ) {
+			ist.read ( &in [0], in.size () );
+			out.clear ();
+			for ( std::streamsize i = 0 ; i < ist.gcount () ; i++ ) {
+				char c = in [i];
+				if ( c == '\n' && previousCR ) {		// Second character of a DOS line end
+					previousCR = false;
+					continue;
+				}
+				previousCR = ( c == '\r' );
+				out.push_back ( previousCR ? '\n' : c );
+			}
+			if ( !out.empty () ) ost.write ( &out [0], out.size () );
+		}
+	}
+	catch ( runtime_error e ) {
+		ost.close ();
+		genUnlink ( path );
+		throw;
+	}
+	ost.close ();
+	if ( ost.fail () ) {
+		genUnlink ( path );
+		ErrorHandler::genError ()->error ( "File write failure.\nFilename: " + genEscapePath ( path ) + ".\n" );
+	}
+}
 void create_database_files ( const string& fileName, bool parallel )
 {
 	deleteDatabaseIndexFiles ( fileName );
@@ -241,6 +294,8 @@ void create_database_files ( const string& fileName, bool parallel )
 
 	if ( parallel )	faindexParallel ( fs, fileName );
 	else			faindexSerial ( fs, fileName );
+	processPeptideIndex ( fs, fileName );
+	if ( InfoParams::instance ().getBoolValue ( "faindex_packed_sequences", false ) ) PackedSequenceStore::create ( fs );
 
 	delete fs;
 }
@@ -254,43 +309,71 @@ static void faindexSerial ( FastaServer* fs, const string& fileName )
 	processAccessionNumbers ( fs, fileName );
 	processSpecies ( fs, fileName );
 }
-static void faindexParallel ( FastaServer* fs, const string& fileName )
-{
-	bool spFlag = is_swissprot_database ( fileName ) || is_uniprot_database ( fileName );
-	bool dna_database = is_dna_database ( fileName );
-	int numEntries = fs->getNumEntries ();
-	bool numAccessionNumber = is_numeric_acc_number_database ( fileName );
-
+/*
+Each thread indexes a contiguous range of entries with its own FastaServer so the comment line
+parsing and sequence reading are independent. The species map is shared as it is read only.
+*/
+class FAIndexThread : public GenThread {
+	FastaServer* fs;
+	bool ownFS;
+	UniprotAndNCBISpeciesMap& unspm;
+	int firstEntry;
+	int lastEntry;
+	int numThreads;
+	bool dnaDatabase;
+	bool numAccessionNumber;
+	IndexedDouble* mole_wt;
+	IndexedDouble* pi;
+	void run ();
+public:
 	VectorIndexedInt species;
-	species.reserve ( numEntries );
-
-	GenOFStream ost1 ( SeqdbDir::instance ().getSeqdbDir () + fileName + ".unr" );	// Unreadable entries
-	UpdatingJavascriptMessage ujm;
-	UniprotAndNCBISpeciesMap unspm ( spFlag );
-	SetString unkSpecies;
-	bool unr = false;
 	vector <IndexedInt> numericAccessionNumber;
 	VectorIndexedConstCString accessionNumber;
+	SetString unkSpecies;
+	StringVector unreadable;
+	FAIndexThread ( FastaServer* fsPtr, bool ownFS, UniprotAndNCBISpeciesMap& unspm, int firstEntry, int lastEntry, int numThreads, bool dnaDatabase, bool numAccessionNumber, IndexedDouble* mole_wt, IndexedDouble* pi );
+	~FAIndexThread ();
+	void process ();
+	int getUnreadableSpeciesCount () const { return fs->getUnreadableSpeciesCount (); }
+};
+FAIndexThread::FAIndexThread ( FastaServer* fsPtr, bool ownFS, UniprotAndNCBISpeciesMap& unspm, int firstEntry, int lastEntry, int numThreads, bool dnaDatabase, bool numAccessionNumber, IndexedDouble* mole_wt, IndexedDouble* pi ) :
+	fs ( ownFS ? new FastaServer ( fsPtr->getFilePath ().empty () ? fsPtr->getFileName () : fsPtr->getFilePath () ) : fsPtr ),
+	ownFS ( ownFS ),
+	unspm ( unspm ),
+	firstEntry ( firstEntry ),
+	lastEntry ( lastEntry ),
+	numThreads ( numThreads ),
+	dnaDatabase ( dnaDatabase ),
+	numAccessionNumber ( numAccessionNumber ),
+	mole_wt ( mole_wt ),
+	pi ( pi )
+{
+	species.reserve ( lastEntry - firstEntry );
 	if ( numAccessionNumber )
-		numericAccessionNumber.reserve ( numEntries );
+		numericAccessionNumber.reserve ( lastEntry - firstEntry );
 	else
-		accessionNumber.reserve ( numEntries );
-	IndexedDouble* mole_wt;
-	IndexedDouble* pi;
-	if ( !dna_database ) {
-		mole_wt = new IndexedDouble [numEntries];
-		pi = new IndexedDouble [numEntries];
-	}
-	for ( int n = 0 ; n < numEntries ; n++ ) {
+		accessionNumber.reserve ( lastEntry - firstEntry );
+}
+FAIndexThread::~FAIndexThread ()
+{
+	if ( ownFS ) delete fs;
+}
+void FAIndexThread::run ()
+{
+	process ();
+}
+void FAIndexThread::process ()
+{
+	UpdatingJavascriptMessage ujm;
+	for ( int n = firstEntry ; n < lastEntry ; n++ ) {
 		int n_plus_1 = n+1;
-		if ( n_plus_1 % REPORTING_FREQUENCY == 0 ) ujm.writeMessage ( cout, n_plus_1 );
+		if ( firstEntry == 0 && n_plus_1 % REPORTING_FREQUENCY == 0 ) ujm.writeMessage ( cout, n_plus_1 * numThreads );	// Only the first thread reports. The count is an estimate for the whole database.
 		for ( fs->firstLine ( n_plus_1 ) ; fs->isDoneLine () ; fs->nextLine () ) {
 			string lineSpecies = fs->getLineSpecies ();
 			IndexedInt speciesEntry;
 			if ( lineSpecies == "UNREADABLE" ) {
 				speciesEntry.number = -1;
-				ost1 << fs->getLineName () << '\n';
-				unr = true;
+				unreadable.push_back ( fs->getLineName () );
 			}
 			else {
 				speciesEntry.number = unspm.getNode ( lineSpecies );
@@ -315,7 +398,7 @@ static void faindexParallel ( FastaServer* fs, const string& fileName )
 				accessionNumber.push_back ( an );
 			}
 		}
-		if ( !dna_database ) {
+		if ( !dnaDatabase ) {												// Each thread writes to its own range of the arrays
 			char* frame = fs->get_fasta_protein ( n_plus_1, 1 );
 			mole_wt [n].index = n_plus_1;
 			ProteinMW pmw ( frame );
@@ -326,11 +409,67 @@ static void faindexParallel ( FastaServer* fs, const string& fileName )
 			pi [n].number = ppi.getProteinPI ();
 		}
 	}
+	if ( firstEntry == 0 ) ujm.deletePreviousMessage ( cout );
+}
+static void faindexParallel ( FastaServer* fs, const string& fileName )
+{
+	bool spFlag = is_swissprot_database ( fileName ) || is_uniprot_database ( fileName );
+	bool dna_database = is_dna_database ( fileName );
+	int numEntries = fs->getNumEntries ();
+	bool numAccessionNumber = is_numeric_acc_number_database ( fileName );
+
+	int numThreads = InfoParams::instance ().getIntValue ( "faindex_num_threads", 0 );
+	if ( numThreads <= 0 ) numThreads = genGetNumProcessors ();
+	numThreads = genMax ( 1, genMin ( numThreads, numEntries / REPORTING_FREQUENCY + 1 ) );	// Small databases aren't worth splitting
+	if ( numThreads > 1 ) ErrorHandler::genError ()->message ( "Indexing with " + gen_itoa ( numThreads ) + " threads.\n" );
+
+	UniprotAndNCBISpeciesMap unspm ( spFlag );
+	IndexedDouble* mole_wt;
+	IndexedDouble* pi;
+	if ( !dna_database ) {
+		mole_wt = new IndexedDouble [numEntries];
+		pi = new IndexedDouble [numEntries];
+	}
+	vector <FAIndexThread*> threads ( numThreads );
+	for ( int i = 0 ; i < numThreads ; i++ ) {
+		int start = static_cast <int> ( static_cast <GENINT64> (numEntries) * i / numThreads );
+		int end = static_cast <int> ( static_cast <GENINT64> (numEntries) * ( i + 1 ) / numThreads );
+		threads [i] = new FAIndexThread ( fs, numThreads > 1, unspm, start, end, numThreads, dna_database, numAccessionNumber, mole_wt, pi );
+	}
+	if ( numThreads == 1 ) threads [0]->process ();
+	else {
+		for ( int j = 0 ; j < numThreads ; j++ ) threads [j]->start ();
+		for ( int k = 0 ; k < numThreads ; k++ ) threads [k]->join ();
+	}
+	VectorIndexedInt species;
+	species.reserve ( numEntries );
+	vector <IndexedInt> numericAccessionNumber;
+	VectorIndexedConstCString accessionNumber;
+	if ( numAccessionNumber )
+		numericAccessionNumber.reserve ( numEntries );
+	else
+		accessionNumber.reserve ( numEntries );
+	SetString unkSpecies;
+	bool unr = false;
+	int unreadableCount = 0;
+	GenOFStream ost1 ( SeqdbDir::instance ().getSeqdbDir () + fileName + ".unr" );	// Unreadable entries
+	for ( int m = 0 ; m < numThreads ; m++ ) {		// Merge in entry order
+		FAIndexThread* t = threads [m];
+		species.insert ( species.end (), t->species.begin (), t->species.end () );
+		numericAccessionNumber.insert ( numericAccessionNumber.end (), t->numericAccessionNumber.begin (), t->numericAccessionNumber.end () );
+		accessionNumber.insert ( accessionNumber.end (), t->accessionNumber.begin (), t->accessionNumber.end () );
+		unkSpecies.insert ( t->unkSpecies.begin (), t->unkSpecies.end () );
+		for ( StringVectorSizeType n = 0 ; n < t->unreadable.size () ; n++ ) {
+			ost1 << t->unreadable [n] << '\n';
+			unr = true;
+		}
+		unreadableCount += t->getUnreadableSpeciesCount ();
+		delete t;
+	}
 	ost1.close ();
-	ujm.deletePreviousMessage ( cout );
 
 	if ( unr ) {
-		ErrorHandler::genError ()->message ( gen_itoa ( fs->getUnreadableSpeciesCount () ) + " comment lines contained unreadable species. These are listed in the .unr file.\n" );
+		ErrorHandler::genError ()->message ( gen_itoa ( unreadableCount ) + " comment lines contained unreadable species. These are listed in the .unr file.\n" );
 	}
 	else genUnlink ( SeqdbDir::instance ().getSeqdbDir () + fileName + ".unr" );
 
@@ -484,6 +623,21 @@ static void processPI ( FastaServer* fs, const string& fileName )
 	ujm.deletePreviousMessage ( cout );
 	writePI ( fileName, pi, numEntries );
 }
+static void processPeptideIndex ( FastaServer* fs, const string& fileName )
+{
+	string enzyme = InfoParams::instance ().getStringValue ( "faindex_peptide_index_enzyme", "" );
+	if ( enzyme.empty () || is_dna_database ( fileName ) ) return;
+	MapStringConstModPtr constMods;			// The index is only used by searches with the same constant modifications
+	StringVector constModNames = InfoParams::instance ().getStringVectorValue ( "faindex_peptide_index_const_mod" );
+	for ( StringVectorSizeType i = 0 ; i < constModNames.size () ; i++ ) {
+		ConstMod* cMod = new ConstMod ( constModNames [i] );
+		constMods [cMod->getAAList ()] = cMod;
+	}
+	initialise_amino_acid_weights ( constMods, ElementalFormulaVector (), true );
+	int missedCleavages = InfoParams::instance ().getIntValue ( "faindex_peptide_index_missed_cleavages", 2 );
+	double maxMass = InfoParams::instance ().getDoubleValue ( "peptide_index_max_mass", 6000.0 );
+	PeptideMassIndex::create ( fs, enzyme, missedCleavages, maxMass );
+}
 static void deleteCRCharactersFromDatabaseFile ( const string& fileName )
 {
 	string name2 = SeqdbDir::instance ().getDatabasePath ( fileName );
@@ -676,7 +830,7 @@ static void deleteDatabaseFiles ( const string& database )
 static void deleteDatabaseIndexFiles ( const string& database )
 {
 	static string database_extension [] = {
-		"acc", "acn", "idx", "idc", "idp", "idi", "mw", "pi", "sl", "sp", "tax", "tl", "unk", "unr", "usp", "END"
+		"acc", "aco", "acn", "idx", "idc", "idp", "idi", "mw", "pi", "psi", "psq", "sl", "sp", "tax", "tl", "unk", "unr", "usp", "END"
 	};
 	for ( int i = 0 ; database_extension [i] != "END" ; i++ ) {
 		string fileName = SeqdbDir::instance ().getSeqdbDir () + database + string ( "." ) + database_extension [i];
@@ -739,6 +893,8 @@ static void writeACC ( const string& fileName, VectorIndexedConstCString& access
 	for ( VectorIndexedConstCStringSizeType ii = 0 ; ii < accessionNumber.size () ; ii++ ) {
 		delete [] const_cast <char*> (accessionNumber [ii].name);
 	}
+	ErrorHandler::genError ()->message ( "Creating accession number offset file (.aco).\n" );
+	createAccessionNumberOffsetFile ( fileName );
 }
 static void writeMW ( const string& fileName, IndexedDouble* mole_wt, int numEntries )
 {
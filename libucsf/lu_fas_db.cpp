@@ -34,6 +34,7 @@
 #include <lu_html_form.h>
 #include <lu_cgi_val.h>
 #include <lu_db_entry.h>
+#include <lu_seq_pack.h>
 using std::string;
 using std::runtime_error;
 
@@ -247,7 +248,18 @@ public:
 	void readProtein ( int serial_number, int dnaReadingFrame );
 };
 
+class PackedSequenceReader : public SequenceReader {
+	PackedSequenceStore* store;
+public:
+	PackedSequenceReader ( DatabaseIndicies* dbIndicies, PackedSequenceStore* store );
+	~PackedSequenceReader ();
+	void readProtein ( int serial_number, int dnaReadingFrame );
+};
+
 class DNAProteinSequenceReader : public SequenceReader {
+	char* fpointer;
+	int savedSerialNumber;
+	int savedFrame;
 public:
 	DNAProteinSequenceReader ( DatabaseIndicies* dbIndicies );
 	~DNAProteinSequenceReader ();
@@ -312,7 +324,9 @@ void FastaServer::openDatabase ( const string& filename, bool createIndicies )
 
 	commentLine = getCommentLine ( usedFileName, dbIndicies );
 
-	sequenceReader = getSequenceReader ( usedFileName, dbIndicies );
+	PackedSequenceStore* store = createIndicies ? 0 : PackedSequenceStore::getStore ( usedFileName, numEntries );
+	if ( store )	sequenceReader = new PackedSequenceReader ( dbIndicies, store );
+	else			sequenceReader = getSequenceReader ( usedFileName, dbIndicies );
 
 	cur = -1;
 }
@@ -1424,20 +1438,35 @@ void DNASequenceReader::readProtein ( int serial_number, int dnaReadingFrame )
 	else
 		readProteinFromDNA ( dnaReadingFrame, maxNTermAA, fpointer, length, protein, numUnknowns );
 }
+PackedSequenceReader::PackedSequenceReader ( DatabaseIndicies* dbIndicies, PackedSequenceStore* store ) :
+	SequenceReader ( dbIndicies ),
+	store ( store )
+{
+}
+PackedSequenceReader::~PackedSequenceReader ()
+{
+	delete store;
+}
+void PackedSequenceReader::readProtein ( int serialNumber, int dnaReadingFrame )
+{
+	store->getSequence ( serialNumber, dnaReadingFrame, protein, maxNTermAA );
+}
 DNAProteinSequenceReader::DNAProteinSequenceReader ( DatabaseIndicies* dbIndicies ) :
-	SequenceReader ( dbIndicies ) {}
+	SequenceReader ( dbIndicies ),
+	fpointer ( 0 ),
+	savedSerialNumber ( -1 ),
+	savedFrame ( -1 )
+{
+}
 DNAProteinSequenceReader::~DNAProteinSequenceReader () {}
 
 void DNAProteinSequenceReader::readProtein ( int serialNumber, int dnaReadingFrame )
 {
-	static char* fpointer;
 	char* cppointer;
 	char val;
 	int i;
-	static int saved_serial_number = -1;
-	static int saved_frame = -1;
 
-	if ( serialNumber != saved_serial_number || dnaReadingFrame != saved_frame + 1 ) {
+	if ( serialNumber != savedSerialNumber || dnaReadingFrame != savedFrame + 1 ) {
 		int length;
 		fpointer = dbIndicies->getProteinPointer ( serialNumber, &length );
 		for ( i = 1 ; i < dnaReadingFrame ; i++ ) while ( *fpointer++ != '\n' );
@@ -1451,8 +1480,8 @@ void DNAProteinSequenceReader::readProtein ( int serialNumber, int dnaReadingFra
 	}
 	if ( maxNTermAA )	*(protein+maxNTermAA) = 0;
 	else				*cppointer = 0;
-	saved_serial_number = serialNumber;
-	saved_frame = dnaReadingFrame;
+	savedSerialNumber = serialNumber;
+	savedFrame = dnaReadingFrame;
 }
 const char* CommentLine::unreadable = "UNREADABLE";
 CommentLine::CommentLine ( DatabaseIndicies* dbIndicies )
@@ -21,6 +21,7 @@
 ******************************************************************************/
 #include <lg_new.h>
 #include <lgen_error.h>
+#include <lgen_thread.h>
 #define LUCSF_FAS_ENZ_MAIN
 #include <lu_param_list.h>
 #include <lu_fas_enz.h>
@@ -309,7 +310,8 @@ char get_enzyme_terminal_specificity ()
 }
 static IntVector& calc_fasta_c_term_fragments ( const string& peptideFormula )
 {
-	static IntVector cleavageIndex;
+	static GEN_THREAD_LOCAL IntVector* cleavageIndexPtr = 0;
+	IntVector& cleavageIndex = genThreadLocalInstance ( cleavageIndexPtr );
 	int numAA = peptideFormula.length ();
 	cleavageIndex.reserve ( numAA );
 	cleavageIndex.clear ();
@@ -331,7 +333,8 @@ static IntVector& calc_fasta_c_term_fragments ( const string& peptideFormula )
 }
 static IntVector& calc_fasta_n_term_fragments ( const string& peptideFormula )
 {
-	static IntVector cleavageIndex;
+	static GEN_THREAD_LOCAL IntVector* cleavageIndexPtr = 0;
+	IntVector& cleavageIndex = genThreadLocalInstance ( cleavageIndexPtr );
 	int numAA = peptideFormula.length ();
 	cleavageIndex.reserve ( numAA );
 	cleavageIndex.clear ();
@@ -352,7 +355,8 @@ static IntVector& calc_fasta_n_term_fragments ( const string& peptideFormula )
 }
 static IntVector& calc_fasta_multi_digest_fragments ( const string& peptideFormula )
 {
-	static IntVector cleavageIndex;
+	static GEN_THREAD_LOCAL IntVector* cleavageIndexPtr = 0;
+	IntVector& cleavageIndex = genThreadLocalInstance ( cleavageIndexPtr );
 	int numAA = peptideFormula.length ();
 	cleavageIndex.reserve ( numAA );
 	cleavageIndex.clear ();
@@ -377,7 +381,8 @@ static IntVector& calc_fasta_multi_digest_fragments ( const string& peptideFormu
 }
 DoubleVector& get_cleaved_masses ( const string& protein, const IntVector& cleavageIndex )
 {
-	static DoubleVector cleavedMassArray ( 36000 );
+	static GEN_THREAD_LOCAL DoubleVector* cleavedMassArrayPtr = 0;
+	DoubleVector& cleavedMassArray = genThreadLocalInstance ( cleavedMassArrayPtr );
 	StringSizeType numAA = protein.length ();
 	if ( numAA > cleavedMassArray.size () ) cleavedMassArray.resize ( numAA );
 
@@ -398,7 +403,8 @@ where you are looking for a fragment whose mass you know to be less than limit.
 */
 DoubleVector& get_cleaved_masses_to_limit ( const string& protein, const IntVector& cleavageIndex, double limit )
 {
-	static DoubleVector cleavedMassArray ( 36000 );
+	static GEN_THREAD_LOCAL DoubleVector* cleavedMassArrayPtr = 0;
+	DoubleVector& cleavedMassArray = genThreadLocalInstance ( cleavedMassArrayPtr );
 	StringSizeType numAA = protein.length ();
 	if ( numAA > cleavedMassArray.size () ) cleavedMassArray.resize ( numAA );
 
@@ -107,8 +107,8 @@ void DatabaseIndicies::readIndexFile ()
 	idiFile.read ( (char*) &maxCommentLength, sizeof (unsigned int) );
 	idiFile.read ( (char*) &maxProteinLength, sizeof (unsigned int) );
 
-	commentIndexMap = new MMapFile <GENINT64> ( fullIDCPath, 0, 0x80000 );
-	proteinIndexMap = new MMapFile <GENINT64> ( fullIDPPath, 0, 0x80000 );
+	commentIndexMap = new MMapFile <GENINT64> ( fullIDCPath, 0, 0x80000, MMAP_ADVICE_WILLNEED );
+	proteinIndexMap = new MMapFile <GENINT64> ( fullIDPPath, 0, 0x80000, MMAP_ADVICE_WILLNEED );
 }
 void DatabaseIndicies::writeIndexFile ()
 {
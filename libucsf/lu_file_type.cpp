@@ -22,6 +22,7 @@
 #include <lg_io.h>
 #include <lg_string.h>
 #include <lgen_file.h>
+#include <lgen_uncompress.h>
 #include <lu_file_type.h>
 #include <lu_mgf.h>
 using std::ios;
@@ -124,7 +125,7 @@ bool isFragmentMOverZIntensityLine ( const string& line )
 bool isMGFSpottingPlateFile ( const string& fullPath )
 {
 	MGFInfo::instance ().reset ();
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	bool spottingPlate = false;
@@ -138,7 +139,7 @@ bool isMGFSpottingPlateFile ( const string& fullPath )
 }
 bool isMGFFile ( const string& fullPath )
 {
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	while ( getline ( ist, line ) ) {
@@ -151,7 +152,7 @@ bool isMGFFile ( const string& fullPath )
 }
 bool isMGFFile2 ( const string& fullPath )	// This used for files with an mgf suffix. It allows files with no scans (just comments).
 {
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	while ( getline ( ist, line ) ) {
@@ -166,7 +167,7 @@ bool isMGFFile2 ( const string& fullPath )	// This used for files with an mgf su
 }
 bool mgfFileHasZeros ( const string& fullPath )
 {
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	while ( getline ( ist, line ) ) {
@@ -186,7 +187,7 @@ bool mgfFileHasZeros ( const string& fullPath )
 }
 bool isMS2File ( const string& fullPath )
 {
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	while ( getline ( ist, line ) ) {
@@ -199,7 +200,7 @@ bool isMS2File ( const string& fullPath )
 }
 bool isMS2File2 ( const string& fullPath )	// This used for files with an ms2 suffix. It allows files with no scans (just comments).
 {
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	while ( getline ( ist, line ) ) {
@@ -214,7 +215,7 @@ bool isMS2File2 ( const string& fullPath )	// This used for files with an ms2 su
 }
 bool isAPLFile ( const string& fullPath )
 {
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	while ( getline ( ist, line ) ) {
@@ -227,7 +228,7 @@ bool isAPLFile ( const string& fullPath )
 }
 bool isAPLFile2 ( const string& fullPath )	// This used for files with an apl suffix. It allows files with no scans (just comments).
 {
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	int i = 0;
 	while ( getline ( ist, line ) ) {
@@ -339,7 +340,7 @@ bool isPPSingleFile ( const string& fullPath )
 >M2$Spot:097$Run:2$JobRunItem:178595$
 */
 	const char* contains [] = { "$Spot:", "$Run:", "$JobRunItem:", 0 };
-	GenIFStream ist ( fullPath );
+	GenZIFStream ist ( fullPath );
 	string line;
 	while ( getline ( ist, line ) ) {
 		string start = ">M";
@@ -469,3 +470,10 @@ bool isCompressedUpload ( const string& f )
 {
 	return isFileType ( f, GZ ) || isFileType ( f, BZ2 ) || isFileType ( f, Z ) || isFileType ( f, CMN );
 }
+string getUncompressedFilename ( const string& f )
+// Strips a .gz or .zip suffix as these files can be read directly by GenZIFStream
+{
+	if ( isFileType ( f, GZ ) )		return f.substr ( 0, f.length () - ( GZ.length () + 1 ) );
+	if ( isFileType ( f, ZIP ) )	return f.substr ( 0, f.length () - ( ZIP.length () + 1 ) );
+	return f;
+}
@@ -118,7 +118,7 @@ void MSFilterParameters::initPeakList ( const ParameterList* params )
 		return;
 	}
 	uploadPeakListFname = genFilenameFromPath ( uploadPeakListFname );	// IE gives the full path whereas Mozilla give the filename (what we want)
-	string uploadName = genPreprocessFile ( uploadPeakListFpath );
+	string uploadName = genPreprocessFile ( uploadPeakListFpath, true );
 	if ( uploadName == uploadPeakListFpath || isCompressedUpload ( uploadName ) ) {		// If the file hasn't been preprocessed or it has just been uncompressed it must be a single file
 		string shortName = genShortFilenameFromPath ( uploadName );
 		string newDir = genDirectoryFromPath ( uploadName ) + SLASH + shortName;
@@ -127,7 +127,7 @@ void MSFilterParameters::initPeakList ( const ParameterList* params )
 		}
 		bool ret = genCreateDirectory ( newDir );
 		string newUploadName;
-		if ( isCompressedUpload ( uploadName ) )
+		if ( uploadName != uploadPeakListFpath && isCompressedUpload ( uploadName ) )	// Just uncompressed
 			newUploadName = newDir + SLASH + genShortFilenameFromPath ( uploadPeakListFname );
 		else
 			newUploadName = newDir + SLASH + uploadPeakListFname;
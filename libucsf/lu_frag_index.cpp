@@ -0,0 +1,160 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_frag_index.cpp                                             *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Inverted index from fragment ion mass to the spectra          *
+*               containing a matching peak.                                   *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <algorithm>
+#include <lg_string.h>
+#include <lgen_error.h>
+#include <lu_frag_index.h>
+#include <lu_getfil.h>
+#include <lu_tag_frag.h>
+using std::string;
+using std::vector;
+using std::lower_bound;
+
+namespace {
+const int MAX_FRAGMENT_INDEX_BINS = 4000000;
+}
+
+FragmentIonIndex::FragmentIonIndex ( const vector <MassTypeVector>& nTag, const vector <MassTypeVector>& nTol, const vector <MassTypeVector>& cTag, const vector <MassTypeVector>& cTol, const DoubleVector& parentMassMinusPosTolerance, int minMatches ) :
+	minMass ( 0 ),
+	binWidth ( 1 ),
+	numBins ( 0 ),
+	minMatches ( minMatches ),
+	parentMassMinusPosTolerance ( parentMassMinusPosTolerance )
+{
+	bool first = true;
+	MassType maxMass = 0;
+	MassType minTol = 0;
+	for ( int i = 0 ; i < 2 ; i++ ) {
+		const vector <MassTypeVector>& tag = ( i == 0 ) ? nTag : cTag;
+		const vector <MassTypeVector>& tol = ( i == 0 ) ? nTol : cTol;
+		for ( vector <MassTypeVector>::size_type j = 0 ; j < tag.size () ; j++ ) {
+			for ( MassTypeVector::size_type k = 0 ; k < tag [j].size () ; k++ ) {
+				if ( first ) {
+					minMass = tag [j][k] - tol [j][k];
+					maxMass = tag [j][k] + tol [j][k];
+					minTol = tol [j][k];
+					first = false;
+				}
+				else {
+					minMass = genMin ( minMass, (MassType)(tag [j][k] - tol [j][k]) );
+					maxMass = genMax ( maxMass, (MassType)(tag [j][k] + tol [j][k]) );
+					minTol = genMin ( minTol, tol [j][k] );
+				}
+			}
+		}
+	}
+	if ( first ) return;
+	binWidth = genMax ( minTol, (MassType)1 );
+	if ( ( maxMass - minMass ) / binWidth >= MAX_FRAGMENT_INDEX_BINS ) {
+		binWidth = ( maxMass - minMass ) / MAX_FRAGMENT_INDEX_BINS + 1;
+	}
+	numBins = getBin ( maxMass ) + 1;
+	initBins ( nTag, nTol, nBinStart, nPostings );
+	initBins ( cTag, cTol, cBinStart, cPostings );
+}
+void FragmentIonIndex::initBins ( const vector <MassTypeVector>& tag, const vector <MassTypeVector>& tol, IntVector& binStart, IntVector& postings )
+{
+	IntVector lastSpectrum ( numBins, -1 );		// A spectrum is only posted once to each bin
+	binStart.assign ( numBins + 1, 0 );
+	int numSpectra = tag.size ();
+	int i;
+	for ( i = 0 ; i < numSpectra ; i++ ) {
+		for ( MassTypeVector::size_type j = 0 ; j < tag [i].size () ; j++ ) {
+			int eBin = getBin ( tag [i][j] + tol [i][j] );
+			for ( int b = getBin ( tag [i][j] - tol [i][j] ) ; b <= eBin ; b++ ) {
+				if ( lastSpectrum [b] != i ) {
+					lastSpectrum [b] = i;
+					binStart [b+1]++;
+				}
+			}
+		}
+	}
+	for ( int b = 0 ; b < numBins ; b++ ) {
+		binStart [b+1] += binStart [b];
+	}
+	postings.resize ( binStart [numBins] );
+	IntVector next ( binStart.begin (), binStart.end () - 1 );
+	fill ( lastSpectrum.begin (), lastSpectrum.end (), -1 );
+	for ( i = 0 ; i < numSpectra ; i++ ) {	// Spectra are posted in order so each bin is sorted
+		for ( MassTypeVector::size_type j = 0 ; j < tag [i].size () ; j++ ) {
+			int eBin = getBin ( tag [i][j] + tol [i][j] );
+			for ( int b = getBin ( tag [i][j] - tol [i][j] ) ; b <= eBin ; b++ ) {
+				if ( lastSpectrum [b] != i ) {
+					lastSpectrum [b] = i;
+					postings [next [b]++] = i;
+				}
+			}
+		}
+	}
+}
+void FragmentIonIndex::countIon ( MassType m, const IntVector& binStart, const IntVector& postings, FragmentIonMatches& fim ) const
+{
+	if ( m < minMass ) return;
+	int b = getBin ( m );
+	if ( b >= numBins ) return;
+	IntVectorConstIterator end = postings.begin () + binStart [b+1];
+	for ( IntVectorConstIterator i = lower_bound ( postings.begin () + binStart [b], end, fim.first ) ; i != end && *i < fim.last ; i++ ) {
+		fim.sharedIons [*i - fim.first]++;
+	}
+}
+void FragmentIonIndex::getMatches ( const string& peptide, int first, double molWt, FragmentIonMatches& fim ) const
+{
+	int numSpectra = parentMassMinusPosTolerance.size ();
+	int last = first;
+	while ( last < numSpectra && parentMassMinusPosTolerance [last] <= molWt ) last++;
+	fim.first = first;
+	fim.last = last;
+	fim.minMatches = minMatches;
+	fim.sharedIons.assign ( last - first, 0 );
+	if ( last == first || numBins == 0 ) return;
+	int len = peptide.length ();
+	MassType nIon = MSTagSearch::getNTerminusWt ();
+	for ( int i = 0 ; i < len - 1 ; i++ ) {
+		nIon += aaArrayMT [peptide [i]];
+		countIon ( nIon, nBinStart, nPostings, fim );
+	}
+	MassType cIon = MSTagSearch::getCTerminusWt ();
+	for ( int j = len ; --j ; ) {
+		cIon += aaArrayMT [peptide [j]];
+		countIon ( cIon, cBinStart, cPostings, fim );
+	}
+}
+FragmentIonIndex* FragmentIonIndex::create ( const vector <MSMSSearch*>& msMSSearch )
+{
+	int minMatches = InfoParams::instance ().getIntValue ( "frag_index_min_matches", 0 );
+	if ( minMatches <= 0 ) return 0;
+	int numSpectra = msMSSearch.size ();
+	vector <MassTypeVector> nTag ( numSpectra );
+	vector <MassTypeVector> nTol ( numSpectra );
+	vector <MassTypeVector> cTag ( numSpectra );
+	vector <MassTypeVector> cTol ( numSpectra );
+	DoubleVector parentMassMinusPosTolerance ( numSpectra );
+	for ( int i = 0 ; i < numSpectra ; i++ ) {
+		if ( !msMSSearch [i]->getFragmentIndexTags ( nTag [i], nTol [i], cTag [i], cTol [i] ) ) {
+			if ( msMSSearch [i]->getPeaks ()->size () ) return 0;	// Search type or ion types not supported by the index
+		}
+		parentMassMinusPosTolerance [i] = msMSSearch [i]->getParentMassMinusPosTolerance ();
+	}
+	ErrorHandler::genError ()->message ( "Fragment ion index created for " + gen_itoa ( numSpectra ) + " spectra.\n" );
+	return new FragmentIonIndex ( nTag, nTol, cTag, cTol, parentMassMinusPosTolerance, minMatches );
+}
@@ -0,0 +1,184 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_frag_simd.cpp                                              *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Vectorized comparison of a theoretical fragment ion mass      *
+*               against a block of peaks.                                     *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <string>
+#include <lgen_define.h>
+#include <lu_frag_simd.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRAG_SIMD_X64
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FRAG_SIMD_AVX2_TARGET
+#elif defined(__GNUC__)						// Includes the mingw build
+#define FRAG_SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+typedef unsigned int (*MatchMaskFunction) ( MassType ion, const MassType* tag, const MassType* tol, int n );
+typedef unsigned int (*GreaterMaskFunction) ( MassType ion, const MassType* max, int n );
+
+unsigned int scalarMatchMask ( MassType ion, const MassType* tag, const MassType* tol, int n )
+{
+	unsigned int mask = 0;
+	for ( int i = 0 ; i < n ; i++ ) {
+		if ( genAbsDiff ( ion, tag [i] ) < tol [i] ) mask |= 1U << i;
+	}
+	return mask;
+}
+unsigned int scalarGreaterMask ( MassType ion, const MassType* max, int n )
+{
+	unsigned int mask = 0;
+	for ( int i = 0 ; i < n ; i++ ) {
+		if ( ion > max [i] ) mask |= 1U << i;
+	}
+	return mask;
+}
+#ifdef FRAG_SIMD_X64
+// SSE2 is part of the x86-64 instruction set so needs no run time check.
+// |ion - tag| < tol is tested as ( ion - tag < tol ) && ( tag - ion < tol ) to avoid needing an abs instruction.
+unsigned int sse2MatchMask ( MassType ion, const MassType* tag, const MassType* tol, int n )
+{
+	__m128i vIon = _mm_set1_epi32 ( ion );
+	unsigned int mask = 0;
+	for ( int i = 0 ; i < n ; i += 4 ) {
+		__m128i vTag = _mm_loadu_si128 ( reinterpret_cast <const __m128i*> (tag + i) );
+		__m128i vTol = _mm_loadu_si128 ( reinterpret_cast <const __m128i*> (tol + i) );
+		__m128i lo = _mm_cmplt_epi32 ( _mm_sub_epi32 ( vIon, vTag ), vTol );
+		__m128i hi = _mm_cmplt_epi32 ( _mm_sub_epi32 ( vTag, vIon ), vTol );
+		mask |= static_cast <unsigned int> (_mm_movemask_ps ( _mm_castsi128_ps ( _mm_and_si128 ( lo, hi ) ) )) << i;
+	}
+	return mask & fragMaskLowBits ( n );
+}
+unsigned int sse2GreaterMask ( MassType ion, const MassType* max, int n )
+{
+	__m128i vIon = _mm_set1_epi32 ( ion );
+	unsigned int mask = 0;
+	for ( int i = 0 ; i < n ; i += 4 ) {
+		__m128i vMax = _mm_loadu_si128 ( reinterpret_cast <const __m128i*> (max + i) );
+		mask |= static_cast <unsigned int> (_mm_movemask_ps ( _mm_castsi128_ps ( _mm_cmpgt_epi32 ( vIon, vMax ) ) )) << i;
+	}
+	return mask & fragMaskLowBits ( n );
+}
+FRAG_SIMD_AVX2_TARGET unsigned int avx2MatchMask ( MassType ion, const MassType* tag, const MassType* tol, int n )
+{
+	__m256i vIon = _mm256_set1_epi32 ( ion );
+	unsigned int mask = 0;
+	for ( int i = 0 ; i < n ; i += 8 ) {
+		__m256i vTag = _mm256_loadu_si256 ( reinterpret_cast <const __m256i*> (tag + i) );
+		__m256i vTol = _mm256_loadu_si256 ( reinterpret_cast <const __m256i*> (tol + i) );
+		__m256i diff = _mm256_abs_epi32 ( _mm256_sub_epi32 ( vIon, vTag ) );
+		mask |= static_cast <unsigned int> (_mm256_movemask_ps ( _mm256_castsi256_ps ( _mm256_cmpgt_epi32 ( vTol, diff ) ) )) << i;
+	}
+	return mask & fragMaskLowBits ( n );
+}
+FRAG_SIMD_AVX2_TARGET unsigned int avx2GreaterMask ( MassType ion, const MassType* max, int n )
+{
+	__m256i vIon = _mm256_set1_epi32 ( ion );
+	unsigned int mask = 0;
+	for ( int i = 0 ; i < n ; i += 8 ) {
+		__m256i vMax = _mm256_loadu_si256 ( reinterpret_cast <const __m256i*> (max + i) );
+		mask |= static_cast <unsigned int> (_mm256_movemask_ps ( _mm256_castsi256_ps ( _mm256_cmpgt_epi32 ( vIon, vMax ) ) )) << i;
+	}
+	return mask & fragMaskLowBits ( n );
+}
+bool checkAVX2 ()
+{
+#ifdef _MSC_VER
+	int info [4];
+	__cpuid ( info, 0 );
+	if ( info [0] < 7 ) return false;
+	__cpuid ( info, 1 );
+	bool osxsave = ( info [2] & ( 1 << 27 ) ) != 0;
+	bool avx = ( info [2] & ( 1 << 28 ) ) != 0;
+	if ( !osxsave || !avx || ( _xgetbv ( 0 ) & 6 ) != 6 ) return false;	// The OS must save the YMM registers
+	__cpuidex ( info, 7, 0 );
+	return ( info [1] & ( 1 << 5 ) ) != 0;
+#else
+	__builtin_cpu_init ();
+	return __builtin_cpu_supports ( "avx2" ) != 0;
+#endif
+}
+#endif
+
+class FragSIMDDispatch {
+public:
+	MatchMaskFunction matchMask;
+	GreaterMaskFunction greaterMask;
+	const char* name;
+	FragSIMDDispatch () :
+		matchMask ( scalarMatchMask ),
+		greaterMask ( scalarGreaterMask ),
+		name ( "scalar" )
+	{
+		if ( !select ( "AVX2" ) ) select ( "SSE2" );
+	}
+	bool select ( const std::string& n )
+	{
+		if ( n == "scalar" ) {
+			matchMask = scalarMatchMask;
+			greaterMask = scalarGreaterMask;
+			name = "scalar";
+			return true;
+		}
+#ifdef FRAG_SIMD_X64
+		if ( sizeof (MassType) != sizeof (int) || MASS_TYPE_MULTIPLIER == 1.0 ) return false;	// The vector code assumes integer masses
+		if ( n == "AVX2" && checkAVX2 () ) {
+			matchMask = avx2MatchMask;
+			greaterMask = avx2GreaterMask;
+			name = "AVX2";
+			return true;
+		}
+		if ( n == "SSE2" ) {
+			matchMask = sse2MatchMask;
+			greaterMask = sse2GreaterMask;
+			name = "SSE2";
+			return true;
+		}
+#endif
+		return false;
+	}
+};
+FragSIMDDispatch fragSIMDDispatch;	// Selected once when the library is loaded
+
+}
+
+unsigned int fragMatchMask ( MassType ion, const MassType* tag, const MassType* tol, int n )
+{
+	return fragSIMDDispatch.matchMask ( ion, tag, tol, n );
+}
+unsigned int fragGreaterMask ( MassType ion, const MassType* max, int n )
+{
+	return fragSIMDDispatch.greaterMask ( ion, max, n );
+}
+const char* getFragSIMDName ()
+{
+	return fragSIMDDispatch.name;
+}
+bool setFragSIMD ( const std::string& name )
+{
+	return fragSIMDDispatch.select ( name );
+}
@@ -247,21 +247,155 @@ string SurvivalHistogram::expectationMethod = "None";
 int SurvivalHistogram::minUsedPeptides = ExpectationParameters::instance ().getMinUsedPeptides ();
 double SurvivalHistogram::tailPercent = ExpectationParameters::instance ().getTailPercent ();
 
+const int SurvivalHistogram::MAX_BINS = 65536;
+
 SurvivalHistogram::SurvivalHistogram ( size_t sizeLimit ) :
 	Histogram (),
 	a ( 0.0 ),
 	b ( 0.0 ),
+	binStart ( 0 ),
+	binShift ( 0 ),
 	size ( 0 ),
 	sizeLimit ( sizeLimit )
 {
 }
 SurvivalHistogram::~SurvivalHistogram () {}
+bool SurvivalHistogram::addValue ( const double x )
+{
+	if ( sizeLimit == 0 ) {		// Just add up the number of spectra
+		size++;
+		return true;
+	}
+	if ( size < sizeLimit ) {
+		addScore ( static_cast <int> ( floor ( x * SCORE_TYPE_MULTIPLIER + 0.5 ) ), 1 );
+		size++;
+		return true;
+	}
+	return false;
+}
+void SurvivalHistogram::addScore ( int score, unsigned int count )
+{
+	if ( counts.empty () || score < binStart || ( ( static_cast <GENINT64> (score) - binStart ) >> binShift ) >= static_cast <GENINT64> (counts.size ()) ) {
+		resizeBins ( score, binShift );
+	}
+	counts [( static_cast <GENINT64> (score) - binStart ) >> binShift] += count;
+}
+void SurvivalHistogram::resizeBins ( int score, int minShift )	// Extends the bins to include score with bins at least 2^minShift wide
+{
+	GENINT64 lo = score - MAX_BINS / 128;
+	GENINT64 hi = score + MAX_BINS / 128;
+	if ( !counts.empty () ) {		// Grow geometrically but only make the bins wider if necessary
+		GENINT64 capacity = static_cast <GENINT64> (MAX_BINS) << binShift;
+		lo = binStart;
+		hi = binStart + ( static_cast <GENINT64> (counts.size ()) << binShift ) - 1;
+		GENINT64 span = hi - lo + 1;
+		if ( score < lo )		lo = genMin ( static_cast <GENINT64> (score), genMax ( lo - span, hi + 1 - capacity ) );
+		else if ( score > hi )	hi = genMax ( static_cast <GENINT64> (score), genMin ( hi + span, lo + capacity - 1 ) );
+	}
+	int shift = genMax ( binShift, minShift );
+	GENINT64 start;
+	for ( ; ; shift++ ) {
+		GENINT64 width = static_cast <GENINT64> (1) << shift;
+		start = lo - ( ( lo % width ) + width ) % width;		// Bins start at a multiple of the width
+		if ( ( ( hi - start ) >> shift ) < MAX_BINS ) break;
+	}
+	UIntVector newCounts ( ( ( hi - start ) >> shift ) + 1, 0 );
+	for ( UIntVectorSizeType i = 0 ; i < counts.size () ; i++ ) {	// Remap using the old bin width
+		if ( counts [i] ) newCounts [( binStart + ( static_cast <GENINT64> (i) << binShift ) - start ) >> shift] += counts [i];
+	}
+	counts.swap ( newCounts );
+	binStart = start;
+	binShift = shift;
+}
+double SurvivalHistogram::getBinValue ( UIntVectorSizeType i ) const
+{
+	GENINT64 start = binStart + ( static_cast <GENINT64> (i) << binShift );
+	if ( binShift == 0 ) return start / SCORE_TYPE_MULTIPLIER;		// Exact score
+	return ( start + ( ( static_cast <GENINT64> (1) << binShift ) - 1 ) / 2.0 ) / SCORE_TYPE_MULTIPLIER;
+}
+void SurvivalHistogram::getMoments ( GENINT64 n, double& mean, double& sdev, double& var ) const	// Moments of the n lowest scores
+{
+	double s = 0.0;
+	GENINT64 r = 0;
+	for ( UIntVectorSizeType i = 0 ; i < counts.size () && r < n ; i++ ) {
+		GENINT64 c = genMin ( static_cast <GENINT64> (counts [i]), n - r );
+		s += c * getBinValue ( i );
+		r += c;
+	}
+	mean = s / n;
+	var = 0.0;
+	r = 0;
+	for ( UIntVectorSizeType j = 0 ; j < counts.size () && r < n ; j++ ) {
+		GENINT64 c = genMin ( static_cast <GENINT64> (counts [j]), n - r );
+		double d = getBinValue ( j ) - mean;
+		var += c * d * d;
+		r += c;
+	}
+	var /= ( n - 1 );
+	sdev = sqrt ( var );
+}
+void SurvivalHistogram::makeSurvivalHistogram ( GENINT64 n ) const	// Same bins as Histogram::makeHistogram
+{
+	UIntVectorSizeType first = 0;
+	while ( counts [first] == 0 ) first++;
+	UIntVectorSizeType last = counts.size () - 1;
+	while ( counts [last] == 0 ) last--;
+	double min = getBinValue ( first );
+	double max = getBinValue ( last );
+	int nbins = 60;
+	if ( n > 60 ) {
+		double mean, sdev, var;
+		getMoments ( n, mean, sdev, var );
+		double binWidth = 3.49 * sdev * pow ( static_cast <double> (n), - ( 1.0 / 3.0 ) );
+		nbins = ( max - min ) / binWidth;
+		nbins = genMax ( 60, nbins );
+	}
+	double interval = ( max - min ) / nbins;
+	if ( interval == 0.0 ) interval = 0.000000001;
+	double halfInterval = interval / 2;
+	int num = 0;
+	double end = min + interval;
+	for ( UIntVectorSizeType i = first ; i <= last ; i++ ) {
+		if ( counts [i] == 0 ) continue;
+		double v = getBinValue ( i );
+		while ( !( v < end ) ) {
+			xyData.add ( end - halfInterval, num );
+			end += interval;
+			num = 0;
+		}
+		num += counts [i];
+	}
+	xyData.add ( end - halfInterval, num );
+}
+bool SurvivalHistogram::merge ( const SurvivalHistogram& rhs )	// Returns false if the size limit was reached
+{
+	if ( sizeLimit == 0 ) {
+		size += rhs.size;
+		return true;
+	}
+	if ( rhs.size > sizeLimit - size ) return false;
+	if ( rhs.counts.empty () ) return true;
+	if ( counts.empty () ) {
+		counts = rhs.counts;
+		binStart = rhs.binStart;
+		binShift = rhs.binShift;
+	}
+	else {
+		if ( rhs.binShift > binShift ) resizeBins ( binStart, rhs.binShift );	// Use the wider bins
+		for ( UIntVectorSizeType i = 0 ; i < rhs.counts.size () ; i++ ) {
+			if ( rhs.counts [i] ) addScore ( rhs.binStart + ( static_cast <GENINT64> (i) << rhs.binShift ), rhs.counts [i] );
+		}
+	}
+	size += rhs.size;
+	return true;
+}
 void SurvivalHistogram::compute ( int numSavedPeptides ) const
 {
-	int numUsedPeptides = val.size () - numSavedPeptides;
+	GENINT64 numValues = ( sizeLimit == 0 ) ? 0 : size;
+	int numUsedPeptides = numValues - numSavedPeptides;
 	if ( expectationMethod == "Linear Tail Fit" ) numUsedPeptides -= 20;
 	if ( numUsedPeptides > 0 ) {
-		makeHistogram ();
+		makeSurvivalHistogram ( numValues );
 		if ( expectationMethod == "Linear Tail Fit" ) {
 			if ( numUsedPeptides >= minUsedPeptides ) {
 				double tot = 0.0;
@@ -288,7 +422,7 @@ void SurvivalHistogram::compute ( int numSavedPeptides ) const
 		else if ( expectationMethod == "Method of Moments" ) {	//	Method of moments
 			if ( numUsedPeptides >= 500 ) {
 				double mean, sdevError, var;
-				moment ( &val[0]-1, numUsedPeptides, &mean, &sdevError, &var );
+				getMoments ( numUsedPeptides, mean, sdevError, var );
 				b = ( sqrt (6.0 * var) ) / pi;
 				a = mean - ( 0.57721566490153286060651209008240243104 * b );
 			}
@@ -296,17 +430,23 @@ void SurvivalHistogram::compute ( int numSavedPeptides ) const
 		else if ( expectationMethod == "Closed Form Max Likelihood" ) {	//	Closed Form Maximum Likelihood
 			if ( numUsedPeptides >= 500 ) {
 				double mean, sdevError, var;
-				sort ( val.begin (), val.begin () + numSavedPeptides );
-				moment ( &val[0]-1, numUsedPeptides, &mean, &sdevError, &var );
+				getMoments ( numUsedPeptides, mean, sdevError, var );
 				double sum1 = 0.0;
-				for ( int i = 0 ; i < numUsedPeptides ; i++ ) {
-					sum1 += val [i] * log ( ( (i+1) - 0.5 ) / ( numUsedPeptides + 0.5 )  );
+				int r = 0;
+				for ( UIntVectorSizeType i = 0 ; i < counts.size () && r < numUsedPeptides ; i++ ) {
+					double v = getBinValue ( i );
+					for ( unsigned int k = 0 ; k < counts [i] && r < numUsedPeptides ; k++, r++ ) {	// Scores in rank order
+						sum1 += v * log ( ( (r+1) - 0.5 ) / ( numUsedPeptides + 0.5 )  );
+					}
 				}
 				sum1 /= numUsedPeptides;
 				b = mean + sum1;
 				double sum2 = 0.0;
-				for ( int j = 0 ; j < numUsedPeptides ; j++ ) {
-					sum2 += exp ( - val [j] / b  );
+				r = 0;
+				for ( UIntVectorSizeType j = 0 ; j < counts.size () && r < numUsedPeptides ; j++ ) {
+					int c = genMin ( static_cast <int> (counts [j]), numUsedPeptides - r );
+					sum2 += c * exp ( - getBinValue ( j ) / b  );
+					r += c;
 				}
 				a = - b * log ( sum2 / numUsedPeptides );
 			}
@@ -20,6 +20,7 @@
 *                                                                             *
 ******************************************************************************/
 #include <lgen_error.h>
+#include <lgen_thread.h>
 #include <lp_frame.h>
 #include <lu_mat_score.h>
 #include <lu_hom_srch.h>
@@ -28,6 +29,8 @@
 #include <lu_param_list.h>
 #include <lu_table.h>
 #include <lu_delim.h>
+#include <lu_getfil.h>
+using std::vector;
 using std::string;
 using std::ostream;
 using std::endl;
@@ -36,15 +39,15 @@ using std::sort;
 int HomologyHit::numPreviousAA = 1;
 int HomologyHit::numNextAA = 1;
 
-HomologyHit::HomologyHit ( FastaServer* fs, int index, int dnaReadingFrame, int openReadingFrame, const char* protein, const string& measuredSequence, int sequenceSet, int numSubstitutions ) :
+HomologyHit::HomologyHit ( FastaServer* fs, int index, int dnaReadingFrame, int openReadingFrame, const char* protein, const SequenceTagMatcher& matcher, int hitNumber ) :
 	ProteinHit ( fs, index, dnaReadingFrame, openReadingFrame ),
-	sequence ( get_regular_expression_match () ),
-	previousAA ( getPreviousAA ( protein ) ),
-	nextAA ( getNextAA () ),
-	startAA ( get_regular_expression_loc1 () - protein + 1 ),
-	measuredSequence ( measuredSequence ),
-	sequenceSet ( sequenceSet ),
-	numSubstitutions ( numSubstitutions ),
+	sequence ( matcher.getMatch () ),
+	previousAA ( getPreviousAA ( protein, matcher.getLoc1 () ) ),
+	nextAA ( getNextAA ( matcher.getLoc2 () ) ),
+	startAA ( matcher.getLoc1 () - protein + 1 ),
+	measuredSequence ( matcher.getMeasuredSequence ( hitNumber ) ),
+	sequenceSet ( matcher.getSequenceSet ( hitNumber ) ),
+	numSubstitutions ( matcher.getNumSubstitutions () ),
 	scoreSet ( false )
 {
 }
@@ -145,9 +148,8 @@ void HomologyHit::printXML ( ostream& os, bool newProtein ) const
 		ParameterList::printXML ( os, "start_aa", startAA );
 	os << "</peptide>" << endl;
 }
-string HomologyHit::getPreviousAA ( const char* protein ) const
+string HomologyHit::getPreviousAA ( const char* protein, const char* loc1 )
 {
-	const char* loc1 = get_regular_expression_loc1 ();
 	int startAA = loc1 - protein;
 	int numDisp = genMin ( numPreviousAA, startAA );
 	string ret;
@@ -157,9 +159,8 @@ string HomologyHit::getPreviousAA ( const char* protein ) const
 	}
 	return ret;
 }
-string HomologyHit::getNextAA () const
+string HomologyHit::getNextAA ( const char* loc2 )
 {
-	const char* loc2 = get_regular_expression_loc2 ();
 	string ret;
 	int i = 0;
 	for ( ; i < numNextAA ; i++ ) {
@@ -228,13 +229,20 @@ HomologySearch::HomologySearch ( const MSHomologyParameters& params ) :
 	HomologyHit::setNumPreviousAA ( params.getPreviousAA () );
 	HomologyHit::setNumNextAA ( params.getNextAA () );
 	homologyHits = new HomologyHits ();
-	initialise_regular_expression_hit_list ( params.getPossibleSequences (), params.getSequenceSet (), params.getMaxSeqErrors (), params.getProductMassTolerance (), !params.getNoEnzyme () );
+	matcher = new SequenceTagMatcher ( params.getPossibleSequences (), params.getSequenceSet (), params.getMaxSeqErrors (), params.getProductMassTolerance (), !params.getNoEnzyme () );
+	numThreads = InfoParams::instance ().getIntValue ( "mshomology_num_threads", 1 );
+	if ( numThreads == 0 ) numThreads = genGetNumProcessors ();
+	if ( FrameIterator::getMPI () ) numThreads = 1;
 	sequenceSearch ();
 	homologyHits->calculateScores ( params.getMinMatches (), params.getScoreMatrix () );
 
 	numHits = homologyHits->size ();
 	databaseHits = homologyHits;
 }
+HomologySearch::~HomologySearch ()
+{
+	delete matcher;
+}
 void HomologySearch::sequenceSearch ()
 {
 	for ( int i = 0 ; i < fs.size () ; i++ ) {
@@ -244,49 +252,112 @@ void HomologySearch::sequenceSearch ()
 }
 void HomologySearch::doSearch ( FastaServer* fsPtr, int i )
 {
-	bool noEnzyme = params.getNoEnzyme ();
 	ProteinHit::addFS ( fsPtr, i );
+	if ( !params.getNoEnzyme () ) init_fasta_enzyme_function ( params.getEnzyme () );
+	if ( numThreads > 1 && params.getIndicies ( i ).size () > numThreads ) {
+		doThreadedSearch ( fsPtr, i );
+		return;
+	}
 	FrameIterator fi ( fsPtr, params.getIndicies ( i ), dnaFrameTranslationPairVector [i], params.getTempOverride () );
-
-	if ( !noEnzyme ) init_fasta_enzyme_function ( params.getEnzyme () );
 	char* reading_frame;
 	while ( ( reading_frame = fi.getNextFrame () ) != NULL ) {
-		if ( noEnzyme ) {
-			while ( multi_unknome_hits_present ( reading_frame ) ) {
-				add_hit ( fsPtr, fi.getEntry (), fi.getFrameTranslation (), fi.getFrame (), reading_frame );
-			}
+		frameSearch ( fsPtr, fi, reading_frame, *matcher, *homologyHits );
+	}
+}
+void HomologySearch::frameSearch ( FastaServer* fs, const FrameIterator& fi, char* reading_frame, SequenceTagMatcher& tagMatcher, HomologyHits& hits ) const
+{
+	if ( params.getNoEnzyme () ) {
+		while ( tagMatcher.isPresentMulti ( reading_frame ) ) {
+			add_hit ( fs, fi, reading_frame, tagMatcher, hits );
 		}
-		else {
-			const IntVector& cleavageIndex = enzyme_fragmenter ( reading_frame );
+	}
+	else {
+		const IntVector& cleavageIndex = enzyme_fragmenter ( reading_frame );
 
-			for ( IntVectorSizeType m = 0 ; m < cleavageIndex.size () ; m++ ) {
-				int offset = ( m == 0 ) ? 0 : cleavageIndex [m-1] + 1;
-				int n = m;
-				if ( multi_unknome_hits_present ( reading_frame + offset ) ) {
-					const char* loc = get_regular_expression_loc2 ();
-					while ( loc > reading_frame + cleavageIndex [n] + 1 ) n++;
-					if ( loc == reading_frame + cleavageIndex [n] + 1 ) 
-						add_hit ( fsPtr, fi.getEntry (), fi.getFrameTranslation (), fi.getFrame (), reading_frame );
-				}
+		for ( IntVectorSizeType m = 0 ; m < cleavageIndex.size () ; m++ ) {
+			int offset = ( m == 0 ) ? 0 : cleavageIndex [m-1] + 1;
+			int n = m;
+			if ( tagMatcher.isPresentMulti ( reading_frame + offset ) ) {
+				const char* loc = tagMatcher.getLoc2 ();
+				while ( loc > reading_frame + cleavageIndex [n] + 1 ) n++;
+				if ( loc == reading_frame + cleavageIndex [n] + 1 ) 
+					add_hit ( fs, fi, reading_frame, tagMatcher, hits );
 			}
 		}
 	}
 }
-void HomologySearch::add_hit ( FastaServer* fs, int index, int dnaReadingFrame, int openReadingFrame, char* protein )
+void HomologySearch::add_hit ( FastaServer* fs, const FrameIterator& fi, char* protein, const SequenceTagMatcher& tagMatcher, HomologyHits& hits ) const
 {
-	char* measuredSequence;
-	int sequenceSet;
-	int numSubstitutions;
-	bool reset = true;
-
-	while ( get_unknome_rexp_results ( &measuredSequence, &sequenceSet, &numSubstitutions, reset ) ) {
-		reset = false;
-		homologyHits->addHit ( HomologyHit ( fs, index, dnaReadingFrame, openReadingFrame, protein, measuredSequence, sequenceSet, numSubstitutions ) );
+	for ( int i = 0 ; i < tagMatcher.getNumHits () ; i++ ) {
+		hits.addHit ( HomologyHit ( fs, fi.getEntry (), fi.getFrameTranslation (), fi.getFrame (), protein, tagMatcher, i ) );
 	}
-	if ( homologyHits->peptideHitsSize () > maxPeptideHits ) {
+	checkNumPeptideHits ( hits );
+}
+void HomologySearch::checkNumPeptideHits ( const HomologyHits& hits ) const
+{
+	if ( hits.peptideHitsSize () > maxPeptideHits ) {
 		ErrorHandler::genError ()->error ( "The maximum number of hits has been exceeded.\n" );
 	}
 }
+class HomologySearchThread : public GenThread {
+	const HomologySearch* homologySearch;
+	FastaServer* fsPtr;			// The hits refer to the search's server rather than the thread's
+	FastaServer* fs;
+	FrameIterator* fi;
+	SequenceTagMatcher matcher;
+	HomologyHits hits;
+	void run ();
+public:
+	HomologySearchThread ( const HomologySearch* homologySearch, FastaServer* fsPtr, const IntVector& indicies, const PairIntInt& frameTransPair, bool tempOverride );
+	~HomologySearchThread ();
+	void merge ( HomologyHits& homologyHits );
+};
+HomologySearchThread::HomologySearchThread ( const HomologySearch* homologySearch, FastaServer* fsPtr, const IntVector& indicies, const PairIntInt& frameTransPair, bool tempOverride ) :
+	homologySearch ( homologySearch ),
+	fsPtr ( fsPtr ),
+	fs ( new FastaServer ( fsPtr->getFilePath ().empty () ? fsPtr->getFileName () : fsPtr->getFilePath () ) ),
+	matcher ( homologySearch->homologyParams.getPossibleSequences (), homologySearch->homologyParams.getSequenceSet (), homologySearch->homologyParams.getMaxSeqErrors (), homologySearch->homologyParams.getProductMassTolerance (), !homologySearch->homologyParams.getNoEnzyme () )
+{
+	fs->setMaxNTermAA ( fsPtr->getMaxNTermAA () );
+	fi = new FrameIterator ( fs, indicies, frameTransPair, tempOverride );
+}
+HomologySearchThread::~HomologySearchThread ()
+{
+	join ();
+	delete fi;
+	delete fs;
+}
+void HomologySearchThread::run ()
+{
+	char* reading_frame;
+	while ( ( reading_frame = fi->getNextFrame () ) != NULL ) {
+		homologySearch->frameSearch ( fsPtr, *fi, reading_frame, matcher, hits );
+	}
+}
+void HomologySearchThread::merge ( HomologyHits& homologyHits )
+{
+	join ();
+	homologyHits.merge ( hits );
+}
+void HomologySearch::doThreadedSearch ( FastaServer* fsPtr, int num )
+{
+	const IntVector& indicies = params.getIndicies ( num );
+	vector <HomologySearchThread*> threads ( numThreads );
+	for ( int i = numThreads ; i-- ; ) {	// Only the first thread reports progress. It is created last so the progress is reported against its entries.
+		// Each thread searches a contiguous block of entries so merging in thread order gives the hits in the same order as a single thread
+		IntVectorConstIterator start = indicies.begin () + static_cast <int> ( static_cast <GENINT64> (indicies.size ()) * i / numThreads );
+		IntVectorConstIterator end = indicies.begin () + static_cast <int> ( static_cast <GENINT64> (indicies.size ()) * ( i + 1 ) / numThreads );
+		threads [i] = new HomologySearchThread ( this, fsPtr, IntVector ( start, end ), dnaFrameTranslationPairVector [num], i == 0 ? params.getTempOverride () : true );
+	}
+	for ( int j = 0 ; j < numThreads ; j++ ) {
+		threads [j]->start ();
+	}
+	for ( int k = 0 ; k < numThreads ; k++ ) {
+		threads [k]->merge ( *homologyHits );
+		delete threads [k];
+	}
+	checkNumPeptideHits ( *homologyHits );
+}
 void HomologySearch::printHTMLHitsTable ( ostream& os ) const
 {
 	int numPeptideHits = homologyHits->peptideHitsSize ();
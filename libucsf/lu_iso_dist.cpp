@@ -26,14 +26,21 @@
 #include <lg_string.h>
 #include <lgen_error.h>
 #include <lgen_math.h>
+#include <lgen_thread.h>
+#include <lu_getfil.h>
 #include <lu_iso.h>
 #include <lu_mass.h>
 #include <lu_mass_conv.h>
 #include <lu_mass_elem.h>
 using std::vector;
 using std::string;
+using std::list;
+using std::map;
+using std::make_pair;
 using std::fill;
 using std::sort;
+using std::max_element;
+using std::lower_bound;
 using std::ostringstream;
 using std::runtime_error;
 
@@ -44,6 +51,38 @@ class SortIsotopicDistributionComponents {
 			return ( a.massOffset < b.massOffset );
 		}
 };
+namespace {
+// Isotope peaks indexed by nominal mass shift from the monoisotopic peak. p holds the peak
+// probabilities and w the probability weighted mass shifts so w/p is the peak centroid.
+struct IsotopePolynomial {
+	DoubleVector p;
+	DoubleVector w;
+	IsotopePolynomial () :
+		p ( 1, 1.0 ),
+		w ( 1, 0.0 ) {}
+};
+const double ISOTOPE_POLYNOMIAL_TRIM = 1e-20;	// Tail peaks below this fraction of the largest peak are dropped
+
+IsotopePolynomial convolve ( const IsotopePolynomial& a, const IsotopePolynomial& b )
+{
+	IsotopePolynomial c;
+	c.p.assign ( a.p.size () + b.p.size () - 1, 0.0 );
+	c.w.assign ( c.p.size (), 0.0 );
+	for ( DoubleVectorSizeType i = 0 ; i < a.p.size () ; i++ ) {
+		if ( a.p [i] == 0.0 ) continue;
+		for ( DoubleVectorSizeType j = 0 ; j < b.p.size () ; j++ ) {
+			c.p [i+j] += a.p [i] * b.p [j];
+			c.w [i+j] += a.w [i] * b.p [j] + a.p [i] * b.w [j];
+		}
+	}
+	double maxP = *max_element ( c.p.begin (), c.p.end () );
+	while ( c.p.size () > 1 && c.p.back () < maxP * ISOTOPE_POLYNOMIAL_TRIM ) {
+		c.p.pop_back ();
+		c.w.pop_back ();
+	}
+	return c;
+}
+}
 bool IsotopicDistribution::initialised = false;
 
 StringVector IsotopicDistribution::elementTable;
@@ -51,9 +90,10 @@ int IsotopicDistribution::numValidElements;
 DoubleVectorVector IsotopicDistribution::isotopeMass;
 DoubleVectorVector IsotopicDistribution::isotopeAbundance;
 
-IsotopicDistribution::IsotopicDistribution ( double mOverZ, int charge, const string& averagineFormulaStr, double probabilityLimit ) :
+IsotopicDistribution::IsotopicDistribution ( double mOverZ, int charge, const string& averagineFormulaStr, double probabilityLimit, bool fineStructure ) :
 	charge ( charge ),
-	probabilityLimit ( probabilityLimit )
+	probabilityLimit ( probabilityLimit ),
+	fineStructure ( fineStructure )
 {
 	double mass = mOverZToMPlusH ( mOverZ, charge, true );
 	Formula <double> averagineFormula ( averagineFormulaStr );
@@ -74,16 +114,18 @@ IsotopicDistribution::IsotopicDistribution ( double mOverZ, int charge, const st
 	ef += temp;
 	createIsotopicDistribution ( ef );
 }
-IsotopicDistribution::IsotopicDistribution ( const string& eFormula, int charge, double probabilityLimit ) :
+IsotopicDistribution::IsotopicDistribution ( const string& eFormula, int charge, double probabilityLimit, bool fineStructure ) :
 	charge ( charge ),
-	probabilityLimit ( probabilityLimit )
+	probabilityLimit ( probabilityLimit ),
+	fineStructure ( fineStructure )
 {
 	ElementalFormula f ( eFormula );
 	createIsotopicDistribution ( f );
 }
-IsotopicDistribution::IsotopicDistribution ( ElementalFormula& ef, int charge, double probabilityLimit ) :
+IsotopicDistribution::IsotopicDistribution ( ElementalFormula& ef, int charge, double probabilityLimit, bool fineStructure ) :
 	charge ( charge ),
-	probabilityLimit ( probabilityLimit )
+	probabilityLimit ( probabilityLimit ),
+	fineStructure ( fineStructure )
 {
 	createIsotopicDistribution ( ef );
 }
@@ -97,6 +139,7 @@ void IsotopicDistribution::createIsotopicDistribution ( ElementalFormula& f )
 	idealMonoisotopicMass = formula_to_ideal_monoisotopic_mass ( f.getFormula ().c_str () ) - ELECTRON_REST_MASS;
 	idealMonoisotopicMZ = mPlusHToMOverZ ( idealMonoisotopicMass, charge, true );
 
+	numIsotopeAtoms = 0;
 	for ( f.first () ; f.isDone () ; f.next () ) {
 		int j;
 		if ( numValidElements == 0 ) {
@@ -121,16 +164,19 @@ void IsotopicDistribution::createIsotopicDistribution ( ElementalFormula& f )
 			e.isotopeAtoms = new int [numIsotopes];
 			fill ( e.isotopeAtoms, e.isotopeAtoms + numIsotopes, 0 );
 			elements.push_back ( e );
+			numIsotopeAtoms += numIsotopes - 1;
 		}
 	}
 
 	monoisotopicPeakTooSmall = false;
 	if ( elements.size () ) {
-		calcIsotopeDistributionComponent ( 0, 1, 1.0 );
 		noDistribution = false;
-		sort ( isotopicDistributionComponent.begin (), isotopicDistributionComponent.end (), SortIsotopicDistributionComponents () );
-		if ( isotopicDistributionComponent.size () == 0 )
-			monoisotopicPeakTooSmall = true;
+		if ( fineStructure || !calcAggregatedDistribution () ) {	// Fine structure needs every isotope combination
+			calcIsotopeDistributionComponent ( 0, 1, 1.0 );
+			sort ( isotopicDistributionComponent.begin (), isotopicDistributionComponent.end (), SortIsotopicDistributionComponents () );
+			if ( isotopicDistributionComponent.size () == 0 )
+				monoisotopicPeakTooSmall = true;
+		}
 	}
 	else
 		noDistribution = true;
@@ -169,35 +215,85 @@ void IsotopicDistribution::calcIsotopeDistributionComponent ( int elementNumber,
 }
 void IsotopicDistribution::addIsotropicDistributionComponent ( double probability )
 {
-	ostringstream formula;
-	int* isotopeAtoms;
-	double massOffset;
-	int index;
+	IsotopicDistributionComponent idc;
+	idc.probability = probability;
+	idc.isotopeAtomsIndex = componentIsotopeAtoms.size ();
 
-	massOffset = 0.0;
-	ElementVectorSizeType i;
-	DoubleVectorVectorSizeType j;
-	for ( i = 0 ; i < elements.size () ; i++ ) {
-		index = elements [i].index;
-		isotopeAtoms = elements [i].isotopeAtoms;
-		for ( j = 1 ; j < isotopeMass [index].size () ; j++ ) {
-			if ( isotopeAtoms [j] ) {
+	double massOffset = 0.0;
+	for ( ElementVectorSizeType i = 0 ; i < elements.size () ; i++ ) {
+		int index = elements [i].index;
+		int* isotopeAtoms = elements [i].isotopeAtoms;
+		for ( DoubleVectorVectorSizeType j = 1 ; j < isotopeMass [index].size () ; j++ ) {
+			componentIsotopeAtoms.push_back ( isotopeAtoms [j] );
+			massOffset += isotopeAtoms [j] * ( isotopeMass [index][j] - isotopeMass [index][0] );
+		}
+	}
+	idc.massOffset = mPlusHToMOverZ ( massOffset + monoisotopicMass, charge, true );
+	isotopicDistributionComponent.push_back ( idc );
+}
+string IsotopicDistribution::getFormula ( const IsotopicDistributionComponent& idc ) const
+{
+	if ( idc.isotopeAtomsIndex < 0 ) return "";
+	ostringstream formula;
+	int k = idc.isotopeAtomsIndex;
+	for ( ElementVectorSizeType i = 0 ; i < elements.size () ; i++ ) {
+		int index = elements [i].index;
+		for ( DoubleVectorVectorSizeType j = 1 ; j < isotopeMass [index].size () ; j++, k++ ) {
+			int n = componentIsotopeAtoms [k];
+			if ( n ) {
 				genPrint ( formula, isotopeMass [index][j], 0 );
 				formula << elementTable [index];
-				formula << isotopeAtoms [j];
+				formula << n;
 				formula << " ";
-				massOffset += isotopeAtoms [j] * ( isotopeMass [index][j] - isotopeMass [index][0] );
 			}
 		}
 	}
-	IsotopicDistributionComponent idc;
-	idc.probability = probability;
-	idc.massOffset = mPlusHToMOverZ ( massOffset + monoisotopicMass, charge, true );
 	string s = formula.str ();
 	string::size_type len = s.length ();
-	if ( len && s [len-1] == ' ' )	idc.formula = s.substr ( 0, len-1 );
-	else							idc.formula = formula.str ();
-	isotopicDistributionComponent.push_back ( idc );
+	if ( len && s [len-1] == ' ' )	return s.substr ( 0, len-1 );
+	else							return s;
+}
+/*
+The isotope peaks are calculated without fine structure by raising the single atom isotope
+distribution of each element to the power of its multiplier and convolving the elements
+together. Returns false if an element has an isotope lighter than the monoisotope.
+*/
+bool IsotopicDistribution::calcAggregatedDistribution ()
+{
+	IsotopePolynomial dist;
+	for ( ElementVectorSizeType i = 0 ; i < elements.size () ; i++ ) {
+		const DoubleVector& mass = isotopeMass [elements [i].index];
+		const DoubleVector& abundance = isotopeAbundance [elements [i].index];
+		IsotopePolynomial atom;
+		for ( DoubleVectorSizeType j = 1 ; j < mass.size () ; j++ ) {
+			int shift = static_cast <int> ( floor ( mass [j] - mass [0] + 0.5 ) );
+			if ( shift < 0 ) return false;
+			if ( shift >= atom.p.size () ) {
+				atom.p.resize ( shift + 1, 0.0 );
+				atom.w.resize ( shift + 1, 0.0 );
+			}
+			atom.p [0] -= abundance [j];		// As for gen_multinomial_probability
+			atom.p [shift] += abundance [j];
+			atom.w [shift] += abundance [j] * ( mass [j] - mass [0] );
+		}
+		IsotopePolynomial element;
+		for ( int n = elements [i].multiplier ; n ; n >>= 1 ) {
+			if ( n & 1 ) element = convolve ( element, atom );
+			if ( n > 1 ) atom = convolve ( atom, atom );
+		}
+		dist = convolve ( dist, element );
+	}
+	for ( DoubleVectorSizeType k = 0 ; k < dist.p.size () ; k++ ) {
+		if ( dist.p [k] > probabilityLimit ) {
+			IsotopicDistributionComponent idc;
+			idc.probability = dist.p [k];
+			idc.massOffset = mPlusHToMOverZ ( dist.w [k] / dist.p [k] + monoisotopicMass, charge, true );
+			idc.isotopeAtomsIndex = -1;
+			isotopicDistributionComponent.push_back ( idc );
+		}
+	}
+	monoisotopicPeakTooSmall = dist.p [0] <= probabilityLimit;
+	return true;
 }
 void IsotopicDistribution::initialise ()
 {
@@ -212,18 +308,18 @@ void IsotopicDistribution::initialiseIsoDistCalculations ()
 const double IsotopePeakStats::DEFAULT_PROBABILITY_LIMIT = 0.0000001;
 const string IsotopePeakStats::DEFAULT_AVERAGINE_FORMULA = "C4.9384 H7.7583 N1.3577 O1.4773 S0.0417";
 // Default Averagine Mass = 111.0543052
-IsotopePeakStats::IsotopePeakStats ( double mOverZ, int charge, const string& averagineFormulaStr, double probabilityLimit ) :
-	IsotopicDistribution ( mOverZ, charge, averagineFormulaStr, probabilityLimit )
+IsotopePeakStats::IsotopePeakStats ( double mOverZ, int charge, const string& averagineFormulaStr, double probabilityLimit, bool fineStructure ) :
+	IsotopicDistribution ( mOverZ, charge, averagineFormulaStr, probabilityLimit, fineStructure )
 {
 	createIsotopePeakStats ();
 }
-IsotopePeakStats::IsotopePeakStats ( const string& eFormula, int charge, double probabilityLimit ) :
-	IsotopicDistribution ( eFormula, charge, probabilityLimit )
+IsotopePeakStats::IsotopePeakStats ( const string& eFormula, int charge, double probabilityLimit, bool fineStructure ) :
+	IsotopicDistribution ( eFormula, charge, probabilityLimit, fineStructure )
 {
 	createIsotopePeakStats ();
 }
-IsotopePeakStats::IsotopePeakStats ( ElementalFormula& ef, int charge, double probabilityLimit ) :
-	IsotopicDistribution ( ef, charge, probabilityLimit )
+IsotopePeakStats::IsotopePeakStats ( ElementalFormula& ef, int charge, double probabilityLimit, bool fineStructure ) :
+	IsotopicDistribution ( ef, charge, probabilityLimit, fineStructure )
 {
 	createIsotopePeakStats ();
 }
@@ -261,6 +357,92 @@ void IsotopePeakStats::createIsotopePeakStats ()
 		}
 	}
 }
+namespace {
+const double AVERAGINE_MASS_BIN = 0.01;
+
+struct IsotopePeakStatsCacheKey {
+	string eFormula;
+	int averagineBin;
+	int charge;
+	double probabilityLimit;
+	bool operator< ( const IsotopePeakStatsCacheKey& rhs ) const
+	{
+		if ( eFormula != rhs.eFormula ) return eFormula < rhs.eFormula;
+		if ( averagineBin != rhs.averagineBin ) return averagineBin < rhs.averagineBin;
+		if ( charge != rhs.charge ) return charge < rhs.charge;
+		return probabilityLimit < rhs.probabilityLimit;
+	}
+};
+struct IsotopePeakStatsCacheEntry {
+	IsotopePeakStats* ips;
+	int refCount;
+	list <IsotopePeakStatsCacheKey>::iterator lru;
+};
+typedef map <IsotopePeakStatsCacheKey, IsotopePeakStatsCacheEntry> MapIsotopePeakStatsCache;
+typedef MapIsotopePeakStatsCache::iterator MapIsotopePeakStatsCacheIterator;
+
+GenMutex isotopeCacheMutex;
+MapIsotopePeakStatsCache isotopeCache;
+list <IsotopePeakStatsCacheKey> isotopeCacheLRU;						// Most recently used first
+map <const IsotopePeakStats*, MapIsotopePeakStatsCacheIterator> isotopeCacheEntries;
+
+void evictIsotopePeakStats ()
+{
+	static int maxSize = InfoParams::instance ().getIntValue ( "isotope_cache_size", 1000 );
+	list <IsotopePeakStatsCacheKey>::iterator i = isotopeCacheLRU.end ();
+	while ( isotopeCache.size () > maxSize && i != isotopeCacheLRU.begin () ) {
+		--i;
+		MapIsotopePeakStatsCacheIterator cur = isotopeCache.find ( *i );
+		if ( cur->second.refCount == 0 ) {			// Distributions still in use are kept
+			isotopeCacheEntries.erase ( cur->second.ips );
+			delete cur->second.ips;
+			isotopeCache.erase ( cur );
+			i = isotopeCacheLRU.erase ( i );
+		}
+	}
+}
+}
+const IsotopePeakStats* IsotopePeakStatsCache::get ( const string& eFormula, int averagineBin, int charge, double probabilityLimit )
+{
+	IsotopePeakStatsCacheKey key;
+	key.eFormula = eFormula;
+	key.averagineBin = averagineBin;
+	key.charge = charge;
+	key.probabilityLimit = probabilityLimit;
+	GenMutexLock gml ( isotopeCacheMutex );
+	MapIsotopePeakStatsCacheIterator cur = isotopeCache.find ( key );
+	if ( cur != isotopeCache.end () ) {
+		isotopeCacheLRU.splice ( isotopeCacheLRU.begin (), isotopeCacheLRU, cur->second.lru );
+		cur->second.refCount++;
+		return cur->second.ips;
+	}
+	IsotopePeakStatsCacheEntry entry;
+	if ( eFormula.empty () )	entry.ips = new IsotopePeakStats ( averagineBin * AVERAGINE_MASS_BIN / charge, charge );
+	else						entry.ips = new IsotopePeakStats ( eFormula, charge, probabilityLimit );
+	entry.refCount = 1;
+	entry.lru = isotopeCacheLRU.insert ( isotopeCacheLRU.begin (), key );
+	isotopeCacheEntries [entry.ips] = isotopeCache.insert ( make_pair ( key, entry ) ).first;
+	evictIsotopePeakStats ();
+	return entry.ips;
+}
+const IsotopePeakStats* IsotopePeakStatsCache::getIsotopePeakStats ( const string& eFormula, int charge, double probabilityLimit )
+{
+	return get ( eFormula, 0, charge, probabilityLimit );
+}
+const IsotopePeakStats* IsotopePeakStatsCache::getAveragineIsotopePeakStats ( double mOverZ, int charge )
+{
+	int averagineBin = static_cast <int> ( floor ( mOverZ * charge / AVERAGINE_MASS_BIN + 0.5 ) );
+	return get ( "", averagineBin, charge, IsotopePeakStats::DEFAULT_PROBABILITY_LIMIT );
+}
+void IsotopePeakStatsCache::release ( const IsotopePeakStats* ips )
+{
+	GenMutexLock gml ( isotopeCacheMutex );
+	map <const IsotopePeakStats*, MapIsotopePeakStatsCacheIterator>::iterator cur = isotopeCacheEntries.find ( ips );
+	if ( cur != isotopeCacheEntries.end () ) {
+		cur->second->second.refCount--;
+		evictIsotopePeakStats ();
+	}
+}
 int IsotopePeakStats::getProbabilityIndexForMass ( double mass ) const
 {
 	return genNearestIndex ( averageMass, mass );
@@ -315,8 +497,47 @@ void IsotopeProfile::getStartAndEndMass ( vector <IsotopePeakStats*>& ips, doubl
 		endMass		= ( i == 0 ) ? e : genMax ( e, endMass );
 	}
 }
+void IsotopeProfile::getProfilePeaks ( vector <IsotopePeakStats*>& ips, const DoubleVector& intensity, DoubleVector& mass, DoubleVector& height )
+{
+	for ( int i = 0 ; i < ips.size () ; i++ ) {
+		if ( detailed ) {
+			for ( IsotopicDistributionConstIterator id ( ips [i] ) ; id.more () ; id.advance () ) {
+				mass.push_back ( id.massOffset () );
+				height.push_back ( id.probability () * intensity [i] );
+			}
+		}
+		else {
+			for ( IsotopePeakStatsConstIterator j ( ips [i] ) ; j.more () ; j.advance () ) {
+				mass.push_back ( j.averageMass () );
+				height.push_back ( j.totalProbability () * intensity [i] );
+			}
+		}
+	}
+}
+void IsotopeProfile::getProfileXValues ( double startX, double endX, double step, DoubleVector& x )
+{
+	for ( double xx = startX ; xx < endX ; xx += step ) {
+		x.push_back ( xx );
+	}
+}
+DoubleVectorSizeType IsotopeProfile::getFirstProfileIndex ( const DoubleVector& x, double startX )
+{
+	return lower_bound ( x.begin (), x.end (), startX ) - x.begin ();
+}
+void IsotopeProfile::addProfile ( const DoubleVector& x, const DoubleVector& y )
+{
+	for ( DoubleVectorSizeType i = 0 ; i < x.size () ; i++ ) {
+		if ( i == 0 || y [i] >= 1e-4 ) XYData::add ( x [i], y [i] );
+	}
+}
+/*
+Each peak is only evaluated within GAUSSIAN_PROFILE_WIDTH standard deviations of its centre. Along
+the equally spaced x values exp ( - d * d / twoSDSquared ) is updated with the ratio of successive
+values, which itself changes by a constant factor, so exp is only called three times per peak.
+*/
 GaussianIsotopeProfile::GaussianIsotopeProfile ( vector <IsotopePeakStats*>& ips, const DoubleVector& intensity, double resolution )
 {
+	static const double GAUSSIAN_PROFILE_WIDTH = 10.0;
 	double startMass;
 	double endMass;
 	getStartAndEndMass ( ips, startMass, endMass );
@@ -328,92 +549,65 @@ GaussianIsotopeProfile::GaussianIsotopeProfile ( vector <IsotopePeakStats*>& ips
 	double endX = endMass + ( 3.0 * sd );
 
 	double step = getStep ( 0.0, ( resolution < 50000 ) ? 50000 : resolution, startMass );
-	for ( double x = startX ; x < endX ; x += step ) {
-		double y = 0.0;
-		for ( int i = 0 ; i < ips.size () ; i++ ) {
-			double localY = 0.0;
-			if ( detailed )	detailedProfile ( twoSDSquared, ips [i], x, localY );
-			else			simpleProfile ( twoSDSquared, ips [i], x, localY );
-			localY *= intensity [i];
-			y += localY;
-		}
-		if ( x == startX || y >= 1e-4 ) XYData::add ( x, y );
-	}
-}
-void GaussianIsotopeProfile::simpleProfile ( double twoSDSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y )
-{
-	for ( IsotopePeakStatsConstIterator i ( isotopePeakStats ) ; i.more () ; i.advance () ) {
-		double top = x - i.averageMass ();
-		top *= top;
-		y += i.totalProbability () * exp ( - top / twoSDSquared );
-	}
-}
-void GaussianIsotopeProfile::detailedProfile ( double twoSDSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y )
-{
-	IsotopicDistributionConstIterator id ( isotopePeakStats );
-	IsotopePeakStatsConstIterator ips ( isotopePeakStats );
-	for ( int i = 0 ; id.more () ; id.advance (), i++ ) {
-		if ( i == ips.numComponents () ) {
-			ips.advance ();
-			i = 0;
+	DoubleVector x;
+	getProfileXValues ( startX, endX, step, x );
+	DoubleVector y ( x.size (), 0.0 );
+	DoubleVector mass;
+	DoubleVector height;
+	getProfilePeaks ( ips, intensity, mass, height );
+	double halfWidth = GAUSSIAN_PROFILE_WIDTH * sd;
+	double ratioMultiplier = exp ( - 2.0 * step * step / twoSDSquared );
+	for ( DoubleVectorSizeType i = 0 ; i < mass.size () ; i++ ) {
+		double m = mass [i];
+		double end = m + halfWidth;
+		DoubleVectorSizeType j = getFirstProfileIndex ( x, m - halfWidth );
+		if ( j == x.size () ) continue;
+		double d = x [j] - m;
+		double val = height [i] * exp ( - d * d / twoSDSquared );
+		double ratio = exp ( - ( 2.0 * d * step + step * step ) / twoSDSquared );
+		for ( ; j < x.size () && x [j] <= end ; j++ ) {
+			y [j] += val;
+			val *= ratio;
+			ratio *= ratioMultiplier;
 		}
-		double top = x - id.massOffset ();
-		top *= top;
-		y += id.probability () * exp ( - top / twoSDSquared );
 	}
+	addProfile ( x, y );
 }
+/*
+The Lorentzian tails fall off slowly so each peak is evaluated out to where its height drops below
+LORENTZIAN_PROFILE_LIMIT, well under the 1e-4 threshold used to add a point to the profile.
+*/
 LorentzianIsotopeProfile::LorentzianIsotopeProfile ( vector <IsotopePeakStats*>& ips, const DoubleVector& intensity, double resolution )
 {
+	using nr::pi;
+	static const double LORENTZIAN_PROFILE_LIMIT = 1e-8;
 	double startMass;
 	double endMass;
 	getStartAndEndMass ( ips, startMass, endMass );
 	double deltaM = startMass / resolution;						// Assumes resolution is that of Mono mass
 	double beta = deltaM / 2.0;									// Resolution at FWHM
 	double betaSquared = beta * beta;
-	double height = 1.0;
 	double startX = startMass - ( 6.0 * beta ) - 1.0;
 	double endX = endMass + ( 6.0 * beta );
 
 	double step = getStep ( 0.0, resolution, startMass );
-	for ( double x = startX ; x < endX ; x += step ) {
-		double y = 0.0;
-		for ( int i = 0 ; i < ips.size () ; i++ ) {
-			double localY = 0.0;
-			if ( detailed )	detailedProfile ( beta, betaSquared, ips [i], x, localY );
-			else			simpleProfile ( beta, betaSquared, ips [i], x, localY );
-			localY *= intensity [i];
-			y += localY;
-		}
-		if ( x == startX || y >= 1e-4 ) XYData::add ( x, y );
-	}
-}
-void LorentzianIsotopeProfile::simpleProfile ( double beta, double betaSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y )
-{
-	using nr::pi;
-	for ( IsotopePeakStatsConstIterator i ( isotopePeakStats ) ; i.more () ; i.advance () ) {
-		double bottom = x - i.averageMass ();
-		bottom *= bottom;
-		bottom += betaSquared;
-		bottom *= pi;
-		y += i.totalProbability () * beta / bottom;
-	}
-}
-void LorentzianIsotopeProfile::detailedProfile ( double beta, double betaSquared, IsotopePeakStats* isotopePeakStats, const double& x, double& y )
-{
-	using nr::pi;
-	IsotopicDistributionConstIterator id ( isotopePeakStats );
-	IsotopePeakStatsConstIterator ips ( isotopePeakStats );
-	for ( int i = 0 ; id.more () ; id.advance (), i++ ) {
-		if ( i == ips.numComponents () ) {
-			ips.advance ();
-			i = 0;
+	DoubleVector x;
+	getProfileXValues ( startX, endX, step, x );
+	DoubleVector y ( x.size (), 0.0 );
+	DoubleVector mass;
+	DoubleVector height;
+	getProfilePeaks ( ips, intensity, mass, height );
+	for ( DoubleVectorSizeType i = 0 ; i < mass.size () ; i++ ) {
+		double m = mass [i];
+		double top = height [i] * beta / pi;
+		double halfWidth = genMax ( 6.0 * beta, sqrt ( top / LORENTZIAN_PROFILE_LIMIT ) );
+		double end = m + halfWidth;
+		for ( DoubleVectorSizeType j = getFirstProfileIndex ( x, m - halfWidth ) ; j < x.size () && x [j] <= end ; j++ ) {
+			double d = x [j] - m;
+			y [j] += top / ( d * d + betaSquared );
 		}
-		double bottom = x - id.massOffset ();
-		bottom *= bottom;
-		bottom += betaSquared;
-		bottom *= pi;
-		y += id.probability () * beta / bottom;
 	}
+	addProfile ( x, y );
 }
 StickIsotopeProfile::StickIsotopeProfile ( vector <IsotopePeakStats*>& isotopePeakStats )
 {
@@ -92,7 +92,7 @@ void MSIsotopeParameters::initIsotopePeakStats ( const ParameterList* params )
 				ErrorHandler::genError ()->error ( "Can't calculate the elemental composition from the peptide sequence.\n" );
 			}
 			mOverZ = mPlusHToMOverZ ( formula_to_monoisotopic_mass ( ef.getFormula ().c_str () ) - ELECTRON_REST_MASS, z, true );
-			isotopePeakStats.push_back ( new IsotopePeakStats ( ef.getFormula (), z ) );
+			isotopePeakStats.push_back ( new IsotopePeakStats ( ef.getFormula (), z, IsotopePeakStats::DEFAULT_PROBABILITY_LIMIT, detailedReport ) );
 			string outString;
 			if ( !nTermName.empty () ) outString += nTermName + '-';
 			outString += initSeq;
@@ -105,7 +105,7 @@ void MSIsotopeParameters::initIsotopePeakStats ( const ParameterList* params )
 				ErrorHandler::genError ()->error ( "The elemental formula field is empty.\n" );
 			}
 			mOverZ = mPlusHToMOverZ ( formula_to_monoisotopic_mass ( eFormula.c_str () ) - ELECTRON_REST_MASS, z, true );
-			isotopePeakStats.push_back ( new IsotopePeakStats ( eFormula, z ) );
+			isotopePeakStats.push_back ( new IsotopePeakStats ( eFormula, z, IsotopePeakStats::DEFAULT_PROBABILITY_LIMIT, detailedReport ) );
 			outputString.push_back ( eFormula );
 		}
 		else if ( dType == "Averagine" ) {
@@ -118,7 +118,7 @@ void MSIsotopeParameters::initIsotopePeakStats ( const ParameterList* params )
 				ErrorHandler::genError ()->error ( "The minimum averagine mass is 300 Da.\n" );
 			}
 			mOverZ = aMass;
-			isotopePeakStats.push_back ( new IsotopePeakStats ( aMass, z ) );
+			isotopePeakStats.push_back ( new IsotopePeakStats ( aMass, z, IsotopePeakStats::DEFAULT_AVERAGINE_FORMULA, IsotopePeakStats::DEFAULT_PROBABILITY_LIMIT, detailedReport ) );
 			outputString.push_back ( aMassStr );
 		}
 		minMoverZ = ( i == 0 ) ? mOverZ : genMin ( mOverZ, minMoverZ );
@@ -69,7 +69,7 @@ void MSIsotopeSearch::printBodyHTML ( ostream& os )
 		}
 		else {
 			if ( ips [i]->getMonoisotopicPeakTooSmall () ) os << "Monoisotopic peak less than minimum probability.<p />" << endl;
-			else {
+			if ( ips [i]->size () ) {			// Peaks above the monoisotope may still be listed
 				os << "Total Abundance: <b>";
 				genPrint ( os, ips [i]->getTotalAbundance () * 100.0, 2 );
 				os << "%</b><br />" << endl;
@@ -118,7 +118,7 @@ void MSIsotopeSearch::printBodyXML ( ostream& os )
 					if ( vips [i]->getMonoisotopicPeakTooSmall () ) {
 						ParameterList::printXML ( os, "error", "Monoisotopic peak less than minimum probability." );
 					}
-					else {
+					if ( vips [i]->size () ) {
 						ParameterList::printDoubleXMLFixed ( os, "total_abundance", vips [i]->getTotalAbundance () * 100.0, 2 );
 						printSummaryReportXML ( os, vips [i] );
 						if ( isoParams.getDetailedReport () ) printDetailedReportXML ( os, vips [i] );
@@ -156,7 +156,7 @@ void MSIsotopeSearch::printBodyTabDelimitedText ( ostream& os )
 					delimitedCell ( os, "Monoisotopic peak less than minimum probability." );
 				delimitedRowEnd ( os );
 			}
-			else {
+			if ( vips [i]->size () ) {
 				delimitedRowStart ( os );
 					delimitedCell ( os, "Total Abundance:" );
 					delimitedCell ( os, vips [i]->getTotalAbundance () * 100.0, 2 );
@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <lg_new.h>
 #include <lg_string.h>
+#include <lgen_thread.h>
 #define LUCSF_MASS_PEP_MAIN
 #include <lu_aa_info.h>
 #include <lu_const_mod.h>
@@ -676,7 +677,8 @@ double getMaxWSubstituent ()
 }
 int* get_protein_int_mass_array ( const char* protein )
 {
-	static IntVector proteinMassArray;
+	static GEN_THREAD_LOCAL IntVector* proteinMassArrayPtr = 0;
+	IntVector& proteinMassArray = genThreadLocalInstance ( proteinMassArrayPtr );
 
 	proteinMassArray.clear ();
 
@@ -687,7 +689,8 @@ int* get_protein_int_mass_array ( const char* protein )
 }
 double* get_protein_double_mass_array ( const char* protein )
 {
-	static DoubleVector proteinMassArray;
+	static GEN_THREAD_LOCAL DoubleVector* proteinMassArrayPtr = 0;
+	DoubleVector& proteinMassArray = genThreadLocalInstance ( proteinMassArrayPtr );
 
 	proteinMassArray.clear ();
 
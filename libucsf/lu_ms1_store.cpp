@@ -0,0 +1,264 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_ms1_store.cpp                                              *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Binary store of the MS scans from an mzML file for raw data   *
+*               access.                                                       *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#ifndef VIS_C
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#ifdef VIS_C
+#include <process.h>
+#endif
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <lg_io.h>
+#include <lg_string.h>
+#include <lgen_file.h>
+#include <lgen_mmap.h>
+#include <lu_ms1_store.h>
+#include <lu_xml_data.h>
+using std::string;
+using std::ios_base;
+using std::map;
+using std::sort;
+using std::stable_sort;
+using std::lower_bound;
+using std::upper_bound;
+using std::runtime_error;
+
+namespace {
+class SortMS1ScanStoreScanByRT {
+	const MS1ScanStoreScanVector& scans;
+public:
+	SortMS1ScanStoreScanByRT ( const MS1ScanStoreScanVector& scans ) :
+		scans ( scans ) {}
+	bool operator () ( int lhs, int rhs ) const { return scans [lhs].rt < scans [rhs].rt; }
+};
+class SortMS1ScanStoreMSMSScanByScan {
+public:
+	bool operator () ( const MS1ScanStoreMSMSScan& lhs, const MS1ScanStoreMSMSScan& rhs ) const { return lhs.scan < rhs.scan; }
+};
+class SortMZIntensityPair {
+public:
+	bool operator () ( const std::pair <double, double>& lhs, const std::pair <double, double>& rhs ) const { return lhs.first < rhs.first; }
+};
+}
+
+MS1ScanStoreWriter::MS1ScanStoreWriter ( const string& mzMLFile ) :
+	mzMLFile ( mzMLFile ),
+	tempFile ( MS1ScanStore::getStoreFilename ( mzMLFile ) + "." + gen_itoa ( getpid () ) + ".tmp" ),	// Another process may be creating the same store
+	offset ( sizeof (MS1ScanStoreHeader) )
+{
+	ost.open ( tempFile.c_str (), ios_base::binary );
+	if ( !ost ) {
+		throw runtime_error ( "The MS scan store for the file " + genFilenameFromPath ( mzMLFile ) + " can't be created." );
+	}
+	MS1ScanStoreHeader header;
+	memset ( &header, 0, sizeof (MS1ScanStoreHeader) );
+	ost.write ( (char*) &header, sizeof (MS1ScanStoreHeader) );
+}
+MS1ScanStoreWriter::~MS1ScanStoreWriter ()
+{
+	if ( ost.is_open () ) {			// write wasn't called or failed
+		ost.close ();
+		genUnlink ( tempFile );
+	}
+}
+void MS1ScanStoreWriter::addMS1Scan ( int scan, double rt, const DoubleVector& mz, const DoubleVector& intensity )
+{
+	int numPeaks = genMin ( mz.size (), intensity.size () );
+	std::vector <std::pair <double, double> > peaks ( numPeaks );
+	for ( int i = 0 ; i < numPeaks ; i++ ) {
+		peaks [i] = std::make_pair ( mz [i], intensity [i] );
+	}
+	stable_sort ( peaks.begin (), peaks.end (), SortMZIntensityPair () );
+	DoubleVector m ( numPeaks );
+	std::vector <float> inten ( numPeaks + 1, 0.0 );	// Extra value for padding
+	for ( int j = 0 ; j < numPeaks ; j++ ) {
+		m [j] = peaks [j].first;
+		inten [j] = static_cast <float> (peaks [j].second);
+	}
+	int numFloats = ( numPeaks % 2 ) ? numPeaks + 1 : numPeaks;
+	if ( numPeaks ) ost.write ( (char*) &m [0], numPeaks * sizeof (double) );
+	if ( numFloats ) ost.write ( (char*) &inten [0], numFloats * sizeof (float) );
+
+	MS1ScanStoreScan s;
+	s.rt = rt;
+	s.offset = offset;
+	s.scan = scan;
+	s.numPeaks = numPeaks;
+	ms1ScanIndex [scan] = ms1Scans.size ();
+	ms1Scans.push_back ( s );
+	offset += numPeaks * sizeof (double) + numFloats * sizeof (float);
+}
+void MS1ScanStoreWriter::addMSMSScan ( int scan, int precursorScan )
+{
+	MS1ScanStoreMSMSScan s;
+	s.scan = scan;
+	s.ms1Index = static_cast <int> (ms1Scans.size ()) - 1;		// Default to the last MS scan
+	if ( precursorScan != -1 ) {
+		map <int, int>::const_iterator cur = ms1ScanIndex.find ( precursorScan );
+		if ( cur != ms1ScanIndex.end () ) s.ms1Index = cur->second;
+	}
+	msmsScans.push_back ( s );
+}
+void MS1ScanStoreWriter::write ()
+{
+	IntVector order ( ms1Scans.size () );
+	for ( IntVectorSizeType i = 0 ; i < order.size () ; i++ ) order [i] = i;
+	stable_sort ( order.begin (), order.end (), SortMS1ScanStoreScanByRT ( ms1Scans ) );
+	IntVector newIndex ( order.size () );
+	MS1ScanStoreScanVector sortedScans;
+	for ( IntVectorSizeType j = 0 ; j < order.size () ; j++ ) {
+		newIndex [order [j]] = j;
+		sortedScans.push_back ( ms1Scans [order [j]] );
+	}
+	for ( MS1ScanStoreMSMSScanVector::size_type k = 0 ; k < msmsScans.size () ; k++ ) {
+		if ( msmsScans [k].ms1Index != -1 ) msmsScans [k].ms1Index = newIndex [msmsScans [k].ms1Index];
+	}
+	sort ( msmsScans.begin (), msmsScans.end (), SortMS1ScanStoreMSMSScanByScan () );
+
+	if ( !sortedScans.empty () )	ost.write ( (char*) &sortedScans [0], sortedScans.size () * sizeof (MS1ScanStoreScan) );
+	if ( !msmsScans.empty () )		ost.write ( (char*) &msmsScans [0], msmsScans.size () * sizeof (MS1ScanStoreMSMSScan) );
+	MS1ScanStoreHeader header;
+	MS1ScanStore::initHeader ( header, mzMLFile );
+	header.numMS1Scans = sortedScans.size ();
+	header.numMSMSScans = msmsScans.size ();
+	header.tableOffset = offset;
+	ost.seekp ( 0 );
+	ost.write ( (char*) &header, sizeof (MS1ScanStoreHeader) );
+	ost.close ();
+	if ( ost.fail () ) {
+		genUnlink ( tempFile );
+		throw runtime_error ( "The MS scan store for the file " + genFilenameFromPath ( mzMLFile ) + " can't be written." );
+	}
+	genRename ( tempFile, MS1ScanStore::getStoreFilename ( mzMLFile ) );
+}
+
+const char* MS1ScanStore::MAGIC = "PPMS1STR";
+const int MS1ScanStore::VERSION = 1;
+
+MS1ScanStore::MS1ScanStore ( const string& mzMLFile )
+{
+	string storeFile = getStoreFilename ( mzMLFile );
+	file = new MMapFile <char> ( storeFile, 0, genFileSize ( storeFile ), MMAP_ADVICE_RANDOM );
+	data = file->getStartPointer ();
+	const MS1ScanStoreHeader* header = reinterpret_cast <const MS1ScanStoreHeader*> (data);
+	const MS1ScanStoreScan* s = reinterpret_cast <const MS1ScanStoreScan*> (data + header->tableOffset);
+	ms1Scans.assign ( s, s + header->numMS1Scans );
+	const MS1ScanStoreMSMSScan* ms = reinterpret_cast <const MS1ScanStoreMSMSScan*> (s + header->numMS1Scans);
+	msmsScans.assign ( ms, ms + header->numMSMSScans );
+}
+MS1ScanStore::~MS1ScanStore ()
+{
+	delete file;
+}
+void MS1ScanStore::initHeader ( MS1ScanStoreHeader& header, const string& mzMLFile )
+{
+	memset ( &header, 0, sizeof (MS1ScanStoreHeader) );
+	memcpy ( header.magic, MAGIC, sizeof (header.magic) );
+	header.version = VERSION;
+	header.fileSize = genFileSize ( mzMLFile );
+	header.modifyTime = genLastModifyTime ( mzMLFile );
+}
+bool MS1ScanStore::checkHeader ( const string& mzMLFile )
+{
+	string storeFile = getStoreFilename ( mzMLFile );
+	if ( !genFileExists ( storeFile ) ) return false;
+	GENINT64 storeSize = genFileSize ( storeFile );
+	if ( storeSize < sizeof (MS1ScanStoreHeader) ) return false;
+	MS1ScanStoreHeader header;
+	initHeader ( header, mzMLFile );
+	MS1ScanStoreHeader h;
+	GenIFStream ist ( storeFile, ios_base::binary );
+	ist.read ( (char*) &h, sizeof (MS1ScanStoreHeader) );
+	if ( ist.fail () ) return false;
+	if ( memcmp ( h.magic, header.magic, sizeof (h.magic) ) ) return false;
+	if ( h.version != header.version ) return false;
+	if ( h.fileSize != header.fileSize ) return false;
+	if ( h.modifyTime != header.modifyTime ) return false;
+	return storeSize == h.tableOffset + h.numMS1Scans * sizeof (MS1ScanStoreScan) + h.numMSMSScans * sizeof (MS1ScanStoreMSMSScan);
+}
+MS1ScanStore* MS1ScanStore::getStore ( const string& mzMLFile )
+{
+	if ( !checkHeader ( mzMLFile ) ) {
+		MS1ScanStoreWriter writer ( mzMLFile );
+		PPExpatMZMLMS1Data ppemd ( writer );
+		ppemd.parseXMLFromFile ( mzMLFile );
+		writer.write ();
+	}
+	return new MS1ScanStore ( mzMLFile );
+}
+int MS1ScanStore::getMS1Index ( int scan ) const
+{
+	MS1ScanStoreMSMSScan s;
+	s.scan = scan;
+	MS1ScanStoreMSMSScanVector::const_iterator cur = lower_bound ( msmsScans.begin (), msmsScans.end (), s, SortMS1ScanStoreMSMSScanByScan () );
+	if ( cur != msmsScans.end () && cur->scan == scan ) return cur->ms1Index;
+	for ( MS1ScanStoreScanVector::size_type i = 0 ; i < ms1Scans.size () ; i++ ) {	// The scan may be an MS scan
+		if ( ms1Scans [i].scan == scan ) return i;
+	}
+	return -1;
+}
+void MS1ScanStore::addScan ( int index, double startMass, double endMass, DoubleVector& x, DoubleVector& y, bool first ) const
+{
+	const MS1ScanStoreScan& s = ms1Scans [index];
+	const double* mz = reinterpret_cast <const double*> (data + s.offset);
+	const float* intensity = reinterpret_cast <const float*> (mz + s.numPeaks);
+	int n = s.numPeaks;
+	if ( first ) {
+		int lo = ( endMass == 0.0 ) ? 0 : lower_bound ( mz, mz + n, startMass ) - mz;
+		int hi = ( endMass == 0.0 ) ? n : upper_bound ( mz, mz + n, endMass ) - mz;
+		for ( int i = lo ; i < hi ; i++ ) {
+			x.push_back ( mz [i] );
+			y.push_back ( intensity [i] );
+		}
+	}
+	else if ( !x.empty () ) {		// Linear interpolation onto the m/z values of the first scan
+		int j = lower_bound ( mz, mz + n, x.front () ) - mz;
+		for ( DoubleVectorSizeType k = 0 ; k < x.size () ; k++ ) {
+			while ( j < n && mz [j] < x [k] ) j++;
+			if ( j == n ) break;
+			if ( mz [j] == x [k] )	y [k] += intensity [j];
+			else if ( j > 0 )		y [k] += intensity [j-1] + ( intensity [j] - intensity [j-1] ) * ( x [k] - mz [j-1] ) / ( mz [j] - mz [j-1] );
+		}
+	}
+}
+/*
+The scans are averaged over numScans MS scans centred on index. The other scans are
+interpolated onto the m/z values of the centre scan so this is intended for profile data.
+*/
+void MS1ScanStore::getXYData ( XYData& xyData, int index, int numScans, double startMass, double endMass ) const
+{
+	int first = genMax ( 0, index - ( numScans - 1 ) / 2 );
+	int last = genMin ( size () - 1, index + numScans / 2 );
+	DoubleVector x;
+	DoubleVector y;
+	addScan ( index, startMass, endMass, x, y, true );
+	for ( int i = first ; i <= last ; i++ ) {
+		if ( i != index ) addScan ( i, startMass, endMass, x, y, false );
+	}
+	double n = last - first + 1;
+	for ( DoubleVectorSizeType j = 0 ; j < x.size () ; j++ ) {
+		xyData.add ( x [j], y [j] / n );
+	}
+}
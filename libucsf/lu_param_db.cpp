@@ -896,6 +896,14 @@ void SQLiteInfo::insert ()
 	vpss.push_back ( make_pair ( string("max_msfit_peaks"),					string("1000")		) );
 	vpss.push_back ( make_pair ( string("msfit_max_reported_hits_limit"),	string("500")		) );
 	vpss.push_back ( make_pair ( string("faindex_parallel"),				string("false")		) );
+	vpss.push_back ( make_pair ( string("faindex_num_threads"),			string("0")			) );
+	vpss.push_back ( make_pair ( string("faindex_packed_sequences"),		string("false")		) );
+	//vpss.push_back ( make_pair ( string("faindex_peptide_index_enzyme"),	string("")			) );
+	vpss.push_back ( make_pair ( string("faindex_peptide_index_missed_cleavages"),	string("2")	) );
+	vpss.push_back ( make_pair ( string("peptide_index"),					string("false")		) );
+	vpss.push_back ( make_pair ( string("peptide_index_max_mass"),			string("6000")		) );
+	vpss.push_back ( make_pair ( string("frag_index_min_matches"),			string("0")			) );
+	vpss.push_back ( make_pair ( string("peak_list_index"),				string("true")		) );
 	//vpss.push_back ( make_pair ( string("viewer_repository"),				string("")			) );
 	//vpss.push_back ( make_pair ( string("centroid_dir"),					string("")			) );
 	//vpss.push_back ( make_pair ( string("centroid_dir_win"),					string("")			) );
@@ -908,6 +916,9 @@ void SQLiteInfo::insert ()
 	//vpss.push_back ( make_pair ( string("user_repository_unix"),					string("")			) );
 	vpss.push_back ( make_pair ( string("multi_process"),					string("false")		) );
 	vpss.push_back ( make_pair ( string("msms_max_spectra"),				string("500")		) );
+	vpss.push_back ( make_pair ( string("msms_memory_budget"),			string("0")			) );
+	vpss.push_back ( make_pair ( string("digest_cache"),					string("false")		) );
+	vpss.push_back ( make_pair ( string("digest_cache_memory"),			string("256")		) );
 	vpss.push_back ( make_pair ( string("duplicate_scans"),					string("false")		) );
 	//vpss.push_back ( make_pair ( string("mpi_run"),							string("")			) );
 	//vpss.push_back ( make_pair ( string("mpi_args"),						string("")			) );
@@ -920,6 +931,13 @@ void SQLiteInfo::insert ()
 	//vpss.push_back ( make_pair ( string("btag_daemon_name"),				string("")			) );
 	vpss.push_back ( make_pair ( string("btag_daemon_remote"),				string("false")		) );
 	vpss.push_back ( make_pair ( string("max_btag_searches"),				string("1")			) );
+	vpss.push_back ( make_pair ( string("btag_num_threads"),				string("1")			) );
+	vpss.push_back ( make_pair ( string("mshomology_num_threads"),			string("1")			) );
+	vpss.push_back ( make_pair ( string("msproduct_num_processes"),		string("1")			) );
+	vpss.push_back ( make_pair ( string("search_compare_binary_results"),	string("true")		) );
+	vpss.push_back ( make_pair ( string("search_compare_num_threads"),		string("1")			) );
+	vpss.push_back ( make_pair ( string("isotope_cache_size"),				string("1000")		) );
+	vpss.push_back ( make_pair ( string("mzml_quan_scans"),					string("1")			) );
 	vpss.push_back ( make_pair ( string("email"),							string("false")		) );
 	vpss.push_back ( make_pair ( string("server_name"),						string("localhost")	) );
 	vpss.push_back ( make_pair ( string("server_port"),						string("80")		) );
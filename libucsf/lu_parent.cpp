@@ -20,7 +20,6 @@
 *                                                                             *
 ******************************************************************************/
 #ifdef RAW_DATA
-#include <memory>
 #include <iomanip>
 #include <lg_string.h>
 #include <lu_parent.h>
@@ -42,7 +41,6 @@ using std::ostream;
 using std::setprecision;
 using std::string;
 using std::ostringstream;
-using std::auto_ptr;
 
 bool PeakFit::graphs = false;
 bool PeakFit::diagnostics = false;
@@ -319,13 +317,13 @@ ParentData::ParentData ( const XYData& xyData, double monoMass, int charge, Elem
 		area.push_back ( intensity [i] * width * nr::sqrtPi );
 		snr.push_back ( intensity [i] / noiseStDev );
 	}
-	auto_ptr <IsotopePeakStats> ips;
+	const IsotopePeakStats* ips;
 	if ( ef && efFlag )	{
-		ips = auto_ptr <IsotopePeakStats> ( new IsotopePeakStats ( ef->getFormula (), charge ) );
+		ips = IsotopePeakStatsCache::getIsotopePeakStats ( ef->getFormula (), charge );
 		fString = ef->getFormula ();
 	}
 	else {
-		ips = auto_ptr <IsotopePeakStats> ( new IsotopePeakStats ( monoMass, charge ) );
+		ips = IsotopePeakStatsCache::getAveragineIsotopePeakStats ( monoMass, charge );
 		fString = "";
 	}
 	ch = charge;
@@ -333,6 +331,7 @@ ParentData::ParentData ( const XYData& xyData, double monoMass, int charge, Elem
 	for ( DoubleVectorVectorSizeType j = 0 ; j < coeff.size () ; j++ ) {
 		theoreticalPercentMax.push_back ( ips->getProbability ( j ) * 100.0 / maximumProbability );
 	}
+	IsotopePeakStatsCache::release ( ips );
 	if ( graphFlag ) {
 		PeakFit::drawGraph ( *graphData, false );
 		delete graphData;
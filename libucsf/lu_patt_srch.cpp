@@ -134,8 +134,10 @@ void PatternSearch::doSearch ( PatternHits* patternHits, FastaServer* fsPtr, int
 
 	if ( !noEnzyme ) init_fasta_enzyme_function ( params.getEnzyme () );
 
+	RegularExpressionDFA dfa ( *regexp, maxErrs, true );	// Quickly rejects frames with no possible match
 	char* readingFrame;
 	while ( ( readingFrame = fi.getNextFrame () ) != NULL ) {
+		if ( !dfa.isPresent ( readingFrame ) ) continue;
 		if ( noEnzyme ) {
 			while ( regexp->isPresentMultiOverlap ( readingFrame ) ) {
 				patternHits->addHit ( PatternHit ( fsPtr, fi.getEntry (), fi.getFrameTranslation (), fi.getFrame (), regexp ) );
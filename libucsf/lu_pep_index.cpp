@@ -0,0 +1,217 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_pep_index.cpp                                              *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Precomputed, mass sorted index of the enzyme cleavage         *
+*               products of a database.                                       *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#ifndef VIS_C
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#ifdef VIS_C
+#include <process.h>
+#endif
+#include <cstring>
+#include <algorithm>
+#include <lg_io.h>
+#include <lg_string.h>
+#include <lgen_file.h>
+#include <lgen_mmap.h>
+#include <lu_fasta.h>
+#include <lu_fas_enz.h>
+#include <lu_getfil.h>
+#include <lu_pep_index.h>
+using std::string;
+using std::vector;
+using std::ios_base;
+using std::sort;
+using std::ostringstream;
+using std::hex;
+
+namespace {
+class SortPeptideIndexEntryAscending {
+public:
+	bool operator () ( const PeptideIndexEntry& lhs, const PeptideIndexEntry& rhs ) const
+	{
+		if ( lhs.mass == rhs.mass ) {
+			if ( lhs.index == rhs.index )	return lhs.start < rhs.start;
+			else							return lhs.index < rhs.index;
+		}
+		return lhs.mass < rhs.mass;
+	}
+};
+}
+
+const char* PeptideMassIndex::MAGIC = "PPPEPIDX";
+const int PeptideMassIndex::VERSION = 1;
+
+PeptideMassIndex::PeptideMassIndex ( const string& baseName ) :
+	entries ( 0 ),
+	sequences ( 0 ),
+	numEntries ( genFileSize ( baseName + ".pix" ) / sizeof (PeptideIndexEntry) )
+{
+	if ( numEntries ) {
+		entries = new MMapFile <PeptideIndexEntry> ( baseName + ".pix" );
+		sequences = new MMapFile <char> ( baseName + ".pxs", 0, 0, MMAP_ADVICE_RANDOM );
+	}
+}
+PeptideMassIndex::~PeptideMassIndex ()
+{
+	delete entries;
+	delete sequences;
+}
+PeptideIndexEntry PeptideMassIndex::getEntry ( GENINT64 i ) const
+{
+	return entries->subscript ( i );
+}
+GENINT64 PeptideMassIndex::lowerBound ( double mass ) const
+{
+	GENINT64 first = 0;
+	GENINT64 count = numEntries;
+	while ( count > 0 ) {
+		GENINT64 step = count / 2;
+		GENINT64 mid = first + step;
+		if ( entries->subscript ( mid ).mass < mass ) {
+			first = mid + 1;
+			count -= step + 1;
+		}
+		else count = step;
+	}
+	return first;
+}
+string PeptideMassIndex::getSequence ( const PeptideIndexEntry& entry ) const
+{
+	return string ( sequences->getRange ( entry.seqOffset, entry.seqOffset + entry.length - 1 ), entry.length );
+}
+string PeptideMassIndex::getBaseName ( FastaServer* fs, const string& enzyme, int missedCleavages )
+{
+	unsigned int hash = 2166136261U;		// FNV-1a hash of the masses used to calculate the index
+	for ( char aa = 'A' ; aa <= 'Z' ; aa++ ) {
+		const unsigned char* p = reinterpret_cast <const unsigned char*> (&amino_acid_wt [aa]);
+		for ( size_t i = 0 ; i < sizeof (double) ; i++ ) {
+			hash = ( hash ^ p [i] ) * 16777619U;
+		}
+	}
+	const unsigned char* p = reinterpret_cast <const unsigned char*> (&terminal_wt);
+	for ( size_t j = 0 ; j < sizeof (double) ; j++ ) {
+		hash = ( hash ^ p [j] ) * 16777619U;
+	}
+	string enz = enzyme;
+	for ( StringSizeType k = 0 ; k < enz.length () ; k++ ) {
+		if ( !isalnum ( enz [k] ) ) enz [k] = '_';
+	}
+	ostringstream ost;
+	ost << SeqdbDir::instance ().getSeqdbDir () << fs->getFileName () << '.' << enz << '_' << missedCleavages << '_' << hex << hash;
+	return ost.str ();
+}
+void PeptideMassIndex::initHeader ( PeptideIndexHeader& header, FastaServer* fs, const string& enzyme, int missedCleavages, double maxMass )
+{
+	memset ( &header, 0, sizeof (PeptideIndexHeader) );
+	memcpy ( header.magic, MAGIC, sizeof (header.magic) );
+	header.version = VERSION;
+	header.missedCleavages = missedCleavages;
+	header.maxMass = maxMass;
+	header.terminalWt = terminal_wt;
+	for ( char aa = 'A' ; aa <= 'Z' ; aa++ ) {	// Database sequences only contain upper case letters
+		header.aaWt [aa] = amino_acid_wt [aa];
+	}
+	header.databaseTime = fs->getDatabaseTime ();
+	strncpy ( header.enzyme, enzyme.c_str (), sizeof (header.enzyme) - 1 );
+}
+bool PeptideMassIndex::checkHeader ( const string& baseName, const PeptideIndexHeader& header )
+{
+	string headerFile = baseName + ".pxh";
+	if ( !genFileExists ( headerFile ) || genFileSize ( headerFile ) != sizeof (PeptideIndexHeader) ) return false;
+	if ( !genFileExists ( baseName + ".pix" ) || !genFileExists ( baseName + ".pxs" ) ) return false;
+	PeptideIndexHeader h;
+	GenIFStream ist ( headerFile, ios_base::binary );
+	ist.read ( (char*) &h, sizeof (PeptideIndexHeader) );
+	if ( ist.fail () ) return false;
+	if ( memcmp ( h.magic, header.magic, sizeof (h.magic) ) ) return false;
+	if ( h.version != header.version ) return false;
+	if ( h.missedCleavages != header.missedCleavages ) return false;
+	if ( h.maxMass < header.maxMass ) return false;
+	if ( h.terminalWt != header.terminalWt ) return false;
+	if ( memcmp ( h.aaWt, header.aaWt, sizeof (h.aaWt) ) ) return false;
+	if ( h.databaseTime != header.databaseTime ) return false;
+	if ( strcmp ( h.enzyme, header.enzyme ) ) return false;
+	return genFileSize ( baseName + ".pix" ) == h.numEntries * sizeof (PeptideIndexEntry);
+}
+void PeptideMassIndex::create ( FastaServer* fs, const string& enzyme, int missedCleavages, double maxMass )
+{
+	init_fasta_enzyme_function ( enzyme );
+	ErrorHandler::genError ()->message ( "Creating peptide mass index (.pxh, .pix and .pxs) for " + enzyme + ".\n" );
+	string baseName = getBaseName ( fs, enzyme, missedCleavages );
+	string tempSuffix = "." + gen_itoa ( getpid () ) + ".tmp";		// Another process may be creating the same index
+	vector <PeptideIndexEntry> vpie;
+	GenOFStream ostSeq ( baseName + ".pxs" + tempSuffix, ios_base::binary );
+	GENINT64 seqOffset = 0;
+	int numEntries = fs->getNumEntries ();
+	for ( int n = 1 ; n <= numEntries ; n++ ) {
+		string frame = fs->get_fasta_protein ( n, 1 );
+		const IntVector& cleavageIndex = enzyme_fragmenter ( frame );
+		int numEnzymeFragments = cleavageIndex.size ();
+		const DoubleVector& cleavedMass = get_cleaved_masses_to_limit ( frame, cleavageIndex, maxMass );
+		for ( int i = 0, missedCleavageLimit = missedCleavages ; i < numEnzymeFragments ; i++, missedCleavageLimit++ ) {
+			double molWt = terminal_wt;
+			int previousCleavageIndex = ( i == 0 ) ? -1 : cleavageIndex [i-1];
+			for ( int j = i ; j <= missedCleavageLimit && j < numEnzymeFragments ; j++ ) {
+				molWt += cleavedMass [j];
+				if ( molWt > maxMass ) break;
+				PeptideIndexEntry pie;
+				pie.mass = molWt;
+				pie.seqOffset = seqOffset;
+				pie.index = n;
+				pie.start = previousCleavageIndex + 1;
+				pie.length = static_cast <unsigned short> ( cleavageIndex [j] - previousCleavageIndex );
+				pie.previousAA = ( i == 0 ) ? '-' : frame [previousCleavageIndex];
+				pie.nextAA = ( j == numEnzymeFragments-1 ) ? '-' : frame [cleavageIndex [j] + 1];
+				ostSeq.write ( frame.c_str () + pie.start, pie.length );
+				seqOffset += pie.length;
+				vpie.push_back ( pie );
+			}
+		}
+	}
+	ostSeq.close ();
+	sort ( vpie.begin (), vpie.end (), SortPeptideIndexEntryAscending () );
+	GenOFStream ostIdx ( baseName + ".pix" + tempSuffix, ios_base::binary );
+	if ( !vpie.empty () ) ostIdx.write ( (char*) &vpie [0], vpie.size () * sizeof (PeptideIndexEntry) );
+	ostIdx.close ();
+
+	PeptideIndexHeader header;
+	initHeader ( header, fs, enzyme, missedCleavages, maxMass );
+	header.numEntries = vpie.size ();
+	GenOFStream ostHdr ( baseName + ".pxh" + tempSuffix, ios_base::binary );
+	ostHdr.write ( (char*) &header, sizeof (PeptideIndexHeader) );
+	ostHdr.close ();
+
+	genRename ( baseName + ".pxs" + tempSuffix, baseName + ".pxs" );
+	genRename ( baseName + ".pix" + tempSuffix, baseName + ".pix" );
+	genRename ( baseName + ".pxh" + tempSuffix, baseName + ".pxh" );	// The header is written last as it marks the index as complete
+	ErrorHandler::genError ()->message ( gen_itoa ( vpie.size () ) + " peptides in the index.\n" );
+}
+PeptideMassIndex* PeptideMassIndex::getIndex ( FastaServer* fs, const string& enzyme, int missedCleavages, double maxMass )
+// Returns 0 if FA-Index hasn't created a current index covering maxMass
+{
+	string baseName = getBaseName ( fs, enzyme, missedCleavages );
+	PeptideIndexHeader header;
+	initHeader ( header, fs, enzyme, missedCleavages, maxMass );
+	if ( !checkHeader ( baseName, header ) ) return 0;
+	return new PeptideMassIndex ( baseName );
+}
@@ -22,6 +22,7 @@
 #include <nr.h>
 #include <lg_io.h>
 #include <lg_memory.h>
+#include <lgen_thread.h>
 #include <lu_pi.h>
 #include <lu_mass.h>
 using std::string;
@@ -29,10 +30,10 @@ using std::ostream;
 
 static double ph_to_charge ( double ph );
 
-static int multiplier_list [AA_ARRAY_SIZE];
-static double pk_n_terminus_aa;
-static double pk_c_terminus_aa;
-static double ln10;
+static GEN_THREAD_LOCAL int multiplier_list [AA_ARRAY_SIZE];	// Thread local as FA-Index calculates the pI in several threads
+static GEN_THREAD_LOCAL double pk_n_terminus_aa;
+static GEN_THREAD_LOCAL double pk_c_terminus_aa;
+static GEN_THREAD_LOCAL double ln10;
 
 int ProteinPI::piPrecision = 1;
 ProteinPI::ProteinPI ( const string& proteinString )
@@ -0,0 +1,206 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_pk_index.cpp                                               *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Sidecar offset index for mgf, ms2 and apl peak lists.         *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#ifndef VIS_C
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#ifdef VIS_C
+#include <process.h>
+#endif
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <lg_io.h>
+#include <lg_string.h>
+#include <lgen_file.h>
+#include <lu_pk_index.h>
+using std::string;
+using std::ios_base;
+using std::ofstream;
+using std::sort;
+
+namespace {
+const int NUM_ORDER_LISTS = 3;		// Scan number, title hash and precursor m/z
+class SortPeakListIndexOrder {
+	const PeakListIndexEntryVector& entries;
+	int list;
+	double getKey ( int i ) const { return PeakListIndex::getKey ( list, entries [i] ); }
+public:
+	SortPeakListIndexOrder ( const PeakListIndexEntryVector& entries, int list ) :
+		entries ( entries ),
+		list ( list ) {}
+	bool operator () ( int lhs, int rhs ) const
+	{
+		double lKey = getKey ( lhs );
+		double rKey = getKey ( rhs );
+		if ( lKey == rKey ) return lhs < rhs;	// Equal keys stay in file order
+		return lKey < rKey;
+	}
+};
+}
+
+const char* PeakListIndex::MAGIC = "PPPKLIDX";
+const int PeakListIndex::VERSION = 1;
+
+PeakListIndex::PeakListIndex ( const string& peakList ) :
+	ist ( new GenIFStream ( getIndexFilename ( peakList ), ios_base::binary ) ),
+	numEntries ( 0 )
+{
+	PeakListIndexHeader header;
+	ist->read ( (char*) &header, sizeof (PeakListIndexHeader) );
+	if ( !ist->fail () ) numEntries = header.numEntries;
+}
+PeakListIndex::~PeakListIndex ()
+{
+	delete ist;
+}
+PeakListIndexEntry PeakListIndex::getEntry ( GENINT64 i ) const
+{
+	PeakListIndexEntry entry;
+	ist->clear ();
+	ist->seekg ( sizeof (PeakListIndexHeader) + i * sizeof (PeakListIndexEntry) );
+	ist->read ( (char*) &entry, sizeof (PeakListIndexEntry) );
+	return entry;
+}
+int PeakListIndex::getOrder ( int list, GENINT64 i ) const
+{
+	int order;
+	ist->clear ();
+	ist->seekg ( sizeof (PeakListIndexHeader) + numEntries * sizeof (PeakListIndexEntry) + ( list * numEntries + i ) * sizeof (int) );
+	ist->read ( (char*) &order, sizeof (int) );
+	return order;
+}
+double PeakListIndex::getKey ( int list, const PeakListIndexEntry& entry )
+{
+	if ( list == 0 )		return entry.scan;
+	else if ( list == 1 )	return entry.titleHash;
+	else					return entry.mOverZ;
+}
+IntVector PeakListIndex::equalRange ( int list, double key ) const
+{
+	GENINT64 first = 0;
+	GENINT64 count = numEntries;
+	while ( count > 0 ) {
+		GENINT64 step = count / 2;
+		GENINT64 mid = first + step;
+		if ( getKey ( list, getEntry ( getOrder ( list, mid ) ) ) < key ) {
+			first = mid + 1;
+			count -= step + 1;
+		}
+		else count = step;
+	}
+	IntVector iv;
+	for ( GENINT64 i = first ; i < numEntries ; i++ ) {
+		int order = getOrder ( list, i );
+		if ( getKey ( list, getEntry ( order ) ) != key ) break;
+		iv.push_back ( order );
+	}
+	return iv;
+}
+IntVector PeakListIndex::getScanEntries ( int scan ) const
+{
+	return equalRange ( 0, scan );
+}
+IntVector PeakListIndex::getTitleEntries ( const string& title ) const
+{
+	return equalRange ( 1, getTitleHash ( title ) );
+}
+IntVector PeakListIndex::getMOverZEntries ( double mOverZ ) const
+{
+	return equalRange ( 2, mOverZ );
+}
+unsigned int PeakListIndex::getTitleHash ( const string& title )
+{
+	unsigned int hash = 2166136261U;		// FNV-1a
+	for ( StringSizeType i = 0 ; i < title.length () ; i++ ) {
+		hash = ( hash ^ static_cast <unsigned char> (title [i]) ) * 16777619U;
+	}
+	return hash;
+}
+int PeakListIndex::getScanNumber ( const string& scan )
+{
+	string s = scan.substr ( 0, scan.find ( ',' ) );
+	if ( s.empty () || s.length () > 9 ) return -1;
+	for ( StringSizeType i = 0 ; i < s.length () ; i++ ) {
+		if ( !isdigit ( s [i] ) ) return -1;
+	}
+	return atoi ( s.c_str () );
+}
+void PeakListIndex::initHeader ( PeakListIndexHeader& header, const string& peakList, int format )
+{
+	memset ( &header, 0, sizeof (PeakListIndexHeader) );
+	memcpy ( header.magic, MAGIC, sizeof (header.magic) );
+	header.version = VERSION;
+	header.format = format;
+	header.fileSize = genFileSize ( peakList );
+	header.modifyTime = genLastModifyTime ( peakList );
+}
+bool PeakListIndex::checkHeader ( const string& peakList, int format )
+{
+	string indexFile = getIndexFilename ( peakList );
+	if ( !genFileExists ( indexFile ) ) return false;
+	GENINT64 indexSize = genFileSize ( indexFile );
+	if ( indexSize < sizeof (PeakListIndexHeader) ) return false;
+	PeakListIndexHeader header;
+	initHeader ( header, peakList, format );
+	PeakListIndexHeader h;
+	GenIFStream ist ( indexFile, ios_base::binary );
+	ist.read ( (char*) &h, sizeof (PeakListIndexHeader) );
+	if ( ist.fail () ) return false;
+	if ( memcmp ( h.magic, header.magic, sizeof (h.magic) ) ) return false;
+	if ( h.version != header.version ) return false;
+	if ( h.format != header.format ) return false;
+	if ( h.fileSize != header.fileSize ) return false;
+	if ( h.modifyTime != header.modifyTime ) return false;
+	return indexSize == sizeof (PeakListIndexHeader) + h.numEntries * ( sizeof (PeakListIndexEntry) + NUM_ORDER_LISTS * sizeof (int) );
+}
+void PeakListIndex::write ( const string& peakList, int format, const PeakListIndexEntryVector& entries )
+{
+	string indexFile = getIndexFilename ( peakList );
+	string tempFile = indexFile + "." + gen_itoa ( getpid () ) + ".tmp";	// Another process may be creating the same index
+	ofstream ost ( tempFile.c_str (), ios_base::binary );
+	if ( !ost ) return;				// The peak list directory may not be writable
+	PeakListIndexHeader header;
+	initHeader ( header, peakList, format );
+	header.numEntries = entries.size ();
+	ost.write ( (char*) &header, sizeof (PeakListIndexHeader) );
+	if ( !entries.empty () ) {
+		ost.write ( (char*) &entries [0], entries.size () * sizeof (PeakListIndexEntry) );
+		IntVector order ( entries.size () );
+		for ( int i = 0 ; i < NUM_ORDER_LISTS ; i++ ) {
+			for ( IntVectorSizeType j = 0 ; j < order.size () ; j++ ) order [j] = j;
+			sort ( order.begin (), order.end (), SortPeakListIndexOrder ( entries, i ) );
+			ost.write ( (char*) &order [0], order.size () * sizeof (int) );
+		}
+	}
+	ost.close ();
+	if ( ost.fail () ) {
+		genUnlink ( tempFile );
+		return;
+	}
+	genRename ( tempFile, indexFile );
+}
+PeakListIndex* PeakListIndex::getIndex ( const string& peakList, int format )
+{
+	if ( !checkHeader ( peakList, format ) ) return 0;
+	return new PeakListIndex ( peakList );
+}
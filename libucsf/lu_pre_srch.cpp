@@ -21,6 +21,7 @@
 ******************************************************************************/
 #include <algorithm>
 #include <lgen_file.h>
+#include <lgen_mmap.h>
 #include <lgen_reg_exp.h>
 #include <lu_fas_ind.h>
 #include <lu_fas_sp.h>
@@ -44,17 +45,21 @@ using std::string;
 using std::ostream;
 using std::endl;
 using std::vector;
-using std::set_intersection;
-using std::set_difference;
+using std::lower_bound;
+using std::upper_bound;
 using std::sort;
 using std::stable_sort;
 using std::ios;
 using std::cout;
 using std::find;
-using std::back_inserter;
 using std::make_pair;
 using std::unique;
 
+struct IndexedDoubleNumberLessThan {
+	bool operator () ( const IndexedDouble& lhs, double rhs ) const { return lhs.number < rhs; }
+	bool operator () ( double lhs, const IndexedDouble& rhs ) const { return lhs < rhs.number; }
+};
+
 struct TaxonomyHit {
 	string scientificName;
 	int node;
@@ -170,7 +175,8 @@ class StandardPreSearch : public PreSearch {
 
 	static bool reportTaxonomy;
 
-	void floatingPointListSearch ( const string& filename, double low, double high, IntVector& serialNumber );
+	int floatingPointListSearch ( const string& filename, double low, double high, vector <bool>& selected ) const;
+	void getSelectedIndicies ( const vector <bool>& selected );
 	void name_regexp_pre_search ( FastaServer* fs, IntVector& indicies, const StringVector& names );
 	void outputHTMLSpeciesSearchResults ( ostream& os ) const;
 public:
@@ -589,43 +595,22 @@ void StandardPreSearch::doSearch ( FastaServer* fs )
 	ujm.writeMessage ( cout, "Doing Pre Search." );
 	numMWIndicies = numEntries;
 	numPIIndicies = numEntries;
-	IntVector fullIndicies;
-	IntVector mwIndicies;
-	IntVector pIIndicies;
-	IntVector mwPiIndicies;
-	IntVector& indiciesRef = fullIndicies;
-	if ( fullPIRange && fullMWRange ) {
-		fullIndicies.resize ( numEntries );
-		for ( int i = 0 ; i < numEntries ; i++ ) {
-			fullIndicies [i] = i + 1;
+	vector <bool> selected;		// Entries passing the MW and pI searches indexed by serial number. Empty if all entries pass.
+	if ( !fullMWRange ) {
+		ujm.writeMessage ( cout, "Doing Protein MW search." );
+		if ( fs->getDNADatabase () ) ErrorHandler::genError ()->error ( "The molecular weight pre-search option is not available for DNA databases.<br />" );
+		if ( highMass <= lowMass ) {
+			ErrorHandler::genError ()->error ( "The protein MW pre-search high mass is less than or equal to the low mass.<br />" );
 		}
-		indiciesRef = fullIndicies;
+		numMWIndicies = floatingPointListSearch ( SeqdbDir::instance ().getSeqdbDir () + filename + ".mw", lowMass, highMass, selected );
 	}
-	else {
-		if ( !fullMWRange ) {
-			ujm.writeMessage ( cout, "Doing Protein MW search." );
-			if ( fs->getDNADatabase () ) ErrorHandler::genError ()->error ( "The molecular weight pre-search option is not available for DNA databases.<br />" );
-			if ( highMass <= lowMass ) {
-				ErrorHandler::genError ()->error ( "The protein MW pre-search high mass is less than or equal to the low mass.<br />" );
-			}
-			floatingPointListSearch ( SeqdbDir::instance ().getSeqdbDir () + filename + ".mw", lowMass, highMass, mwIndicies );
-			numMWIndicies = mwIndicies.size ();
-			if ( fullPIRange ) indiciesRef = mwIndicies;
-		}
-		if ( !fullPIRange ) {
-			ujm.writeMessage ( cout, "Doing Protein pI search." );
-			if ( fs->getDNADatabase () ) ErrorHandler::genError ()->error ( "The pI pre-search option is not available for DNA databases.<br />" );
-			if ( highPI <= lowPI ) {
-				ErrorHandler::genError ()->error ( "The protein pI pre-search high pI is less than or equal to the low pI.<br />" );
-			}
-			floatingPointListSearch ( SeqdbDir::instance ().getSeqdbDir () + filename + ".pi", lowPI, highPI, pIIndicies );
-			numPIIndicies = pIIndicies.size ();
-			if ( fullMWRange ) indiciesRef = pIIndicies;
-		}
-		if ( !fullMWRange && !fullPIRange ) {
-			set_intersection ( mwIndicies.begin (), mwIndicies.end (), pIIndicies.begin (), pIIndicies.end (), back_inserter ( mwPiIndicies ) );
-			indiciesRef = mwPiIndicies;
+	if ( !fullPIRange ) {
+		ujm.writeMessage ( cout, "Doing Protein pI search." );
+		if ( fs->getDNADatabase () ) ErrorHandler::genError ()->error ( "The pI pre-search option is not available for DNA databases.<br />" );
+		if ( highPI <= lowPI ) {
+			ErrorHandler::genError ()->error ( "The protein pI pre-search high pI is less than or equal to the low pI.<br />" );
 		}
+		numPIIndicies = floatingPointListSearch ( SeqdbDir::instance ().getSeqdbDir () + filename + ".pi", lowPI, highPI, selected );
 	}
 	if ( !fullTaxonomyList.empty () ) {
 		ujm.writeMessage ( cout, "Doing Taxonomy search." );
@@ -650,13 +635,25 @@ void StandardPreSearch::doSearch ( FastaServer* fs )
 		}
 		const IntVector& taxonomyIndicies = taxSearch.getIndicies ();
 		numTaxIndicies = taxonomyIndicies.size ();
-		if ( speciesRemove )
-			set_difference ( indiciesRef.begin (), indiciesRef.end (), taxonomyIndicies.begin (), taxonomyIndicies.end (), back_inserter ( finalIndicies ) );
-		else
-			set_intersection ( indiciesRef.begin (), indiciesRef.end (), taxonomyIndicies.begin (), taxonomyIndicies.end (), back_inserter ( finalIndicies ) );
+		if ( speciesRemove ) {
+			if ( selected.empty () ) {
+				selected.assign ( numEntries + 1, true );
+				selected [0] = false;
+			}
+			for ( IntVectorSizeType j = 0 ; j < taxonomyIndicies.size () ; j++ ) {
+				selected [taxonomyIndicies [j]] = false;
+			}
+			getSelectedIndicies ( selected );
+		}
+		else {
+			for ( IntVectorSizeType j = 0 ; j < taxonomyIndicies.size () ; j++ ) {
+				int index = taxonomyIndicies [j];
+				if ( selected.empty () || selected [index] ) finalIndicies.push_back ( index );
+			}
+		}
 	}
 	else
-		finalIndicies = indiciesRef;
+		getSelectedIndicies ( selected );
 
 	numPreNameIndicies = finalIndicies.size ();
 	if ( names.size () ) {
@@ -674,20 +671,42 @@ void StandardPreSearch::doSearch ( FastaServer* fs )
 	}
 	ujm.deletePreviousMessage ( cout );
 }
-void StandardPreSearch::floatingPointListSearch ( const string& filename, double low, double high, IntVector& serialNumber )
-{
-	GenIFStream inFile ( filename, ios::binary );
-	for ( ; ; ) {
-		IndexedDouble id;
-		inFile.read ( (char*) &id, sizeof (IndexedDouble) );
-		if ( inFile.eof () ) break;
-		double number = id.number;
-		if ( number >= low ) {
-			if ( number > high ) break;
-			serialNumber.push_back ( id.index );
+/*
+The .mw and .pi files are sorted by value so the range is found by binary search. The entries in the
+range are combined with any previous selection.
+*/
+int StandardPreSearch::floatingPointListSearch ( const string& filename, double low, double high, vector <bool>& selected ) const
+{
+	GENINT64 numRecords = genFileSize ( filename ) / sizeof (IndexedDouble);
+	vector <bool> hit ( numEntries + 1, false );
+	int num = 0;
+	if ( numRecords ) {
+		MMapFile <IndexedDouble> mmf ( filename, 0, numRecords * sizeof (IndexedDouble) );	// Map the whole file
+		const IndexedDouble* first = mmf.getStartPointer ();
+		const IndexedDouble* last = first + numRecords;
+		const IndexedDouble* lo = lower_bound ( first, last, low, IndexedDoubleNumberLessThan () );
+		const IndexedDouble* hi = upper_bound ( lo, last, high, IndexedDoubleNumberLessThan () );
+		for ( const IndexedDouble* id = lo ; id != hi ; id++ ) {
+			hit [id->index] = selected.empty () || selected [id->index];
+		}
+		num = hi - lo;
+	}
+	selected.swap ( hit );
+	return num;
+}
+void StandardPreSearch::getSelectedIndicies ( const vector <bool>& selected )
+{
+	if ( selected.empty () ) {
+		finalIndicies.resize ( numEntries );
+		for ( int i = 0 ; i < numEntries ; i++ ) {
+			finalIndicies [i] = i + 1;
+		}
+	}
+	else {
+		for ( int i = 1 ; i <= numEntries ; i++ ) {
+			if ( selected [i] ) finalIndicies.push_back ( i );
 		}
 	}
-	sort ( serialNumber.begin (), serialNumber.end () );
 }
 void StandardPreSearch::name_regexp_pre_search ( FastaServer* fs, IntVector& indicies, const StringVector& names )
 {
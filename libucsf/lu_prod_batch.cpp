@@ -0,0 +1,125 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_prod_batch.cpp                                             *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Runs a batch of MS-Product searches within the calling        *
+*               program.                                                      *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#ifndef VIS_C
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include <sstream>
+#include <stdexcept>
+#include <lg_string.h>
+#include <lgen_thread.h>
+#include <lu_getfil.h>
+#include <lu_param_list.h>
+#include <lu_prog.h>
+#include <lu_prod_batch.h>
+#include <lu_prod_srch.h>
+#ifdef MYSQL_DATABASE
+#include <ld_init.h>
+#endif
+using std::string;
+using std::cout;
+using std::streambuf;
+using std::ostringstream;
+using std::runtime_error;
+
+MSProductBatch::MSProductBatch ()
+{
+}
+MSProductBatch& MSProductBatch::instance ()
+{
+	static MSProductBatch m;
+	return m;
+}
+void MSProductBatch::add ( const string& commandLineNVPairs )
+{
+	string queryString;								// The pairs are space separated with URL escaped values
+	StringVector sv = genGetSubstrings ( commandLineNVPairs, ' ' );
+	for ( StringVectorSizeType i = 0 ; i < sv.size () ; i++ ) {
+		if ( sv [i].empty () ) continue;
+		if ( !queryString.empty () ) queryString += "&";
+		queryString += sv [i];
+	}
+	queryStrings.push_back ( queryString );
+}
+void MSProductBatch::runSearch ( const string& queryString ) const
+{
+	ParameterList paramList ( queryString, false, false );
+	MSProgram::setParams ( &paramList );
+	ProgramLink::setParams ( &paramList );
+	ostringstream ost;
+	streambuf* coutBuf = cout.rdbuf ( ost.rdbuf () );	// The results go to a file
+	try {
+		MSProductParameters params ( &paramList );
+		MSProductSearch ps ( params );
+		ps.outputResults ( false );
+	}
+	catch ( runtime_error e ) {}					// A failed search doesn't stop the rest of the batch
+	cout.rdbuf ( coutBuf );
+}
+void MSProductBatch::runSearches ( int first, int increment ) const
+{
+	for ( StringVectorSizeType i = first ; i < queryStrings.size () ; i += increment ) {
+		runSearch ( queryStrings [i] );
+	}
+}
+void MSProductBatch::run ()
+{
+	if ( queryStrings.empty () ) return;
+	const ParameterList* programLinkParams = ProgramLink::getParams ();
+	const ParameterList* msProgramParams = MSProgram::getParams ();
+	int numProcesses = InfoParams::instance ().getIntValue ( "msproduct_num_processes", 1 );
+	if ( numProcesses <= 0 ) numProcesses = genGetNumProcessors ();
+	numProcesses = genMin ( numProcesses, static_cast <int> (queryStrings.size ()) );
+#ifndef VIS_C
+	if ( numProcesses > 1 ) {
+		cout.flush ();								// Otherwise the child processes would also write the buffered output
+#ifdef MYSQL_DATABASE
+		MySQLPPSDDBase::instance ( false, true );	// The connection can't be shared. Each process opens its own.
+#endif
+		IntVector pids;
+		for ( int i = 0 ; i < numProcesses ; i++ ) {
+			pid_t pid = fork ();
+			if ( pid == 0 ) {
+				runSearches ( i, numProcesses );
+#ifdef MYSQL_DATABASE
+				MySQLPPSDDBase::instance ( false, true );
+#endif
+				_exit ( 0 );
+			}
+			else if ( pid == -1 ) runSearches ( i, numProcesses );	// Fork failed
+			else pids.push_back ( pid );
+		}
+		for ( IntVectorSizeType j = 0 ; j < pids.size () ; j++ ) {
+			int status;
+			waitpid ( pids [j], &status, 0 );
+		}
+	}
+	else runSearches ( 0, 1 );
+#else
+	runSearches ( 0, 1 );
+#endif
+	queryStrings.clear ();
+	ProgramLink::setParams ( programLinkParams );
+	MSProgram::setParams ( msProgramParams );
+}
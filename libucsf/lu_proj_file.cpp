@@ -286,6 +286,7 @@ StringVector ProjectFile::getRawTypes ( const ParameterList* params )
 		if ( !r.empty () ) {
 			if ( isFileType ( r, WIFF ) )		sv.push_back ( WIFF );
 			else if ( isFileType ( r, RAW ) )	sv.push_back ( RAW );
+			else if ( isFileType ( r, MZML ) )	sv.push_back ( MZML );
 			else								sv.push_back ( T2D );
 		}
 		else sv.push_back ( "" );
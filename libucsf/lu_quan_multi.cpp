@@ -152,14 +152,15 @@ DoubleVectorVector QuanMSMSXMLData::getFormulaPurityCoefficients ( const string&
 	for ( int i = 0 ; i < f.size () ; i++ ) {
 		DoubleVector dv;
 		if ( f [i] != "" ) {
-			IsotopePeakStats ips ( f [i], 1 );
-			int index = ips.getProbabilityIndexForMass ( m [i] );
-			if ( index >= 2 ) dv.push_back ( ips.getProbability ( index - 2 ) );
+			const IsotopePeakStats* ips = IsotopePeakStatsCache::getIsotopePeakStats ( f [i], 1 );
+			int index = ips->getProbabilityIndexForMass ( m [i] );
+			if ( index >= 2 ) dv.push_back ( ips->getProbability ( index - 2 ) );
 			else dv.push_back ( 0.0 );
-			if ( index >= 1 ) dv.push_back ( ips.getProbability ( index - 1 ) );
+			if ( index >= 1 ) dv.push_back ( ips->getProbability ( index - 1 ) );
 			else dv.push_back ( 0.0 );
-			dv.push_back ( ips.getProbability ( index + 1 ) );
-			dv.push_back ( ips.getProbability ( index + 2 ) );
+			dv.push_back ( ips->getProbability ( index + 1 ) );
+			dv.push_back ( ips->getProbability ( index + 2 ) );
+			IsotopePeakStatsCache::release ( ips );
 		}
 		else {									// No formulae so assume no correction
 			for ( int j = 0 ; j < 4 ; j++ ) {
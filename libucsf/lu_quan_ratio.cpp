@@ -76,15 +76,16 @@ CosSimilarity::CosSimilarity ( const string& formulaString, int charge, const Do
 	cosSimilarityIntensity ( -100.0 ),
 	cosSimilarityArea ( -100.0 )
 {
-	IsotopePeakStats id ( formulaString, charge );
-	int np = id.getNumPeaks ();
-	int ind1 = id.getProbabilityIndexForIdealMonoisotopicMZ ();
+	const IsotopePeakStats* id = IsotopePeakStatsCache::getIsotopePeakStats ( formulaString, charge );
+	int np = id->getNumPeaks ();
+	int ind1 = id->getProbabilityIndexForIdealMonoisotopicMZ ();
 	int distSize = genMax ( intensity.size (), area.size () );
 	DoubleVector dv;
 	for ( int i = ind1 ; i < np ; i++ ) {
-		dv.push_back ( id.getProbability ( i ) );
+		dv.push_back ( id->getProbability ( i ) );
 		if ( dv.size () == distSize ) break;
 	}
+	IsotopePeakStatsCache::release ( id );
 	if ( dv.size () > 1 ) {
 		if ( intensity.size () > 1 )	cosSimilarityIntensity = cosSimilarity ( intensity, dv );
 		if ( area.size () > 1 )			cosSimilarityArea = cosSimilarity ( area, dv );
@@ -158,12 +159,12 @@ class MSPurityCorrection {
 	double** a;
 	double** b;
 public:
-	MSPurityCorrection ( const vector <IsotopePeakStats*>& ips, int offset );
+	MSPurityCorrection ( const vector <const IsotopePeakStats*>& ips, int offset );
 	~MSPurityCorrection ();
 	void loadA () const;
 	void correction ( DoubleVector& dv ) const;
 };
-MSPurityCorrection::MSPurityCorrection ( const vector <IsotopePeakStats*>& ips, int offset ) :
+MSPurityCorrection::MSPurityCorrection ( const vector <const IsotopePeakStats*>& ips, int offset ) :
 	numQuanPeaks ( ips.size () ),
 	matrix ( numQuanPeaks )
 {
@@ -330,16 +331,16 @@ void QuantitationRatio::init2 ( const DoubleVectorVectorVector& coeff, Elemental
 	}
 	DoubleVectorVector dvvIntensity;
 	DoubleVectorVector dvvArea;
-	vector <IsotopePeakStats*> vips;
+	vector <const IsotopePeakStats*> vips;
 	if ( o18Flag ) {
-		vips.push_back ( new IsotopePeakStats ( formulae [0], charge, 0.0001 ) );	// A lower probability limit has been used for increased
+		vips.push_back ( IsotopePeakStatsCache::getIsotopePeakStats ( formulae [0].getFormula (), charge, 0.0001 ) );	// A lower probability limit has been used for increased
 																					// speed. The only effect is likely to be with very high ratios.
 	}
 	else {		// Correct intensities for purity
 		dvvIntensity = intensity1;
 		dvvArea = area1;
 		for ( int i = 0 ; i < numQuanStates ; i++ ) {
-			vips.push_back ( new IsotopePeakStats ( formulae [i], charge, 0.0001 ) );
+			vips.push_back ( IsotopePeakStatsCache::getIsotopePeakStats ( formulae [i].getFormula (), charge, 0.0001 ) );
 		}
 		for ( int j = 0 ; j < numPeaks ; j++ ) {
 			DoubleVector dvIntensity (numQuanStates);
@@ -374,7 +375,7 @@ void QuantitationRatio::init2 ( const DoubleVectorVectorVector& coeff, Elemental
 				double measuredLightHeavyRatioInt;
 				double measuredLightHeavyRatioArea;
 				if ( o18Flag ) {
-					IsotopePeakStats* ipsLight = vips [0];
+					const IsotopePeakStats* ipsLight = vips [0];
 					double m4overm0 = ipsLight->getProbability ( m + 4 ) / ipsLight->getProbability ( m );	// Eqn. 1 from Zang et al 2004, J. Proteome Research Vol. 3, No. 3, pp 604-612
 					double m2overm0 = ipsLight->getProbability ( m + 2 ) / ipsLight->getProbability ( m );
 					double oneMinusm2overm0 = 1.0 - m2overm0;
@@ -405,7 +406,7 @@ void QuantitationRatio::init2 ( const DoubleVectorVectorVector& coeff, Elemental
 		}
 	}
 	for ( int x = 0 ; x < vips.size () ; x++ ) {
-		delete vips [x];
+		IsotopePeakStatsCache::release ( vips [x] );
 	}
 	if ( reportPeakIntensity )	intensity = intensity1;
 	if ( reportPeakSNR )		snr = snr1;
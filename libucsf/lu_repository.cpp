@@ -30,6 +30,7 @@
 #include <lg_time.h>
 #include <lgen_error.h>
 #include <lgen_file.h>
+#include <lgen_uncompress.h>
 #include <lu_getfil.h>
 #include <lu_repository.h>
 #include <lu_spec_id.h>
@@ -56,6 +57,26 @@ string getFractionName ( const string& fName, const string& type )
 {
 	return fName.substr ( 0, fName.length () - ( type.length () + 1 ));
 }
+bool compressedFileHasCR ( const string& fullPath )
+{
+	GenZIFStream ist ( fullPath );
+	for ( int i = 0 ; i < 256 ; i++ ) {
+		int c = ist.get ();
+		if ( c == EOF ) break;
+		if ( c == '\r' ) return true;
+	}
+	return false;
+}
+// Compressed peak lists are read directly unless they have to be rewritten. In this case they are expanded first.
+void expandCompressedFile ( string& fullPath, string& f )
+{
+	ErrorHandler::genError ()->message ( "Uncompressing file " + f + ".\n" );
+	string newPath = getUncompressedFilename ( fullPath );
+	genUncompressFile ( fullPath, newPath );
+	genUnlink ( fullPath );
+	fullPath = newPath;
+	f = getUncompressedFilename ( f );
+}
 }
 
 Repository::Repository ( const string& baseDir, const string& searchName ) :
@@ -519,23 +540,29 @@ bool PPProject::parseFile ( const string& fullPath, const string& f )
 		return parseCentroidFile ( fullPath, f );
 	return true;
 }
-bool PPProject::parseCentroidFile ( const string& fullPath, const string& f )
+bool PPProject::parseCentroidFile ( const string& path, const string& name )
 {
-	bool mgfFlag = isFileType ( f, MGF );
-	bool dtaFlag = isFileType ( f, DTA );
-	bool pklFlag = isFileType ( f, PKL );
-	bool ms2Flag = isFileType ( f, MS2 );
-	bool aplFlag = isFileType ( f, APL );
+	string fullPath = path;
+	string f = name;
+	string uncompressedF = getUncompressedFilename ( f );	// gzip and zip files are read through GenZIFStream
+	bool mgfFlag = isFileType ( uncompressedF, MGF );
+	bool dtaFlag = isFileType ( uncompressedF, DTA );
+	bool pklFlag = isFileType ( uncompressedF, PKL );
+	bool ms2Flag = isFileType ( uncompressedF, MS2 );
+	bool aplFlag = isFileType ( uncompressedF, APL );
+	if ( ( dtaFlag || pklFlag ) && f != uncompressedF ) expandCompressedFile ( fullPath, f );	// These are converted to mgf files
 #ifndef VIS_C
 	// All currently supported centroid files are text files. On a UNIX platform we need to check
 	// for dos or mac text files and do the necessary conversion.
 	if ( upload ) {
-		convertToUnixTextWithMessage ( fullPath );
+		if ( f != uncompressedF && compressedFileHasCR ( fullPath ) ) expandCompressedFile ( fullPath, f );
+		if ( f == uncompressedF ) convertToUnixTextWithMessage ( fullPath );
 	}
 #endif
 	if ( mgfFlag ) {
 		if ( isMGFFile2 ( fullPath ) ) {
 			if ( mgfFileHasZeros ( fullPath ) ) {
+				if ( f != uncompressedF ) expandCompressedFile ( fullPath, f );
 				removeMGFZeroIntensities ( fullPath );
 			}
 			mgfs.push_back ( f );
@@ -837,7 +864,7 @@ bool PPProject::parseAPLs ( const string& uploadName )
 }
 void PPProject::parseAPLFile ( const string& uploadName, const string& f )
 {
-	GenIFStream ifs ( uploadName + SLASH + f );
+	GenZIFStream ifs ( uploadName + SLASH + f );
 	for ( ; ; ) {
 		string line;
 		double mz;
@@ -1188,7 +1215,7 @@ bool PPProject::parseCentroidFiles ( const StringVector& files )
 	int num = files.size ();
 	if ( num != nFiles ) return false;
 	for ( int i = 0 ; i < num ; i++ ) {
-		fractionNames.push_back ( genShortFilenameFromPath ( files [i] ) );
+		fractionNames.push_back ( genShortFilenameFromPath ( getUncompressedFilename ( files [i] ) ) );
 		centroidFiles.push_back ( files [i] );
 	}
 	return true;
@@ -1257,6 +1284,7 @@ bool PPProject::createFractionFiles () // repository
 			if ( genIsDirectory ( dir + SLASH + f ) ) fFrac = f;
 			else if ( isFileType ( f, WIFF ) ) fFrac = getFractionName ( f, WIFF );
 			else if ( isFileType ( f, RAW ) ) fFrac = getFractionName ( f, RAW );
+			else if ( isFileType ( f, MZML ) ) fFrac = getFractionName ( f, MZML );
 			if ( frac == fFrac ) {
 				rawPath = genDirectoryFromPath ( rPath ) + "/" + f;
 				break;
@@ -0,0 +1,198 @@
+/******************************************************************************
+*                                                                             *
+*  Library    : libucsf                                                       *
+*                                                                             *
+*  Filename   : lu_seq_pack.cpp                                               *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Residue packed copy of the database sequences.                *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#ifndef VIS_C
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#ifdef VIS_C
+#include <process.h>
+#endif
+#include <cstring>
+#include <lg_io.h>
+#include <lg_string.h>
+#include <lgen_file.h>
+#include <lgen_mmap.h>
+#include <lu_check_db.h>
+#include <lu_fasta.h>
+#include <lu_getfil.h>
+#include <lu_seq_pack.h>
+using std::string;
+using std::ios_base;
+
+namespace {
+const char DECODE [32] = {
+	0,
+	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+	'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+	'.', '*', '-', 0, 0
+};
+const int HEADER_RECORDS = sizeof (PackedSequenceHeader) / sizeof (PackedSequenceEntry);	// The header occupies this many entry records in the .psi file
+}
+
+const char* PackedSequenceStore::MAGIC = "PPSEQPAK";
+const int PackedSequenceStore::VERSION = 1;
+const int PackedSequenceStore::RESIDUES_PER_WORD = 12;
+
+PackedSequenceStore::PackedSequenceStore ( const string& database ) :
+	entries ( 0 ),
+	words ( 0 ),
+	numFrames ( 1 )
+{
+	string baseName = getBaseName ( database );
+	PackedSequenceHeader h;
+	GenIFStream ist ( baseName + ".psi", ios_base::binary );
+	ist.read ( (char*) &h, sizeof (PackedSequenceHeader) );
+	ist.close ();
+	numFrames = h.numFrames;
+	entries = new MMapFile <PackedSequenceEntry> ( baseName + ".psi" );
+	if ( h.numWords ) words = new MMapFile <GENUINT64> ( baseName + ".psq" );
+}
+PackedSequenceStore::~PackedSequenceStore ()
+{
+	delete entries;
+	delete words;
+}
+int PackedSequenceStore::getSequence ( int serialNumber, int frame, char* protein, int maxLength ) const
+{
+	if ( numFrames == 1 ) frame = 1;
+	const PackedSequenceEntry& e = entries->subscript ( HEADER_RECORDS + static_cast <GENINT64> ( serialNumber - 1 ) * numFrames + frame - 1 );
+	int length = e.length;
+	if ( maxLength && maxLength < length ) length = maxLength;
+	if ( length ) {
+		GENINT64 numWords = ( length + RESIDUES_PER_WORD - 1 ) / RESIDUES_PER_WORD;
+		const GENUINT64* w = words->getRange ( e.offset, e.offset + numWords - 1 );
+		char* p = protein;
+		char* end = protein + length;
+		for ( ; p + RESIDUES_PER_WORD <= end ; w++ ) {		// Whole words
+			GENUINT64 x = *w;
+			for ( int i = 0 ; i < RESIDUES_PER_WORD ; i++, x >>= 5 ) {
+				*p++ = DECODE [x & 31];
+			}
+		}
+		if ( p != end ) {									// Last partial word
+			for ( GENUINT64 x = *w ; p != end ; x >>= 5 ) {
+				*p++ = DECODE [x & 31];
+			}
+		}
+	}
+	protein [length] = 0;
+	return length;
+}
+int PackedSequenceStore::getCode ( char aa )
+{
+	for ( int i = 1 ; i < 32 ; i++ ) {
+		if ( DECODE [i] == aa ) return i;
+	}
+	return 0;
+}
+string PackedSequenceStore::getBaseName ( const string& database )
+{
+	return SeqdbDir::instance ().getSeqdbDir () + database;
+}
+void PackedSequenceStore::initHeader ( PackedSequenceHeader& header, const string& database )
+{
+	memset ( &header, 0, sizeof (PackedSequenceHeader) );
+	memcpy ( header.magic, MAGIC, sizeof (header.magic) );
+	header.version = VERSION;
+	string path = SeqdbDir::instance ().getDatabasePath ( database );
+	header.databaseSize = genFileSize ( path );
+	header.databaseTime = genLastModifyTime ( path );
+}
+bool PackedSequenceStore::checkHeader ( const string& database, int numEntries )
+{
+	string baseName = getBaseName ( database );
+	string indexFile = baseName + ".psi";
+	if ( !genFileExists ( indexFile ) || !genFileExists ( baseName + ".psq" ) ) return false;
+	if ( genFileSize ( indexFile ) < sizeof (PackedSequenceHeader) ) return false;
+	PackedSequenceHeader header;
+	initHeader ( header, database );
+	PackedSequenceHeader h;
+	GenIFStream ist ( indexFile, ios_base::binary );
+	ist.read ( (char*) &h, sizeof (PackedSequenceHeader) );
+	if ( ist.fail () ) return false;
+	if ( memcmp ( h.magic, header.magic, sizeof (h.magic) ) ) return false;
+	if ( h.version != header.version ) return false;
+	if ( h.numEntries != numEntries ) return false;
+	if ( h.databaseSize != header.databaseSize ) return false;
+	if ( h.databaseTime != header.databaseTime ) return false;
+	if ( genFileSize ( baseName + ".psq" ) != h.numWords * sizeof (GENUINT64) ) return false;
+	return genFileSize ( indexFile ) == sizeof (PackedSequenceHeader) + h.numEntries * h.numFrames * sizeof (PackedSequenceEntry);
+}
+void PackedSequenceStore::create ( FastaServer* fs )
+{
+	string database = fs->getFileName ();
+	if ( is_pdna_format_database ( database ) ) return;
+	ErrorHandler::genError ()->message ( "Creating packed sequence files (.psi and .psq).\n" );
+	string baseName = getBaseName ( database );
+	string tempSuffix = "." + gen_itoa ( getpid () ) + ".tmp";
+	PackedSequenceHeader header;
+	initHeader ( header, database );
+	header.numFrames = fs->getDNADatabase () ? 6 : 1;
+	header.numEntries = fs->getNumEntries ();
+	GenOFStream ostIdx ( baseName + ".psi" + tempSuffix, ios_base::binary );
+	GenOFStream ostSeq ( baseName + ".psq" + tempSuffix, ios_base::binary );
+	ostIdx.write ( (char*) &header, sizeof (PackedSequenceHeader) );	// Rewritten when the number of words is known
+	bool valid = true;
+	for ( int n = 1 ; n <= header.numEntries && valid ; n++ ) {
+		for ( int f = 1 ; f <= header.numFrames ; f++ ) {
+			const char* protein = fs->get_fasta_protein ( n, f );
+			PackedSequenceEntry pse;
+			memset ( &pse, 0, sizeof (PackedSequenceEntry) );
+			pse.offset = header.numWords;
+			pse.length = strlen ( protein );
+			for ( int i = 0 ; i < pse.length ; i += RESIDUES_PER_WORD ) {
+				GENUINT64 x = 0;
+				for ( int j = genMin ( pse.length - i, RESIDUES_PER_WORD ) ; j-- ; ) {
+					int code = getCode ( protein [i+j] );
+					if ( code == 0 ) {
+						ErrorHandler::genError ()->message ( string ( "Entry " ) + gen_itoa ( n ) + " contains the character '" + protein [i+j] + "' which can't be packed. The packed sequence files have not been created.\n" );
+						valid = false;
+						break;
+					}
+					x = ( x << 5 ) | code;
+				}
+				if ( !valid ) break;
+				ostSeq.write ( (char*) &x, sizeof (GENUINT64) );
+				header.numWords++;
+			}
+			if ( !valid ) break;
+			ostIdx.write ( (char*) &pse, sizeof (PackedSequenceEntry) );
+		}
+	}
+	ostSeq.close ();
+	ostIdx.seekp ( 0 );
+	ostIdx.write ( (char*) &header, sizeof (PackedSequenceHeader) );
+	ostIdx.close ();
+	if ( valid ) {
+		genRename ( baseName + ".psq" + tempSuffix, baseName + ".psq" );
+		genRename ( baseName + ".psi" + tempSuffix, baseName + ".psi" );		// The index is renamed last as it marks the store as complete
+	}
+	else {
+		genUnlink ( baseName + ".psq" + tempSuffix );
+		genUnlink ( baseName + ".psi" + tempSuffix );
+	}
+}
+PackedSequenceStore* PackedSequenceStore::getStore ( const string& database, int numEntries )
+{
+	if ( !checkHeader ( database, numEntries ) ) return 0;
+	return new PackedSequenceStore ( database );
+}
@@ -23,6 +23,7 @@
 #include <lg_string.h>
 #include <lu_get_link.h>
 #include <lu_mass_conv.h>
+#include <lu_frag_simd.h>
 #include <lu_tag_frag.h>
 #include <lu_tag_par.h>
 #include <lu_immonium.h>
@@ -1315,6 +1316,29 @@ MSTagSearch::MSTagSearch ( MSMSDataPoint* file, MSTagParameters& params ) :
 MSTagSearch::~MSTagSearch ()
 {
 }
+void MSTagSearch::merge ( const MSMSSearch* rhs )	// Combines the results of a search over a different part of the database
+{
+	const MSTagSearch* ts = static_cast <const MSTagSearch*> (rhs);
+	if ( !survHist.merge ( ts->survHist ) || !ts->spectrumRetained ) spectrumRetained = false;
+}
+bool MSTagSearch::getFragmentIndexTags ( MassTypeVector& nTag, MassTypeVector& nTol, MassTypeVector& cTag, MassTypeVector& cTol ) const
+{
+	// The backbone ion types used by the fragment ion index to preselect the spectra to score
+	for ( int i = 0 ; i < numPeaks ; i++ ) {
+		MassType tol = fragTolerance [i];
+		MassType tol2 = tol + tol;
+		if ( b_flag )								{ nTag.push_back ( nIonFragTag [i][b_index] );		nTol.push_back ( tol ); }
+		if ( c_flag )								{ nTag.push_back ( nIonFragTag [i][c_index] );		nTol.push_back ( tol ); }
+		if ( doublyChargedIons && bp2_flag )		{ nTag.push_back ( nIonFragTag [i][bp2_index] );	nTol.push_back ( tol2 ); }
+		if ( doublyChargedIons && cp2_flag )		{ nTag.push_back ( nIonFragTag [i][cp2_index] );	nTol.push_back ( tol2 ); }
+		if ( y_flag )								{ cTag.push_back ( cIonFragTag [i][y_index] );		cTol.push_back ( tol ); }
+		if ( z_flag )								{ cTag.push_back ( cIonFragTag [i][z_index] );		cTol.push_back ( tol ); }
+		if ( zPlus1DaFlag )							{ cTag.push_back ( cIonFragTag [i][zPlus1DaIndex] );cTol.push_back ( tol ); }
+		if ( doublyChargedIons && yp2_flag )		{ cTag.push_back ( cIonFragTag [i][yp2_index] );	cTol.push_back ( tol2 ); }
+		if ( doublyChargedIons && zp2_flag )		{ cTag.push_back ( cIonFragTag [i][zp2_index] );	cTol.push_back ( tol2 ); }
+	}
+	return !nTag.empty () || !cTag.empty ();
+}
 size_t MSTagSearch::getHistogramLimit ( const MSTagParameters& params )
 {
 	size_t val;
@@ -1697,6 +1721,47 @@ void MSTagSearch::initFragTags ()
 		minCFragTagInData = ( i == 0 ) ? minCFragTag [0] : genMin ( minCFragTagInData, minCFragTag [i] );
 	}
 	ionMatched.resize ( numPeaks );
+	initFragTagsSoA ();
+}
+void MSTagSearch::initFragTagsSoA ()
+{
+	tagStride = numPeaks + FRAG_SIMD_PADDING;		// The vector code reads past the last peak
+	nIonTagSoA.assign ( numNIonTypes * tagStride, 0 );
+	cIonTagSoA.assign ( numCIonTypes * tagStride, 0 );
+	fragToleranceSoA.assign ( 3 * tagStride, 0 );
+	maxNFragTagSoA.assign ( tagStride, 0 );
+	maxCFragTagSoA.assign ( tagStride, 0 );
+	for ( int i = 0 ; i < numPeaks ; i++ ) {
+		int j;
+		for ( j = 0 ; j < numNIonTypes ; j++ ) nIonTagSoA [j*tagStride+i] = nIonFragTag [i][j];
+		for ( j = 0 ; j < numCIonTypes ; j++ ) cIonTagSoA [j*tagStride+i] = cIonFragTag [i][j];
+		MassType fragTol = fragTolerance [i];
+		MassType fragTol2 = fragTol + fragTol;
+		fragToleranceSoA [i] = fragTol;
+		fragToleranceSoA [tagStride+i] = fragTol2;
+		fragToleranceSoA [2*tagStride+i] = fragTol2 + fragTol;
+		maxNFragTagSoA [i] = maxNFragTag [i];
+		maxCFragTagSoA [i] = maxCFragTag [i];
+	}
+}
+void MSTagSearch::matchIonTests ( MassType ion, int& start, const MassTypeVector& minTag, const MassTypeVector& maxTagSoA, const IonMatchTest* tests, int numTests )
+{
+	// Equivalent to testing each peak in the window against the tests in order and stopping at the first match
+	int end = start;
+	while ( end < numPeaks && ion >= minTag [end] ) end++;
+	for ( int s = start ; s < end ; s += FRAG_SIMD_BLOCK_SIZE ) {
+		int n = genMin ( end - s, FRAG_SIMD_BLOCK_SIZE );
+		unsigned int outOfRange = fragGreaterMask ( ion, &maxTagSoA [s], n );
+		start += fragMaskCount ( outOfRange );
+		unsigned int unmatched = ~outOfRange & fragMaskLowBits ( n );
+		for ( int t = 0 ; t < numTests && unmatched ; t++ ) {
+			unsigned int hits = fragMatchMask ( ion, tests [t].tag + s, tests [t].tol + s, n ) & unmatched;
+			unmatched &= ~hits;
+			for ( int i = s ; hits ; hits >>= 1, i++ ) {
+				if ( hits & 1 ) ionMatched [i] = genMax ( tests [t].score, ionMatched [i] );
+			}
+		}
+	}
 }
 bool MSTagSearch::doMatch ( const string& peptide, bool nTermPeptide, bool cTermPeptide, double mol_wt, TagMatchVector& tagMatch, const ScoreType& minScore )
 {
@@ -1716,6 +1781,15 @@ bool MSTagSearch::doMatch ( const string& peptide, bool nTermPeptide, bool cTerm
 	}
 	return false;
 }
+void MSTagSearch::addUnscoredMatch ( const string& peptide )	// Counts a peptide rejected by the fragment ion index without scoring it
+{
+	if ( compositionSearch && compositionSearch->doCompositionSearch ( peptide ) == false );
+	else {
+		if ( !survHist.addValue ( 0.0 ) ) {
+			spectrumRetained = false;
+		}
+	}
+}
 void MSTagSearchAllowErrors::resetNextMods ()
 {
 	if ( modificationTable ) modificationTable->resetNextMods ();
@@ -2213,55 +2287,26 @@ void MSTagSearch::doNIonsESI_TRAP_CID_low_res ( const string& sequence )
 		if ( checkNIonM )					nIonM |= oxidizedMFlag [aa];
 		if ( checkNIonPhosphorylation )		nIonPhosphorylation |= phosphorylationFlag [aa];
 		if ( nIon < minNFragTagInData || k == 0 ) continue;
-		for ( int i = start ; i < numPeaks ; i++ ) {
-			if ( nIon < minNFragTag [i] ) break;
-			if ( nIon > maxNFragTag [i] ) {
-				start++;
-				continue;
-			}
-			MassTypeVector& fragTag = nIonFragTag [i];
-			ScoreType& matched = ionMatched [i];
-			MassType fragTol = fragTolerance [i];
-			MassType fragTol2 = fragTol + fragTol;
-			if ( genAbsDiff ( nIon, fragTag [b_index] ) < fragTol ) {
-				matched = genMax ( b_score, matched );
-			}
-			else if ( doublyChargedIons && nIonPosChargeBearing && genAbsDiff ( nIon, fragTag [bp2_index] ) < fragTol2 ) {
-				matched = genMax ( bp2_score, matched );
-			}
-			else if ( triplyChargedIons && nIonPosChargeBearing > 1 ) {
-				if ( genAbsDiff ( nIon, fragTag [bp3_index] ) < fragTol2 + fragTol ) {
-					matched = genMax ( bp3_score, matched );
-				}
-			}
-			else if ( genAbsDiff ( nIon, fragTag [a_index] ) < fragTol ) {
-				matched = genMax ( a_score, matched );
-			}
-			else if ( nIonAmmoniaLoss && genAbsDiff ( nIon, fragTag [b_nh3_index] ) < fragTol ) {
-				matched = genMax ( b_nh3_score, matched );
-			}
-			else if ( doublyChargedIons && nIonAmmoniaLoss && nIonPosChargeBearing && genAbsDiff ( nIon, fragTag [bp2_nh3_index] ) < fragTol2 ) {
-				matched = genMax ( bp2_nh3_score, matched );
-			}
-			else if ( nIonWaterLoss && genAbsDiff ( nIon, fragTag [b_h2o_index] ) < fragTol ) {
-				matched = genMax ( b_h2o_score, matched );
-			}
-			else if ( doublyChargedIons && nIonWaterLoss && nIonPosChargeBearing && genAbsDiff ( nIon, fragTag [bp2_h2o_index] ) < fragTol2 ) {
-				matched = genMax ( bp2_h2o_score, matched );
-			}
-			else if ( nIonM && genAbsDiff ( nIon, fragTag [b_soch4_index] ) < fragTol ) {
-				matched = genMax ( b_soch4_score, matched );
-			}
-			else if ( doublyChargedIons && nIonM && nIonPosChargeBearing && genAbsDiff ( nIon, fragTag [bp2_soch4_index] ) < fragTol2 ) {
-				matched = genMax ( bp2_soch4_score, matched );
-			}
-			else if ( nIonPhosphorylation && genAbsDiff ( nIon, fragTag [b_h3po4_index] ) < fragTol ) {
-				matched = genMax ( b_h3po4_score, matched );
-			}
-			else if ( doublyChargedIons && nIonPhosphorylation && nIonPosChargeBearing && genAbsDiff ( nIon, fragTag [bp2_h3po4_index] ) < fragTol2 ) {
-				matched = genMax ( bp2_h3po4_score, matched );
-			}
+		IonMatchTest tests [12];
+		int n = 0;
+		bool p2 = doublyChargedIons && nIonPosChargeBearing;
+		addIonMatchTest ( tests, n, getNTag ( b_index ), getFragTol ( 1 ), b_score );
+		if ( p2 ) addIonMatchTest ( tests, n, getNTag ( bp2_index ), getFragTol ( 2 ), bp2_score );
+		if ( triplyChargedIons && nIonPosChargeBearing > 1 ) {
+			addIonMatchTest ( tests, n, getNTag ( bp3_index ), getFragTol ( 3 ), bp3_score );	// No further ion types are tried in this case
 		}
+		else {
+			addIonMatchTest ( tests, n, getNTag ( a_index ), getFragTol ( 1 ), a_score );
+			if ( nIonAmmoniaLoss )			addIonMatchTest ( tests, n, getNTag ( b_nh3_index ), getFragTol ( 1 ), b_nh3_score );
+			if ( p2 && nIonAmmoniaLoss )	addIonMatchTest ( tests, n, getNTag ( bp2_nh3_index ), getFragTol ( 2 ), bp2_nh3_score );
+			if ( nIonWaterLoss )			addIonMatchTest ( tests, n, getNTag ( b_h2o_index ), getFragTol ( 1 ), b_h2o_score );
+			if ( p2 && nIonWaterLoss )		addIonMatchTest ( tests, n, getNTag ( bp2_h2o_index ), getFragTol ( 2 ), bp2_h2o_score );
+			if ( nIonM )					addIonMatchTest ( tests, n, getNTag ( b_soch4_index ), getFragTol ( 1 ), b_soch4_score );
+			if ( p2 && nIonM )				addIonMatchTest ( tests, n, getNTag ( bp2_soch4_index ), getFragTol ( 2 ), bp2_soch4_score );
+			if ( nIonPhosphorylation )		addIonMatchTest ( tests, n, getNTag ( b_h3po4_index ), getFragTol ( 1 ), b_h3po4_score );
+			if ( p2 && nIonPhosphorylation )addIonMatchTest ( tests, n, getNTag ( bp2_h3po4_index ), getFragTol ( 2 ), bp2_h3po4_score );
+		}
+		matchIonTests ( nIon, start, minNFragTag, maxNFragTagSoA, tests, n );
 	}
 }
 void MSTagSearch::doNIonsESI_Q_CID ( const string& sequence )
@@ -2344,46 +2389,20 @@ void MSTagSearch::doNIonsESI_Q_CID ( const string& sequence )
 		if ( checkNIonM )					nIonM |= oxidizedMFlag [aa];
 		if ( checkNIonPhosphorylation )		nIonPhosphorylation |= phosphorylationFlag [aa];
 		if ( nIon < minNFragTagInData || k == 0 ) continue;
-		for ( int i = start ; i < numPeaks ; i++ ) {
-			if ( nIon < minNFragTag [i] ) break;
-			if ( nIon > maxNFragTag [i] ) {
-				start++;
-				continue;
-			}
-			MassTypeVector& fragTag = nIonFragTag [i];
-			ScoreType& matched = ionMatched [i];
-			MassType fragTol = fragTolerance [i];
-			if ( genAbsDiff ( nIon, fragTag [b_index] ) < fragTol ) {
-				matched = genMax ( b_score, matched );
-			}
-			else if ( genAbsDiff ( nIon, fragTag [a_index] ) < fragTol ) {
-				matched = genMax ( a_score, matched );
-			}
-			else if ( nIonAmmoniaLoss && genAbsDiff ( nIon, fragTag [a_nh3_index] ) < fragTol ) {
-				matched = genMax ( a_nh3_score, matched );
-			}
-			else if ( nIonWaterLoss && genAbsDiff ( nIon, fragTag [a_h2o_index] ) < fragTol ) {
-				matched = genMax ( a_h2o_score, matched );
-			}
-			else if ( nIonAmmoniaLoss && genAbsDiff ( nIon, fragTag [b_nh3_index] ) < fragTol ) {
-				matched = genMax ( b_nh3_score, matched );
-			}
-			else if ( nIonWaterLoss && genAbsDiff ( nIon, fragTag [b_h2o_index] ) < fragTol ) {
-				matched = genMax ( b_h2o_score, matched );
-			}
-			else if ( k >= len - 3 && nIonPosChargeBearing && genAbsDiff ( nIon, fragTag [b_plus_h2o_index] ) < fragTol ) {
-				matched = genMax ( b_plus_h2o_score, matched );
-			}
-			else if ( nIonM && genAbsDiff ( nIon, fragTag [b_soch4_index] ) < fragTol ) {
-				matched = genMax ( b_soch4_score, matched );
-			}
-			else if ( nIonPhosphorylation && genAbsDiff ( nIon, fragTag [a_h3po4_index] ) < fragTol ) {
-				matched = genMax ( a_h3po4_score, matched );
-			}
-			else if ( nIonPhosphorylation && genAbsDiff ( nIon, fragTag [b_h3po4_index] ) < fragTol ) {
-				matched = genMax ( b_h3po4_score, matched );
-			}
-		}
+		IonMatchTest tests [10];
+		int n = 0;
+		const MassType* fragTol = getFragTol ( 1 );
+		addIonMatchTest ( tests, n, getNTag ( b_index ), fragTol, b_score );
+		addIonMatchTest ( tests, n, getNTag ( a_index ), fragTol, a_score );
+		if ( nIonAmmoniaLoss )						addIonMatchTest ( tests, n, getNTag ( a_nh3_index ), fragTol, a_nh3_score );
+		if ( nIonWaterLoss )						addIonMatchTest ( tests, n, getNTag ( a_h2o_index ), fragTol, a_h2o_score );
+		if ( nIonAmmoniaLoss )						addIonMatchTest ( tests, n, getNTag ( b_nh3_index ), fragTol, b_nh3_score );
+		if ( nIonWaterLoss )						addIonMatchTest ( tests, n, getNTag ( b_h2o_index ), fragTol, b_h2o_score );
+		if ( k >= len - 3 && nIonPosChargeBearing )	addIonMatchTest ( tests, n, getNTag ( b_plus_h2o_index ), fragTol, b_plus_h2o_score );
+		if ( nIonM )								addIonMatchTest ( tests, n, getNTag ( b_soch4_index ), fragTol, b_soch4_score );
+		if ( nIonPhosphorylation )					addIonMatchTest ( tests, n, getNTag ( a_h3po4_index ), fragTol, a_h3po4_score );
+		if ( nIonPhosphorylation )					addIonMatchTest ( tests, n, getNTag ( b_h3po4_index ), fragTol, b_h3po4_score );
+		matchIonTests ( nIon, start, minNFragTag, maxNFragTagSoA, tests, n );
 	}
 }
 void MSTagSearch::doNIonsESI_ETD_low_res ( const string& sequence )
@@ -2748,53 +2767,25 @@ void MSTagSearch::doCIonsESI_TRAP_CID_low_res ( const string& sequence )
 		if ( checkCIonPhosphorylation )		cIonPhosphorylation |= phosphorylationFlag [aa];
 		if ( checkCIonWaterLoss )			cIonWaterLoss |= waterLossFlag [aa];
 		if ( cIon < minCFragTagInData ) continue;
-		for ( int i = start ; i < numPeaks ; i++ ) {
-			if ( cIon < minCFragTag [i] ) break;
-			if ( cIon > maxCFragTag [i] ) {
-				start++;
-				continue;
-			}
-			MassTypeVector& fragTag = cIonFragTag [i];
-			ScoreType& matched = ionMatched [i];
-			MassType fragTol = fragTolerance [i];
-			MassType fragTol2 = fragTol + fragTol;
-
-			if ( genAbsDiff ( cIon, fragTag [y_index] ) < fragTol ) {
-				matched = genMax ( y_score, matched );
-			}
-			else if ( doublyChargedIons && cIonPosChargeBearing && genAbsDiff ( cIon, fragTag [yp2_index] ) < fragTol2 ) {
-				matched = genMax ( yp2_score, matched );
-			}
-			else if ( triplyChargedIons && cIonPosChargeBearing > 1 ) {
-				if ( genAbsDiff ( cIon, fragTag [yp3_index] ) < fragTol2 + fragTol ) {
-					matched = genMax ( yp3_score, matched );
-				}
-			}
-			else if ( cIonAmmoniaLoss && genAbsDiff ( cIon, fragTag [y_nh3_index] ) < fragTol ) {
-				matched = genMax ( y_nh3_score, matched );
-			}
-			else if ( doublyChargedIons && cIonAmmoniaLoss && cIonPosChargeBearing && genAbsDiff ( cIon, fragTag [yp2_nh3_index] ) < fragTol2 ) {
-				matched = genMax ( yp2_nh3_score, matched );
-			}
-			else if ( cIonWaterLoss && genAbsDiff ( cIon, fragTag [y_h2o_index] ) < fragTol ) {
-				matched = genMax ( y_h2o_score, matched );
-			}
-			else if ( doublyChargedIons && cIonWaterLoss && cIonPosChargeBearing && genAbsDiff ( cIon, fragTag [yp2_h2o_index] ) < fragTol2 ) {
-				matched = genMax ( yp2_h2o_score, matched );
-			}
-			else if ( cIonM && genAbsDiff ( cIon, fragTag [y_soch4_index] ) < fragTol ) {
-				matched = genMax ( y_soch4_score, matched );
-			} 
-			else if ( doublyChargedIons && cIonM && cIonPosChargeBearing && genAbsDiff ( cIon, fragTag [yp2_soch4_index] ) < fragTol2 ) {
-				matched = genMax ( yp2_soch4_score, matched );
-			}
-			else if ( cIonPhosphorylation && genAbsDiff ( cIon, fragTag [y_h3po4_index] ) < fragTol ) {
-				matched = genMax ( y_h3po4_score, matched );
-			}
-			else if ( doublyChargedIons && cIonPhosphorylation && cIonPosChargeBearing && genAbsDiff ( cIon, fragTag [yp2_h3po4_index] ) < fragTol2 ) {
-				matched = genMax ( yp2_h3po4_score, matched );
-			}
+		IonMatchTest tests [11];
+		int n = 0;
+		bool p2 = doublyChargedIons && cIonPosChargeBearing;
+		addIonMatchTest ( tests, n, getCTag ( y_index ), getFragTol ( 1 ), y_score );
+		if ( p2 ) addIonMatchTest ( tests, n, getCTag ( yp2_index ), getFragTol ( 2 ), yp2_score );
+		if ( triplyChargedIons && cIonPosChargeBearing > 1 ) {
+			addIonMatchTest ( tests, n, getCTag ( yp3_index ), getFragTol ( 3 ), yp3_score );	// No further ion types are tried in this case
 		}
+		else {
+			if ( cIonAmmoniaLoss )			addIonMatchTest ( tests, n, getCTag ( y_nh3_index ), getFragTol ( 1 ), y_nh3_score );
+			if ( p2 && cIonAmmoniaLoss )	addIonMatchTest ( tests, n, getCTag ( yp2_nh3_index ), getFragTol ( 2 ), yp2_nh3_score );
+			if ( cIonWaterLoss )			addIonMatchTest ( tests, n, getCTag ( y_h2o_index ), getFragTol ( 1 ), y_h2o_score );
+			if ( p2 && cIonWaterLoss )		addIonMatchTest ( tests, n, getCTag ( yp2_h2o_index ), getFragTol ( 2 ), yp2_h2o_score );
+			if ( cIonM )					addIonMatchTest ( tests, n, getCTag ( y_soch4_index ), getFragTol ( 1 ), y_soch4_score );
+			if ( p2 && cIonM )				addIonMatchTest ( tests, n, getCTag ( yp2_soch4_index ), getFragTol ( 2 ), yp2_soch4_score );
+			if ( cIonPhosphorylation )		addIonMatchTest ( tests, n, getCTag ( y_h3po4_index ), getFragTol ( 1 ), y_h3po4_score );
+			if ( p2 && cIonPhosphorylation )addIonMatchTest ( tests, n, getCTag ( yp2_h3po4_index ), getFragTol ( 2 ), yp2_h3po4_score );
+		}
+		matchIonTests ( cIon, start, minCFragTag, maxCFragTagSoA, tests, n );
 	}
 }
 void MSTagSearch::doCIonsESI_Q_CID ( const string& sequence )
@@ -2855,32 +2846,15 @@ void MSTagSearch::doCIonsESI_Q_CID ( const string& sequence )
 		if ( checkCIonPhosphorylation )		cIonPhosphorylation |= phosphorylationFlag [aa];
 		if ( checkCIonWaterLoss )			cIonWaterLoss |= waterLossFlag [aa];
 		if ( cIon < minCFragTagInData ) continue;
-		for ( int i = start ; i < numPeaks ; i++ ) {
-			if ( cIon < minCFragTag [i] ) break;
-			if ( cIon > maxCFragTag [i] ) {
-				start++;
-				continue;
-			}
-			MassTypeVector& fragTag = cIonFragTag [i];
-			ScoreType& matched = ionMatched [i];
-			MassType fragTol = fragTolerance [i];
-
-			if ( genAbsDiff ( cIon, fragTag [y_index] ) < fragTol ) {
-				matched = genMax ( y_score, matched );
-			}
-			else if ( cIonAmmoniaLoss && genAbsDiff ( cIon, fragTag [y_nh3_index] ) < fragTol ) {
-				matched = genMax ( y_nh3_score, matched );
-			}
-			else if ( cIonWaterLoss && genAbsDiff ( cIon, fragTag [y_h2o_index] ) < fragTol ) {
-				matched = genMax ( y_h2o_score, matched );
-			}
-			else if ( cIonM && genAbsDiff ( cIon, fragTag [y_soch4_index] ) < fragTol ) {
-				matched = genMax ( y_soch4_score, matched );
-			} 
-			else if ( cIonPhosphorylation && genAbsDiff ( cIon, fragTag [y_h3po4_index] ) < fragTol ) {
-				matched = genMax ( y_h3po4_score, matched );
-			}
-		}
+		IonMatchTest tests [5];
+		int n = 0;
+		const MassType* fragTol = getFragTol ( 1 );
+		addIonMatchTest ( tests, n, getCTag ( y_index ), fragTol, y_score );
+		if ( cIonAmmoniaLoss )		addIonMatchTest ( tests, n, getCTag ( y_nh3_index ), fragTol, y_nh3_score );
+		if ( cIonWaterLoss )		addIonMatchTest ( tests, n, getCTag ( y_h2o_index ), fragTol, y_h2o_score );
+		if ( cIonM )				addIonMatchTest ( tests, n, getCTag ( y_soch4_index ), fragTol, y_soch4_score );
+		if ( cIonPhosphorylation )	addIonMatchTest ( tests, n, getCTag ( y_h3po4_index ), fragTol, y_h3po4_score );
+		matchIonTests ( cIon, start, minCFragTag, maxCFragTagSoA, tests, n );
 	}
 }
 void MSTagSearch::doCIonsESI_ETD_low_res ( const string& sequence )
@@ -21,6 +21,7 @@
 ******************************************************************************/
 #include <queue>
 #include <lg_io.h>
+#include <lgen_thread.h>
 #include <lgen_reg_exp.h>
 #include <lu_aa_calc.h>
 #include <lu_mat_score.h>
@@ -28,6 +29,9 @@
 #include <lp_frame.h>
 #include <lu_tag_srch.h>
 #include <lu_delim.h>
+#include <lu_dig_cache.h>
+#include <lu_pep_index.h>
+#include <lu_getfil.h>
 #include <lu_tag_par.h>
 #include <lu_table.h>
 using std::vector;
@@ -100,6 +104,12 @@ void TagHits::addHit ( const TagHit& hit, int dataSet )
 {
 	hits [dataSet]->push_back ( hit );
 }
+void TagHits::merge ( const TagHits& rhs, FastaServer* fs )
+{
+	for ( int i = 0 ; i < numSearches ; i++ ) {
+		hits [i]->merge ( *rhs.hits [i], fs );
+	}
+}
 class sortMSMSSearchByParentMass {
 public:
 	int operator () ( const MSMSSearch* a, const double b ) const
@@ -113,7 +123,8 @@ TagSearch::TagSearch ( MSTagParameters& params ) :
 	DatabaseSearch ( params ),
 	tagParams ( params ),
 	maxTagMatches ( params.getMaxHits () ),
-	randomSearch ( params.isRandomSearch () )
+	randomSearch ( params.isRandomSearch () ),
+	tagSearchContext ( msMSSearch, 0 )
 {
 	SurvivalHistogram::setExpectationMethod ( params.getExpectationMethod () );
 	MSMSDataSetInfo* dsi = params.getDataSetInfo ();
@@ -121,6 +132,7 @@ TagSearch::TagSearch ( MSTagParameters& params ) :
 		msMSSearch.push_back ( getMSTagSearch ( dsi->getDataSet ( i ), params ) );
 	}
 	tagHits = new TagHits ( msMSSearch, params );
+	tagSearchContext.tagHits = tagHits;
 	numSearches = msMSSearch.size ();
 	EnzymeParameters enzymeParameters = params.getEnzymeParameters ();
 	compMask = enzymeParameters.getCompMask ();
@@ -128,6 +140,10 @@ TagSearch::TagSearch ( MSTagParameters& params ) :
 	compMaskTypeOr = enzymeParameters.getCompMaskType () == "OR";
 	initNonSpecific ( params );
 	modTable = MSTagSearchAllowErrors::getModificationTable ();
+	numThreads = InfoParams::instance ().getIntValue ( "btag_num_threads", 1 );
+	if ( numThreads == 0 ) numThreads = genGetNumProcessors ();
+	// The modification, crosslinking and random searches update global state during scoring so are run on a single thread
+	if ( randomSearch || modTable || params.isCrosslinking () || FrameIterator::getMPI () ) numThreads = 1;
 }
 TagSearch::~TagSearch ()
 {
@@ -135,6 +151,9 @@ TagSearch::~TagSearch ()
 	for ( int i = 0 ; i < msMSSearch.size () ; i++ ) {
 		delete msMSSearch [i];
 	}
+	for ( int j = 0 ; j < threadMSMSSearch.size () ; j++ ) {
+		delete threadMSMSSearch [j];
+	}
 }
 void TagSearch::initNonSpecific ( const MSTagParameters& params )
 {
@@ -240,7 +259,7 @@ void TagSearch::doSearch ()
 			FrameIterator* fi = new FrameIterator ( fs [0], params.getIndicies ( 0 ), dnaFrameTranslationPairVector [0], params.getTempOverride () );
 			for ( int i = 1 ; ( readingFrame = fi->getNextFrame () ) != NULL ; i++ ) {
 				random_shuffle ( readingFrame, readingFrame + strlen ( readingFrame ) );
-				tag_search ( *fi, readingFrame );
+				tag_search ( *fi, readingFrame, tagSearchContext );
 				if ( i % ( getActualPruneInterval ( i, pruneInterval ) ) == 0 ) tagHits->prune ();
 			}
 			int minProcessed;
@@ -281,13 +300,95 @@ void TagSearch::doNormalSearch ( FastaServer* fsPtr, int num )
 {
 	char* readingFrame;
 	ProteinHit::addFS ( fsPtr, num );
+	if ( indexSearch ( fsPtr, num ) ) return;
+	if ( numThreads > 1 && params.getIndicies ( num ).size () > numThreads ) {
+		doThreadedSearch ( fsPtr, num );
+		return;
+	}
 	int pruneInterval = getPruneInterval ( numSearches );
 	FrameIterator fi ( fsPtr, params.getIndicies ( num ), dnaFrameTranslationPairVector [num], params.getTempOverride () );
+	tagSearchContext.databaseNumber = num;
 	for ( int i = 1 ; ( readingFrame = fi.getNextFrame () ) != NULL ; i++ ) {
-		tag_search ( fi, readingFrame );
+		tag_search ( fi, readingFrame, tagSearchContext );
 		if ( i % ( getActualPruneInterval ( i, pruneInterval ) ) == 0 ) tagHits->prune ();
 	}
 }
+class TagSearchThread : public GenThread {
+	TagSearch* tagSearch;
+	FastaServer* fs;
+	FrameIterator* fi;
+	vector <MSMSSearch*> msMSSearch;
+	TagHits* tagHits;
+	TagSearchContext tsc;
+	int pruneInterval;
+	void run ();
+public:
+	TagSearchThread ( TagSearch* tagSearch, FastaServer* fsPtr, int num, const IntVector& indicies, const PairIntInt& frameTransPair, bool tempOverride );
+	~TagSearchThread ();
+	void merge ( FastaServer* fsPtr );
+};
+TagSearchThread::TagSearchThread ( TagSearch* tagSearch, FastaServer* fsPtr, int num, const IntVector& indicies, const PairIntInt& frameTransPair, bool tempOverride ) :
+	tagSearch ( tagSearch ),
+	fs ( new FastaServer ( fsPtr->getFilePath ().empty () ? fsPtr->getFileName () : fsPtr->getFilePath () ) ),
+	tsc ( msMSSearch, 0 ),
+	pruneInterval ( TagSearch::getPruneInterval ( tagSearch->numSearches ) )
+{
+	fs->setMaxNTermAA ( fsPtr->getMaxNTermAA () );
+	MSMSDataSetInfo* dsi = tagSearch->tagParams.getDataSetInfo ();
+	for ( int i = 0 ; i < dsi->getNumDataSets () ; i++ ) {
+		msMSSearch.push_back ( getMSTagSearch ( dsi->getDataSet ( i ), tagSearch->tagParams ) );
+	}
+	tagHits = new TagHits ( msMSSearch, tagSearch->tagParams );
+	tsc.tagHits = tagHits;
+	tsc.databaseNumber = num;
+	fi = new FrameIterator ( fs, indicies, frameTransPair, tempOverride );
+}
+TagSearchThread::~TagSearchThread ()
+{
+	join ();
+	delete fi;
+	delete tagHits;
+	delete fs;
+}
+void TagSearchThread::run ()
+{
+	char* readingFrame;
+	for ( int i = 1 ; ( readingFrame = fi->getNextFrame () ) != NULL ; i++ ) {
+		tagSearch->tag_search ( *fi, readingFrame, tsc );
+		if ( i % ( TagSearch::getActualPruneInterval ( i, pruneInterval ) ) == 0 ) tagHits->prune ();
+	}
+}
+void TagSearchThread::merge ( FastaServer* fsPtr )
+{
+	join ();
+	for ( int i = 0 ; i < msMSSearch.size () ; i++ ) {
+		tagSearch->msMSSearch [i]->merge ( msMSSearch [i] );
+	}
+	tagSearch->tagHits->merge ( *tagHits, fsPtr );
+	tagSearch->tagHits->prune ();
+	// The hits refer to the parent peaks held by the thread's searches so these are kept until the search is deleted
+	tagSearch->threadMSMSSearch.insert ( tagSearch->threadMSMSSearch.end (), msMSSearch.begin (), msMSSearch.end () );
+	msMSSearch.clear ();
+}
+void TagSearch::doThreadedSearch ( FastaServer* fsPtr, int num )
+{
+	const IntVector& indicies = params.getIndicies ( num );
+	vector <IntVector> threadIndicies ( numThreads );
+	for ( IntVectorSizeType i = 0 ; i < indicies.size () ; i++ ) {
+		threadIndicies [i % numThreads].push_back ( indicies [i] );		// Interleave the entries to balance the load
+	}
+	vector <TagSearchThread*> threads ( numThreads );
+	for ( int j = numThreads ; j-- ; ) {		// Only the first thread reports progress. It is created last so the progress is reported against its entries.
+		threads [j] = new TagSearchThread ( this, fsPtr, num, threadIndicies [j], dnaFrameTranslationPairVector [num], j == 0 ? params.getTempOverride () : true );
+	}
+	for ( int k = 0 ; k < numThreads ; k++ ) {
+		threads [k]->start ();
+	}
+	for ( int m = 0 ; m < numThreads ; m++ ) {
+		threads [m]->merge ( fsPtr );
+		delete threads [m];
+	}
+}
 bool TagSearch::continueSearch () const
 {
 	int n = 0;
@@ -301,7 +402,7 @@ bool TagSearch::continueSearch () const
 	if ( ((double)n / numSearches) < 0.1 ) return false;
 	return flag;
 }
-void TagSearch::addTagHit ( int searchNumber, const TagMatchVector& tagMatch, const string& sequence, const FrameIterator& fi, int previousAA, int nextAA, int startAA )
+void TagSearch::addTagHit ( TagHits* tagHits, int searchNumber, const TagMatchVector& tagMatch, const string& sequence, const FrameIterator& fi, int previousAA, int nextAA, int startAA )
 {
 	for ( TagMatchVectorSizeType i = 0 ; i < tagMatch.size () ; i++ ) {
 		if ( tagHits->size ( searchNumber ) > maxTagMatches ) {
@@ -382,8 +483,11 @@ NoEnzymeSearch::NoEnzymeSearch ( MSTagParameters& params ) :
 	doSearch ();
 }
 NoEnzymeSearch::~NoEnzymeSearch () {}
-void NoEnzymeSearch::tag_search ( const FrameIterator& fi, const char* frame )
+void NoEnzymeSearch::tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc )
 {
+	vector <MSMSSearch*>& msMSSearch = tsc.msMSSearch;
+	TagHits* tagHits = tsc.tagHits;
+	TagMatchVector& tagMatch = tsc.tagMatch;
 	const IntVector& cleavageIndex = ( allowNonSpecificType == 'E' ) ? IntVector () : enzyme_fragmenter ( frame );
 	if ( modTable ) modTable->setMotifSites ( frame );
 	int num_aa = strlen ( frame );
@@ -416,7 +520,7 @@ void NoEnzymeSearch::tag_search ( const FrameIterator& fi, const char* frame )
 								string possMatch ( &frame [s], end - start );
 								if ( msMSSearch [i]->doMatch ( possMatch, ( start == startProtein ), ( end == endProtein ), sum, tagMatch, tagHits->getMinScore ( i ) ) ) {
 									if ( !compMask || checkComposition ( possMatch ) ) {
-										addTagHit ( i, tagMatch, possMatch, fi, ( start == startProtein ) ? '-' : frame [s-1], ( end == endProtein ) ? '-' : frame [e], s+1 );
+										addTagHit ( tagHits, i, tagMatch, possMatch, fi, ( start == startProtein ) ? '-' : frame [s-1], ( end == endProtein ) ? '-' : frame [e], s+1 );
 									}
 								}
 							}
@@ -453,8 +557,11 @@ NoEnzymeIntSearch::NoEnzymeIntSearch ( MSTagParameters& params ) :
 }
 NoEnzymeIntSearch::~NoEnzymeIntSearch () {}
 /* Bug fixed version - needs checking
-void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame )
+void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc )
 {
+	vector <MSMSSearch*>& msMSSearch = tsc.msMSSearch;
+	TagHits* tagHits = tsc.tagHits;
+	TagMatchVector& tagMatch = tsc.tagMatch;
 	const IntVector& cleavageIndex = ( allowNonSpecificType == 'E' ) ? IntVector () : enzyme_fragmenter ( frame );
 	if ( modTable ) modTable->setMotifSites ( frame );
 	int num_aa = strlen ( frame );
@@ -491,7 +598,7 @@ void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame
 								if ( genAbsDiff ( mol_wt, parentMass ) < parentTolerance ) {
 									if ( msMSSearch [i]->doMatch ( possMatch, ( start == startProtein ), ( end == endProtein ), mol_wt, tagMatch, tagHits->getMinScore ( i ) ) ) {
 										if ( !compMask || checkComposition ( possMatch ) ) {
-											addTagHit ( i, tagMatch, possMatch, fi, ( start == startProtein ) ? '-' : frame [s-1], ( end == endProtein ) ? '-' : frame [e], s+1 );
+											addTagHit ( tagHits, i, tagMatch, possMatch, fi, ( start == startProtein ) ? '-' : frame [s-1], ( end == endProtein ) ? '-' : frame [e], s+1 );
 										}
 									}
 								}
@@ -517,8 +624,11 @@ void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame
 	}
 }
 */
-void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame )
+void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc )
 {
+	vector <MSMSSearch*>& msMSSearch = tsc.msMSSearch;
+	TagHits* tagHits = tsc.tagHits;
+	TagMatchVector& tagMatch = tsc.tagMatch;
 	const IntVector& cleavageIndex = ( allowNonSpecificType == 'E' ) ? IntVector () : enzyme_fragmenter ( frame );
 	if ( modTable ) modTable->setMotifSites ( frame );
 	int num_aa = strlen ( frame );
@@ -550,7 +660,7 @@ void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame
 							if ( genAbsDiff ( mol_wt, parentMass ) < parentTolerance ) {
 								if ( msMSSearch [i]->doMatch ( possMatch, ( start == startProtein ), ( end == endProtein ), mol_wt, tagMatch, tagHits->getMinScore ( i ) ) ) {
 									if ( !compMask || checkComposition ( possMatch ) ) {
-										addTagHit ( i, tagMatch, possMatch, fi, ( start == startProtein ) ? '-' : frame [s-1], ( end == endProtein ) ? '-' : frame [e], s+1 );
+										addTagHit ( tagHits, i, tagMatch, possMatch, fi, ( start == startProtein ) ? '-' : frame [s-1], ( end == endProtein ) ? '-' : frame [e], s+1 );
 									}
 								}
 							}
@@ -562,21 +672,104 @@ void NoEnzymeIntSearch::tag_search ( const FrameIterator& fi, const char* frame
 		}
 	}
 }
+DigestCache* YesEnzymeSearch::digestCache = 0;
+
 YesEnzymeSearch::YesEnzymeSearch ( MSTagParameters& params ) :
 	TagSearch ( params )
 {
 	startLimit = msMSSearch.front ()->getParentMassMinusPosTolerance ();
 	endLimit = msMSSearch.back ()->getParentMassPlusNegTolerance ();
 	cleavedLimit = ( cnbr_digest ) ? endLimit - cnbr_homoserine_lactone_mod : endLimit;
+	usePeptideIndex = InfoParams::instance ().getBoolValue ( "peptide_index", false );
+	// The index pre-filter only counts the peptides it rejects so it can't be used if the expectation value histograms keep the scores.
+	// It also only indexes unmodified fragment ions.
+	bool useFragIndex = !params.isCrosslinking () && !modTable && MSTagSearch::getHistogramLimit ( params ) == 0;
+	fragIndex = useFragIndex ? FragmentIonIndex::create ( msMSSearch ) : 0;
 	doSearch ();
 }
-YesEnzymeSearch::~YesEnzymeSearch () {}
-void YesEnzymeSearch::tag_search ( const FrameIterator& fi, const char* frame )
+YesEnzymeSearch::~YesEnzymeSearch ()
 {
-	IntVector& cleavage_index = enzyme_fragmenter ( frame );
+	delete fragIndex;
+}
+bool YesEnzymeSearch::indexSearch ( FastaServer* fsPtr, int num )
+{
+	// The index holds unmodified cleavage products of protein databases
+	if ( !usePeptideIndex || randomSearch || modTable || cnbr_digest || tagParams.isCrosslinking () ) return false;
+	if ( fsPtr->getDNADatabase () || fsPtr->getMaxNTermAA () || !fsPtr->getFilePath ().empty () ) return false;
+	PeptideMassIndex* pmi = PeptideMassIndex::getIndex ( fsPtr, tagParams.getEnzyme (), missedCleavages, endLimit );
+	if ( pmi == 0 ) return false;
+	const IntVector& indicies = params.getIndicies ( num );
+	vector <bool> searched ( fsPtr->getNumEntries () + 1, false );	// Entries which have passed the pre-search
+	for ( IntVectorSizeType i = 0 ; i < indicies.size () ; i++ ) {
+		searched [indicies [i]] = true;
+	}
+	TagMatchVector& tagMatch = tagSearchContext.tagMatch;
+	int drf = dnaFrameTranslationPairVector [num].first;
+	int pruneInterval = getPruneInterval ( numSearches );
+	int n = 1;
+	for ( GENINT64 j = pmi->lowerBound ( startLimit ) ; j < pmi->size () ; j++ ) {
+		PeptideIndexEntry pie = pmi->getEntry ( j );
+		double mol_wt = pie.mass;
+		if ( mol_wt > endLimit ) break;
+		if ( mol_wt <= startLimit || !searched [pie.index] ) continue;
+		bool nTermProt = ( pie.previousAA == '-' );
+		bool cTermProt = ( pie.nextAA == '-' );
+		string possMatch;
+		bool first = true;
+		int ind = lower_bound ( msMSSearch.begin (), msMSSearch.end (), mol_wt, sortMSMSSearchByParentMass () ) - msMSSearch.begin ();
+		for ( ; ind < msMSSearch.size () ; ind++ ) {
+			MSMSSearch* msms = msMSSearch [ind];
+			if ( msms->getSpectrumRetained () ) {
+				if ( msms->getParentMassMinusPosTolerance () > mol_wt ) break;
+				if ( msms->checkMatch ( mol_wt ) ) {
+					if ( first ) {
+						possMatch = pmi->getSequence ( pie );
+						if ( fragIndex ) fragIndex->getMatches ( possMatch, ind, mol_wt, tagSearchContext.fragMatches );
+						first = false;
+					}
+					if ( !compMask || checkComposition ( possMatch ) ) {
+						if ( fragIndex && !tagSearchContext.fragMatches.isCandidate ( ind ) ) {
+							msms->addUnscoredMatch ( possMatch );
+							continue;
+						}
+						if ( msms->doMatch ( possMatch, nTermProt, cTermProt, mol_wt, tagMatch, tagHits->getMinScore ( ind ) ) ) {
+							FrameIterator fi ( fsPtr, pie.index, drf, 1 );
+							addTagHit ( tagHits, ind, tagMatch, possMatch, fi, pie.previousAA, pie.nextAA, pie.start + 1 );
+						}
+					}
+				}
+			}
+		}
+		if ( n++ % pruneInterval == 0 ) tagHits->prune ();
+	}
+	delete pmi;
+	return true;
+}
+void YesEnzymeSearch::tag_search ( const FrameIterator& fi, const char* frame, TagSearchContext& tsc )
+{
+	vector <MSMSSearch*>& msMSSearch = tsc.msMSSearch;
+	TagHits* tagHits = tsc.tagHits;
+	TagMatchVector& tagMatch = tsc.tagMatch;
 	if ( modTable ) modTable->setMotifSites ( frame );
-	int numEnzymeFragments = cleavage_index.size ();
-	DoubleVector& enzyme_fragment_mass_array = get_cleaved_masses_to_limit ( frame, cleavage_index, cleavedLimit );
+	int numEnzymeFragments;
+	const int* cleavage_index;
+	const double* enzyme_fragment_mass_array;
+	DigestCache* dc = randomSearch ? 0 : digestCache;
+	int frameLength = dc ? strlen ( frame ) : 0;
+	if ( dc == 0 || !dc->get ( tsc.databaseNumber, fi, frameLength, numEnzymeFragments, cleavage_index, enzyme_fragment_mass_array ) ) {
+		IntVector& cleavageIndex = enzyme_fragmenter ( frame );
+		numEnzymeFragments = cleavageIndex.size ();
+		if ( numEnzymeFragments == 0 ) return;
+		cleavage_index = &cleavageIndex [0];
+		if ( dc && dc->getBuilding () ) {
+			// The masses aren't limited so the digest can be reused by searches with a different mass range.
+			// They are the same as the limited masses up to the limit so the search results are unchanged.
+			DoubleVector& mass = get_cleaved_masses ( frame, cleavageIndex );
+			dc->add ( tsc.databaseNumber, fi, frameLength, cleavageIndex, mass );
+			enzyme_fragment_mass_array = &mass [0];
+		}
+		else enzyme_fragment_mass_array = &get_cleaved_masses_to_limit ( frame, cleavageIndex, cleavedLimit ) [0];
+	}
 	int missedCleavageLimit = missedCleavages;
 	bool first;
 	int hitLength;
@@ -611,7 +804,7 @@ void YesEnzymeSearch::tag_search ( const FrameIterator& fi, const char* frame )
 								bool cTermProt = ( j == numEnzymeFragments-1 );
 								if ( possMatch [hitLength - 1] == 'M' ) possMatch[hitLength-1] = 'h';	//CNBr only
 								if ( msms->doMatch ( possMatch, nTermProt, cTermProt, mol_wt, tagMatch, tagHits->getMinScore ( ind ) ) ) {
-									addTagHit ( ind, tagMatch, possMatch, fi, nTermProt ? '-' : frame[previousCleavageIndex], cTermProt ? '-' : frame [cleavage_index[j] + 1], previousCleavageIndex + 2 );
+									addTagHit ( tagHits, ind, tagMatch, possMatch, fi, nTermProt ? '-' : frame[previousCleavageIndex], cTermProt ? '-' : frame [cleavage_index[j] + 1], previousCleavageIndex + 2 );
 								}
 							}
 						}
@@ -644,12 +837,17 @@ void YesEnzymeSearch::tag_search ( const FrameIterator& fi, const char* frame )
 									hitLength = cleavage_index [j] - previousCleavageIndex;
 									possMatch = string ( frame + previousCleavageIndex + 1, hitLength );
 									if ( modTable ) modTable->setMotifFlags ( previousCleavageIndex + 2, previousCleavageIndex + 1 + hitLength );
+									if ( fragIndex ) fragIndex->getMatches ( possMatch, ind, mol_wt, tsc.fragMatches );
 									first = false;
 								}
 								if ( !compMask || checkComposition ( possMatch ) ) {
+									if ( fragIndex && !tsc.fragMatches.isCandidate ( ind ) ) {
+										msms->addUnscoredMatch ( possMatch );
+										continue;
+									}
 									bool cTermProt = ( j == numEnzymeFragments-1 );
 									if ( msms->doMatch ( possMatch, nTermProt, cTermProt, mol_wt, tagMatch, tagHits->getMinScore ( ind ) ) ) {
-										addTagHit ( ind, tagMatch, possMatch, fi, nTermProt ? '-' : frame[previousCleavageIndex], cTermProt ? '-' : frame [cleavage_index[j] + 1], previousCleavageIndex + 2 );
+										addTagHit ( tagHits, ind, tagMatch, possMatch, fi, nTermProt ? '-' : frame[previousCleavageIndex], cTermProt ? '-' : frame [cleavage_index[j] + 1], previousCleavageIndex + 2 );
 									}
 								}
 							}
@@ -869,6 +1067,14 @@ void TagHitsContainer::push_back ( const T& hit )
 	tHits.push_back ( hit );
 	if ( tHits.size () > pruneLevel ) pruneHits ();
 }
+void TagHitsContainer::merge ( const TagHitsContainer& rhs, FastaServer* fs )
+{
+	for ( int i = 0 ; i < rhs.tHits.size () ; i++ ) {
+		T hit = rhs.tHits [i];
+		hit.setFastaServer ( fs );
+		push_back ( hit );
+	}
+}
 void TagHitsContainer::printHTMLReport ( ostream& os, int dataSet )
 {
 	printNumHits ( os, "MS-Tag", numHits, params.getMaxReportedHits () );
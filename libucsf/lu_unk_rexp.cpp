@@ -20,55 +20,39 @@
 *                                                                             *
 ******************************************************************************/
 #include <lg_new.h>
+#include <cstring>
 #include <lg_string.h>
 #include <lgen_error.h>
 #include <lu_unk_rexp.h>
 #include <lu_seq_exp.h>
-using std::vector;
-using std::copy;
 using std::string;
 
-static void initialise_unknome_search ();
-
-static vector <char*> hits;
-static vector <int> seqset;
-static vector <int> maxerrs;
-static int num_hits;
-static int check_len;
-
-static int* node;
-static int maxnumerrs;
-static int maxlen;
-static int minlen;
-static int* sum_errors;
-
-static IntVector hit_number (1);
-static int hit_number_array_size = 1;
-static int num_errors;
-static int nhits;
-
-static const char* loc1;
-static const char* loc2;
-#include <iostream>
-void initialise_regular_expression_hit_list ( const StringVector& reg_exp_hits, const IntVector& set, const IntVector& max_allow_errors, const Tolerance* massTolerance, int check_peptide_length )
+SequenceTagMatcher::SequenceTagMatcher ( const StringVector& regExpHits, const IntVector& set, const IntVector& maxAllowErrors, const Tolerance* massTolerance, bool checkPeptideLength ) :
+	checkLen ( checkPeptideLength ),
+	nhits ( 0 ),
+	numErrors ( 0 ),
+	sameString ( false ),
+	loc1 ( 0 ),
+	loc2 ( 0 ),
+	candidateStart ( 0 )
 {
-	if ( reg_exp_hits.empty () ) {
+	if ( regExpHits.empty () ) {
 		ErrorHandler::genError ()->error ( "No sequences entered.\n" );
 	}
-	for ( StringVectorSizeType i = 0 ; i < reg_exp_hits.size () ; i++ ) {
-		SequenceExpression seq_exp ( reg_exp_hits [i], massTolerance );
-		StringVector seq_list = seq_exp.getSequenceList ();
-		for ( StringVectorSizeType j = 0 ; j < seq_list.size () ; j++ ) {
-			hits.push_back ( gen_new_string ( seq_list [j].c_str () ) );
-			seqset.push_back ( set [i] );
-			maxerrs.push_back ( max_allow_errors [i] );
-			string s = hits.back ();
+	for ( StringVectorSizeType i = 0 ; i < regExpHits.size () ; i++ ) {
+		SequenceExpression seqExp ( regExpHits [i], massTolerance );
+		StringVector seqList = seqExp.getSequenceList ();
+		for ( StringVectorSizeType j = 0 ; j < seqList.size () ; j++ ) {
+			hits.push_back ( seqList [j] );
+			seqSet.push_back ( set [i] );
+			maxErrs.push_back ( maxAllowErrors [i] );
+			const string& s = hits.back ();
 			if ( s.length () < 4 ) {
 				ErrorHandler::genError ()->error ( "One or more of the possible sequences is too short.\n" );
 			}
-			if ( s.length () <= maxerrs.back () + 3 ) {
+			if ( s.length () <= maxErrs.back () + 3 ) {
 				string err;
-				if ( reg_exp_hits.size () == 1 )
+				if ( regExpHits.size () == 1 )
 					err = "The maximum number of errors is too large for the specified sequence.\n";
 				else
 					err = "The maximum number of errors is too large for the specified sequence for spectrum " + gen_itoa (i+1) + ".\n";
@@ -76,135 +60,178 @@ void initialise_regular_expression_hit_list ( const StringVector& reg_exp_hits,
 			}
 		}
 	}
-	num_hits = hits.size ();
-	check_len = check_peptide_length;
-	initialise_unknome_search ();
+	node.resize ( hits.size () );
+	node [0] = 0;
+	minLen = maxLen = hits [0].length ();
+	for ( StringVectorSizeType k = 1 ; k < hits.size () ; k++ ) {
+		const char* h1 = hits [k-1].c_str ();
+		const char* h2 = hits [k].c_str ();
+		int j;
+		for ( j = 0 ; h2 [j] == h1 [j] ; j++ ) {
+			if ( h2 [j] == 0 ) {		// Repeated sequences are never reached by the search
+				j++;
+				break;
+			}
+		}
+		node [k] = j;
+		minLen = genMin ( (int) hits [k].length (), minLen );
+		maxLen = genMax ( (int) hits [k].length (), maxLen );
+	}
+	maxNumErrs = 0;
+	for ( IntVectorSizeType m = 0 ; m < maxErrs.size () ; m++ ) {
+		maxNumErrs = genMax ( maxErrs [m], maxNumErrs );
+	}
+	sumErrors.resize ( maxLen );
+	for ( StringVectorSizeType n = 0 ; n < hits.size () ; n++ ) hitPtrs.push_back ( hits [n].c_str () );
+	initFilter ();
 }
-static void initialise_unknome_search ()
+void SequenceTagMatcher::initFilter ()
 {
-	int i, j;
-
-	node = new int [num_hits];
-	node [0] = 0;
-	minlen = maxlen = strlen ( hits [0] );
-	for ( i = 1 ; i < num_hits ; i++ ) {
-		for ( j = 0 ; hits [i] [j] == hits [i-1] [j] ; j++ );
-		node [i] = j;
-		minlen = genMin ( (int) strlen ( hits [i] ), minlen );
-		maxlen = genMax ( (int) strlen ( hits [i] ), maxlen );
+	int numBits = 0;
+	for ( StringVectorSizeType i = 0 ; i < hits.size () ; i++ ) numBits += hits [i].length ();
+	numWords = ( numBits + 63 ) / 64;
+	int numChars = 1;								// Character 0 is used for characters not in any sequence
+	for ( int c = 0 ; c < 256 ; c++ ) charIndex [c] = 0;
+	for ( StringVectorSizeType j = 0 ; j < hits.size () ; j++ ) {
+		for ( StringSizeType k = 0 ; k < hits [j].length () ; k++ ) {
+			unsigned char c = hits [j][k];
+			if ( charIndex [c] == 0 ) charIndex [c] = numChars++;
+		}
 	}
-	maxnumerrs = 0;
-	for ( i = 0 ; i < num_hits ; i++ ) {
-		maxnumerrs = genMax ( maxerrs [i], maxnumerrs );
+	startBits.assign ( numWords, 0 );
+	charBits.assign ( numChars * numWords, 0 );
+	acceptBits.assign ( ( maxNumErrs + 1 ) * numWords, 0 );
+	lastBitLength.assign ( numWords * 64, 0 );
+	int bit = 0;									// The sequences are stored one after the other
+	int allowErrs = 0;
+	for ( StringVectorSizeType m = 0 ; m < hits.size () ; m++ ) {
+		// The error count for a shared prefix is taken from an earlier sequence without checking it
+		// against the maximum for this sequence so allow for the earlier maximums.
+		allowErrs = node [m] ? genMax ( allowErrs, maxErrs [m] ) : maxErrs [m];
+		int len = hits [m].length ();
+		startBits [bit / 64] |= static_cast <GENUINT64> (1) << ( bit % 64 );
+		for ( int n = 0 ; n < len ; n++, bit++ ) {
+			unsigned char c = hits [m][n];
+			charBits [charIndex [c] * numWords + bit / 64] |= static_cast <GENUINT64> (1) << ( bit % 64 );
+		}
+		int last = bit - 1;
+		acceptBits [allowErrs * numWords + last / 64] |= static_cast <GENUINT64> (1) << ( last % 64 );
+		lastBitLength [last] = len;
 	}
-	sum_errors = new int [maxlen];
+	state.resize ( ( maxNumErrs + 1 ) * numWords );
 }
-bool multi_unknome_hits_present ( char* offset )
+/*
+Bit b of state level e is set if the sequence position at b and the ones before it in the same
+sequence match the text ending at the current character with at most e substitutions. The
+levels are updated from the highest down so level e-1 still holds the previous character.
+*/
+void SequenceTagMatcher::findCandidates ( const char* str, int len )
 {
-	static int same_string = 0;
-	const char* loc = check_len ? loc2 : loc1 + 1;
-
-	if ( same_string ) {
-		if ( unknome_hit_present ( loc ) ) {		/* Called after a hit has already been found in a reading frame. */
-			return ( true );
+	candidates.assign ( len, 0 );
+	candidateStart = str;
+	state.assign ( state.size (), 0 );
+	GENUINT64* st = &state [0];
+	const GENUINT64* sb = &startBits [0];
+	for ( int t = 0 ; t < len ; t++ ) {
+		const GENUINT64* cb = &charBits [charIndex [static_cast <unsigned char> (str [t])] * numWords];
+		for ( int e = maxNumErrs ; e >= 0 ; e-- ) {
+			GENUINT64* r = st + e * numWords;
+			const GENUINT64* ab = &acceptBits [e * numWords];
+			GENUINT64 carry = 0;
+			GENUINT64 carryPrev = 0;
+			for ( int w = 0 ; w < numWords ; w++ ) {
+				GENUINT64 s = r [w];
+				GENUINT64 v = ( ( s << 1 ) | carry | sb [w] ) & cb [w];
+				carry = s >> 63;
+				if ( e ) {								// Substitution
+					GENUINT64 sp = r [w - numWords];
+					v |= ( sp << 1 ) | carryPrev | sb [w];
+					carryPrev = sp >> 63;
+				}
+				r [w] = v;
+				GENUINT64 accept = v & ab [w];
+				for ( int b = 0 ; accept ; b++, accept >>= 1 ) {
+					if ( accept & 1 ) candidates [t + 1 - lastBitLength [w * 64 + b]] = 1;
+				}
+			}
+		}
+	}
+}
+bool SequenceTagMatcher::isPresentMulti ( const char* offset )
+{
+	if ( sameString ) {
+		if ( hitPresent ( checkLen ? loc2 : loc1 + 1, true ) ) {	// Called after a hit has already been found in a reading frame.
+			return true;
 		}
 	}
 	else {
-		if ( unknome_hit_present ( offset ) ) {		/* Called at the start of a reading frame. */
-			same_string = 1;
-			return ( true );
+		if ( hitPresent ( offset, false ) ) {						// Called at the start of a reading frame.
+			sameString = true;
+			return true;
 		}
 	}
-	same_string = 0;								/* End of reading frame, no more hits. */
-	return ( false );
+	sameString = false;												// End of reading frame, no more hits.
+	return false;
 }
-bool unknome_hit_present ( const char* offset )
+bool SequenceTagMatcher::hitPresent ( const char* offset, bool sameFrame )
 {
 	int len = strlen ( offset );
 
 	nhits = 0;
-	if ( len < minlen ) return ( false );	/* Shorter than any hit. */
-	if ( check_len ) len = 1;			/* Used for digest specific fragments */
-	num_errors = maxnumerrs + 1;
-	int bestLen = maxlen;
+	if ( len < minLen ) return false;	// Shorter than any hit.
+	if ( checkLen ) len = 1;			// Used for digest specific fragments
+	else if ( !sameFrame ) findCandidates ( offset, len );
+	numErrors = maxNumErrs + 1;
+	int bestLen = maxLen;
+	int numHits = hits.size ();
+	const char* const* hp = &hitPtrs [0];
+	const int* nd = &node [0];
+	const int* me = &maxErrs [0];
+	int* se = &sumErrors [0];
 	for ( int i = 0 ; i < len ; i++ ) {
-		loc1 = offset + i;				/* loc1 is the start of the section of protein under examination */
-		sum_errors [0] = 0;
-		for ( int j = 0, k = 0 ; j < num_hits ; j++ ) {
-			int nod = node [j];
+		if ( !checkLen && !candidates [offset + i - candidateStart] ) continue;	// No sequence matches here
+		loc1 = offset + i;				// loc1 is the start of the section of protein under examination
+		se [0] = 0;
+		for ( int j = 0, k = 0 ; j < numHits ; j++ ) {
+			int nod = nd [j];
 			if ( k >= nod ) {
-				const char* ep = &(hits [j][nod]);	/* ep is the pointer in the hit string */
-				const char* lp = loc1 + nod;		/* lp is the pointer in the protein string */
-				int nerrs = sum_errors [nod];
+				const char* ep = hp [j] + nod;		// ep is the pointer in the hit string
+				const char* lp = loc1 + nod;		// lp is the pointer in the protein string
+				int nerrs = se [nod];
 
 				for ( k = nod ; ; k++ ) {
 					if ( *ep == 0 ) {
 						loc2 = lp;
 						int curLen = loc2 - loc1;
-						if ( nerrs < num_errors ) {	// If there are several hits for a particular protein alignment
-							hit_number [0] = j;
+						if ( nerrs < numErrors ) {	// If there are several hits for a particular protein alignment
+							hitNumber.assign ( 1, j );
 							nhits = 1;				// only the one (or more) with the least errors is reported.
-							num_errors = nerrs;
+							numErrors = nerrs;
 							bestLen = curLen;
 						}
-						else if ( nhits && ( nerrs == num_errors ) ) {
+						else if ( nhits && ( nerrs == numErrors ) ) {
 							if ( curLen < bestLen ) {	// only the one (or more) which is shortest is reported.
-								hit_number [0] = j;
+								hitNumber.assign ( 1, j );
 								nhits = 1;
-								num_errors = nerrs;
+								numErrors = nerrs;
 								bestLen = curLen;
 							}
 							else if ( nhits && ( bestLen == curLen ) ) {
-								if ( nhits == hit_number_array_size ) {
-									hit_number_array_size *= 2;
-									hit_number.resize ( hit_number_array_size );
-								}
-								hit_number [nhits++] = j;
+								hitNumber.push_back ( j );
+								nhits++;
 							}
 						}
 						break;
 					}
 					if ( *lp == 0 ) break;
-					sum_errors [k] = nerrs;
+					se [k] = nerrs;
 					if ( *ep++ != *lp++ ) {
-						if ( ++nerrs > maxerrs [j] ) break;
+						if ( ++nerrs > me [j] ) break;
 					}
 				}
 			}
 		}
-		if ( num_errors <= maxnumerrs ) return ( true );
-	}
-	return ( false );
-}
-bool get_unknome_rexp_results ( char** measured_sequence, int* sequence_set, int* num_substitutions, bool reset )
-{
-	static int i;
-
-	if ( reset ) i = 0;
-
-	for ( ; i < nhits ; ) {
-		*measured_sequence = hits [hit_number [i]];
-		*num_substitutions = num_errors;
-		*sequence_set = seqset [hit_number [i]];
-		i++;
-		return ( true );
+		if ( numErrors <= maxNumErrs ) return true;
 	}
-	return ( false );
-}
-char* get_regular_expression_match ()
-{
-	static vector <char> expression;
-	int length = loc2 - loc1;
-	expression.resize ( length + 1 );
-	copy ( loc1, loc2, expression.begin () );
-	expression [length] = 0;
-	return ( &expression [0] );
-}
-const char* get_regular_expression_loc1 ()
-{
-	return ( loc1 );
-}
-const char* get_regular_expression_loc2 ()
-{
-	return ( loc2 );
+	return false;
 }
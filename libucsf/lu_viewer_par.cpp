@@ -379,7 +379,7 @@ void MSViewerParameters::initPeakList ( const ParameterList* params, UpdatingJav
 			return;
 		}
 		ujm.writeMessage ( cout, "Starting preprocessing of results file." );
-		string uploadName = genPreprocessFile ( uploadPeakListFpath );
+		string uploadName = genPreprocessFile ( uploadPeakListFpath, true );
 		ujm.writeMessage ( cout, "Ending preprocessing of results file." );
 		if ( uploadName == uploadPeakListFpath || isCompressedUpload ( uploadName ) ) {		// If the file hasn't been preprocessed or it has just been uncompressed it must be a single file
 			string shortName = genShortFilenameFromPath ( uploadName );
@@ -389,7 +389,7 @@ void MSViewerParameters::initPeakList ( const ParameterList* params, UpdatingJav
 			}
 			bool ret = genCreateDirectory ( newDir );
 			string newUploadName;
-			if ( isCompressedUpload ( uploadName ) )
+			if ( uploadName != uploadPeakListFpath && isCompressedUpload ( uploadName ) )	// Just uncompressed
 				newUploadName = newDir + SLASH + genShortFilenameFromPath ( uploadPeakListFname );
 			else
 				newUploadName = newDir + SLASH + uploadPeakListFname;
@@ -585,7 +585,7 @@ void MSViewerParameters::processAPLFiles ( UpdatingJavascriptMessage& ujm )
 	for ( StringVectorSizeType i = 0 ; i < sv.size () ; i++ ) {
 		string df2 = sv [i];
 		string path2 =  peakListFpath + SLASH + df2;
-		if ( !genIsDirectory ( path2 ) && isFileType ( path2, APL ) ) {
+		if ( !genIsDirectory ( path2 ) && isFileType ( getUncompressedFilename ( path2 ), APL ) ) {
 			ujm.writeMessage ( cout, "Processing file " + df2 + "." );
 			PPProject::parseAPLFile ( peakListFpath, df2 );
 		}
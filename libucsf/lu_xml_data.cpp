@@ -30,6 +30,7 @@
 #include <lu_aa_info.h>
 #include <lu_mass_conv.h>
 #include <lu_mass_elem.h>
+#include <lu_ms1_store.h>
 #include <lu_spec_id.h>
 #include <lu_xml_data.h>
 using std::string;
@@ -732,6 +733,162 @@ void PPExpatMZMLData::characterDataHandler ( const char* str, int len )
 	}
 }
 /*
+Reads the MS scans from an mzML file and the MS scan preceding each MSMS scan. Scan numbers
+are taken from "scan=" in the spectrum id or are the spectrum index plus one otherwise.
+*/
+PPExpatMZMLMS1Data::PPExpatMZMLMS1Data ( MS1ScanStoreWriter& writer ) :
+	writer ( writer ),
+	spectrumFlag ( false ),
+	paramGroupFlag ( false ),
+	binaryDataArray ( false ),
+	binaryFlag ( false ),
+	compression ( false ),
+	mzArrayFlag ( false ),
+	intenArrayFlag ( false ),
+	precision ( 64 ),
+	index ( 0 ),
+	scan ( 0 ),
+	msLevel ( 0 ),
+	rt ( 0.0 ),
+	precursorScan ( -1 )
+{
+}
+PPExpatMZMLMS1Data::~PPExpatMZMLMS1Data () {}
+int PPExpatMZMLMS1Data::getScanNumber ( const string& id, int defaultScan )
+{
+	string::size_type start = id.find ( "scan=" );
+	if ( start == string::npos ) return defaultScan;
+	return atoi ( id.substr ( start + 5 ).c_str () );
+}
+void PPExpatMZMLMS1Data::startElement ( const char* name, const char** attributes )
+{
+	if ( !spectrumFlag ) {
+		if ( paramGroupFlag ) {
+			if ( !strcmp ( name, "cvParam" ) ) {
+				string n;
+				string v;
+				getAttributeValue ( attributes, "name", n );
+				getAttributeValue ( attributes, "value", v );
+				curParam [n] = v;
+			}
+		}
+		else if ( !strcmp ( name, "spectrum" ) ) {
+			string id;
+			getAttributeValue ( attributes, "id", id );
+			scan = getScanNumber ( id, index + 1 );
+			spectrumFlag = true;
+		}
+		else if ( !strcmp ( name, "referenceableParamGroup" ) ) {
+			getAttributeValue ( attributes, "id", paramGroupID );
+			paramGroupFlag = true;
+		}
+		return;
+	}
+	if ( !binaryDataArray ) {
+		if ( !strcmp ( name, "referenceableParamGroupRef" ) ) {
+			string ref;
+			getAttributeValue ( attributes, "ref", ref );
+			std::map <std::string, MapStringToString>::const_iterator cur = paramGroups.find ( ref );
+			if ( cur != paramGroups.end () ) {
+				MapStringToStringConstIterator cur2 = (*cur).second.find ( "ms level" );
+				if ( cur2 != (*cur).second.end () ) msLevel = atoi ( (*cur2).second.c_str () );
+			}
+		}
+		else if ( !strcmp ( name, "precursor" ) ) {
+			string ref;
+			if ( getAttributeValue ( attributes, "spectrumRef", ref ) ) precursorScan = getScanNumber ( ref, -1 );
+		}
+		else if ( !strcmp ( name, "binaryDataArray" ) ) {
+			binaryDataArray = true;
+		}
+		else {
+			getCVAttributeValue ( name, attributes, "ms level", msLevel );
+			if ( getCVAttributeValue ( name, attributes, "scan start time", rt ) ) {
+				string units;
+				getAttributeValue ( attributes, "unitName", units );
+				if ( units == "second" ) rt /= 60.0;
+			}
+		}
+	}
+	else if ( msLevel == 1 ) {			// Only the MS peaks are stored
+		if ( getCVAttributeName ( name, attributes, "zlib compression" ) )	compression = true;
+		if ( getCVAttributeName ( name, attributes, "no compression" ) )	compression = false;
+		if ( getCVAttributeName ( name, attributes, "m/z array" ) )			mzArrayFlag = true;
+		if ( getCVAttributeName ( name, attributes, "intensity array" ) )	intenArrayFlag = true;
+		if ( getCVAttributeName ( name, attributes, "32-bit float" ) )		precision = 32;
+		if ( getCVAttributeName ( name, attributes, "64-bit float" ) )		precision = 64;
+		if ( !strcmp ( name, "referenceableParamGroupRef" ) ) {
+			string ref;
+			getAttributeValue ( attributes, "ref", ref );
+			if ( ref == "mz_params" )				mzArrayFlag = true;
+			else if ( ref == "int_params" )			intenArrayFlag = true;
+			std::map <std::string, MapStringToString>::const_iterator cur = paramGroups.find ( ref );
+			if ( cur != paramGroups.end () ) {
+				if ( (*cur).second.find ( "m/z array" ) != (*cur).second.end () )			mzArrayFlag = true;
+				if ( (*cur).second.find ( "intensity array" ) != (*cur).second.end () )		intenArrayFlag = true;
+				if ( (*cur).second.find ( "64-bit float" ) != (*cur).second.end () ) 		precision = 64;
+				if ( (*cur).second.find ( "32-bit float" ) != (*cur).second.end () )		precision = 32;
+				if ( (*cur).second.find ( "no compression" ) != (*cur).second.end () )		compression = false;
+				if ( (*cur).second.find ( "zlib compression" ) != (*cur).second.end () )	compression = true;
+			}
+		}
+		if ( !strcmp ( name, "binary" ) ) binaryFlag = true;
+	}
+}
+void PPExpatMZMLMS1Data::endElement ( const char* name )
+{
+	if ( binaryFlag ) {
+		if ( !strcmp ( name, "binary" ) ) binaryFlag = false;
+	}
+	else if ( binaryDataArray ) {
+		if ( !strcmp ( name, "binaryDataArray" ) ) {
+			if ( mzArrayFlag || intenArrayFlag ) {
+				DoubleVector& dv = mzArrayFlag ? mzList : intensityList;
+				if ( compression ) {
+					if ( precision == 32 ) makeVector32Uncompress ( s, 0, false, dv );
+					else makeVector64Uncompress ( s, 0, false, dv );
+				}
+				else {
+					if ( precision == 32 ) makeVector32 ( s, false, dv );
+					else makeVector64 ( s, false, dv );
+				}
+			}
+			s = "";
+			binaryDataArray = false;
+			compression = false;
+			mzArrayFlag = false;
+			intenArrayFlag = false;
+			precision = 64;
+		}
+	}
+	else if ( spectrumFlag ) {
+		if ( !strcmp ( name, "spectrum" ) ) {
+			if ( msLevel == 1 )		writer.addMS1Scan ( scan, rt, mzList, intensityList );
+			else if ( msLevel > 1 )	writer.addMSMSScan ( scan, precursorScan );
+			mzList.clear ();
+			intensityList.clear ();
+			spectrumFlag = false;
+			msLevel = 0;
+			rt = 0.0;
+			precursorScan = -1;
+			index++;
+		}
+	}
+	else if ( paramGroupFlag ) {
+		if ( !strcmp ( name, "referenceableParamGroup" ) ) {
+			paramGroups [paramGroupID] = curParam;
+			curParam.clear ();
+			paramGroupFlag = false;
+		}
+	}
+}
+void PPExpatMZMLMS1Data::characterDataHandler ( const char* str, int len )
+{
+	if ( binaryFlag ) {
+		s.append ( str, len );
+	}
+}
+/*
 psi - Protein Standards Institute
 cv - controlled vocabulary
 
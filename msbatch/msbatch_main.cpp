@@ -193,7 +193,7 @@ void batchSubmission ( ostream& os, ParameterList& paramList )
 		paramList.setValue ( "project_name", projectName );
 		paramList.removeName ( "upload_data_filename" );
 		paramList.removeName ( "upload_data_filepath" );
-		string uploadName = genPreprocessFile ( uploadFpath );
+		string uploadName = genPreprocessFile ( uploadFpath, true );
 		if ( uploadName == uploadFpath || isCompressedUpload ( uploadName ) ) {		// If the file hasn't been preprocessed or it has just been uncompressed it must be a single file
 			string shortName = genShortFilenameFromPath ( uploadName );
 			string newDir = genDirectoryFromPath ( uploadName ) + SLASH + shortName;
@@ -202,7 +202,7 @@ void batchSubmission ( ostream& os, ParameterList& paramList )
 			}
 			genCreateDirectory ( newDir );
 			string newUploadName;
-			if ( isCompressedUpload ( uploadName ) )
+			if ( uploadName != uploadFpath && isCompressedUpload ( uploadName ) )	// Just uncompressed
 				newUploadName = newDir + SLASH + genShortFilenameFromPath ( uploadFname );
 			else
 				newUploadName = newDir + SLASH + uploadFname;
@@ -0,0 +1,347 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : searchCompare                                                 *
+*                                                                             *
+*  Filename   : sc_bin_res.cpp                                                *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Binary copy of the spectrum results in a Batch-Tag results    *
+*               file.                                                         *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#ifndef VIS_C
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#ifdef VIS_C
+#include <process.h>
+#endif
+#include <cstring>
+#include <fstream>
+#include <lg_io.h>
+#include <lg_string.h>
+#include <lgen_file.h>
+#include <lgen_mmap.h>
+#include <lu_getfil.h>
+#include <lu_xml.h>
+#include <sc_bin_res.h>
+#include <sc_search_res.h>
+using std::string;
+using std::ios_base;
+using std::ofstream;
+using std::vector;
+using std::map;
+
+namespace {
+class BinaryResultsStrings {
+	map <string, int> index;
+	StringVector strings;
+public:
+	int add ( const string& s )
+	{
+		map <string, int>::iterator cur = index.find ( s );
+		if ( cur != index.end () ) return cur->second;
+		int idx = strings.size ();
+		index [s] = idx;
+		strings.push_back ( s );
+		return idx;
+	}
+	GENINT64 size () const { return strings.size (); }
+	GENINT64 getNumBytes () const
+	{
+		GENINT64 n = 0;
+		for ( StringVectorSizeType i = 0 ; i < strings.size () ; i++ ) n += strings [i].length () + 1;
+		return n;
+	}
+	void write ( ofstream& ost ) const
+	{
+		GENINT64 offset = 0;
+		for ( StringVectorSizeType i = 0 ; i < strings.size () ; i++ ) {
+			ost.write ( (char*) &offset, sizeof (GENINT64) );
+			offset += strings [i].length () + 1;
+		}
+		for ( StringVectorSizeType j = 0 ; j < strings.size () ; j++ ) {
+			ost.write ( strings [j].c_str (), strings [j].length () + 1 );
+		}
+	}
+};
+// The line columns hold the values of the readBlock variables after each line has been read.
+class BinaryResultsLines {
+public:
+	DoubleVector error;
+	DoubleVector score;
+	IntVector rank;
+	IntVector numUnmatched;
+	IntVector startAA;
+	IntVector nTerm;
+	IntVector peptide;
+	IntVector cTerm;
+	IntVector neutralLoss;
+	IntVector scoreDiff;
+	IntVector accNum;
+	string type;
+	GENINT64 size () const { return type.size (); }
+	template <class T> static void writeColumn ( ofstream& ost, const vector <T>& v )
+	{
+		if ( !v.empty () ) ost.write ( (char*) &v [0], v.size () * sizeof (T) );
+	}
+	void write ( ofstream& ost ) const
+	{
+		writeColumn ( ost, error );
+		writeColumn ( ost, score );
+		writeColumn ( ost, rank );
+		writeColumn ( ost, numUnmatched );
+		writeColumn ( ost, startAA );
+		writeColumn ( ost, nTerm );
+		writeColumn ( ost, peptide );
+		writeColumn ( ost, cTerm );
+		writeColumn ( ost, neutralLoss );
+		writeColumn ( ost, scoreDiff );
+		writeColumn ( ost, accNum );
+		ost.write ( type.c_str (), type.size () );
+		string pad ( getPad ( type.size () ), 0 );
+		ost.write ( pad.c_str (), pad.size () );
+	}
+	static GENINT64 getPad ( GENINT64 n ) { return ( 8 - n % 8 ) % 8; }
+	static GENINT64 getNumBytes ( GENINT64 n )
+	{
+		return n * ( 2 * sizeof (double) + 9 * sizeof (int) + 1 ) + getPad ( n );
+	}
+};
+// Returns false if the block can't be stored in the binary file (crosslinked results).
+bool readBinaryResultsBlock ( string& spec, bool noExpectation, vector <BinaryResultsSpectrum>& spectra, BinaryResultsLines& lines, BinaryResultsStrings& strs )
+{
+	string::size_type start = 0;
+	string::size_type end;
+	BinaryResultsSpectrum brs;
+	memset ( &brs, 0, sizeof (BinaryResultsSpectrum) );
+	brs.specID = strs.add ( genNextString ( spec, "\t", start, end ) );
+	brs.numPeaks = genNextInt ( spec, "\t", start, end );
+	brs.mOverZ = genNextDouble ( spec, "\t", start, end );
+	brs.charge = genNextInt ( spec, "\t", start, end );
+	brs.intensity = genNextDouble ( spec, "\r\n", start, end );
+	if ( spec [start] == '\n' ) start++;
+	if ( !noExpectation ) {
+		brs.a = genNextDouble ( spec, "\t", start, end );
+		brs.b = genNextDouble ( spec, "\t", start, end );
+		brs.numSpectra = genNextInt ( spec, "\r\n", start, end );
+		if ( spec [start] == '\n' ) start++;
+	}
+	brs.firstLine = lines.size ();
+	int rank = 0;
+	int numUnmatched = 0;
+	double error = 0.0;
+	string nTerm;
+	string peptide;
+	string cTerm;
+	string neutralLoss;
+	int startAA = 0;
+	double score = 0.0;
+	string scoreDiff;
+	string accNum;
+	for ( ; ; ) {
+		string s = genNextString ( spec, "\t", start, end );
+		if ( end == string::npos ) break;
+		char type;
+		if ( s [0] == '+' ) {
+			type = '+';
+			startAA = atoi ( s.substr ( 1 ).c_str () );
+			accNum = genNextString ( spec, "\r\n", start, end );
+		}
+		else if ( s [0] == 'M' ) {
+			type = 'M';
+			numUnmatched = genNextInt ( spec, "\t", start, end );
+			SearchResults::getPeptideFromResults ( spec, start, nTerm, peptide, cTerm, neutralLoss );
+			score = genNextDouble ( spec, "\r\n", start, end );
+		}
+		else if ( s [0] == 'X' ) return false;
+		else {
+			type = 'R';
+			rank = atoi ( s.c_str () );
+			numUnmatched = genNextInt ( spec, "\t", start, end );
+			error = genNextDouble ( spec, "\t", start, end );
+			SearchResults::getPeptideFromResults ( spec, start, nTerm, peptide, cTerm, neutralLoss );
+			startAA = genNextInt ( spec, "\t", start, end );
+			score = genNextDouble ( spec, "\t", start, end );
+			scoreDiff = genNextString ( spec, "\t", start, end );
+			accNum = genNextString ( spec, "\r\n", start, end );
+		}
+		if ( spec [start] == '\n' ) start++;
+		lines.type += type;
+		lines.error.push_back ( error );
+		lines.score.push_back ( score );
+		lines.rank.push_back ( rank );
+		lines.numUnmatched.push_back ( numUnmatched );
+		lines.startAA.push_back ( startAA );
+		lines.nTerm.push_back ( strs.add ( nTerm ) );
+		lines.peptide.push_back ( strs.add ( peptide ) );
+		lines.cTerm.push_back ( strs.add ( cTerm ) );
+		lines.neutralLoss.push_back ( strs.add ( neutralLoss ) );
+		lines.scoreDiff.push_back ( strs.add ( scoreDiff ) );
+		lines.accNum.push_back ( strs.add ( accNum ) );
+	}
+	brs.numLines = lines.size () - brs.firstLine;
+	spectra.push_back ( brs );
+	return true;
+}
+}
+
+const char* BinaryResults::MAGIC = "PPBTRES1";
+const int BinaryResults::VERSION = 1;
+
+BinaryResults::BinaryResults ( const string& fname ) :
+	file ( 0 )
+{
+	string binFile = getFilename ( fname );
+	file = new MMapFile <char> ( binFile, 0, genFileSize ( binFile ), MMAP_ADVICE_SEQUENTIAL );
+	const char* p = file->getStartPointer ();
+	header = (const BinaryResultsHeader*) p;
+	p += sizeof (BinaryResultsHeader) + header->numParts * sizeof (BinaryResultsPart);
+	spectra = (const BinaryResultsSpectrum*) p;
+	p += header->numSpectra * sizeof (BinaryResultsSpectrum);
+	GENINT64 n = header->numLines;
+	error = (const double*) p;			p += n * sizeof (double);
+	score = (const double*) p;			p += n * sizeof (double);
+	rank = (const int*) p;				p += n * sizeof (int);
+	numUnmatched = (const int*) p;		p += n * sizeof (int);
+	startAA = (const int*) p;			p += n * sizeof (int);
+	nTerm = (const int*) p;				p += n * sizeof (int);
+	peptide = (const int*) p;			p += n * sizeof (int);
+	cTerm = (const int*) p;				p += n * sizeof (int);
+	neutralLoss = (const int*) p;		p += n * sizeof (int);
+	scoreDiff = (const int*) p;			p += n * sizeof (int);
+	accNum = (const int*) p;			p += n * sizeof (int);
+	type = p;							p += n + BinaryResultsLines::getPad ( n );
+	stringOffsets = (const GENINT64*) p;
+	p += header->numStrings * sizeof (GENINT64);
+	strings = p;
+}
+BinaryResults::~BinaryResults ()
+{
+	delete file;
+}
+StringVector BinaryResults::getPartFilenames ( const string& fname )
+{
+	StringVector parts;
+	if ( genFileExists ( fname ) ) parts.push_back ( fname );
+	else {
+		for ( int i = 0 ; ; i++ ) {
+			string f = fname + string ( "_" ) + gen_itoa ( i );
+			if ( genFileExists ( f ) ) parts.push_back ( f );
+			else break;
+		}
+	}
+	return parts;
+}
+void BinaryResults::initHeader ( BinaryResultsHeader& header, const StringVector& parts, bool noExpectation )
+{
+	memset ( &header, 0, sizeof (BinaryResultsHeader) );
+	memcpy ( header.magic, MAGIC, sizeof (header.magic) );
+	header.version = VERSION;
+	header.noExpectation = noExpectation;
+	header.numParts = parts.size ();
+}
+bool BinaryResults::checkHeader ( const string& fname, const StringVector& parts, bool noExpectation )
+{
+	string binFile = getFilename ( fname );
+	if ( !genFileExists ( binFile ) ) return false;
+	GENINT64 binSize = genFileSize ( binFile );
+	if ( binSize < sizeof (BinaryResultsHeader) ) return false;
+	BinaryResultsHeader header;
+	initHeader ( header, parts, noExpectation );
+	BinaryResultsHeader h;
+	GenIFStream ist ( binFile, ios_base::binary );
+	ist.read ( (char*) &h, sizeof (BinaryResultsHeader) );
+	if ( ist.fail () ) return false;
+	if ( memcmp ( h.magic, header.magic, sizeof (h.magic) ) ) return false;
+	if ( h.version != header.version ) return false;
+	if ( h.noExpectation != header.noExpectation ) return false;
+	if ( h.numParts != header.numParts ) return false;
+	for ( StringVectorSizeType i = 0 ; i < parts.size () ; i++ ) {
+		BinaryResultsPart brp;
+		ist.read ( (char*) &brp, sizeof (BinaryResultsPart) );
+		if ( ist.fail () ) return false;
+		if ( brp.size != genFileSize ( parts [i] ) ) return false;
+		if ( brp.modifyTime != genLastModifyTime ( parts [i] ) ) return false;
+	}
+	GENINT64 size = sizeof (BinaryResultsHeader);
+	size += h.numParts * sizeof (BinaryResultsPart);
+	size += h.numSpectra * sizeof (BinaryResultsSpectrum);
+	size += BinaryResultsLines::getNumBytes ( h.numLines );
+	size += h.numStrings * sizeof (GENINT64) + h.stringBytes;
+	return binSize == size;
+}
+bool BinaryResults::write ( const string& fname, const StringVector& parts, bool noExpectation )
+{
+	vector <BinaryResultsSpectrum> spectra;
+	BinaryResultsLines lines;
+	BinaryResultsStrings strs;
+	for ( StringVectorSizeType i = 0 ; i < parts.size () ; i++ ) {
+		GenIFStream ist ( parts [i] );
+		if ( i == 0 ) {
+			XMLIStreamList xstr ( ist, "parameters" );
+			string pStr;
+			xstr.getNext ( pStr );
+		}
+		XMLIStreamList xstr ( ist, "d" );
+		for ( ; ; ) {
+			string spec;
+			if ( xstr.getNextBlock ( spec ) ) {
+				if ( !readBinaryResultsBlock ( spec, noExpectation, spectra, lines, strs ) ) return false;
+			}
+			else break;
+		}
+	}
+	string binFile = getFilename ( fname );
+	string tempFile = binFile + "." + gen_itoa ( getpid () ) + ".tmp";	// Another process may be creating the same file
+	ofstream ost ( tempFile.c_str (), ios_base::binary );
+	if ( !ost ) return false;			// The results directory may not be writable
+	BinaryResultsHeader header;
+	initHeader ( header, parts, noExpectation );
+	header.numSpectra = spectra.size ();
+	header.numLines = lines.size ();
+	header.numStrings = strs.size ();
+	header.stringBytes = strs.getNumBytes ();
+	ost.write ( (char*) &header, sizeof (BinaryResultsHeader) );
+	for ( StringVectorSizeType j = 0 ; j < parts.size () ; j++ ) {
+		BinaryResultsPart brp;
+		brp.size = genFileSize ( parts [j] );
+		brp.modifyTime = genLastModifyTime ( parts [j] );
+		ost.write ( (char*) &brp, sizeof (BinaryResultsPart) );
+	}
+	BinaryResultsLines::writeColumn ( ost, spectra );
+	lines.write ( ost );
+	strs.write ( ost );
+	ost.close ();
+	if ( ost.fail () ) {
+		genUnlink ( tempFile );
+		return false;
+	}
+	genRename ( tempFile, binFile );
+	return true;
+}
+bool BinaryResults::update ( const string& fname, bool noExpectation )
+{
+	if ( !InfoParams::instance ().getBoolValue ( "search_compare_binary_results", true ) ) return false;
+	StringVector parts = getPartFilenames ( fname );
+	if ( parts.empty () ) return false;
+	if ( checkHeader ( fname, parts, noExpectation ) ) return true;
+	if ( !write ( fname, parts, noExpectation ) ) return false;
+	return checkHeader ( fname, parts, noExpectation );
+}
+BinaryResults* BinaryResults::getResults ( const string& fname, bool noExpectation )
+{
+	if ( !update ( fname, noExpectation ) ) return 0;
+	return new BinaryResults ( fname );
+}
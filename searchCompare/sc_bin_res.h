@@ -0,0 +1,129 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : searchCompare                                                 *
+*                                                                             *
+*  Filename   : sc_bin_res.h                                                  *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Binary copy of the spectrum results in a Batch-Tag results    *
+*               file.                                                         *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __sc_bin_res_h
+#define __sc_bin_res_h
+
+#include <string>
+#include <lgen_define.h>
+
+template <class T> class MMapFile;
+
+struct BinaryResultsHeader {
+	char magic [8];
+	int version;
+	int noExpectation;		// Set if the results have no expectation value line
+	int numParts;			// Number of results files (the results can be split into <name>_0, <name>_1, ...)
+	int pad;
+	GENINT64 numSpectra;
+	GENINT64 numLines;
+	GENINT64 numStrings;
+	GENINT64 stringBytes;
+};
+
+struct BinaryResultsPart {	// Size and modification time of each results file
+	GENINT64 size;
+	GENINT64 modifyTime;
+};
+
+struct BinaryResultsSpectrum {
+	double mOverZ;
+	double intensity;
+	double a;				// Expectation value parameters
+	double b;
+	int specID;				// String table index
+	int numPeaks;
+	int charge;
+	int numSpectra;
+	GENINT64 firstLine;
+	int numLines;
+	int pad;
+};
+
+/*
+The binary results are written to <results file>.bin the first time Search Compare reads
+a set of results. The file contains:
+
+	BinaryResultsHeader
+	BinaryResultsPart records
+	BinaryResultsSpectrum records in results file order.
+	The hit line columns, each with numLines entries:
+		double error, double score,
+		int rank, int numUnmatched, int startAA,
+		int nTerm, int peptide, int cTerm, int neutralLoss, int scoreDiff, int accNum (string table indicies),
+		char type ('R' ranked hit, 'M' modification hit, '+' extra accession number)
+	GENINT64 string offsets (8 byte aligned).
+	The strings, each null terminated.
+
+The file is memory mapped so no text is parsed when the results are read. Crosslinked
+search results aren't converted and are always read from the results file.
+*/
+class BinaryResults {
+	MMapFile <char>* file;
+	const BinaryResultsHeader* header;
+	const BinaryResultsSpectrum* spectra;
+	const double* error;
+	const double* score;
+	const int* rank;
+	const int* numUnmatched;
+	const int* startAA;
+	const int* nTerm;
+	const int* peptide;
+	const int* cTerm;
+	const int* neutralLoss;
+	const int* scoreDiff;
+	const int* accNum;
+	const char* type;
+	const GENINT64* stringOffsets;
+	const char* strings;
+	static const char* MAGIC;
+	static const int VERSION;
+	static void initHeader ( BinaryResultsHeader& header, const StringVector& parts, bool noExpectation );
+	static bool checkHeader ( const std::string& fname, const StringVector& parts, bool noExpectation );
+	static bool write ( const std::string& fname, const StringVector& parts, bool noExpectation );
+public:
+	BinaryResults ( const std::string& fname );
+	~BinaryResults ();
+	GENINT64 getNumSpectra () const { return header->numSpectra; }
+	const BinaryResultsSpectrum& getSpectrum ( GENINT64 i ) const { return spectra [i]; }
+	char getType ( GENINT64 j ) const { return type [j]; }
+	double getError ( GENINT64 j ) const { return error [j]; }
+	double getScore ( GENINT64 j ) const { return score [j]; }
+	int getRank ( GENINT64 j ) const { return rank [j]; }
+	int getNumUnmatched ( GENINT64 j ) const { return numUnmatched [j]; }
+	int getStartAA ( GENINT64 j ) const { return startAA [j]; }
+	const char* getNTerm ( GENINT64 j ) const { return getString ( nTerm [j] ); }
+	const char* getPeptide ( GENINT64 j ) const { return getString ( peptide [j] ); }
+	const char* getCTerm ( GENINT64 j ) const { return getString ( cTerm [j] ); }
+	const char* getNeutralLoss ( GENINT64 j ) const { return getString ( neutralLoss [j] ); }
+	const char* getScoreDiff ( GENINT64 j ) const { return getString ( scoreDiff [j] ); }
+	const char* getAccNum ( GENINT64 j ) const { return getString ( accNum [j] ); }
+	const char* getString ( int idx ) const { return strings + stringOffsets [idx]; }
+
+	static std::string getFilename ( const std::string& fname ) { return fname + ".bin"; }
+	static StringVector getPartFilenames ( const std::string& fname );
+	static bool update ( const std::string& fname, bool noExpectation );
+	static BinaryResults* getResults ( const std::string& fname, bool noExpectation );
+};
+
+#endif /* ! __sc_bin_res_h */
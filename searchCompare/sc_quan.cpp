@@ -109,7 +109,7 @@ PeakFitData* PeptidePositionQuan::getQuanRatio ( double mOverZ, int charge, cons
 		}
 	}
 	if ( quanMSMSFlag ) {
-		if ( rawTypes [searchIndex][fraction-1] == WIFF || rawTypes [searchIndex][fraction-1] == RAW || rawTypes [searchIndex][fraction-1] == "" )
+		if ( rawTypes [searchIndex][fraction-1] == WIFF || rawTypes [searchIndex][fraction-1] == RAW || rawTypes [searchIndex][fraction-1] == MZML || rawTypes [searchIndex][fraction-1] == "" )
 			quanRatio = new QuantitationMultiMassWindow ( vXYData [0] );
 		else
 			quanRatio = new QuantitationMultiNormal ( vXYData [0], defaultResolution );
@@ -0,0 +1,115 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : searchCompare                                                 *
+*                                                                             *
+*  Filename   : sc_res_load.cpp                                               *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Concurrent loading of the results files being compared.       *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <iostream>
+#include <stdexcept>
+#include <lg_string.h>
+#include <lgen_file.h>
+#include <lgen_thread.h>
+#include <lu_getfil.h>
+#include <lu_param_list.h>
+#include <lu_proj_file.h>
+#include <lu_html.h>
+#include <sc_bin_res.h>
+#include <sc_res_load.h>
+using std::string;
+using std::vector;
+using std::runtime_error;
+using std::cout;
+
+vector <SearchResultsLoader::Item*> SearchResultsLoader::items;
+SearchResultsLoader::MapExpNameItemPtr SearchResultsLoader::expItems;
+
+class SearchResultsLoadThread : public GenThread {
+	GenMutex& mutex;
+	int& next;
+	void run ();
+public:
+	SearchResultsLoadThread ( GenMutex& mutex, int& next ) :
+		mutex ( mutex ),
+		next ( next ) {}
+};
+void SearchResultsLoadThread::run ()
+{
+	for ( ; ; ) {
+		int i;
+		{
+			GenMutexLock lock ( mutex );
+			if ( next >= SearchResultsLoader::items.size () ) return;
+			i = next++;
+		}
+		try {
+			SearchResultsLoader::items [i]->load ();
+		}
+		catch ( runtime_error ) {}	// The file is read again when the SearchResults object is created
+	}
+}
+void SearchResultsLoader::Item::load ()
+{
+	BinaryResults::update ( fname, noExpectation );
+	if ( !noExpectation ) eValueFlag = SearchResults::getEValues ( expName, mievi, false );
+}
+void SearchResultsLoader::load ( const StringVector& fnames )
+{
+	int numThreads = InfoParams::instance ().getIntValue ( "search_compare_num_threads", 1 );
+	if ( numThreads == 0 ) numThreads = genGetNumProcessors ();
+	numThreads = genMin ( numThreads, (int)fnames.size () );
+	if ( numThreads <= 1 ) return;
+	for ( StringVectorSizeType i = 0 ; i < fnames.size () ; i++ ) {
+		StringVector parts = BinaryResults::getPartFilenames ( fnames [i] );
+		if ( parts.empty () ) continue;								// Reported when the SearchResults object is created
+		ParameterList pList ( parts [0], false, false, false, false );	// The parameters are at the start of the first file
+		string expName = getProjectDir ( &pList ) + SLASH + pList.getStringValue ( "expect_coeff_file" ) + ".xml";
+		bool noExpectation = pList.getStringValue ( "expect_calc_method", "None" ) == "None";
+		Item* item = new Item ( fnames [i], expName, noExpectation );
+		items.push_back ( item );
+		if ( !noExpectation ) expItems [expName] = item;
+	}
+	ujm->writeMessage ( cout, "Reading " + gen_itoa ( items.size () ) + " results files with " + gen_itoa ( numThreads ) + " threads" );
+	GenMutex mutex;
+	int next = 0;
+	vector <SearchResultsLoadThread*> threads;
+	for ( int j = 0 ; j < numThreads ; j++ ) {
+		threads.push_back ( new SearchResultsLoadThread ( mutex, next ) );
+		threads.back ()->start ();
+	}
+	for ( int k = 0 ; k < numThreads ; k++ ) {
+		threads [k]->join ();
+		delete threads [k];
+	}
+}
+bool SearchResultsLoader::getEValues ( const string& expName, MapIDExpectationValueInfo& mievi, bool& eValueFlag )
+{
+	MapExpNameItemPtr::iterator cur = expItems.find ( expName );
+	if ( cur == expItems.end () ) return false;
+	eValueFlag = cur->second->eValueFlag;
+	mievi.swap ( cur->second->mievi );
+	expItems.erase ( cur );
+	return true;
+}
+void SearchResultsLoader::deleteItems ()	// Called once the SearchResults objects have been created
+{
+	for ( int i = 0 ; i < items.size () ; i++ ) {
+		delete items [i];
+	}
+	items.clear ();
+	expItems.clear ();
+}
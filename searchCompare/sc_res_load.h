@@ -0,0 +1,71 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : searchCompare                                                 *
+*                                                                             *
+*  Filename   : sc_res_load.h                                                 *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Concurrent loading of the results files being compared.       *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+
+#ifndef __sc_res_load_h
+#define __sc_res_load_h
+
+#include <map>
+#include <string>
+#include <lgen_define.h>
+#include <sc_search_res.h>
+
+class SearchResultsLoadThread;
+
+/*
+The SearchResults objects share a lot of static state so they are still created one after
+another. Before this happens the loader reads the files for each search with a pool of
+search_compare_num_threads threads. Each thread:
+
+	Creates or validates the binary copy of the results (see sc_bin_res.h).
+	Reads the expectation value coefficient file.
+
+SearchResults then maps the binary results and picks up the expectation values with
+getEValues rather than parsing the text files itself. The hits for each spectrum are still
+read from the binary results (readBinaryBlock) in the serial part as this updates the
+static state. The items are deleted once all the SearchResults objects have been created.
+*/
+class SearchResultsLoader {
+	friend class SearchResultsLoadThread;
+	class Item {
+	public:
+		std::string fname;
+		std::string expName;
+		bool noExpectation;
+		bool eValueFlag;
+		MapIDExpectationValueInfo mievi;
+		Item ( const std::string& fname, const std::string& expName, bool noExpectation ) :
+			fname ( fname ),
+			expName ( expName ),
+			noExpectation ( noExpectation ),
+			eValueFlag ( false ) {}
+		void load ();
+	};
+	typedef std::map <std::string, Item*> MapExpNameItemPtr;
+	static std::vector <Item*> items;
+	static MapExpNameItemPtr expItems;
+public:
+	static void load ( const StringVector& fnames );
+	static bool getEValues ( const std::string& expName, MapIDExpectationValueInfo& mievi, bool& eValueFlag );
+	static void deleteItems ();
+};
+
+#endif /* ! __sc_res_load_h */
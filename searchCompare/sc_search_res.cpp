@@ -24,6 +24,7 @@
 #endif
 #define SEARCH_RES_MAIN
 #include <cmath>
+#include <lg_memory.h>
 #include <lg_stdlib.h>
 #include <lg_time.h>
 #include <lgen_file.h>
@@ -34,6 +35,7 @@
 #include <lu_app_gr.h>
 #include <lu_check_db.h>
 #include <lu_prod_par.h>
+#include <lu_prod_batch.h>
 #include <lu_get_link.h>
 #include <lu_html.h>
 #include <lu_html_form.h>
@@ -57,9 +59,11 @@
 #include <lu_species.h>
 #include <lu_srch_form.h>
 #include <sc_anum_res.h>
+#include <sc_bin_res.h>
 #include <sc_search_res.h>
 #include <sc_mzidentml.h>
 #include <sc_quan.h>
+#include <sc_res_load.h>
 #include <sc_xlink.h>
 using namespace FileTypes;
 using std::vector;
@@ -79,6 +83,10 @@ using std::back_inserter;
 using std::merge;
 using std::make_pair;
 
+namespace {
+GenArena hitArena;		// Spectrum and hit objects for all the searches. These are kept until the program exits.
+}
+
 IntVector ProteinInfo::dbIdx;
 MapStringToInt ProteinInfo::dbNameMap;
 vector <FastaServer*> ProteinInfo::fs;
@@ -695,6 +703,7 @@ void ProteinInfo::deleteTempDirs ()
 	}
 }
 MapStringToDouble HitPeptide::msd;
+MapStringToHitPeptide HitPeptide::hitPeptides;
 HitPeptide::HitPeptide ( const string& nTerm, const string& peptide, const string& cTerm, const string& neutralLoss ) :
 	nTerm ( nTerm ),
 	peptide ( peptide ),
@@ -727,6 +736,15 @@ HitPeptide::HitPeptide ( const string& nTerm, const string& peptide, const strin
 	mmod = mmod || ( !cTerm.empty () && genIsNumberStart ( cTerm [0] ) );
 	mmod = mmod || ( !neutralLoss.empty () && genIsNumberStart ( neutralLoss [0] ) );
 }
+const HitPeptide* HitPeptide::getHitPeptide ( const string& nTerm, const string& peptide, const string& cTerm, const string& neutralLoss )
+{
+	string key = nTerm + '\t' + peptide + '\t' + cTerm + '\t' + neutralLoss;	// The fields can't contain tabs
+	MapStringToHitPeptide::iterator cur = hitPeptides.find ( key );
+	if ( cur == hitPeptides.end () ) {
+		cur = hitPeptides.insert ( make_pair ( key, HitPeptide ( nTerm, peptide, cTerm, neutralLoss ) ) ).first;
+	}
+	return &cur->second;
+}
 string HitPeptide::getBlibPeptide () const
 {
 	string bPep;
@@ -1025,11 +1043,12 @@ bool PeptidePosition::reportComposition = false;
 bool PeptidePosition::reportMModValue = false;
 bool PeptidePosition::reportLinks = false;
 bool PeptidePosition::runMSProductFlag = false;
+SetString PeptidePosition::accessionNumbers;
 double PeptidePosition::rtIntervalStart = 0.0;
 double PeptidePosition::rtIntervalEnd = 0.0;
 const double PeptidePosition::INVALID_ERROR = std::numeric_limits<double>::infinity();
 PeptidePosition::PeptidePosition ( const string& accessionNumber, const HitPeptide* hitPeptide, double error, const SpecID* spID, const MSMSSpectrumInfo* mmsi, int startAA, int searchIndex ) :
-	accessionNumber ( accessionNumber ),
+	accessionNumber ( getAccessionNumberPtr ( accessionNumber ) ),
 	hitPeptide ( hitPeptide ),
 	error ( error ),
 	startAA ( startAA ),
@@ -1042,6 +1061,7 @@ PeptidePosition::PeptidePosition ( const string& accessionNumber, const HitPepti
 	setSpectrumNumber ( spID, searchIndex );
 }
 PeptidePosition::PeptidePosition ( const SpecID* spID, const MSMSSpectrumInfo* mmsi, int searchIndex ) :
+	accessionNumber ( getAccessionNumberPtr ( "" ) ),
 	specID ( spID ),
 	mmsi ( mmsi ),
 	hitPeptide ( 0 ),
@@ -1052,6 +1072,10 @@ PeptidePosition::PeptidePosition ( const SpecID* spID, const MSMSSpectrumInfo* m
 	setSpectrumNumber ( spID, searchIndex );
 	error = INVALID_ERROR;
 }
+const string* PeptidePosition::getAccessionNumberPtr ( const string& accessionNumber )
+{
+	return &(*accessionNumbers.insert ( accessionNumber ).first);
+}
 void PeptidePosition::setSpectrumNumber ( const SpecID* spID, int searchIndex )
 {
 	if ( spID ) {
@@ -1132,9 +1156,9 @@ bool PeptidePosition::checkComposition () const
 }
 bool PeptidePosition::isDecoyHit () const
 {
-	if ( accessionNumber.empty () ) return false;
+	if ( accessionNumber->empty () ) return false;
 	else {
-		PairIntString pis = ProteinInfo::getANumPair ( accessionNumber );
+		PairIntString pis = ProteinInfo::getANumPair ( *accessionNumber );
 		int idx = pis.first;
 		string an = pis.second;
 		if ( an [0] != '-' && ProteinInfo::getNonDecoyFlag ( idx ) )
@@ -1841,55 +1865,37 @@ void PeptidePosition::runMSProduct ( int i, double score ) const
 	idx++;
 	string scoreStr = gen_ftoa ( score, "%.1f" );
 	string outputFilename =  gen_itoa ( idx ) + "_" + stripFilenameChars ( getPeptide () ) + "_" + scoreStr + "_" + gen_itoa ( getCharge () );
-	PPTempFile tempFile ( "msprod", ".txt" );
-	string tempFileFullPath = tempFile.getFullPath ();
-
-	string command;
-#ifdef VIS_C
-	command += "\"";
-#endif
-	command += getSystemCall ( "mssearch.cgi" );
-	command += " - ";
-	command += getCommandLineNVPair ( "search_name", "msproduct" );
-	command += " ";
-	command += getCommandLineNVPair ( "output_filename", outputFilename );
-	command += " ";
-	command += getCommandLineNVPair ( "results_to_file", "1" );
-	command += " ";
-	command += getCommandLineNVPair ( "output_type", "XML" );
-	command += " ";
-	command += getCommandLineNVPair ( "report_title", "MS-Product" );
-	command += " ";
-	command += getCommandLineNVPair ( "version", Version::instance ().getVersion () );
-	command += " ";
-	command += getCommandLineNVPair ( "data_source", "List of Files" );
-	command += " ";
-	command += getCommandLineNVPair ( "use_instrument_ion_types", "1" );
-	command += " ";
-	command += getCommandLineNVPair ( "search_key", searchKey [i] );
-	command += " ";
-	command += getCommandLineNVPair ( "instrument_name", instrument [i] );
-	command += " ";
-	command += parentTolerances [i]->getCommandLineNVPair ( "msms_parent_mass" );
-	command += fragmentTolerances [i]->getCommandLineNVPair ( "fragment_masses" );
-	command += getCommandLineNVPair ( "parent_mass_convert", "monoisotopic" );
-	command += " ";
-	command += specID->getCommandLineNVPair ();
-	command += getCommandLineNVPair ( "max_charge", mmsi->getCharge () );
-	command += " ";
-	command += hitPeptide->getCommandLineNVPair ( 1 );
-	command += MSMSPeakFilterOptions::getCommandLineNVPair ( ProgramLink::getParams () );
-	command += "> ";
-#ifdef VIS_C
-	command += "\"" + tempFileFullPath + "\"";
-#else
-	command += tempFileFullPath;
-#endif
-#ifdef VIS_C
-	command +=  "\"";
-#endif
-	genSystem ( command, "", true );
-	genUnlink ( tempFileFullPath );
+	string args;
+	args += getCommandLineNVPair ( "search_name", "msproduct" );
+	args += " ";
+	args += getCommandLineNVPair ( "output_filename", outputFilename );
+	args += " ";
+	args += getCommandLineNVPair ( "results_to_file", "1" );
+	args += " ";
+	args += getCommandLineNVPair ( "output_type", "XML" );
+	args += " ";
+	args += getCommandLineNVPair ( "report_title", "MS-Product" );
+	args += " ";
+	args += getCommandLineNVPair ( "version", Version::instance ().getVersion () );
+	args += " ";
+	args += getCommandLineNVPair ( "data_source", "List of Files" );
+	args += " ";
+	args += getCommandLineNVPair ( "use_instrument_ion_types", "1" );
+	args += " ";
+	args += getCommandLineNVPair ( "search_key", searchKey [i] );
+	args += " ";
+	args += getCommandLineNVPair ( "instrument_name", instrument [i] );
+	args += " ";
+	args += parentTolerances [i]->getCommandLineNVPair ( "msms_parent_mass" );
+	args += fragmentTolerances [i]->getCommandLineNVPair ( "fragment_masses" );
+	args += getCommandLineNVPair ( "parent_mass_convert", "monoisotopic" );
+	args += " ";
+	args += specID->getCommandLineNVPair ();
+	args += getCommandLineNVPair ( "max_charge", mmsi->getCharge () );
+	args += " ";
+	args += hitPeptide->getCommandLineNVPair ( 1 );
+	args += MSMSPeakFilterOptions::getCommandLineNVPair ( ProgramLink::getParams () );
+	MSProductBatch::instance ().add ( args );
 }
 void PeptidePosition::initialise ( const SearchResultsPtrVector& searchResults )
 {
@@ -2119,6 +2125,10 @@ PeptideSpectralInfo::PeptideSpectralInfo ( int unmatched, int numPeaks, int rank
 	b ( b )
 {
 }
+void* PeptideSpectralInfo::operator new ( size_t size )
+{
+	return hitArena.allocate ( size );
+}
 void PeptideSpectralInfo::setExpectationFlag ( const string& expectationCalculationType )
 {
 	noExpectation = ( expectationCalculationType == "None" );
@@ -2298,6 +2308,10 @@ void PPPeptideHitInfo::printDelimited ( ostream& os ) const
 		if ( reportRepeats )	delimitedEmptyCell ( os );
 	}
 }
+void* SearchResultsPeptideHit::operator new ( size_t size )
+{
+	return hitArena.allocate ( size );
+}
 SearchResultsPeptideHit::SearchResultsPeptideHit ( const SpecID* spID, const MSMSSpectrumInfo* mmsi, int searchIndex ) :
 	peptidePosition ( spID, mmsi, searchIndex )
 {
@@ -3335,7 +3349,7 @@ string SearchResults::getMapTagHits ( MapIDMapAccNoAndVectorSearchResultsPeptide
 			iv = ProteinInfo::initialise ( pList );
 			string outputDir = getProjectDir ( pList );
 			expName = outputDir + SLASH + pList->getStringValue  ( "expect_coeff_file" ) + ".xml";
-			eValueFlag = getEValues ( expName, mievi );
+			if ( !SearchResultsLoader::getEValues ( expName, mievi, eValueFlag ) ) eValueFlag = getEValues ( expName, mievi );
 			PeptidePosition::initialiseParams ( pList );
 			ExtraUserMods::instance ().addUserMods2 ( pList, ExtraUserModsForm::getNumUserMods () );
 			SCModInfo::init ( numSearches, pList->getStringVectorValue ( "const_mod" ), modificationScoreThreshold );
@@ -3359,6 +3373,16 @@ string SearchResults::getMapTagHits ( MapIDMapAccNoAndVectorSearchResultsPeptide
 			linkInfo = new LinkInfo ( pList );
 
 			databaseResults = new DatabaseResults ( pList->getStringVectorValue ( "database" ), ist );
+			BinaryResults* br = BinaryResults::getResults ( fname, noExpectation );
+			if ( br ) {
+				ujm->writeMessage ( cout, "Reading results for each spectrum" );
+				for ( GENINT64 j = 0 ; j < br->getNumSpectra () ; j++ ) {
+					if ( ( j + 1 ) % 10000 == 0 ) ujm->writeMessage ( cout, "Reading results for each spectrum, " + gen_itoa ( j + 1 ) + " spectra" );
+					readBinaryBlock ( *br, j, mapTagHits, multisample, idFilterSet, idFilter, eValueFlag, mievi, expName, linearTailFitExpectation, minPeptideScore, maxPeptideEValue, iv );
+				}
+				delete br;
+				break;
+			}
 		}
 		ujm->writeMessage ( cout, "Reading results for each spectrum" );
 		XMLIStreamList xstr ( ist, "d" );
@@ -3377,121 +3401,168 @@ string SearchResults::getMapTagHits ( MapIDMapAccNoAndVectorSearchResultsPeptide
 	//sortCLinkPeptideLines ( "" );
 	return instrument;
 }
-void SearchResults::readBlock ( string& spec, MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, bool multisample, const SetInt& idFilterSet, bool idFilter, bool eValueFlag, MapIDExpectationValueInfo& mievi, const string& expName, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, double xlMinLowScore, double xlMinScoreDiff, double xlMaxLowExpectation, const IntVector& iv )
-{
-	bool idFilterSetFlag = !idFilterSet.empty ();
-	string::size_type start = 0;
-	string::size_type end;
-	string specID = genNextString ( spec, "\t", start, end );
+class SearchResultsBlock {	// Values shared by the results lines for a spectrum
+public:
+	string specID;
 	string spotID;
-	SpecID sid ( specID );
+	MSMSSpectrumInfo* mmsi;
+	int numPeaks;
+	double a;
+	double b;
+	int numSpectra;
+	bool idFilter;
+	bool diskFlag;
+	SpecID* spID;
+	const HitPeptide* hitPeptide;
+	PeptideSpectralInfo* psi;
+	double expectation;
+	SCModInfo scmi;
+	SearchResultsBlock ( const string& specID, int numPeaks, bool idFilter, bool diskFlag ) :
+		specID ( specID ),
+		mmsi ( 0 ),
+		numPeaks ( numPeaks ),
+		a ( 0.0 ),
+		b ( 0.0 ),
+		numSpectra ( 0 ),
+		idFilter ( idFilter ),
+		diskFlag ( diskFlag ),
+		spID ( 0 ),
+		hitPeptide ( 0 ),
+		psi ( 0 ),
+		expectation ( 0.0 ) {}
+};
+void SearchResults::initBlock ( SearchResultsBlock& srb, double mOverZ, int charge, double intensity, bool multisample, const SetInt& idFilterSet )
+{
+	SpecID sid ( srb.specID );
 	if ( multisample ) {
-		if ( spottingPlate ) spotID = sid.getSpotID ();
-		else spotID = gen_itoa ( sid.getFraction () );
+		if ( spottingPlate ) srb.spotID = sid.getSpotID ();
+		else srb.spotID = gen_itoa ( sid.getFraction () );
 	}
 	else {
-		spotID = defaultID;
-		if ( idFilterSetFlag ) {
-			idFilter = idFilterSet.find ( sid.getFraction () ) != idFilterSet.end ();  
+		srb.spotID = defaultID;
+		if ( !idFilterSet.empty () ) {
+			srb.idFilter = idFilterSet.find ( sid.getFraction () ) != idFilterSet.end ();  
+		}
+	}
+	idSet.insert ( srb.spotID );
+	srb.mmsi = new MSMSSpectrumInfo ( mOverZ, charge, intensity, srb.numPeaks );
+	midmsi [srb.spotID][srb.specID] = srb.mmsi;
+}
+void SearchResults::setBlockExpectation ( SearchResultsBlock& srb, bool eValueFlag, const MapIDExpectationValueInfo& mievi, const string& expName )
+{
+	if ( !noExpectation && eValueFlag ) {
+		MapIDExpectationValueInfo::const_iterator cur = mievi.find ( srb.specID );
+		if ( cur != mievi.end () ) {
+			srb.a = (*cur).second.getGradient ();
+			srb.b = (*cur).second.getOffset ();
+		}
+		else {
+			ErrorHandler::genError ()->error ( "The expectation value file " + expName + " is incomplete.\n" + "SpecID: " + srb.specID + " not found.\n" );
 		}
 	}
-	idSet.insert ( spotID );
+}
+// A '+' line holds another protein for the previous peptide. An 'M' line holds a modified version of the
+// peptide which is only used for the site scores.
+void SearchResults::addBlockLine ( SearchResultsBlock& srb, char type, int rank, int numUnmatched, double error, const string& nTerm, const string& peptide, const string& cTerm, const string& neutralLoss, int startAA, double score, const string& scoreDiff, const string& accNum, MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, const IntVector& iv )
+{
+	bool mod = type == 'M';
+	if ( type != '+' ) {
+		srb.expectation = getEval ( score, srb.a, srb.b, srb.numSpectra, linearTailFitExpectation );
+		if ( !mod ) {
+			bool scoreFlag = score >= minPeptideScore && srb.expectation <= maxPeptideEValue;
+			if ( srb.diskFlag || scoreFlag ) {
+				srb.hitPeptide = HitPeptide::getHitPeptide ( nTerm, peptide, cTerm, neutralLoss );
+				srb.psi = new PeptideSpectralInfo ( numUnmatched, srb.numPeaks, rank, score, srb.expectation, scoreDiff, srb.numSpectra, srb.a, srb.b );
+			}
+		}
+		srb.scmi.addHit ( nTerm, peptide, cTerm, neutralLoss, score, srb.expectation, srb.numSpectra );
+	}
+	if ( !mod ) {
+		bool scoreFlag = score >= minPeptideScore && srb.expectation <= maxPeptideEValue && srb.idFilter;
+		if ( srb.diskFlag || scoreFlag ) {
+			if ( srb.spID == 0 ) srb.spID = new SpecID ( srb.specID );
+			string fullAccNum = getFullAccNum ( iv, accNum );
+			mapTagHits [srb.spotID][fullAccNum].push_back ( new SearchResultsPeptideHit ( srb.spID, srb.mmsi, srb.psi, error, srb.hitPeptide, startAA, fullAccNum, numSearches-1 ) );
+		}
+	}
+}
+void SearchResults::readBlock ( string& spec, MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, bool multisample, const SetInt& idFilterSet, bool idFilter, bool eValueFlag, MapIDExpectationValueInfo& mievi, const string& expName, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, double xlMinLowScore, double xlMinScoreDiff, double xlMaxLowExpectation, const IntVector& iv )
+{
+	string::size_type start = 0;
+	string::size_type end;
+	string specID = genNextString ( spec, "\t", start, end );
 	int numPeaks = genNextInt ( spec, "\t", start, end );
 	double mOverZ = genNextDouble ( spec, "\t", start, end );
 	int charge = genNextInt ( spec, "\t", start, end );
 	double intensity = genNextDouble ( spec, "\r\n", start, end );
 	if ( spec [start] == '\n' ) start++;
-	MSMSSpectrumInfo* mmsi = new MSMSSpectrumInfo ( mOverZ, charge, intensity, numPeaks );
-	midmsi [spotID][specID] = mmsi;
-	double a = 0.0;
-	double b = 0.0;
-	int numSpectra = 0;
+	SearchResultsBlock srb ( specID, numPeaks, idFilter, discScoreGraph && !discFilenameExists );
+	initBlock ( srb, mOverZ, charge, intensity, multisample, idFilterSet );
 	if ( !noExpectation ) {
-		a = genNextDouble ( spec, "\t", start, end );
-		b = genNextDouble ( spec, "\t", start, end );
-		numSpectra = genNextInt ( spec, "\r\n", start, end );
+		srb.a = genNextDouble ( spec, "\t", start, end );
+		srb.b = genNextDouble ( spec, "\t", start, end );
+		srb.numSpectra = genNextInt ( spec, "\r\n", start, end );
 		if ( spec [start] == '\n' ) start++;
-		if ( eValueFlag ) {
-			MapIDExpectationValueInfo::const_iterator cur = mievi.find ( specID );
-			if ( cur != mievi.end () ) {
-				a = (*cur).second.getGradient ();
-				b = (*cur).second.getOffset ();
-			}
-			else {
-				ErrorHandler::genError ()->error ( "The expectation value file " + expName + " is incomplete.\n" + "SpecID: " + specID + " not found.\n" );
-			}
-		}
+		setBlockExpectation ( srb, eValueFlag, mievi, expName );
 	}
-	int rank;
-	int numUnmatched;
-	double error;
+	int rank = 0;				// The fields not on a line keep their values from the previous line
+	int numUnmatched = 0;
+	double error = 0.0;
 	string nTerm;
 	string peptide;
 	string cTerm;
 	string neutralLoss;
-	int startAA;
-	double score;
+	int startAA = 0;
+	double score = 0.0;
 	double maxScore = -std::numeric_limits<double>::max();
-	double expectation;
 	string scoreDiff;
 	string accNum;
-	SpecID* spID = 0;
-	HitPeptide* hitPeptide = 0;
-	PeptideSpectralInfo* psi;
-	SCModInfo scmi;
-	bool diskFlag = discScoreGraph && !discFilenameExists;
 	for ( ; ; ) {
 		string s = genNextString ( spec, "\t", start, end );
 		if ( end == string::npos ) break;
-		bool mod = false;
 		if ( s [0] == '+' ) {
 			startAA = atoi ( s.substr ( 1 ).c_str () );
 			accNum = genNextString ( spec, "\r\n", start, end );
-			if ( spec [start] == '\n' ) start++;
 		}
-		else {
-			if ( s [0] == 'M' ) {
-				numUnmatched = genNextInt ( spec, "\t", start, end );
-				getPeptideFromResults ( spec, start, nTerm, peptide, cTerm, neutralLoss );
-				score = genNextDouble ( spec, "\r\n", start, end );
-				mod = true;
-			}
-			else if ( s [0] == 'X' ) {
-				readXLinkBlock ( spec, s, start, end, maxScore, a, b, numSpectra, linearTailFitExpectation, minPeptideScore, maxPeptideEValue, xlMinLowScore, xlMinScoreDiff, xlMaxLowExpectation, idFilter, spID, specID, numPeaks, mmsi );
-				break;
-			}
-			else {
-				rank = atoi ( s.c_str () );
-				numUnmatched = genNextInt ( spec, "\t", start, end );
-				error = genNextDouble ( spec, "\t", start, end );
-				getPeptideFromResults ( spec, start, nTerm, peptide, cTerm, neutralLoss );
-				startAA = genNextInt ( spec, "\t", start, end );
-				score = genNextDouble ( spec, "\t", start, end );
-				scoreDiff = genNextString ( spec, "\t", start, end );
-				accNum = genNextString ( spec, "\r\n", start, end );
-				maxScore = genMax ( maxScore, score );
-			}
-			expectation = getEval ( score, a, b, numSpectra, linearTailFitExpectation );
-			if ( spec [start] == '\n' ) start++;
-			if ( !mod ) {
-				bool scoreFlag = score >= minPeptideScore && expectation <= maxPeptideEValue;
-				if ( diskFlag || scoreFlag ) {
-					hitPeptide = new HitPeptide ( nTerm, peptide, cTerm, neutralLoss );
-					psi = new PeptideSpectralInfo ( numUnmatched, numPeaks, rank, score, expectation, scoreDiff, numSpectra, a, b );
-				}
-			}
-			scmi.addHit ( nTerm, peptide, cTerm, neutralLoss, score, expectation, numSpectra );
+		else if ( s [0] == 'M' ) {
+			numUnmatched = genNextInt ( spec, "\t", start, end );
+			getPeptideFromResults ( spec, start, nTerm, peptide, cTerm, neutralLoss );
+			score = genNextDouble ( spec, "\r\n", start, end );
 		}
-		if ( !mod ) {
-			bool scoreFlag = score >= minPeptideScore && expectation <= maxPeptideEValue && idFilter;
-			if ( diskFlag || scoreFlag ) {
-				if ( spID == 0 ) spID = new SpecID ( specID );
-				accNum = getFullAccNum ( iv, accNum );
-				mapTagHits [spotID][accNum].push_back ( new SearchResultsPeptideHit ( spID, mmsi, psi, error, hitPeptide, startAA, accNum, numSearches-1 ) );
-			}
+		else if ( s [0] == 'X' ) {
+			readXLinkBlock ( spec, s, start, end, maxScore, srb.a, srb.b, srb.numSpectra, linearTailFitExpectation, minPeptideScore, maxPeptideEValue, xlMinLowScore, xlMinScoreDiff, xlMaxLowExpectation, srb.idFilter, srb.spID, specID, numPeaks, srb.mmsi );
+			break;
 		}
+		else {
+			rank = atoi ( s.c_str () );
+			numUnmatched = genNextInt ( spec, "\t", start, end );
+			error = genNextDouble ( spec, "\t", start, end );
+			getPeptideFromResults ( spec, start, nTerm, peptide, cTerm, neutralLoss );
+			startAA = genNextInt ( spec, "\t", start, end );
+			score = genNextDouble ( spec, "\t", start, end );
+			scoreDiff = genNextString ( spec, "\t", start, end );
+			accNum = genNextString ( spec, "\r\n", start, end );
+			maxScore = genMax ( maxScore, score );
+		}
+		if ( spec [start] == '\n' ) start++;
+		addBlockLine ( srb, s [0], rank, numUnmatched, error, nTerm, peptide, cTerm, neutralLoss, startAA, score, scoreDiff, accNum, mapTagHits, linearTailFitExpectation, minPeptideScore, maxPeptideEValue, iv );
 	}
-	if ( spID ) scmi.add ( spID );
+	if ( srb.spID ) srb.scmi.add ( srb.spID );
+}
+void SearchResults::readBinaryBlock ( const BinaryResults& br, GENINT64 index, MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, bool multisample, const SetInt& idFilterSet, bool idFilter, bool eValueFlag, MapIDExpectationValueInfo& mievi, const string& expName, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, const IntVector& iv )
+{
+	const BinaryResultsSpectrum& brs = br.getSpectrum ( index );
+	SearchResultsBlock srb ( br.getString ( brs.specID ), brs.numPeaks, idFilter, discScoreGraph && !discFilenameExists );
+	initBlock ( srb, brs.mOverZ, brs.charge, brs.intensity, multisample, idFilterSet );
+	srb.a = brs.a;
+	srb.b = brs.b;
+	srb.numSpectra = brs.numSpectra;
+	setBlockExpectation ( srb, eValueFlag, mievi, expName );
+	GENINT64 end = brs.firstLine + brs.numLines;
+	for ( GENINT64 j = brs.firstLine ; j < end ; j++ ) {
+		addBlockLine ( srb, br.getType ( j ), br.getRank ( j ), br.getNumUnmatched ( j ), br.getError ( j ), br.getNTerm ( j ), br.getPeptide ( j ), br.getCTerm ( j ), br.getNeutralLoss ( j ), br.getStartAA ( j ), br.getScore ( j ), br.getScoreDiff ( j ), br.getAccNum ( j ), mapTagHits, linearTailFitExpectation, minPeptideScore, maxPeptideEValue, iv );
+	}
+	if ( srb.spID ) srb.scmi.add ( srb.spID );
 }
 void SearchResults::readXLinkBlock ( string& spec, string& s, string::size_type& start, string::size_type& end, double maxScore, double a, double b, int numSpectra, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, double xlMinLowScore, double xlMinScoreDiff, double xlMaxLowExpectation, bool idFilter, SpecID* spID, const string& specID, int numPeaks, MSMSSpectrumInfo* mmsi )
 {
@@ -3561,8 +3632,8 @@ void SearchResults::readXLinkBlock ( string& spec, string& s, string::size_type&
 			if ( spID == 0 ) {
 				spID = new SpecID ( specID );
 			}
-			HitPeptide* hitPeptide = new HitPeptide ( nTerm, peptide, cTerm, neutralLoss );
-			HitPeptide* hitPeptide2 = new HitPeptide ( nTerm2, peptide2, cTerm2, neutralLoss2 );
+			const HitPeptide* hitPeptide = HitPeptide::getHitPeptide ( nTerm, peptide, cTerm, neutralLoss );
+			const HitPeptide* hitPeptide2 = HitPeptide::getHitPeptide ( nTerm2, peptide2, cTerm2, neutralLoss2 );
 			PeptideSpectralInfo* psi = new PeptideSpectralInfo ( numUnmatched, numPeaks, rank, score, expectation, scoreDiff, numSpectra, a, b );
 			if ( psi->getExpectationValue ( psi->getScore () - xFirstScore ) <= xlMaxLowExpectation ) {
 				xldi.calc ( 0 );
@@ -3655,7 +3726,7 @@ void SearchResults::getPeptideFromResults ( string& spec, string::size_type& sta
 	if ( s3 [0] == '+' ) neutralLoss = s3.substr ( 1 );
 	else start = previousStart;							// No Neutral Loss
 }
-bool SearchResults::getEValues ( const string& fname, MapIDExpectationValueInfo& mievi )
+bool SearchResults::getEValues ( const string& fname, MapIDExpectationValueInfo& mievi, bool message )
 {
 	string fileName = fname;
 	for ( int i = 0 ; ; i++ ) {
@@ -3671,7 +3742,7 @@ bool SearchResults::getEValues ( const string& fname, MapIDExpectationValueInfo&
 					break;
 			}
 		}
-		if ( i == 0 ) ujm->writeMessage ( cout, "Getting expectation values" );
+		if ( i == 0 && message ) ujm->writeMessage ( cout, "Getting expectation values" );
 		GenIFStream ist ( curFile );						// Open the current file
 		XMLIStreamList xslDataSet ( ist, "d" );
 		for ( ; ; ) {
@@ -3799,3 +3870,7 @@ MSMSSpectrumInfo::MSMSSpectrumInfo ( double mOverZ, int charge, double intensity
 	numPeaks ( numPeaks )
 {
 }
+void* MSMSSpectrumInfo::operator new ( size_t size )
+{
+	return hitArena.allocate ( size );
+}
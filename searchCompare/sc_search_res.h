@@ -42,6 +42,7 @@ class TaxonomyMatch;
 class FastaServer;
 class UpdatingJavascriptMessage;
 class LinkInfo;
+class BinaryResults;
 
 typedef std::vector <FastaServer*> FastaServerPtrVector;
 
@@ -186,6 +187,8 @@ class MSMSSpectrumInfo {
 public:
 	MSMSSpectrumInfo () {}
 	MSMSSpectrumInfo ( double mOverZ, int charge, double intensity, int numPeaks );
+	void* operator new ( size_t size );
+	void operator delete ( void* ) {}	// Freed with the arena
 	double getMOverZ () const { return mOverZ; }
 	int getCharge () const { return charge; }
 	double getIntensity () const { return intensity; }
@@ -198,8 +201,12 @@ class SearchResults;
 typedef std::vector <SearchResults*> SearchResultsPtrVector;
 typedef SearchResultsPtrVector::size_type SearchResultsPtrVectorSizeType;
 
+class HitPeptide;
+typedef std::map <std::string, HitPeptide> MapStringToHitPeptide;
+
 class HitPeptide {
 	static MapStringToDouble msd;
+	static MapStringToHitPeptide hitPeptides;
 	std::string databasePeptide;
 	std::string nTerm;
 	std::string peptide;
@@ -208,6 +215,7 @@ class HitPeptide {
 	bool mmod;
 public:
 	HitPeptide ( const std::string& nTerm, const std::string& peptide, const std::string& cTerm, const std::string& neutralLoss );
+	static const HitPeptide* getHitPeptide ( const std::string& nTerm, const std::string& peptide, const std::string& cTerm, const std::string& neutralLoss );
 	std::string getDatabasePeptide () const
 	{
 		if ( databasePeptide.empty () )	return peptide;
@@ -242,7 +250,7 @@ public:
 class SiteScores;
 
 class PeptidePosition {
-	std::string accessionNumber;
+	const std::string* accessionNumber;
 	const HitPeptide* hitPeptide;
 	const SpecID* specID;
 	const MSMSSpectrumInfo* mmsi;
@@ -269,6 +277,8 @@ class PeptidePosition {
 	static std::string compMaskType;
 	static unsigned int compMask;
 	static MapStringToUInt compMaskMap;
+	static SetString accessionNumbers;	// Each accession number is stored once and shared by its hits
+	static const std::string* getAccessionNumberPtr ( const std::string& accessionNumber );
 	static bool multipleErrorUnits;
 	static bool multipleFractionNames;
 	static bool spottingPlatesFlag;
@@ -313,7 +323,7 @@ public:
 	void setSubsequentOccurence () const { firstOccurence = false; }
 	void setQuanResults () const;
 	bool checkComposition () const;
-	std::string getAccessionNumber () const { return accessionNumber; }
+	std::string getAccessionNumber () const { return *accessionNumber; }
 	bool isDecoyHit () const;
 	int getFraction () const { return specID->getFraction (); }
 	std::string getSpot () const { return specID->getID (); }
@@ -573,6 +583,8 @@ class PeptideSpectralInfo {
 	static bool noExpectation;
 public:
 	PeptideSpectralInfo ( int unmatched, int numPeaks, int rank, double score, double expectation, const std::string& scDiff, int numPrecursor, double a = 0.0, double b = 0.0 );
+	void* operator new ( size_t size );
+	void operator delete ( void* ) {}	// Freed with the arena
 	int getMatched () const { return numPeaks - unmatched; }
 	int getUnmatched () const { return unmatched; }
 	int getNumPeaks () const { return numPeaks; }
@@ -674,6 +686,8 @@ protected:
 public:
 	SearchResultsPeptideHit ( const SpecID* spID, const MSMSSpectrumInfo* mmsi, int searchIndex );
 	SearchResultsPeptideHit ( const SpecID* specID, const MSMSSpectrumInfo* mmsi, const PeptideSpectralInfo* psi, double error, const HitPeptide* hitPeptide, int startAA, const std::string& accNum, int searchIndex );
+	void* operator new ( size_t size );
+	void operator delete ( void* ) {}	// Freed with the arena
 	void printHTML ( std::ostream& os, const ProteinInfo& proteinInfo, int searchNumber, const std::string& styleID, const SCMSTagLink& smtl, const std::string& id, bool joint, bool showTimes = true ) const;
 	void printHTMLPeak1 ( std::ostream& os, const std::string& styleID ) const;
 	void printHTMLPeak2 ( std::ostream& os, int searchNumber, const std::string& styleID, const SCMSTagLink& smtl, bool joint ) const;
@@ -1040,6 +1054,7 @@ typedef std::vector <SearchResults*> VectorSearchResultsPtr;
 typedef std::vector <SearchResultsCrosslinkPeptideHit*>::iterator SearchResultsCrosslinkPeptideHitPtrVectorIterator;
 
 class SResLink;
+class SearchResultsBlock;
 
 class SearchResults {
 	std::string projectName;
@@ -1092,16 +1107,20 @@ class SearchResults {
 	typedef MapIDMapAccNoAndVectorSearchResultsPeptideHit::const_iterator MapIDMapAccNoAndVectorSearchResultsPeptideHitConstIterator;
 	Histogram histogram;
 	double getEval ( double score, double a, double b, int numSpectra, bool linearTailFitExpectation ) const;
-	bool getEValues ( const std::string& fname, MapIDExpectationValueInfo& mievi );
 	std::string getMapTagHits ( MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, const std::string& fname, bool multisample, const SetInt& idFilterSet, double minPeptideScore, double maxPeptideEValue, double xlMinLowScore, double xlMinScoreDiff, double xlMaxLowExpectation );
+	void initBlock ( SearchResultsBlock& srb, double mOverZ, int charge, double intensity, bool multisample, const SetInt& idFilterSet );
+	void setBlockExpectation ( SearchResultsBlock& srb, bool eValueFlag, const MapIDExpectationValueInfo& mievi, const std::string& expName );
+	void addBlockLine ( SearchResultsBlock& srb, char type, int rank, int numUnmatched, double error, const std::string& nTerm, const std::string& peptide, const std::string& cTerm, const std::string& neutralLoss, int startAA, double score, const std::string& scoreDiff, const std::string& accNum, MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, const IntVector& iv );
 	void readBlock ( std::string& spec, MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, bool multisample, const SetInt& idFilterSet, bool idFilter, bool eValueFlag, MapIDExpectationValueInfo& mievi, const std::string& expName, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, double xlMinLowScore, double xlMinScoreDiff, double xlMaxLowExpectation, const IntVector& iv );
+	void readBinaryBlock ( const BinaryResults& br, GENINT64 index, MapIDMapAccNoAndVectorSearchResultsPeptideHit& mapTagHits, bool multisample, const SetInt& idFilterSet, bool idFilter, bool eValueFlag, MapIDExpectationValueInfo& mievi, const std::string& expName, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, const IntVector& iv );
 	void readXLinkBlock ( std::string& spec, std::string& s, std::string::size_type& start, std::string::size_type& end, double maxScore, double a, double b, int numSpectra, bool linearTailFitExpectation, double minPeptideScore, double maxPeptideEValue, double xlMinLowScore, double xlMinScoreDiff, double xlMaxLowExpectation, bool idFilter, SpecID* spID, const std::string& specID, int numPeaks, MSMSSpectrumInfo* mmsi );
 	static void processHits ( SearchResultsProteinHitPtrVector& pHits, bool noExpectation, double minBestDiscScore, MapSpecIDBestDiscriminantScore& bestScores, MapSpecIDAndPeptideDiscriminantScore& dsMap, DiscriminantScore& discScore, const SearchCompareParams& params, int fileIndex, const std::string& id );
 	void createHistogram ( const MapSpecIDAndPeptideDiscriminantScore& dsMap );
-	void getPeptideFromResults ( std::string& spec, std::string::size_type& start, std::string& nTerm, std::string& peptide, std::string& cTerm, std::string& neutralLoss );
 	static void sortCLinkPeptideLines ( const std::string& sortType, const SearchResultsCrosslinkPeptideHitPtrVectorIterator& begin, const SearchResultsCrosslinkPeptideHitPtrVectorIterator& end );
 	static std::string getFullAccNum ( const IntVector& iv, const std::string& a );
 public:
+	static bool getEValues ( const std::string& fname, MapIDExpectationValueInfo& mievi, bool message = true );
+	static void getPeptideFromResults ( std::string& spec, std::string::size_type& start, std::string& nTerm, std::string& peptide, std::string& cTerm, std::string& neutralLoss );
 	SearchResults ( const std::string& projectName, const std::string& resultName, const std::string& fname, const SearchCompareParams& params, int fileIndex, const std::string& searchEndTime, const std::string& searchTime );
 	void drawHistogram ( std::ostream& os ) const;
 	StringVector getAccessionNumbers ( const std::string& id = defaultID );
@@ -32,6 +32,7 @@
 #include <lu_html.h>
 #include <lu_param_list.h>
 #include <lu_prod_par.h>
+#include <lu_prod_batch.h>
 #include <lu_r_plot.h>
 #include <lu_table.h>
 #include <lu_sctag_link.h>
@@ -330,60 +331,42 @@ void SearchResultsCrosslinkPeptideHit::runMSProduct ( int i, double score, const
 	idx++;
 	string scoreStr = gen_ftoa ( score, "%.1f" );
 	string outputFilename =  gen_itoa ( idx ) + "_" + stripFilenameChars ( hitPeptide1->getPeptide () + "---" + hitPeptide2->getPeptide () ) + "_" + scoreStr + "_" + gen_itoa ( getCharge () );
-	PPTempFile tempFile ( "msprod", ".txt" );
-	string tempFileFullPath = tempFile.getFullPath ();
-
-	string command;
-#ifdef VIS_C
-	command += "\"";
-#endif
-	command += getSystemCall ( "mssearch.cgi" );
-	command += " - ";
-	command += getCommandLineNVPair ( "search_name", "msproduct" );
-	command += " ";
-	command += getCommandLineNVPair ( "output_filename", outputFilename );
-	command += " ";
-	command += getCommandLineNVPair ( "results_to_file", "1" );
-	command += " ";
-	command += getCommandLineNVPair ( "output_type", "XML" );
-	command += " ";
-	command += getCommandLineNVPair ( "report_title", "MS-Product" );
-	command += " ";
-	command += getCommandLineNVPair ( "version", Version::instance ().getVersion () );
-	command += " ";
-	command += getCommandLineNVPair ( "data_source", "List of Files" );
-	command += " ";
-	command += getCommandLineNVPair ( "use_instrument_ion_types", "1" );
-	command += " ";
-	command += getCommandLineNVPair ( "search_key", searchKey [i] );
-	command += " ";
-	command += getCommandLineNVPair ( "instrument_name", instrument [i] );
-	command += " ";
-	command += parentTolerances [i]->getCommandLineNVPair ( "msms_parent_mass" );
-	command += fragmentTolerances [i]->getCommandLineNVPair ( "fragment_masses" );
-	command += getCommandLineNVPair ( "parent_mass_convert", "monoisotopic" );
-	command += " ";
-	command += specID->getCommandLineNVPair ();
-	command += getCommandLineNVPair ( "max_charge", mmsi->getCharge () );
-	command += " ";
-	command += getCommandLineNVPair ( "count_pos_z", "Ignore Basic AA" );
-	command += " ";
-	command += getCommandLineNVPair ( "link_search_type", linkInfo->getName () );
-	command += " ";
-	command += hitPeptide1->getCommandLineNVPair ( 1 );
-	command += hitPeptide2->getCommandLineNVPair ( 2 );
-	command += MSMSPeakFilterOptions::getCommandLineNVPair ( ProgramLink::getParams () );
-	command += "> ";
-#ifdef VIS_C
-	command += "\"" + tempFileFullPath + "\"";
-#else
-	command += tempFileFullPath;
-#endif
-#ifdef VIS_C
-	command +=  "\"";
-#endif
-	genSystem ( command, "", true );
-	genUnlink ( tempFileFullPath );
+	string args;
+	args += getCommandLineNVPair ( "search_name", "msproduct" );
+	args += " ";
+	args += getCommandLineNVPair ( "output_filename", outputFilename );
+	args += " ";
+	args += getCommandLineNVPair ( "results_to_file", "1" );
+	args += " ";
+	args += getCommandLineNVPair ( "output_type", "XML" );
+	args += " ";
+	args += getCommandLineNVPair ( "report_title", "MS-Product" );
+	args += " ";
+	args += getCommandLineNVPair ( "version", Version::instance ().getVersion () );
+	args += " ";
+	args += getCommandLineNVPair ( "data_source", "List of Files" );
+	args += " ";
+	args += getCommandLineNVPair ( "use_instrument_ion_types", "1" );
+	args += " ";
+	args += getCommandLineNVPair ( "search_key", searchKey [i] );
+	args += " ";
+	args += getCommandLineNVPair ( "instrument_name", instrument [i] );
+	args += " ";
+	args += parentTolerances [i]->getCommandLineNVPair ( "msms_parent_mass" );
+	args += fragmentTolerances [i]->getCommandLineNVPair ( "fragment_masses" );
+	args += getCommandLineNVPair ( "parent_mass_convert", "monoisotopic" );
+	args += " ";
+	args += specID->getCommandLineNVPair ();
+	args += getCommandLineNVPair ( "max_charge", mmsi->getCharge () );
+	args += " ";
+	args += getCommandLineNVPair ( "count_pos_z", "Ignore Basic AA" );
+	args += " ";
+	args += getCommandLineNVPair ( "link_search_type", linkInfo->getName () );
+	args += " ";
+	args += hitPeptide1->getCommandLineNVPair ( 1 );
+	args += hitPeptide2->getCommandLineNVPair ( 2 );
+	args += MSMSPeakFilterOptions::getCommandLineNVPair ( ProgramLink::getParams () );
+	MSProductBatch::instance ().add ( args );
 }
 void SearchResultsCrosslinkPeptideHit::printDelimited ( ostream& os, const PPProteinHitQuanInfo& ppphqi, const LinkInfo* linkInfo ) const
 {
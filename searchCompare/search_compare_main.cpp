@@ -30,10 +30,12 @@
 #include <lu_html.h>
 #include <lu_prog_par.h>
 #include <lu_proj_file.h>
+#include <lu_prod_batch.h>
 #include <lu_version.h>
 #include <lu_param_list.h>
 #include <ld_init.h>
 #include <lu_mzidentml.h>
+#include <sc_res_load.h>
 #include <sc_sres_rep.h>
 using std::vector;
 using std::string;
@@ -113,6 +115,7 @@ int main ( int argc, char** argv )
 		vector <SearchResults*> searchResults;
 		getSearchResults ( params, searchResults );
 		writeReport ( params, searchResults );
+		MSProductBatch::instance ().run ();		// Any MS-Product runs requested in the report
 		delete ujm;
 		printProgramInformationHTML ( cout, "Search Compare" );
 		ProteinInfo::deleteTempDirs ();
@@ -131,6 +134,10 @@ static void getSearchResults ( const SearchCompareParams& params, vector <Search
 	string proj;
 	StringVector filenames = params.getFilenames ();
 #ifdef MYSQL_DATABASE
+	vector <BatchJobItem*> batchJobs;
+	StringVector searchEndTimes;
+	StringVector searchTimes;
+	StringVector resultsFullPaths;
 	for ( StringVectorSizeType i = 0 ; i < filenames.size () ; i++ ) {
 		BatchJobItem* bji;
 		string searchEndTime;
@@ -150,20 +157,31 @@ static void getSearchResults ( const SearchCompareParams& params, vector <Search
 		if ( i != 0 && temp != proj ) sresSingleProject = false;
 		proj = temp;
 		MySQLPPSDDBase::instance ().updateProjectRecordUpdated ( bji->getProjectID () );
-		searchResults.push_back ( new SearchResults ( bji->getProjectName (), bji->getResultsName (), bji->getResultsFullPath (), params, i, searchEndTime, searchTime ) );
+		batchJobs.push_back ( bji );
+		searchEndTimes.push_back ( searchEndTime );
+		searchTimes.push_back ( searchTime );
+		resultsFullPaths.push_back ( bji->getResultsFullPath () );
 	}
+	SearchResultsLoader::load ( resultsFullPaths );
+	for ( StringVectorSizeType j = 0 ; j < batchJobs.size () ; j++ ) {
+		BatchJobItem* bji = batchJobs [j];
+		searchResults.push_back ( new SearchResults ( bji->getProjectName (), bji->getResultsName (), bji->getResultsFullPath (), params, j, searchEndTimes [j], searchTimes [j] ) );
+	}
+	SearchResultsLoader::deleteItems ();
 #endif
 	if ( filenames.empty () ) {
 		int numSearches = params.getNumCommandLineSearches ();
 		StringVector projectNames = params.getCommandLineProjectNames ();
 		StringVector resultsNames = params.getCommandLineResultsNames ();
 		StringVector resultsFullPaths = params.getCommandLineResultsFullPaths ();
+		SearchResultsLoader::load ( resultsFullPaths );
 		for ( StringVectorSizeType i = 0 ; i < numSearches ; i++ ) {
 			string temp = getUncalibratedProject ( projectNames [i] );
 			if ( i != 0 && temp != proj ) sresSingleProject = false;
 			proj = temp;
 			searchResults.push_back ( new SearchResults ( projectNames [i], resultsNames [i], resultsFullPaths [i], params, i, "", "" ) );
 		}
+		SearchResultsLoader::deleteItems ();
 		if ( searchResults.empty () ) ErrorHandler::genError ()->error ( "No results to display.\n" );
 	}
 	if ( sresTime && !sresMergedFlag && !sresSingleProject ) {
@@ -0,0 +1,116 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : test_daemon_sched                                             *
+*                                                                             *
+*  Filename   : test_daemon_sched.cpp                                         *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Tests the order the Batch-Tag daemon starts queued searches.  *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstdio>
+#include <lgen_define.h>
+#include <ld_sched.h>
+using std::string;
+using std::make_pair;
+
+namespace {
+
+const string HOST = "node1";
+const string OTHER_HOST = "node2";
+
+int numFailures = 0;
+
+void checkKeys ( const string& name, const StringVector& keys, const string& expected )
+{
+	string actual;
+	for ( StringVectorSizeType i = 0 ; i < keys.size () ; i++ ) {
+		if ( i ) actual += " ";
+		actual += keys [i];
+	}
+	if ( actual != expected ) {
+		printf ( "FAIL %s: started \"%s\" expected \"%s\"\n", name.c_str (), actual.c_str (), expected.c_str () );
+		numFailures++;
+	}
+}
+VectorDaemonJobRecord getQueue ()	// In priority then submission order
+{
+	VectorDaemonJobRecord queued;
+	queued.push_back ( DaemonJobRecord ( "h1", "p7", "userA", -1 ) );
+	queued.push_back ( DaemonJobRecord ( "a1", "p1", "userA", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "a2", "p2", "userA", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "a3", "p2", "userA", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "b1", "p4", "userB", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "b2", "p5", "userB", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "c1", "p6", "userC", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "z1", "p8", "userC", 5 ) );
+	return queued;
+}
+void checkPriorityOrder ()
+{
+	VectorDaemonJobRecord queued;
+	queued.push_back ( DaemonJobRecord ( "k1", "p1", "userA", -1 ) );
+	queued.push_back ( DaemonJobRecord ( "k2", "p2", "userA", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "k3", "p3", "userA", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "k4", "p4", "userA", 3 ) );
+	checkKeys ( "priority order", getFairShareJobKeys ( queued, MapStringToInt (), MapPairStringStringToInt (), HOST, 0 ), "k1 k2 k3 k4" );
+}
+void checkFairShare ()
+{
+	MapStringToInt userJobs;
+	userJobs ["userA"] = 2;		// userA already has two searches running
+	MapPairStringStringToInt hostUserJobs;
+	hostUserJobs [make_pair ( HOST, string ( "userA" ) )] = 2;
+	// h1 has a higher priority so starts first even though userA has the most searches.
+	// Within priority 0 the users take turns, fewest running first. a3 waits as a2 is in the same project.
+	checkKeys ( "fair share", getFairShareJobKeys ( getQueue (), userJobs, hostUserJobs, HOST, 0 ), "h1 b1 c1 b2 a1 a2 z1" );
+}
+void checkSubmissionOrder ()	// Users with the same number of searches running are taken in submission order
+{
+	checkKeys ( "submission order", getFairShareJobKeys ( getQueue (), MapStringToInt (), MapPairStringStringToInt (), HOST, 0 ), "h1 b1 c1 a1 b2 a2 z1" );
+}
+void checkOneJobPerProject ()
+{
+	VectorDaemonJobRecord queued;
+	queued.push_back ( DaemonJobRecord ( "k1", "p1", "userA", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "k2", "p1", "userB", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "k3", "p2", "userB", 0 ) );
+	queued.push_back ( DaemonJobRecord ( "k4", "p1", "userC", 1 ) );
+	checkKeys ( "one job per project", getFairShareJobKeys ( queued, MapStringToInt (), MapPairStringStringToInt (), HOST, 0 ), "k1 k3" );
+}
+void checkMaxJobsPerUser ()
+{
+	MapStringToInt userJobs;
+	userJobs ["userA"] = 2;
+	MapPairStringStringToInt hostUserJobs;
+	hostUserJobs [make_pair ( HOST, string ( "userA" ) )] = 2;
+	checkKeys ( "max jobs per user", getFairShareJobKeys ( getQueue (), userJobs, hostUserJobs, HOST, 3 ), "h1 b1 c1 b2 z1" );
+
+	userJobs ["userB"] = 4;		// Searches on another node don't count towards the limit on this one
+	hostUserJobs [make_pair ( OTHER_HOST, string ( "userB" ) )] = 4;
+	checkKeys ( "max jobs per user on another node", getFairShareJobKeys ( getQueue (), userJobs, hostUserJobs, HOST, 1 ), "c1 b1" );
+}
+
+}
+
+int main ( int argc, char** argv )
+{
+	checkPriorityOrder ();
+	checkFairShare ();
+	checkSubmissionOrder ();
+	checkOneJobPerProject ();
+	checkMaxJobsPerUser ();
+	printf ( "test_daemon_sched: %s\n", numFailures ? "FAILED" : "passed" );
+	return numFailures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : test_frag_simd                                                *
+*                                                                             *
+*  Filename   : test_frag_simd.cpp                                            *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Checks that the vectorized fragment matching gives the same   *
+*               masks as the scalar code.                                     *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstdio>
+#include <lgen_define.h>
+#include <lu_frag_simd.h>
+using std::string;
+
+namespace {
+
+const char* implementations [] = { "SSE2", "AVX2" };
+const int NUM_IMPLEMENTATIONS = sizeof ( implementations ) / sizeof ( char* );
+const int ARRAY_SIZE = FRAG_SIMD_BLOCK_SIZE + FRAG_SIMD_PADDING;
+const int NUM_TRIALS = 2000;
+const MassType MAX_TOLERANCE = 5000;	// 0.5 Da
+
+int numFailures = 0;
+
+unsigned int seed = 12345;
+int randomInt ( int n )	// Same sequence on every platform
+{
+	seed = seed * 1103515245 + 12345;
+	return ( ( seed >> 8 ) & 0xFFFFFF ) % n;
+}
+struct Block {
+	MassType ion;
+	MassType tag [ARRAY_SIZE];
+	MassType tol [ARRAY_SIZE];
+	MassType max [ARRAY_SIZE];
+};
+void makeBlock ( Block& b )	// Many of the peaks are exactly at or one unit inside or outside the tolerance
+{
+	b.ion = 1000000 + randomInt ( 20000000 );
+	for ( int i = 0 ; i < ARRAY_SIZE ; i++ ) {
+		MassType tol = randomInt ( MAX_TOLERANCE + 1 );
+		MassType diff;
+		switch ( randomInt ( 4 ) ) {
+			case 0:		diff = tol; break;
+			case 1:		diff = tol + 1; break;
+			case 2:		diff = tol - 1; break;
+			default:	diff = randomInt ( 3 * MAX_TOLERANCE );
+		}
+		if ( randomInt ( 2 ) ) diff = -diff;
+		b.tag [i] = b.ion + diff;
+		b.tol [i] = tol;
+		b.max [i] = b.ion + ( randomInt ( 3 ) - 1 ) * randomInt ( 2 );	// Equal to, one below or one above the ion
+	}
+}
+void checkImplementation ( const string& name, const Block& b, int n, unsigned int match, unsigned int greater )
+{
+	unsigned int m = fragMatchMask ( b.ion, b.tag, b.tol, n );
+	unsigned int g = fragGreaterMask ( b.ion, b.max, n );
+	if ( m != match ) {
+		printf ( "FAIL %s fragMatchMask n=%d: %08x expected %08x\n", name.c_str (), n, m, match );
+		numFailures++;
+	}
+	if ( g != greater ) {
+		printf ( "FAIL %s fragGreaterMask n=%d: %08x expected %08x\n", name.c_str (), n, g, greater );
+		numFailures++;
+	}
+}
+void checkBlocks ( BoolDeque& available )
+{
+	for ( int t = 0 ; t < NUM_TRIALS ; t++ ) {
+		Block b;
+		makeBlock ( b );
+		for ( int n = 1 ; n <= FRAG_SIMD_BLOCK_SIZE ; n++ ) {	// Covers every n % 4 and n % 8 tail
+			setFragSIMD ( "scalar" );
+			unsigned int match = fragMatchMask ( b.ion, b.tag, b.tol, n );
+			unsigned int greater = fragGreaterMask ( b.ion, b.max, n );
+			for ( int i = 0 ; i < NUM_IMPLEMENTATIONS ; i++ ) {
+				if ( available [i] ) {
+					setFragSIMD ( implementations [i] );
+					checkImplementation ( implementations [i], b, n, match, greater );
+				}
+			}
+		}
+	}
+}
+
+}
+
+int main ( int argc, char** argv )
+{
+	BoolDeque available;
+	for ( int i = 0 ; i < NUM_IMPLEMENTATIONS ; i++ ) {
+		available.push_back ( setFragSIMD ( implementations [i] ) );
+		if ( !available.back () ) printf ( "test_frag_simd: %s not available on this machine\n", implementations [i] );
+	}
+	checkBlocks ( available );
+	printf ( "test_frag_simd: %s\n", numFailures ? "FAILED" : "passed" );
+	return numFailures ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : test_histogram                                                *
+*                                                                             *
+*  Filename   : test_histogram.cpp                                            *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Regression test for the binned survival histogram.            *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstdio>
+#include <cmath>
+#include <lgen_define.h>
+#include <lu_fragmentation.h>
+#include <lu_histogram.h>
+using std::string;
+using nr::pi;
+
+// The results are compared with a copy of the implementation that stored every score.
+// That implementation called makeHistogram before fitting which sorts the scores so Method of Moments
+// and Closed Form Max Likelihood were already fitted to the lowest scores. The binned version does the same.
+
+namespace {
+
+class StoredSurvivalHistogram : public Histogram {
+	mutable XYData xySurv;
+	mutable double b;
+	mutable double a;
+	string expectationMethod;
+	int minUsedPeptides;
+	double tailPercent;
+	void compute ( int numSavedPeptides ) const;
+public:
+	StoredSurvivalHistogram ( const string& expectationMethod ) :
+		a ( 0.0 ),
+		b ( 0.0 ),
+		expectationMethod ( expectationMethod ),
+		minUsedPeptides ( ExpectationParameters::instance ().getMinUsedPeptides () ),
+		tailPercent ( ExpectationParameters::instance ().getTailPercent () ) {}
+	void addValue ( double x ) { val.push_back ( x ); }
+	void init ( int numSavedPeptides ) const { compute ( numSavedPeptides ); }
+	double getEValue ( double score ) const;
+};
+void StoredSurvivalHistogram::compute ( int numSavedPeptides ) const
+{
+	int numUsedPeptides = val.size () - numSavedPeptides;
+	if ( expectationMethod == "Linear Tail Fit" ) numUsedPeptides -= 20;
+	if ( numUsedPeptides > 0 ) {
+		makeHistogram ();
+		if ( expectationMethod == "Linear Tail Fit" ) {
+			if ( numUsedPeptides >= minUsedPeptides ) {
+				double tot = 0.0;
+				double actTot = 0.0;
+				XYData xyTemp;
+				for ( int i = xyData.size () ; i-- ; ) {
+					tot += xyData.y ( i );
+					if ( actTot > numUsedPeptides / tailPercent ) break;
+					actTot += xyData.y ( i );
+					if ( tot > (numSavedPeptides + 20) ) {
+						xyTemp.add ( xyData.x ( i ), actTot / numUsedPeptides );
+					}
+				}
+				for ( int j = 0 ; j < xyTemp.size () ; j++ ) {
+					if ( xyTemp.y ( j ) ) {
+						xySurv.add ( xyTemp.x ( j ), log10 ( xyTemp.y ( j ) ) );
+					}
+				}
+				xySurv.linearRegression ( &b, &a );
+			}
+		}
+		else if ( expectationMethod == "Method of Moments" ) {
+			if ( numUsedPeptides >= 500 ) {
+				double mean, sdevError, var;
+				moment ( &val[0]-1, numUsedPeptides, &mean, &sdevError, &var );
+				b = ( sqrt (6.0 * var) ) / pi;
+				a = mean - ( 0.57721566490153286060651209008240243104 * b );
+			}
+		}
+		else if ( expectationMethod == "Closed Form Max Likelihood" ) {
+			if ( numUsedPeptides >= 500 ) {
+				double mean, sdevError, var;
+				moment ( &val[0]-1, numUsedPeptides, &mean, &sdevError, &var );
+				double sum1 = 0.0;
+				for ( int i = 0 ; i < numUsedPeptides ; i++ ) {
+					sum1 += val [i] * log ( ( (i+1) - 0.5 ) / ( numUsedPeptides + 0.5 )  );
+				}
+				sum1 /= numUsedPeptides;
+				b = mean + sum1;
+				double sum2 = 0.0;
+				for ( int j = 0 ; j < numUsedPeptides ; j++ ) {
+					sum2 += exp ( - val [j] / b  );
+				}
+				a = - b * log ( sum2 / numUsedPeptides );
+			}
+		}
+	}
+}
+double StoredSurvivalHistogram::getEValue ( double score ) const
+{
+	if ( a != 0.0 ) {
+		score /= SCORE_TYPE_MULTIPLIER;
+		if ( expectationMethod == "Linear Tail Fit" ) {
+			double y = (a * score) + b;
+			return pow ( 10.0, y ) * val.size ();
+		}
+		else
+			return ( 1.0 - exp ( -exp ( (- 1 / b) * (score - a) ) ) ) * val.size ();
+	}
+	else
+		return -1.0;
+}
+
+const char* methods [] = { "Linear Tail Fit", "Method of Moments", "Closed Form Max Likelihood" };
+const int NUM_METHODS = sizeof ( methods ) / sizeof ( char* );
+const int NUM_SAVED_PEPTIDES = 10;
+const size_t SIZE_LIMIT = 1000000;
+const double E_VALUE_TOLERANCE = 0.001;		// Allows for summation order and the wider bins
+
+int numFailures = 0;
+
+unsigned int seed = 12345;
+double uniformRandom ()	// Same sequence on every platform
+{
+	seed = seed * 1103515245 + 12345;
+	return ( ( ( seed >> 8 ) & 0xFFFFFF ) + 0.5 ) / 16777216.0;
+}
+DoubleVector getScores ( int num, double location, double scale )	// Extreme value distributed scores in score units
+{
+	DoubleVector dv;
+	for ( int i = 0 ; i < num ; i++ ) {
+		double x = location - scale * log ( - log ( uniformRandom () ) );
+		dv.push_back ( floor ( x * SCORE_TYPE_MULTIPLIER + 0.5 ) / SCORE_TYPE_MULTIPLIER );
+	}
+	return dv;
+}
+void addScores ( SurvivalHistogram& sh, StoredSurvivalHistogram& ssh, const DoubleVector& dv )
+{
+	for ( DoubleVectorSizeType i = 0 ; i < dv.size () ; i++ ) {
+		sh.addValue ( dv [i] );
+		ssh.addValue ( dv [i] );
+	}
+}
+void checkEValues ( const string& name, const string& method, const SurvivalHistogram& sh, const StoredSurvivalHistogram& ssh, const DoubleVector& scores )
+{
+	ssh.init ( NUM_SAVED_PEPTIDES );
+	sh.init ( NUM_SAVED_PEPTIDES );
+	if ( sh.getEValueFlag () != ( ssh.getEValue ( 0.0 ) != -1.0 ) ) {
+		printf ( "FAIL %s %s: fit flag differs\n", name.c_str (), method.c_str () );
+		numFailures++;
+		return;
+	}
+	for ( DoubleVectorSizeType i = 0 ; i < scores.size () ; i++ ) {
+		double score = scores [i] * SCORE_TYPE_MULTIPLIER;
+		double e = sh.getEValue ( score );
+		double expected = ssh.getEValue ( score );
+		if ( genAbsDiff ( e, expected ) > E_VALUE_TOLERANCE * expected ) {
+			printf ( "FAIL %s %s: score %.3f e value %g expected %g\n", name.c_str (), method.c_str (), scores [i], e, expected );
+			numFailures++;
+		}
+	}
+}
+void checkHistogram ( const string& name, const DoubleVector& dv1, const DoubleVector& dv2, const DoubleVector& scores )
+{
+	for ( int i = 0 ; i < NUM_METHODS ; i++ ) {
+		SurvivalHistogram::setExpectationMethod ( methods [i] );
+		StoredSurvivalHistogram ssh ( methods [i] );
+		SurvivalHistogram sh ( SIZE_LIMIT );
+		addScores ( sh, ssh, dv1 );
+		addScores ( sh, ssh, dv2 );
+		checkEValues ( name, methods [i], sh, ssh, scores );
+	}
+}
+void checkMerge ( const string& name, const DoubleVector& dv1, const DoubleVector& dv2, const DoubleVector& scores )
+{
+	for ( int i = 0 ; i < NUM_METHODS ; i++ ) {
+		SurvivalHistogram::setExpectationMethod ( methods [i] );
+		StoredSurvivalHistogram ssh ( methods [i] );
+		SurvivalHistogram sh1 ( SIZE_LIMIT );
+		SurvivalHistogram sh2 ( SIZE_LIMIT );
+		addScores ( sh1, ssh, dv1 );
+		addScores ( sh2, ssh, dv2 );
+		if ( !sh1.merge ( sh2 ) || sh1.getSize () != dv1.size () + dv2.size () ) {
+			printf ( "FAIL %s %s: merge failed\n", name.c_str (), methods [i] );
+			numFailures++;
+			continue;
+		}
+		checkEValues ( name, methods [i], sh1, ssh, scores );
+	}
+}
+void checkSizeLimit ()
+{
+	SurvivalHistogram sh1 ( 100 );
+	SurvivalHistogram sh2 ( 100 );
+	for ( int i = 0 ; i < 60 ; i++ ) {
+		sh1.addValue ( i );
+		sh2.addValue ( i );
+	}
+	if ( sh1.merge ( sh2 ) || sh1.getSize () != 60 ) {
+		printf ( "FAIL merge over the size limit\n" );
+		numFailures++;
+	}
+}
+
+}
+
+int main ( int argc, char** argv )
+{
+	DoubleVector narrow = getScores ( 3000, 20.0, 4.0 );		// Bins one score unit wide
+	DoubleVector narrow2 = getScores ( 2000, 25.0, 3.0 );
+	DoubleVector wide = getScores ( 3000, 150.0, 60.0 );		// Needs wider bins
+	DoubleVector narrowScores;
+	narrowScores.push_back ( 40.0 );
+	narrowScores.push_back ( 50.0 );
+	narrowScores.push_back ( 60.0 );
+	DoubleVector wideScores;
+	wideScores.push_back ( 400.0 );
+	wideScores.push_back ( 500.0 );
+	wideScores.push_back ( 600.0 );
+
+	checkHistogram ( "narrow", narrow, narrow2, narrowScores );
+	checkMerge ( "narrow merge", narrow, narrow2, narrowScores );
+	checkHistogram ( "wide", narrow, wide, wideScores );
+	checkMerge ( "wide into narrow merge", narrow, wide, wideScores );
+	checkMerge ( "narrow into wide merge", wide, narrow, wideScores );
+	checkSizeLimit ();
+	printf ( "test_histogram: %s\n", numFailures ? "FAILED" : "passed" );
+	return numFailures ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : test_iso_dist                                                 *
+*                                                                             *
+*  Filename   : test_iso_dist.cpp                                             *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Regression test for the isotope distribution calculation.     *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstdio>
+#include <lgen_define.h>
+#include <lg_string.h>
+#include <lu_iso.h>
+using std::string;
+
+// Reference values were produced by the isotopologue enumeration that preceded the convolution engine.
+// Aggregated peaks are only compared above 1% abundance as the enumeration pruned the tail below the probability limit.
+
+namespace {
+
+struct PeakReference {
+	const char* formula;
+	int charge;
+	int peak;
+	double mz;
+	double probability;
+};
+
+PeakReference peakReference [] = {
+	{ "C50 H80 N14 O15 S1", 1, 0, 1148.564280, 0.503572 },
+	{ "C50 H80 N14 O15 S1", 1, 1, 1149.567110, 0.309567 },
+	{ "C50 H80 N14 O15 S1", 1, 2, 1150.568079, 0.131669 },
+	{ "C50 H80 N14 O15 S1", 1, 3, 1151.569220, 0.041773 },
+	{ "C50 H80 N14 O15 S1", 1, 4, 1152.570574, 0.010648 },
+	{ "C50 H80 N14 O15 S1", 2, 0, 574.785778, 0.503572 },
+	{ "C50 H80 N14 O15 S1", 2, 1, 575.287193, 0.309567 },
+	{ "C50 H80 N14 O15 S1", 2, 2, 575.787678, 0.131669 },
+	{ "C50 H80 N14 O15 S1", 2, 3, 576.288248, 0.041773 },
+	{ "C50 H80 N14 O15 S1", 2, 4, 576.788925, 0.010648 },
+	{ "C254 H377 N65 O75 S6", 1, 0, 5729.600321, 0.030086 },
+	{ "C254 H377 N65 O75 S6", 1, 1, 5730.603181, 0.093386 },
+	{ "C254 H377 N65 O75 S6", 1, 2, 5731.605485, 0.157180 },
+	{ "C254 H377 N65 O75 S6", 1, 3, 5732.607464, 0.187909 },
+	{ "C254 H377 N65 O75 S6", 1, 4, 5733.609226, 0.177498 },
+	{ "C254 H377 N65 O75 S6", 1, 5, 5734.610837, 0.140182 },
+	{ "C254 H377 N65 O75 S6", 1, 6, 5735.612341, 0.095843 },
+	{ "C254 H377 N65 O75 S6", 1, 7, 5736.613767, 0.058073 },
+	{ "C254 H377 N65 O75 S6", 1, 8, 5737.615140, 0.031711 },
+	{ "C254 H377 N65 O75 S6", 1, 9, 5738.616475, 0.015801 },
+	{ "C254 H377 N65 O75 S6", 2, 0, 2865.303799, 0.030086 },
+	{ "C254 H377 N65 O75 S6", 2, 1, 2865.805229, 0.093386 },
+	{ "C254 H377 N65 O75 S6", 2, 2, 2866.306381, 0.157180 },
+	{ "C254 H377 N65 O75 S6", 2, 3, 2866.807370, 0.187909 },
+	{ "C254 H377 N65 O75 S6", 2, 4, 2867.308251, 0.177498 },
+	{ "C254 H377 N65 O75 S6", 2, 5, 2867.809057, 0.140182 },
+	{ "C254 H377 N65 O75 S6", 2, 6, 2868.309809, 0.095843 },
+	{ "C254 H377 N65 O75 S6", 2, 7, 2868.810522, 0.058073 },
+	{ "C254 H377 N65 O75 S6", 2, 8, 2869.311208, 0.031711 },
+	{ "C254 H377 N65 O75 S6", 2, 9, 2869.811875, 0.015801 },
+	{ "C10 H12 Cl2 Br1", 1, 0, 280.949394, 0.260905 },
+	{ "C10 H12 Cl2 Br1", 1, 1, 281.952786, 0.028579 },
+	{ "C10 H12 Cl2 Br1", 1, 2, 282.947020, 0.422172 },
+	{ "C10 H12 Cl2 Br1", 1, 3, 283.950389, 0.046130 },
+	{ "C10 H12 Cl2 Br1", 1, 4, 284.944383, 0.191401 },
+	{ "C10 H12 Cl2 Br1", 1, 5, 285.947692, 0.020783 },
+	{ "C10 H12 Cl2 Br1", 1, 6, 286.941813, 0.027008 },
+	{ "C10 H12 Cl2 Br1", 2, 0, 140.978335, 0.260905 },
+	{ "C10 H12 Cl2 Br1", 2, 1, 141.480031, 0.028579 },
+	{ "C10 H12 Cl2 Br1", 2, 2, 141.977148, 0.422172 },
+	{ "C10 H12 Cl2 Br1", 2, 3, 142.478833, 0.046130 },
+	{ "C10 H12 Cl2 Br1", 2, 4, 142.975830, 0.191401 },
+	{ "C10 H12 Cl2 Br1", 2, 5, 143.477484, 0.020783 },
+	{ "C10 H12 Cl2 Br1", 2, 6, 143.974545, 0.027008 },
+	{ "C34 H32 Fe1 N4 O4", 1, 0, 614.181417, 0.039425 },
+	{ "C34 H32 Fe1 N4 O4", 1, 1, 615.184565, 0.015279 },
+	{ "C34 H32 Fe1 N4 O4", 1, 2, 616.176800, 0.622101 },
+	{ "C34 H32 Fe1 N4 O4", 1, 3, 617.179761, 0.254625 },
+	{ "C34 H32 Fe1 N4 O4", 1, 4, 618.182344, 0.057815 },
+	{ "C34 H32 Fe1 N4 O4", 2, 0, 307.594347, 0.039425 },
+	{ "C34 H32 Fe1 N4 O4", 2, 1, 308.095921, 0.015279 },
+	{ "C34 H32 Fe1 N4 O4", 2, 2, 308.592038, 0.622101 },
+	{ "C34 H32 Fe1 N4 O4", 2, 3, 309.093519, 0.254625 },
+	{ "C34 H32 Fe1 N4 O4", 2, 4, 309.594810, 0.057815 },
+	{ "C600 H950 N170 O180 S5", 1, 2, 13578.906397, 0.010379 },
+	{ "C600 H950 N170 O180 S5", 1, 3, 13579.909056, 0.026382 },
+	{ "C600 H950 N170 O180 S5", 1, 4, 13580.911637, 0.051217 },
+	{ "C600 H950 N170 O180 S5", 1, 5, 13581.914148, 0.080920 },
+	{ "C600 H950 N170 O180 S5", 1, 6, 13582.916599, 0.108285 },
+	{ "C600 H950 N170 O180 S5", 1, 7, 13583.918995, 0.126128 },
+	{ "C600 H950 N170 O180 S5", 1, 8, 13584.921343, 0.130441 },
+	{ "C600 H950 N170 O180 S5", 1, 9, 13585.923648, 0.121590 },
+	{ "C600 H950 N170 O180 S5", 1, 10, 13586.925917, 0.103365 },
+	{ "C600 H950 N170 O180 S5", 1, 11, 13587.928152, 0.080900 },
+	{ "C600 H950 N170 O180 S5", 1, 12, 13588.930358, 0.058744 },
+	{ "C600 H950 N170 O180 S5", 1, 13, 13589.932539, 0.039828 },
+	{ "C600 H950 N170 O180 S5", 1, 14, 13590.934700, 0.025351 },
+	{ "C600 H950 N170 O180 S5", 1, 15, 13591.936842, 0.015217 },
+	{ "C600 H950 N170 O180 S5", 2, 2, 6789.956837, 0.010379 },
+	{ "C600 H950 N170 O180 S5", 2, 3, 6790.458166, 0.026382 },
+	{ "C600 H950 N170 O180 S5", 2, 4, 6790.959457, 0.051217 },
+	{ "C600 H950 N170 O180 S5", 2, 5, 6791.460712, 0.080920 },
+	{ "C600 H950 N170 O180 S5", 2, 6, 6791.961938, 0.108285 },
+	{ "C600 H950 N170 O180 S5", 2, 7, 6792.463136, 0.126128 },
+	{ "C600 H950 N170 O180 S5", 2, 8, 6792.964310, 0.130441 },
+	{ "C600 H950 N170 O180 S5", 2, 9, 6793.465462, 0.121590 },
+	{ "C600 H950 N170 O180 S5", 2, 10, 6793.966597, 0.103365 },
+	{ "C600 H950 N170 O180 S5", 2, 11, 6794.467714, 0.080900 },
+	{ "C600 H950 N170 O180 S5", 2, 12, 6794.968817, 0.058744 },
+	{ "C600 H950 N170 O180 S5", 2, 13, 6795.469908, 0.039828 },
+	{ "C600 H950 N170 O180 S5", 2, 14, 6795.970988, 0.025351 },
+	{ "C600 H950 N170 O180 S5", 2, 15, 6796.472059, 0.015217 }
+};
+
+struct AveragineReference {
+	double mOverZ;
+	int charge;
+	int peak;
+	double mz;
+	double probability;
+};
+
+AveragineReference averagineReference [] = {
+	{ 1500, 2, 0, 1499.770102, 0.175753 },
+	{ 1500, 2, 1, 1500.271532, 0.284906 },
+	{ 1500, 2, 2, 1500.772763, 0.251819 },
+	{ 1500, 2, 3, 1501.273883, 0.158594 },
+	{ 1500, 2, 4, 1501.774943, 0.078999 },
+	{ 1500, 2, 5, 1502.275975, 0.032883 },
+	{ 1500, 2, 6, 1502.776999, 0.011831 }
+};
+
+struct FineStructureReference {
+	const char* formula;
+	const char* isotopes;
+	double massOffset;
+	double probability;
+};
+
+FineStructureReference fineStructureReference [] = {
+	{ "C2 H6 O1", "", 46.04131623, 0.97566274 },
+	{ "C2 H6 O1", "13C1", 47.04467107, 0.02110501 },
+	{ "C2 H6 O1", "17O1", 47.04553331, 0.00037165 },
+	{ "C2 H6 O1", "2H1", 47.04759298, 0.00067328 },
+	{ "C2 H6 O1", "18O1", 48.04556261, 0.00200498 },
+	{ "C2 H6 O1", "13C2", 48.04802591, 0.00011413 },
+	{ "C10 H12 Cl2 Br1", "", 280.94939426, 0.26090533 },
+	{ "C10 H12 Cl2 Br1", "13C1", 281.95274910, 0.02821881 },
+	{ "C10 H12 Cl2 Br1", "2H1", 281.95567101, 0.00036009 },
+	{ "C10 H12 Cl2 Br1", "37Cl1", 282.94644417, 0.16695737 },
+	{ "C10 H12 Cl2 Br1", "81Br1", 282.94734776, 0.25380236 },
+	{ "C10 H12 Cl2 Br1", "13C2", 282.95610394, 0.00137343 },
+	{ "C10 H12 Cl2 Br1", "13C1 37Cl1", 283.94979901, 0.01805766 },
+	{ "C10 H12 Cl2 Br1", "13C1 81Br1", 283.95070260, 0.02745057 },
+	{ "C10 H12 Cl2 Br1", "2H1 37Cl1", 283.95272092, 0.00023043 },
+	{ "C10 H12 Cl2 Br1", "2H1 81Br1", 283.95362451, 0.00035029 },
+	{ "C10 H12 Cl2 Br1", "37Cl2", 284.94349408, 0.02670965 },
+	{ "C10 H12 Cl2 Br1", "37Cl1 81Br1", 284.94439767, 0.16241207 },
+	{ "C10 H12 Cl2 Br1", "13C2 37Cl1", 284.95315385, 0.00087888 },
+	{ "C10 H12 Cl2 Br1", "13C2 81Br1", 284.95405744, 0.00133604 },
+	{ "C10 H12 Cl2 Br1", "13C1 37Cl2", 285.94684892, 0.00288884 },
+	{ "C10 H12 Cl2 Br1", "13C1 37Cl1 81Br1", 285.94775251, 0.01756605 },
+	{ "C10 H12 Cl2 Br1", "2H1 37Cl1 81Br1", 285.95067442, 0.00022415 },
+	{ "C10 H12 Cl2 Br1", "37Cl2 81Br1", 286.94144758, 0.02598250 },
+	{ "C10 H12 Cl2 Br1", "13C2 37Cl2", 286.95020376, 0.00014060 },
+	{ "C10 H12 Cl2 Br1", "13C2 37Cl1 81Br1", 286.95110735, 0.00085495 },
+	{ "C10 H12 Cl2 Br1", "13C1 37Cl2 81Br1", 287.94480242, 0.00281020 },
+	{ "C10 H12 Cl2 Br1", "13C2 37Cl2 81Br1", 288.94815726, 0.00013677 }
+};
+
+const double MZ_TOLERANCE = 0.00002;
+const double RELATIVE_PROBABILITY_TOLERANCE = 0.004;
+const double FINE_STRUCTURE_TOLERANCE = 0.000000015;
+
+int numFailures = 0;
+
+void checkPeak ( const IsotopePeakStats& ips, const string& name, int charge, int peak, double mz, double probability )
+{
+	if ( peak >= ips.getNumPeaks () ) {
+		printf ( "FAIL %s z=%d peak %d missing\n", name.c_str (), charge, peak );
+		numFailures++;
+		return;
+	}
+	double m = ips.getAverageMass () [peak];
+	double p = ips.getProbability ( peak );
+	if ( genAbsDiff ( m, mz ) > MZ_TOLERANCE || genAbsDiff ( p, probability ) > RELATIVE_PROBABILITY_TOLERANCE * probability ) {
+		printf ( "FAIL %s z=%d peak %d: %.6f %.6f expected %.6f %.6f\n", name.c_str (), charge, peak, m, p, mz, probability );
+		numFailures++;
+	}
+}
+void checkAggregatedPeaks ()
+{
+	for ( int i = 0 ; i < sizeof ( peakReference ) / sizeof ( PeakReference ) ; i++ ) {
+		const PeakReference& pr = peakReference [i];
+		IsotopePeakStats ips ( string ( pr.formula ), pr.charge );
+		checkPeak ( ips, pr.formula, pr.charge, pr.peak, pr.mz, pr.probability );
+	}
+	for ( int j = 0 ; j < sizeof ( averagineReference ) / sizeof ( AveragineReference ) ; j++ ) {
+		const AveragineReference& ar = averagineReference [j];
+		IsotopePeakStats ips ( ar.mOverZ, ar.charge );
+		checkPeak ( ips, "averagine " + gen_ftoa ( ar.mOverZ, "%.1f" ), ar.charge, ar.peak, ar.mz, ar.probability );
+	}
+}
+void checkFineStructure ()
+{
+	int numRef = sizeof ( fineStructureReference ) / sizeof ( FineStructureReference );
+	for ( int i = 0 ; i < numRef ; ) {
+		string formula = fineStructureReference [i].formula;
+		IsotopicDistribution id ( formula, 1, 0.0001, true );
+		IsotopicDistributionConstIterator it ( &id );
+		for ( ; i < numRef && formula == fineStructureReference [i].formula ; i++, it.advance () ) {
+			const FineStructureReference& fr = fineStructureReference [i];
+			if ( !it.more () ) {
+				printf ( "FAIL %s component %s missing\n", fr.formula, fr.isotopes );
+				numFailures++;
+				continue;
+			}
+			if ( it.formula () != fr.isotopes || genAbsDiff ( it.massOffset (), fr.massOffset ) > FINE_STRUCTURE_TOLERANCE || genAbsDiff ( it.probability (), fr.probability ) > FINE_STRUCTURE_TOLERANCE ) {
+				printf ( "FAIL %s component [%s] %.8f %.8f expected [%s] %.8f %.8f\n", fr.formula, it.formula ().c_str (), it.massOffset (), it.probability (), fr.isotopes, fr.massOffset, fr.probability );
+				numFailures++;
+			}
+		}
+		if ( it.more () ) {
+			printf ( "FAIL %s has extra components\n", formula.c_str () );
+			numFailures++;
+		}
+	}
+}
+
+}
+
+int main ( int argc, char** argv )
+{
+	checkAggregatedPeaks ();
+	checkFineStructure ();
+	printf ( "test_iso_dist: %s\n", numFailures ? "FAILED" : "passed" );
+	return numFailures ? 1 : 0;
+}
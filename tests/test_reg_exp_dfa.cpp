@@ -0,0 +1,190 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : test_reg_exp_dfa                                              *
+*                                                                             *
+*  Filename   : test_reg_exp_dfa.cpp                                          *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Checks that screening with RegularExpressionDFA doesn't       *
+*               change the matches found by RegularExpression.                *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstdio>
+#include <cstring>
+#include <lgen_define.h>
+#include <lg_string.h>
+#include <lgen_reg_exp.h>
+using std::string;
+
+namespace {
+
+struct PatternCase {
+	const char* regExp;
+	int maxErrors;
+	bool screens;			// The DFA should reject some of the strings
+};
+
+// The expressions are in the syntax used by MS-Pattern.
+// Expressions with more positions than fit in 64 bits have their longest ranges widened.
+// With substitutions each position needs maxErrors + 1 bits so the limit is reached sooner.
+
+PatternCase patternCases [] = {
+	{ "KR", 0, true },
+	{ "C[DE]K", 0, true },
+	{ "[KR][^P]", 0, true },
+	{ "W.\\{2,5\\}C", 0, true },
+	{ "C.\\{3,\\}K", 0, true },
+	{ "D*EK", 0, true },
+	{ "A[CD]*E.K", 0, true },
+	{ "^MA", 0, true },
+	{ "^[KR]..C", 0, true },
+	{ "K$", 0, true },
+	{ "C.*R$", 0, true },
+	{ "^M.*K$", 0, true },
+	{ "CDEK", 1, true },
+	{ "W[DE].K", 1, true },
+	{ "C.\\{2,4\\}DK", 1, true },
+	{ "^MAC", 1, true },
+	{ "CWK$", 1, true },
+	{ "CADWEK", 2, true },
+	{ "^CDE.K$", 2, false },
+	{ "C.\\{70\\}K", 0, true },							// Widened range
+	{ "W.\\{30,80\\}C.\\{40\\}K", 0, true },
+	{ "C.\\{20\\}DEK", 1, true },
+	{ "CW.\\{15,25\\}K", 2, true },
+	{ "^C.\\{70\\}K$", 0, true },
+	{ "CDEKACDEKACDEKACDEKACDEKACDEKACDEKACDEKACDEKACDEKACDEKACDEKACDEKAC", 0, true },	// Screened on the start of the expression
+	{ "CADEKWCADEKWCADEKWCADEKWCADEKW", 1, true }
+};
+
+const char* AMINO_ACIDS = "ACDEKMPRW";
+const char* motifs [] = { "CDEKA", "CADEKW", "MAC" };	// Repeated with a few changes so the long expressions match
+const int NUM_STRINGS = 3000;
+const int MIN_LENGTH = 5;
+const int MAX_LENGTH = 250;
+const int MUTATION_RATE = 40;
+
+int numFailures = 0;
+
+unsigned int seed = 12345;
+int randomInt ( int n )	// Same sequence on every platform
+{
+	seed = seed * 1103515245 + 12345;
+	return ( ( seed >> 8 ) & 0xFFFFFF ) % n;
+}
+StringVector getStrings ()
+{
+	StringVector sv;
+	int numAA = strlen ( AMINO_ACIDS );
+	int numMotifs = sizeof ( motifs ) / sizeof ( char* );
+	for ( int i = 0 ; i < NUM_STRINGS ; i++ ) {
+		int len = MIN_LENGTH + randomInt ( MAX_LENGTH - MIN_LENGTH );
+		string s;
+		if ( i % 3 == 0 ) {
+			string motif = motifs [randomInt ( numMotifs )];
+			for ( int j = 0 ; j < len ; j++ ) {
+				if ( randomInt ( MUTATION_RATE ) == 0 )	s += AMINO_ACIDS [randomInt ( numAA )];
+				else									s += motif [j % motif.length ()];
+			}
+		}
+		else {
+			for ( int j = 0 ; j < len ; j++ ) s += AMINO_ACIDS [randomInt ( numAA )];
+		}
+		sv.push_back ( s );
+	}
+	return sv;
+}
+RegularExpression* getRegularExpression ( const string& regExp, int maxErrors )
+{
+	if ( maxErrors )	return new RegularExpressionWithErrors ( regExp, maxErrors );
+	else				return new RegularExpression ( regExp );
+}
+string getHits ( RegularExpression* re, const string& s )	// Hit list for a search without an enzyme
+{
+	string hits;
+	const char* str = s.c_str ();
+	while ( re->isPresentMultiOverlap ( str ) ) {
+		hits += gen_itoa ( re->getStartAA () ) + ":" + gen_itoa ( re->getNErr () ) + ":" + re->getMatch () + " ";
+	}
+	return hits;
+}
+string getAnchoredHits ( RegularExpression* re, const string& s )	// Hit list for a search with an enzyme that cleaves everywhere
+{
+	string hits;
+	for ( StringSizeType i = 0 ; i < s.length () ; i++ ) {
+		if ( re->isPresent ( s.c_str () + i ) ) {
+			hits += gen_itoa ( i ) + ":" + gen_itoa ( re->getNErr () ) + ":" + re->getMatch () + " ";
+		}
+	}
+	return hits;
+}
+void checkPattern ( const PatternCase& pc, const StringVector& sv )
+{
+	string regExp = pc.regExp;
+	RegularExpression* re = getRegularExpression ( regExp, pc.maxErrors );
+	RegularExpressionDFA dfa ( *re, pc.maxErrors );
+	RegularExpression* reAnchored = getRegularExpression ( regExp [0] == '^' ? regExp : "^" + regExp, pc.maxErrors );
+	RegularExpressionDFA dfaAnchored ( *reAnchored, pc.maxErrors, true );	// As used by MS-Pattern with an enzyme
+	int numRejected = 0;
+	for ( StringVectorSizeType i = 0 ; i < sv.size () ; i++ ) {
+		const string& s = sv [i];
+		bool present = re->isPresent ( s.c_str () );
+		bool screened = dfa.isPresent ( s.c_str () );
+		if ( present && !screened ) {
+			printf ( "FAIL %s errors=%d: DFA rejects %s\n", pc.regExp, pc.maxErrors, s.c_str () );
+			numFailures++;
+		}
+		if ( !screened ) numRejected++;
+		string hits = getHits ( re, s );
+		string screenedHits = screened ? getHits ( re, s ) : "";
+		if ( hits != screenedHits ) {
+			printf ( "FAIL %s errors=%d: hits %s screened hits %s\n", pc.regExp, pc.maxErrors, hits.c_str (), screenedHits.c_str () );
+			numFailures++;
+		}
+		string anchoredHits = getAnchoredHits ( reAnchored, s );
+		string screenedAnchoredHits = dfaAnchored.isPresent ( s.c_str () ) ? getAnchoredHits ( reAnchored, s ) : "";
+		if ( anchoredHits != screenedAnchoredHits ) {
+			printf ( "FAIL %s errors=%d: anchored hits %s screened hits %s\n", pc.regExp, pc.maxErrors, anchoredHits.c_str (), screenedAnchoredHits.c_str () );
+			numFailures++;
+		}
+	}
+	if ( !dfa.isUsable () || ( pc.screens && numRejected == 0 ) ) {
+		printf ( "FAIL %s errors=%d: no strings screened out\n", pc.regExp, pc.maxErrors );
+		numFailures++;
+	}
+	delete reAnchored;
+	delete re;
+}
+void checkUnusable ()	// Back references can't be screened
+{
+	RegularExpression re ( "\\(C.\\)K\\1" );
+	RegularExpressionDFA dfa ( re );
+	if ( dfa.isUsable () || !dfa.isPresent ( "AAAA" ) ) {
+		printf ( "FAIL back reference expression screened\n" );
+		numFailures++;
+	}
+}
+
+}
+
+int main ( int argc, char** argv )
+{
+	StringVector sv = getStrings ();
+	for ( int i = 0 ; i < sizeof ( patternCases ) / sizeof ( PatternCase ) ; i++ ) {
+		checkPattern ( patternCases [i], sv );
+	}
+	checkUnusable ();
+	printf ( "test_reg_exp_dfa: %s\n", numFailures ? "FAILED" : "passed" );
+	return numFailures ? 1 : 0;
+}
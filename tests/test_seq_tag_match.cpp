@@ -0,0 +1,313 @@
+/******************************************************************************
+*                                                                             *
+*  Program    : test_seq_tag_match                                            *
+*                                                                             *
+*  Filename   : test_seq_tag_match.cpp                                        *
+*                                                                             *
+*  Created    : October 18th 2026                                             *
+*                                                                             *
+*  Purpose    : Checks that SequenceTagMatcher finds the same MS-Homology     *
+*               hits as the original search.                                  *
+*                                                                             *
+*  Author(s)  : Peter Baker                                                   *
+*                                                                             *
+*  This file is the confidential and proprietary product of The Regents of    *
+*  the University of California.  Any unauthorized use, reproduction or       *
+*  transfer of this file is strictly prohibited.                              *
+*                                                                             *
+*  Copyright (2026) The Regents of the University of California.              *
+*                                                                             *
+*  All rights reserved.                                                       *
+*                                                                             *
+******************************************************************************/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <lgen_define.h>
+#include <lg_string.h>
+#include <lu_pq_vector.h>
+#include <lu_seq_exp.h>
+#include <lu_unk_rexp.h>
+using std::string;
+
+// The results are compared with a copy of the search that kept its state in static variables.
+// The original read past the end of repeated sequences when finding the shared prefix. The copy stops
+// one character past the terminator which gives the value it relied on.
+
+namespace {
+
+class StaticSequenceMatcher {
+	StringVector hits;
+	IntVector seqset;
+	IntVector maxerrs;
+	int num_hits;
+	int check_len;
+	IntVector node;
+	int maxnumerrs;
+	int maxlen;
+	int minlen;
+	IntVector sum_errors;
+	int same_string;
+	bool unknome_hit_present ( const char* offset );
+public:
+	IntVector hit_number;
+	int num_errors;
+	int nhits;
+	const char* loc1;
+	const char* loc2;
+	StaticSequenceMatcher ( const StringVector& reg_exp_hits, const IntVector& set, const IntVector& max_allow_errors, int check_peptide_length );
+	bool multi_unknome_hits_present ( const char* offset );
+	string getMeasuredSequence ( int i ) const { return hits [hit_number [i]]; }
+	int getSequenceSet ( int i ) const { return seqset [hit_number [i]]; }
+};
+StaticSequenceMatcher::StaticSequenceMatcher ( const StringVector& reg_exp_hits, const IntVector& set, const IntVector& max_allow_errors, int check_peptide_length ) :
+	hit_number ( 1 ),
+	same_string ( 0 ),
+	loc1 ( 0 ),
+	loc2 ( 0 )
+{
+	for ( StringVectorSizeType i = 0 ; i < reg_exp_hits.size () ; i++ ) {
+		SequenceExpression seq_exp ( reg_exp_hits [i], 0 );
+		StringVector seq_list = seq_exp.getSequenceList ();
+		for ( StringVectorSizeType j = 0 ; j < seq_list.size () ; j++ ) {
+			hits.push_back ( seq_list [j] );
+			seqset.push_back ( set [i] );
+			maxerrs.push_back ( max_allow_errors [i] );
+		}
+	}
+	num_hits = hits.size ();
+	check_len = check_peptide_length;
+
+	node.resize ( num_hits );
+	node [0] = 0;
+	minlen = maxlen = hits [0].length ();
+	for ( int i = 1 ; i < num_hits ; i++ ) {
+		const char* h1 = hits [i-1].c_str ();
+		const char* h2 = hits [i].c_str ();
+		int j;
+		for ( j = 0 ; j <= hits [i].length () && h2 [j] == h1 [j] ; j++ );
+		node [i] = j;
+		minlen = genMin ( (int) hits [i].length (), minlen );
+		maxlen = genMax ( (int) hits [i].length (), maxlen );
+	}
+	maxnumerrs = 0;
+	for ( int i = 0 ; i < num_hits ; i++ ) {
+		maxnumerrs = genMax ( maxerrs [i], maxnumerrs );
+	}
+	sum_errors.resize ( maxlen );
+}
+bool StaticSequenceMatcher::multi_unknome_hits_present ( const char* offset )
+{
+	const char* loc = check_len ? loc2 : loc1 + 1;
+
+	if ( same_string ) {
+		if ( unknome_hit_present ( loc ) ) {
+			return ( true );
+		}
+	}
+	else {
+		if ( unknome_hit_present ( offset ) ) {
+			same_string = 1;
+			return ( true );
+		}
+	}
+	same_string = 0;
+	return ( false );
+}
+bool StaticSequenceMatcher::unknome_hit_present ( const char* offset )
+{
+	int len = strlen ( offset );
+
+	nhits = 0;
+	if ( len < minlen ) return ( false );
+	if ( check_len ) len = 1;
+	num_errors = maxnumerrs + 1;
+	int bestLen = maxlen;
+	for ( int i = 0 ; i < len ; i++ ) {
+		loc1 = offset + i;
+		sum_errors [0] = 0;
+		for ( int j = 0, k = 0 ; j < num_hits ; j++ ) {
+			int nod = node [j];
+			if ( k >= nod ) {
+				const char* ep = hits [j].c_str () + nod;
+				const char* lp = loc1 + nod;
+				int nerrs = sum_errors [nod];
+
+				for ( k = nod ; ; k++ ) {
+					if ( *ep == 0 ) {
+						loc2 = lp;
+						int curLen = loc2 - loc1;
+						if ( nerrs < num_errors ) {
+							hit_number [0] = j;
+							nhits = 1;
+							num_errors = nerrs;
+							bestLen = curLen;
+						}
+						else if ( nhits && ( nerrs == num_errors ) ) {
+							if ( curLen < bestLen ) {
+								hit_number [0] = j;
+								nhits = 1;
+								num_errors = nerrs;
+								bestLen = curLen;
+							}
+							else if ( nhits && ( bestLen == curLen ) ) {
+								if ( nhits == hit_number.size () ) hit_number.resize ( nhits * 2 );
+								hit_number [nhits++] = j;
+							}
+						}
+						break;
+					}
+					if ( *lp == 0 ) break;
+					sum_errors [k] = nerrs;
+					if ( *ep++ != *lp++ ) {
+						if ( ++nerrs > maxerrs [j] ) break;
+					}
+				}
+			}
+		}
+		if ( num_errors <= maxnumerrs ) return ( true );
+	}
+	return ( false );
+}
+
+struct SequenceCase {
+	const char* name;
+	const char* sequences;	// Space separated
+	const char* maxErrors;
+};
+
+// Sequences sharing a prefix are adjacent so the shared part is only compared once.
+
+SequenceCase sequenceCases [] = {
+	{ "single",							"CDEKAW",									"1" },
+	{ "exact",							"KAWCDE CDEKR",								"0 0" },
+	{ "shared prefix fewer errors last",	"CDEKAW CDEKRM CDEWKA",						"2 0 1" },
+	{ "shared prefix more errors last",	"CDEKAW CDEKRM CDEWKA",						"0 1 2" },
+	{ "nested prefix",					"CDEK CDEKAW CDEKAWM",						"0 2 1" },
+	{ "repeated sequence",				"MACDEK MACDEK WKACD",						"0 1 1" },
+	{ "repeated sequence more errors",	"MACDEK MACDEK MACDEK",						"2 0 1" },
+	{ "expression",						"AC[DE]KW {KAW}CD",							"1 0" },
+	{ "expression shared prefix",		"CD[EK]AW[MR] CDEAWK",						"2 1" },
+	{ "multiple words",					"CDEKAWCDEK CDEKAWMACD KAWCDEKAWC MACDEKAWCD WCDEKAWMAC CDEKRMACDE WKACDEKAWM AWCDEKAWCD", "2 1 0 2 1 2 0 1" }
+};
+
+const char* AMINO_ACIDS = "ACDEKMRW";
+const char* motifs [] = { "CDEKAW", "MACDEK", "KAWCD" };	// Repeated with a few changes so the sequences match
+const int NUM_FRAMES = 400;
+const int MIN_LENGTH = 3;
+const int MAX_LENGTH = 120;
+const int MUTATION_RATE = 8;
+
+int numFailures = 0;
+
+unsigned int seed = 12345;
+int randomInt ( int n )	// Same sequence on every platform
+{
+	seed = seed * 1103515245 + 12345;
+	return ( ( seed >> 8 ) & 0xFFFFFF ) % n;
+}
+StringVector getFrames ()
+{
+	StringVector sv;
+	int numAA = strlen ( AMINO_ACIDS );
+	int numMotifs = sizeof ( motifs ) / sizeof ( char* );
+	for ( int i = 0 ; i < NUM_FRAMES ; i++ ) {
+		int len = MIN_LENGTH + randomInt ( MAX_LENGTH - MIN_LENGTH );
+		string s;
+		if ( i % 2 == 0 ) {
+			string motif = motifs [randomInt ( numMotifs )];
+			for ( int j = 0 ; j < len ; j++ ) {
+				if ( randomInt ( MUTATION_RATE ) == 0 )	s += AMINO_ACIDS [randomInt ( numAA )];
+				else									s += motif [j % motif.length ()];
+			}
+		}
+		else {
+			for ( int j = 0 ; j < len ; j++ ) s += AMINO_ACIDS [randomInt ( numAA )];
+		}
+		sv.push_back ( s );
+	}
+	return sv;
+}
+string getHitList ( const SequenceTagMatcher& stm, const char* frame )
+{
+	string s = gen_itoa ( stm.getLoc1 () - frame ) + "-" + gen_itoa ( stm.getLoc2 () - frame ) + ":" + gen_itoa ( stm.getNumSubstitutions () );
+	for ( int i = 0 ; i < stm.getNumHits () ; i++ ) {
+		s += " " + gen_itoa ( stm.getHitNumber ( i ) ) + "," + gen_itoa ( stm.getSequenceSet ( i ) ) + "," + stm.getMeasuredSequence ( i );
+	}
+	return s + ";";
+}
+string getHitList ( const StaticSequenceMatcher& ssm, const char* frame )
+{
+	string s = gen_itoa ( ssm.loc1 - frame ) + "-" + gen_itoa ( ssm.loc2 - frame ) + ":" + gen_itoa ( ssm.num_errors );
+	for ( int i = 0 ; i < ssm.nhits ; i++ ) {
+		s += " " + gen_itoa ( ssm.hit_number [i] ) + "," + gen_itoa ( ssm.getSequenceSet ( i ) ) + "," + ssm.getMeasuredSequence ( i );
+	}
+	return s + ";";
+}
+bool present ( SequenceTagMatcher& stm, const char* offset )
+{
+	return stm.isPresentMulti ( offset );
+}
+bool present ( StaticSequenceMatcher& ssm, const char* offset )
+{
+	return ssm.multi_unknome_hits_present ( offset );
+}
+template <class T>
+string getHits ( T& matcher, const string& frame, bool enzyme )
+{
+	string hits;
+	const char* f = frame.c_str ();
+	if ( enzyme ) {						// Called at each cleavage site as MS-Homology does for tryptic peptides
+		for ( StringSizeType i = 0 ; i < frame.length () ; i++ ) {
+			if ( i == 0 || frame [i-1] == 'K' || frame [i-1] == 'R' ) {
+				if ( present ( matcher, f + i ) ) hits += gen_itoa ( i ) + "=" + getHitList ( matcher, f );
+			}
+		}
+	}
+	else {
+		while ( present ( matcher, f ) ) hits += getHitList ( matcher, f );
+	}
+	return hits;
+}
+void checkSequences ( const SequenceCase& sc, const StringVector& frames, bool enzyme )
+{
+	StringVector sequences;
+	IntVector sequenceSet;
+	IntVector maxErrors;
+	getPostQueryVector ( sc.sequences, sequences, ' ' );
+	StringVector errs;
+	getPostQueryVector ( sc.maxErrors, errs, ' ' );
+	for ( StringVectorSizeType i = 0 ; i < sequences.size () ; i++ ) {
+		sequenceSet.push_back ( i + 1 );
+		maxErrors.push_back ( atoi ( errs [i].c_str () ) );
+	}
+	SequenceTagMatcher stm ( sequences, sequenceSet, maxErrors, 0, enzyme );
+	StaticSequenceMatcher ssm ( sequences, sequenceSet, maxErrors, enzyme );
+	int numHits = 0;
+	for ( StringVectorSizeType j = 0 ; j < frames.size () ; j++ ) {
+		string hits = getHits ( stm, frames [j], enzyme );
+		string expected = getHits ( ssm, frames [j], enzyme );
+		if ( hits != expected ) {
+			printf ( "FAIL %s%s: %s hits %s expected %s\n", sc.name, enzyme ? " enzyme" : "", frames [j].c_str (), hits.c_str (), expected.c_str () );
+			numFailures++;
+		}
+		if ( !expected.empty () ) numHits++;
+	}
+	if ( numHits == 0 ) {
+		printf ( "FAIL %s%s: no hits found\n", sc.name, enzyme ? " enzyme" : "" );
+		numFailures++;
+	}
+}
+
+}
+
+int main ( int argc, char** argv )
+{
+	StringVector frames = getFrames ();
+	for ( int i = 0 ; i < sizeof ( sequenceCases ) / sizeof ( SequenceCase ) ; i++ ) {
+		checkSequences ( sequenceCases [i], frames, false );
+		checkSequences ( sequenceCases [i], frames, true );
+	}
+	printf ( "test_seq_tag_match: %s\n", numFailures ? "FAILED" : "passed" );
+	return numFailures ? 1 : 0;
+}